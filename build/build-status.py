@@ -0,0 +1,8 @@
+#! /usr/bin/env python
+
+# Programs that are runnable.
+ns3_runnable_programs = ['build/src/core/examples/ns3.22-main-callback-debug', 'build/src/core/examples/ns3.22-sample-simulator-debug', 'build/src/core/examples/ns3.22-main-ptr-debug', 'build/src/core/examples/ns3.22-sample-random-variable-debug', 'build/src/core/examples/ns3.22-sample-random-variable-stream-debug', 'build/src/core/examples/ns3.22-command-line-example-debug', 'build/src/core/examples/ns3.22-hash-example-debug', 'build/src/core/examples/ns3.22-main-test-sync-debug', 'build/src/network/examples/ns3.22-main-packet-header-debug', 'build/src/network/examples/ns3.22-main-packet-tag-debug', 'build/src/network/examples/ns3.22-packet-socket-apps-debug', 'build/src/stats/examples/ns3.22-gnuplot-example-debug', 'build/src/stats/examples/ns3.22-double-probe-example-debug', 'build/src/stats/examples/ns3.22-time-probe-example-debug', 'build/src/stats/examples/ns3.22-gnuplot-aggregator-example-debug', 'build/src/stats/examples/ns3.22-gnuplot-helper-example-debug', 'build/src/stats/examples/ns3.22-file-aggregator-example-debug', 'build/src/stats/examples/ns3.22-file-helper-example-debug', 'build/src/tocino/examples/ns3.22-tocino-queue-benchmark-debug', 'build/src/tocino/examples/ns3.22-tocino-event-benchmark-debug', 'build/src/tocino/examples/ns3.22-tocino-adaptive-routing-debug', 'build/src/tocino/examples/ns3.22-tocino-latency-debug', 'build/src/tocino/examples/ns3.22-tocino-collectives-debug', 'build/src/tocino/examples/ns3.22-tocino-trace-replay-debug', 'build/src/tocino/examples/ns3.22-tocino-saturation-debug', 'build/src/tocino/examples/ns3.22-tocino-mpi-torus-debug', 'build/examples/tutorial/ns3.22-hello-simulator-debug', 'build/examples/tutorial/ns3.22-fourth-debug', 'build/scratch/subdir/ns3.22-subdir-debug', 'build/scratch/ns3.22-scratch-simulator-debug']
+
+# Scripts that are runnable.
+ns3_runnable_scripts = ['sample-simulator.py']
+
@@ -0,0 +1,49 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_3D_TORUS_TOPOLOGY_HELPER_H__
+#define __TOCINO_3D_TORUS_TOPOLOGY_HELPER_H__
+
+#include "ns3/nstime.h"
+
+#include "tocino-torus-topology-helper.h"
+
+namespace ns3
+{
+
+class TocinoChannel;
+
+// Retained for existing users; devices are stored
+// flat, see TocinoTorusNetDeviceContainer
+typedef TocinoTorusNetDeviceContainer Tocino3DTorusNetDeviceContainer;
+
+// A RADIX x RADIX x RADIX torus with wrap-around
+// links in every dimension
+class Tocino3DTorusTopologyHelper : public TocinoTorusTopologyHelper
+{
+    public:
+
+    Tocino3DTorusTopologyHelper( uint32_t );
+
+    const uint32_t RADIX;
+    
+    uint32_t CoordinatesToIndex(
+            const uint32_t,
+            const uint32_t,
+            const uint32_t ) const;
+
+    using TocinoTorusTopologyHelper::Middle;
+    using TocinoTorusTopologyHelper::CrossesBisection;
+    using TocinoTorusTopologyHelper::ReportBisectionBandwidth;
+
+    // As above, for the X dimension
+    uint32_t Middle() const;
+
+    bool CrossesBisection( Ptr<TocinoChannel> ) const;
+    
+    void ReportBisectionBandwidth( 
+            const Tocino3DTorusNetDeviceContainer&,
+            const Time ) const;
+};
+
+}
+
+#endif // __TOCINO_3D_TORUS_TOPOLOGY_HELPER_H__
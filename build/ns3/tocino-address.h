@@ -0,0 +1,212 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_ADDRESS_H__
+#define __TOCINO_ADDRESS_H__
+
+#include <stdint.h>
+#include <sstream>
+#include <string>
+
+#include "ns3/mac48-address.h"
+
+#include "tocino-misc.h"
+
+namespace ns3 {
+
+class TocinoAddress
+{
+    public:
+
+    TocinoAddress()
+    {
+        m_address.raw = 0;
+        
+        m_isValid = false;
+    }
+
+    explicit TocinoAddress( uint32_t a )
+    {
+        m_address.raw = a;
+        
+        m_isValid = true;
+    }
+    
+    typedef uint8_t Coordinate;
+    
+    TocinoAddress( Coordinate x, Coordinate y, Coordinate z, Coordinate w = 0 )
+    {
+        NS_ASSERT( w <= MAX_W );
+
+        m_address.x = x;
+        m_address.y = y;
+        m_address.z = z;
+        m_address.w = w;
+        m_address.multicast = 0;
+        
+        m_isValid = true;
+    }
+
+    Address ConvertTo() const
+    {
+        return Address( GetType(),
+            reinterpret_cast<const uint8_t*>( &m_address.raw ),
+            GetLength() );
+    }
+
+    operator Address() const
+    {
+        return ConvertTo();
+    }
+
+    static TocinoAddress ConvertFrom( const Address &a )
+    {
+        TocinoAddress ta;
+        NS_ASSERT( a.CheckCompatible( GetType(), GetLength() ) );
+        a.CopyTo( reinterpret_cast<uint8_t*>( &ta.m_address.raw ) );
+        ta.m_isValid = !a.IsInvalid();
+        return ta;
+    }
+    
+    bool IsValid() const
+    {
+        return m_isValid;
+    }
+    
+    bool IsInvalid() const
+    {
+        return !m_isValid;
+    }
+
+    bool IsMulticast()
+    {
+        return m_address.multicast;
+    }
+
+    void SetMulticast()
+    {
+        m_address.multicast = true; 
+    }
+    
+    Mac48Address AsMac48Address() const
+    {
+        uint8_t buf[6];
+       
+        // Microsoft XCG OUI
+        buf[5] = 0xDC;
+        buf[4] = 0xB4;
+        buf[3] = 0xC4;
+
+        // embed XYZ in lower 3B
+        buf[2] = m_address.x;
+        buf[1] = m_address.y;
+        buf[0] = m_address.z;
+
+        // W is rare; fold it into the OUI rather than collide
+        buf[3] ^= m_address.w;
+
+        Mac48Address a;
+        a.CopyFrom( buf );
+
+        return a;
+    }
+    
+    Coordinate GetX() const
+    {
+        return m_address.x;
+    }
+    
+    Coordinate GetY() const
+    {
+        return m_address.y;
+    }
+    
+    Coordinate GetZ() const
+    {
+        return m_address.z;
+    }
+    
+    Coordinate GetW() const
+    {
+        return m_address.w;
+    }
+  
+    static const int MAX_DIM = TOCINO_MAX_DIMENSIONS;
+
+    // N.B.
+    // The 4th dimension lives in the 7 bits formerly reserved,
+    // so its radix is limited to 128.  This keeps the address,
+    // and so the head flit, at 4 bytes.
+    static const Coordinate MAX_W = 127;
+
+    Coordinate GetCoordinate( TocinoDimension d ) const
+    {
+        NS_ASSERT( d != TOCINO_INVALID_DIMENSION );
+        NS_ASSERT( d < MAX_DIM );
+
+        if( d == TOCINO_DIMENSION_W )
+        {
+            return m_address.w;
+        }
+
+        return m_address.coord[ d.AsUInt32() ];
+    }
+
+    static uint8_t GetLength()
+    {
+        return sizeof( m_address );
+    }
+
+    private:
+
+    static uint8_t GetType()
+    {
+        static uint8_t type = Address::Register();
+        return type;
+    }
+
+    union
+    {
+        struct
+        {
+            union
+            {
+                struct
+                {
+                    Coordinate x, y, z;
+                };
+                Coordinate coord[3];
+            };
+
+            uint8_t w         : 7;
+            uint8_t multicast : 1;
+        };
+        uint32_t raw;
+    }
+    m_address;
+
+    bool m_isValid;
+};
+
+// Colon-separated coordinates, e.g. "1:2:0:0", which are
+// safe to embed in comma-separated output
+inline std::string
+TocinoAddressToString( const TocinoAddress& ta )
+{
+    std::ostringstream oss;
+
+    for( int dim = 0; dim < TocinoAddress::MAX_DIM; ++dim )
+    {
+        if( dim > 0 )
+        {
+            oss << ":";
+        }
+
+        oss << static_cast<unsigned>( ta.GetCoordinate( dim ) );
+    }
+
+    return oss.str();
+}
+
+}
+
+#endif /* __TOCINO_ADDRESS_H__ */
+
@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_ARBITER_H__
+#define __TOCINO_ARBITER_H__   
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+
+#include "tocino-flow-control.h"
+#include "tocino-misc.h"
+
+namespace ns3
+{
+
+class TocinoNetDevice;
+class TocinoTx;
+
+// ISSUE-REVIEW: consider moving this to its own file
+struct TocinoArbiterAllocation
+{
+    TocinoInputPort inputPort;
+    TocinoOutputVC outputVC;
+    
+    TocinoArbiterAllocation( TocinoInputPort port, TocinoOutputVC vc ) 
+        : inputPort( port )
+        , outputVC( vc )
+    {}
+    
+    TocinoArbiterAllocation()
+        : inputPort( TOCINO_INVALID_PORT )
+        , outputVC( TOCINO_INVALID_VC )
+    {}
+    
+    bool operator==( const TocinoArbiterAllocation& other ) const
+    {
+        if( other.inputPort != inputPort )
+            return false;
+
+        if( other.outputVC != outputVC )
+            return false;
+
+        return true;
+    }
+
+    bool operator!=( const TocinoArbiterAllocation& other ) const
+    {
+        return !( *this == other );
+    }
+};
+
+// Why an arbiter found no candidate, counted once per
+// VC each time Arbitrate returns DO_NOTHING
+struct TocinoArbiterStallCounts
+{
+    uint32_t allocatedQueueIsEmpty;
+    uint32_t allocatedQueueNotEmptyButXOFF;
+    uint32_t unallocatedButAllQueuesEmpty;
+    uint32_t unallocatedButAllNonEmptyQueuesAreXOFF;
+
+    TocinoArbiterStallCounts()
+        : allocatedQueueIsEmpty( 0 )
+        , allocatedQueueNotEmptyButXOFF( 0 )
+        , unallocatedButAllQueuesEmpty( 0 )
+        , unallocatedButAllNonEmptyQueuesAreXOFF( 0 )
+    {}
+};
+
+struct TocinoArbiter : public Object
+{
+    static TypeId GetTypeId( void );
+
+    // ISSUE-REVIEW:
+    // There is way too much stuff in this interface.
+    // We're pretty much adding pure-virtuals here just
+    // to use them later without a dynamic downcast.
+    //
+    // All we really need is Arbitrate, and maybe Initialize
+    // The other stuff should only be in derived classes
+    // which support those functions.
+    //  -MAS
+    
+    virtual TocinoArbiterAllocation Arbitrate() = 0;
+
+    virtual void Initialize( const TocinoNetDevice*, const TocinoTx* ) = 0;
+
+    virtual TocinoArbiterAllocation GetVCOwner( const TocinoOutputVC ) const = 0;
+
+    virtual void ReportStatistics() const = 0;
+
+    virtual TocinoArbiterStallCounts GetStallCounts() const = 0;
+
+    // Notifications from TocinoTx, for arbiters which
+    // track queue and XON/XOFF state incrementally rather
+    // than polling it on every call to Arbitrate.
+    virtual void FlitEnqueued( const TocinoInputPort, const TocinoOutputVC ) {}
+    virtual void FlitDequeued( const TocinoInputPort, const TocinoOutputVC ) {}
+    virtual void XStateChanged( const TocinoFlowControlState& ) {}
+
+    static const TocinoArbiterAllocation DO_NOTHING;
+};
+
+}
+#endif //__TOCINO_ARBITER_H__
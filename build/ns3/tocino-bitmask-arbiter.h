@@ -0,0 +1,96 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_BITMASK_ARBITER_H__
+#define __TOCINO_BITMASK_ARBITER_H__
+
+#include <stdint.h>
+
+#include "tocino-arbiter.h"
+
+namespace ns3
+{
+
+class TocinoNetDevice;
+
+// An arbiter which keeps its candidate set as bitmasks.
+//
+// Rather than polling every queue on every call to Arbitrate,
+// as TocinoSimpleArbiter does, we track which queues are
+// non-empty and which VCs are XON incrementally, via the
+// notifications from TocinoTx.  Winners are then chosen by bit
+// scans, rotated by either a round-robin pointer or a seeded
+// LFSR.  Arbitrate never allocates.
+//
+// Like TocinoSimpleArbiter, once a head flit wins an output VC
+// that VC is owned by its input port until the tail is sent.
+
+class TocinoBitmaskArbiter : public TocinoArbiter
+{
+    public:
+
+    static TypeId GetTypeId( void );
+
+    TocinoBitmaskArbiter();
+
+    TocinoArbiterAllocation Arbitrate();
+
+    void Initialize( const TocinoNetDevice*, const TocinoTx* );
+
+    TocinoArbiterAllocation GetVCOwner( const TocinoOutputVC ) const;
+
+    void ReportStatistics() const;
+
+    TocinoArbiterStallCounts GetStallCounts() const;
+
+    void FlitEnqueued( const TocinoInputPort, const TocinoOutputVC );
+    void FlitDequeued( const TocinoInputPort, const TocinoOutputVC );
+    void XStateChanged( const TocinoFlowControlState& );
+
+    enum Priority { ROUND_ROBIN, LFSR };
+
+    private:
+
+    uint32_t GetCandidateVCs() const;
+
+    uint32_t NextPriority( const uint32_t, const uint32_t );
+
+    static uint32_t SelectBit( const uint32_t, const uint32_t );
+
+    void CollectStallInfo();
+
+    void UpdateState( const TocinoArbiterAllocation );
+
+    const TocinoNetDevice* m_tnd;
+    const TocinoTx *m_ttx;
+
+    uint32_t m_nPorts;
+    uint32_t m_nVCs;
+
+    // Bit N set iff queue (inputPort=N, outputVC) is not empty
+    uint32_t m_readyPorts[ TOCINO_MAX_VCS ];
+
+    // Bit N set iff m_readyPorts[N] is not zero
+    uint32_t m_nonEmptyVCs;
+
+    // Bit N set iff outputVC=N is XON
+    uint32_t m_xonVCs;
+
+    // Bit N set iff outputVC=N is allocated to m_owner[N]
+    uint32_t m_ownedVCs;
+    uint32_t m_owner[ TOCINO_MAX_VCS ];
+
+    Priority m_priority;
+    uint32_t m_seed;
+
+    uint32_t m_lfsr;
+    uint32_t m_lastVC;
+    uint32_t m_lastPort[ TOCINO_MAX_VCS ];
+
+    // Statistics on stall conditions
+    uint32_t m_stallAllocatedQueueIsEmpty;
+    uint32_t m_stallAllocatedQueueNotEmptyButXOFF;
+    uint32_t m_stallUnallocatedButAllQueuesEmpty;
+    uint32_t m_stallUnallocatedButAllNonEmptyQueuesAreXOFF;
+};
+
+}
+#endif //__TOCINO_BITMASK_ARBITER_H__
@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_COLLECTIVE_APPLICATION_H__
+#define __TOCINO_COLLECTIVE_APPLICATION_H__
+
+#include <vector>
+#include <deque>
+#include <map>
+#include <limits>
+
+#include "ns3/ptr.h"
+#include "ns3/application.h"
+#include "ns3/net-device.h"
+#include "ns3/traced-callback.h"
+
+#include "tocino-net-device.h"
+
+namespace ns3
+{
+
+class NodeContainer;
+
+// One rank of an MPI-style collective, run over every
+// node of a NodeContainer, rank = index in the container.
+//
+// Each algorithm is compiled into a list of steps, each
+// sending at most one message and expecting at most one.
+// A step begins only once the previous step's sends have
+// been accepted by the NetDevice and its expected packets
+// have all arrived, so the data dependencies of the real
+// collective are honored.  Messages are cut into packets
+// of at most PacketSize bytes, and each packet carries its
+// step number in its first four bytes, so that packets
+// from a peer already a step ahead are not miscounted.
+//
+// The collective may be repeated; each repetition starts
+// locally as soon as the previous one is done.
+class TocinoCollectiveApplication : public Application
+{
+    public:
+
+    enum Algorithm
+    {
+        RING_ALLREDUCE,
+        RECURSIVE_DOUBLING_ALLREDUCE,
+        PAIRWISE_ALLTOALL,
+        BINOMIAL_BROADCAST
+    };
+
+    static TypeId GetTypeId();
+
+    TocinoCollectiveApplication();
+
+    void Initialize( const uint32_t, const NodeContainer* );
+
+    uint32_t GetStepCount() const;
+
+    uint32_t GetPacketsSent() const;
+    uint32_t GetPacketsReceived() const;
+
+    uint32_t GetIterationsCompleted() const;
+
+    // When this rank finished each repetition
+    const std::vector< Time >& GetFinishTimes() const;
+
+    // Time from the start of a repetition, or the end of
+    // the one before, until the last rank finished it
+    static Time GetCompletionTime(
+            const std::vector< Ptr<TocinoCollectiveApplication> >&,
+            const uint32_t );
+
+    // Signature of the Complete trace source: repetition,
+    // and the time this rank spent on it
+    typedef void (* CompleteCallback)( uint32_t, Time );
+
+    private:
+
+    static const uint32_t NO_PEER;
+
+    struct Step
+    {
+        uint32_t sendTo;
+        uint32_t sendBytes;
+        uint32_t receiveFrom;
+        uint32_t receiveBytes;
+
+        Step()
+            : sendTo( NO_PEER )
+            , sendBytes( 0 )
+            , receiveFrom( NO_PEER )
+            , receiveBytes( 0 )
+        {}
+    };
+
+    void BuildSchedule();
+
+    uint32_t GetPacketCount( const uint32_t ) const;
+
+    void StartStep();
+    void TryAdvance();
+
+    void TrySendPending();
+
+    // NetDevice ready callback, following a refused send
+    void DeviceReady( Ptr<NetDevice> );
+
+    void StartApplication();
+    void StopApplication();
+
+    bool AcceptPacket(
+            Ptr<NetDevice>,
+            Ptr<const Packet>,
+            uint16_t,
+            const Address& );
+
+    Algorithm m_algorithm;
+    uint32_t m_messageSize;
+    uint32_t m_packetSize;
+    uint32_t m_iterations;
+    uint32_t m_root;
+
+    uint32_t m_rank;
+    uint32_t m_ranks;
+
+    std::vector< Step > m_schedule;
+
+    // Current position, counting steps across repetitions
+    uint32_t m_iteration;
+    uint32_t m_step;
+    bool m_running;
+
+    Time m_startTime;
+    Time m_iterationStart;
+    std::vector< Time > m_finishTimes;
+
+    // Packets of the current step not yet accepted
+    std::deque< Ptr<Packet> > m_pendingPackets;
+    Address m_pendingDestAddress;
+
+    // Packets received, by global step number
+    std::map< uint32_t, uint32_t > m_received;
+
+    uint32_t m_packetsSent;
+    uint32_t m_packetsReceived;
+
+    Ptr<TocinoNetDevice> m_netDevice;
+    const NodeContainer* m_nodeContainer;
+
+    TracedCallback< uint32_t, Time > m_completeTrace;
+};
+
+}
+
+#endif // __TOCINO_COLLECTIVE_APPLICATION_H__
@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_DIMENSION_ORDER_ROUTER_H__
+#define __TOCINO_DIMENSION_ORDER_ROUTER_H__
+
+#include <vector>
+#include <string>
+
+#include "ns3/simple-ref-count.h"
+
+#include "tocino-router.h"
+#include "tocino-net-device.h"
+#include "tocino-address.h"
+#include "tocino-misc.h"
+
+namespace ns3
+{
+
+class TocinoDimensionOrderRouter : public TocinoRouter
+{
+    public:
+
+    static TypeId GetTypeId( void );
+
+    TocinoDimensionOrderRouter();
+
+    void Initialize( const TocinoNetDevice*, const TocinoInputPort );
+
+    TocinoRoute Route( const TocinoFlit& ) const;
+
+    // Same wrap-around radix in every dimension
+    void EnableWrapAround( uint32_t );
+
+    // Comma-separated radix per dimension, X first,
+    // e.g. "8,8,0" - zero means no wrap-around
+    void SetWrapAroundRadices( std::string );
+
+    // Comma-separated extent of each dimension, X first,
+    // e.g. "8,8,4".  When set, routes to every destination
+    // are compiled into a table on first use.  Not done in
+    // Initialize, since the device has no address yet.
+    void SetLookupTableRadices( std::string );
+
+    // Bytes of lookup table owned by this router
+    uint32_t GetLookupTableBytes() const;
+
+    // Bytes of lookup table owned by all routers
+    static uint64_t GetTotalLookupTableBytes();
+    
+    protected:
+
+    // Parse a comma-separated radix per dimension, X first;
+    // unmentioned dimensions get zero
+    static void ParseRadices( const std::string&, uint32_t* );
+
+    bool TopologyHasWrapAround() const;
+    bool TopologyHasWrapAround( const TocinoDimension ) const;
+
+    // Zero if the dimension does not wrap
+    uint32_t GetWrapAroundRadix( const TocinoDimension ) const;
+
+    TocinoDirection DetermineRoutingDirection(
+            const TocinoAddress::Coordinate, 
+            const TocinoAddress::Coordinate,
+            const TocinoDimension ) const;
+
+    bool RouteCrossesDateline(
+            const TocinoAddress::Coordinate,
+            const TocinoDirection,
+            const TocinoDimension ) const;
+
+    const TocinoNetDevice* m_tnd;
+    TocinoInputPort m_inputPort;
+
+    private:
+
+    bool m_wrap;
+
+    // per-dimension, zero if that dimension does not wrap
+    uint32_t m_radix[TOCINO_MAX_DIMENSIONS];
+
+    bool m_outOfOrderOK;
+
+    // A compiled route is the output port, plus a flag
+    // if the hop crosses the dateline
+    static const uint8_t LOOKUP_PORT_MASK = 0x7F;
+    static const uint8_t LOOKUP_DATELINE = 0x80;
+
+    struct LookupTable : public SimpleRefCount< LookupTable >
+    {
+        ~LookupTable();
+
+        uint32_t GetBytes() const;
+        
+        // indexed by destination, X varying fastest
+        std::vector< uint8_t > entries;
+    };
+
+    uint8_t LookupRoute( const TocinoAddress& ) const;
+    void CompileLookupTable() const;
+
+    uint32_t m_lookupTableRadix[TOCINO_MAX_DIMENSIONS];
+    uint32_t m_lookupTableNodes; // zero if no table
+    bool m_shareLookupTable;
+    
+    // compiled lazily, hence mutable
+    mutable Ptr< LookupTable > m_lookupTable;
+    
+    static uint64_t s_totalLookupTableBytes;
+};
+
+}
+
+#endif //__TOCINO_DIMENSION_ORDER_ROUTER_H__
@@ -0,0 +1,98 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_FLOW_CONTROL_H__
+#define __TOCINO_FLOW_CONTROL_H__
+
+#include <bitset>
+#include <stdint.h>
+
+#include "ns3/assert.h"
+#include "ns3/ptr.h"
+
+#include "tocino-misc.h"
+
+namespace ns3
+{
+
+class Packet;
+class TocinoFlit;
+
+typedef std::bitset<TOCINO_MAX_VCS> TocinoVCBitSet;
+typedef TocinoVCBitSet TocinoFlowControlState;
+
+Ptr<Packet> GetTocinoFlowControlFlit( const TocinoFlowControlState& );
+bool IsTocinoFlowControlFlit( Ptr<const Packet> );
+TocinoFlowControlState GetTocinoFlowControlState( Ptr<const Packet> );
+
+// Returns a shared, prebuilt LLC flit carrying the given state.
+//
+// LLC flits are never modified in flight, so one flit per
+// distinct state is built on first use and then reused by
+// every transmitter.  This keeps link-level flow control off
+// the heap entirely.
+const TocinoFlit& GetPooledTocinoFlowControlFlit( const TocinoFlowControlState& );
+
+const TocinoFlowControlState TocinoAllXON( ~0 );
+const TocinoFlowControlState TocinoAllXOFF( 0 );
+
+// Credits returned on each VC, as carried by a credit flit.
+//
+// Four bits per VC, so a credit flit is no bigger than an
+// XON/XOFF flit, but a receiver may return at most
+// MAX_CREDITS at once on any one VC.
+class TocinoCredits
+{
+    public:
+
+    static const uint32_t MAX_CREDITS = 15;
+
+    TocinoCredits()
+        : m_packed( 0 )
+    {}
+
+    explicit TocinoCredits( const uint64_t packed )
+        : m_packed( packed )
+    {}
+
+    uint32_t Get( const uint32_t vc ) const
+    {
+        NS_ASSERT( vc < TOCINO_MAX_VCS );
+        return ( m_packed >> ( vc * BITS_PER_VC ) ) & MAX_CREDITS;
+    }
+
+    void Add( const uint32_t vc )
+    {
+        NS_ASSERT( Get( vc ) < MAX_CREDITS );
+        m_packed += static_cast<uint64_t>( 1 ) << ( vc * BITS_PER_VC );
+    }
+
+    bool Any() const
+    {
+        return m_packed != 0;
+    }
+
+    void Clear()
+    {
+        m_packed = 0;
+    }
+
+    uint64_t GetPacked() const
+    {
+        return m_packed;
+    }
+
+    private:
+
+    static const uint32_t BITS_PER_VC = 4;
+
+    uint64_t m_packed;
+};
+
+Ptr<Packet> GetTocinoCreditFlit( const TocinoCredits& );
+bool IsTocinoCreditFlit( Ptr<const Packet> );
+TocinoCredits GetTocinoCredits( Ptr<const Packet> );
+
+// As GetPooledTocinoFlowControlFlit, but for credit flits
+const TocinoFlit& GetPooledTocinoCreditFlit( const TocinoCredits& );
+}
+
+#endif // __TOCINO_FLOW_CONTROL_H__
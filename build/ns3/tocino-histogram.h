@@ -0,0 +1,65 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_HISTOGRAM_H__
+#define __TOCINO_HISTOGRAM_H__
+
+#include <stdint.h>
+#include <ostream>
+#include <vector>
+
+namespace ns3
+{
+
+// A histogram of non-negative integers with logarithmic
+// buckets.  Values below 64 are counted exactly; beyond
+// that, each power of two is split into 32 buckets, so a
+// reported percentile is within about 3% of the truth.
+//
+// N.B.
+// Memory is a few hundred counters at most, however many
+// values are added, which is what lets us keep one per
+// node, or per flow, for the whole run.
+class TocinoHistogram
+{
+    public:
+
+    TocinoHistogram();
+
+    void Add( const uint64_t );
+    void Merge( const TocinoHistogram& );
+    void Reset();
+
+    uint64_t GetCount() const;
+    uint64_t GetMin() const;
+    uint64_t GetMax() const;
+    double GetMean() const;
+
+    // Upper bound of the bucket holding the given
+    // quantile, in [0,1], clipped to the largest value
+    uint64_t GetPercentile( const double ) const;
+
+    // count,min,mean,p50,p99,p999,max
+    void PrintSummary( std::ostream& ) const;
+    static void PrintSummaryHeader( std::ostream& );
+
+    private:
+
+    static const uint32_t SUB_BUCKET_BITS = 5;
+    static const uint32_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+
+    static uint32_t GetBucket( const uint64_t );
+    static uint64_t GetBucketHigh( const uint32_t );
+
+    // grown on demand, up to the largest bucket used
+    std::vector< uint64_t > m_buckets;
+
+    uint64_t m_count;
+    uint64_t m_min;
+    uint64_t m_max;
+
+    // double, since sums of nanoseconds overflow
+    double m_sum;
+};
+
+}
+
+#endif // __TOCINO_HISTOGRAM_H__
@@ -0,0 +1,49 @@
+
+#ifdef NS3_MODULE_COMPILATION
+# error "Do not include ns3 module aggregator headers from other modules; these are meant only for end user scripts."
+#endif
+
+#ifndef NS3_MODULE_TOCINO
+    
+
+// Module headers:
+#include "all2all.h"
+#include "callback-queue.h"
+#include "tocino-3d-torus-topology-helper.h"
+#include "tocino-adaptive-router.h"
+#include "tocino-address.h"
+#include "tocino-arbiter.h"
+#include "tocino-bitmask-arbiter.h"
+#include "tocino-channel.h"
+#include "tocino-collective-application.h"
+#include "tocino-crossbar.h"
+#include "tocino-dimension-order-router.h"
+#include "tocino-flit-header.h"
+#include "tocino-flit-id-tag.h"
+#include "tocino-flit.h"
+#include "tocino-flow-control.h"
+#include "tocino-helper.h"
+#include "tocino-histogram.h"
+#include "tocino-link-sampler.h"
+#include "tocino-misc.h"
+#include "tocino-net-device.h"
+#include "tocino-placement.h"
+#include "tocino-queue.h"
+#include "tocino-remote-channel.h"
+#include "tocino-router.h"
+#include "tocino-routing-table.h"
+#include "tocino-rx.h"
+#include "tocino-simple-arbiter.h"
+#include "tocino-stats-collector.h"
+#include "tocino-test-results.h"
+#include "tocino-torus-topology-helper.h"
+#include "tocino-trace-replay-application.h"
+#include "tocino-trace.h"
+#include "tocino-traffic-class-tag.h"
+#include "tocino-traffic-matrix-application.h"
+#include "tocino-traffic-patterns.h"
+#include "tocino-tx.h"
+#include "tocino-type-safe-uint32.h"
+#include "tocino-valiant-router.h"
+#include "tocino-vc-allocator.h"
+#endif
@@ -0,0 +1,344 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_NET_DEVICE_H__
+#define __TOCINO_NET_DEVICE_H__
+
+#include <map>
+#include <ostream>
+#include <string>
+
+#include "ns3/net-device.h"
+#include "ns3/traced-value.h"
+#include "ns3/traced-callback.h"
+#include "ns3/nstime.h"
+
+#include "tocino-address.h"
+#include "tocino-flit.h"
+#include "tocino-flit-header.h"
+#include "tocino-histogram.h"
+#include "tocino-misc.h"
+#include "tocino-vc-allocator.h"
+
+namespace ns3
+{
+
+class Node;
+class TocinoChannel;
+class TocinoTx;
+class TocinoRx;
+class CallbackQueue;
+class Queue;
+
+class TestEjectFlit;
+
+class TocinoNetDevice : public NetDevice
+{
+public:
+    static TypeId GetTypeId( void );
+
+    // Invoked when a send previously refused for lack of
+    // injection queue space may now succeed
+    typedef Callback< void, Ptr<NetDevice> > ReadyCallback;
+
+    // Signature of the PacketLatency trace source: the
+    // source of a packet just ejected, its latency since
+    // Send, its hop count and its total queueing delay
+    typedef void (* PacketLatencyCallback)(
+            const TocinoAddress&, Time, uint32_t, Time );
+
+    typedef std::map< TocinoAddress, TocinoHistogram > SourceHistograms;
+
+    // Link-level flow control.  Under XON/XOFF a receiver
+    // pauses its neighbor when an input queue is almost
+    // full, so every input queue holds back a reserve
+    // sized by TocinoChannel::FlitBuffersRequired.  Under
+    // CREDIT a transmitter counts the free buffers of each
+    // downstream input queue instead, and needs no reserve.
+    // Both ends of a link must agree.
+    enum FlowControl
+    {
+        XON_XOFF,
+        CREDIT
+    };
+
+    // How each TocinoRx picks which input VC to forward
+    // from next, among those whose head flit may move.
+    // LOWEST_VC always favors the lowest, and so may
+    // starve the dateline VCs under load.  CLASS_PRIORITY
+    // favors the highest traffic class (see
+    // TocinoVCAllocator), and is round-robin within one.
+    enum InputVCSelection
+    {
+        LOWEST_VC,
+        ROUND_ROBIN_VC,
+        OLDEST_FIRST,
+        CLASS_PRIORITY
+    };
+    
+    TocinoNetDevice();
+    void Initialize();
+    
+    virtual ~TocinoNetDevice();
+    virtual void DoDispose();
+
+    virtual void SetIfIndex( const uint32_t index );
+    virtual uint32_t GetIfIndex( void ) const;
+    virtual Ptr<Channel> GetChannel( void ) const;
+    virtual bool SetMtu( const uint16_t mtu );
+    virtual uint16_t GetMtu( void ) const;
+    virtual void SetAddress( Address address );
+    virtual Address GetAddress( void ) const;
+    virtual bool IsLinkUp( void ) const;
+    virtual void AddLinkChangeCallback( Callback<void> callback );
+    virtual bool IsBroadcast( void ) const;
+    virtual Address GetBroadcast( void ) const;
+    virtual bool IsMulticast( void ) const;
+    virtual Address GetMulticast( Ipv4Address a ) const;
+    virtual Address GetMulticast( Ipv6Address a ) const;
+    virtual bool IsPointToPoint( void ) const;
+    virtual bool IsBridge( void ) const;
+    
+    virtual bool Send( 
+            Ptr<Packet> packet,
+            const Address& dest,
+            uint16_t protocolNumber );
+    
+    virtual bool SendFrom(
+            Ptr<Packet> packet,
+            const Address& source,
+            const Address& dest,
+            uint16_t protocolNumber );
+
+    virtual bool SendVia(
+            Ptr<Packet> packet,
+            const Address& dest,
+            const Address& intermediate,
+            uint16_t protocolNumber );
+
+    virtual Ptr<Node> GetNode( void ) const;
+    virtual void SetNode( Ptr<Node> node );
+    virtual bool NeedsArp( void ) const;
+    virtual void SetReceiveCallback( NetDevice::ReceiveCallback cb );
+    virtual void SetPromiscReceiveCallback( PromiscReceiveCallback cb );
+    virtual bool SupportsSendFrom( void ) const;
+
+    // Invoked, for each sender sharing this device, when
+    // a refused packet may be retried
+    void AddReadyCallback( ReadyCallback cb );
+    
+    void SetChannel( uint32_t, Ptr<TocinoChannel> );
+    Ptr<TocinoChannel> GetChannel( uint32_t );
+
+    TocinoAddress GetTocinoAddress( void ) const;
+
+    TocinoRx* GetReceiver( const TocinoInputPort ) const;
+    TocinoTx* GetTransmitter( const TocinoOutputPort ) const;
+   
+    uint32_t GetNPorts() const;
+    void SetNPorts( uint32_t );
+
+    uint32_t GetNVCs() const;
+    void SetNVCs( uint32_t );
+
+    // Get the injection/ejection port
+    uint32_t GetHostPort() const;
+
+    TocinoFlittizedPacket Flitter(
+            const Ptr<Packet>,
+            const TocinoAddress&,
+            const TocinoAddress&,
+            const TocinoInputVC,
+            const TocinoFlitHeader::Type );
+
+    // As Flitter, but produces lightweight flits which
+    // refer to the packet rather than copying from it
+    TocinoFlitQueue LightweightFlitter(
+            const Ptr<Packet>,
+            const TocinoAddress&,
+            const TocinoAddress&,
+            const TocinoInputVC,
+            const TocinoFlitHeader::Type );
+   
+    bool AllQuiet() const;
+    void DumpState() const;
+    void ReportStatistics() const;
+
+    // Over packets ejected here, in nanoseconds, except
+    // hop count.  Hop queueing is the mean queueing delay
+    // per router traversed, source and destination included.
+    const TocinoHistogram& GetLatencyHistogram() const;
+    const TocinoHistogram& GetHopCountHistogram() const;
+    const TocinoHistogram& GetHopQueueingHistogram() const;
+
+    // Latency by source, empty unless PerSourceLatency
+    const SourceHistograms& GetSourceLatencyHistograms() const;
+
+    // Discard latency and input VC wait statistics,
+    // e.g. after warm-up
+    void ResetLatencyStatistics();
+
+    // One comma-separated line per histogram, after
+    // those of ReportLatencyHeader
+    void ReportLatency( std::ostream& ) const;
+    static void ReportLatencyHeader( std::ostream& );
+
+    // Attempt to send m_currentFlits
+    void TrySendFlits();
+
+    // called by TocinoTx to eject a flit
+    void EjectFlit( const TocinoFlit& );
+
+    // Deferred work.  Rather than calling these functions
+    // directly (and reentrantly), TocinoRx and TocinoTx mark
+    // them pending here.  All pending work is drained by a
+    // single event at the current time.
+    void ScheduleTryForwardFlit( const TocinoInputPort );
+    void ScheduleTransmitEnd( const TocinoOutputPort );
+    void ScheduleTrySendFlits();
+
+    const TypeId& GetRouterTypeId() const;
+    const TypeId& GetArbiterTypeId() const;
+
+    FlowControl GetFlowControl() const;
+
+    // Depth of each input queue, per VC
+    uint32_t GetInputQueueFlits() const;
+
+    const TocinoVCAllocator& GetVCAllocator() const;
+
+    InputVCSelection GetInputVCSelection() const;
+
+    // Nanoseconds flits of an input VC waited in input
+    // queues, over every port but the host port
+    TocinoHistogram GetInputVCWaitHistogram( const TocinoInputVC ) const;
+
+    bool GetExpressTransmit() const;
+
+    // Express mode.  A transmitter sending a run of flits
+    // ahead (see TocinoTx::StartRun) registers here.  Every
+    // event on this device first brings such runs up to
+    // date; an event receiving on the input port that feeds
+    // a run also stops it, as the transmitter would have
+    // given that port a chance to forward at each flit.
+    void SetExpressRun( const TocinoOutputPort, const bool );
+    void CatchUpExpressRuns( const TocinoInputPort );
+
+private:
+    // disable copy and copy-assignment
+    TocinoNetDevice& operator=( const TocinoNetDevice& );
+    TocinoNetDevice( const TocinoNetDevice& );
+    
+    // Omnibus send function from which all others are implemented
+    bool SendEx( Ptr<Packet>, 
+            const TocinoAddress&,
+            const TocinoAddress&,
+            const TocinoAddress&,
+            uint16_t );
+
+    // Number of flits SendEx will queue for a packet
+    uint32_t GetFlitCount( const Ptr<const Packet>, const bool ) const;
+
+    void InjectFlit( const TocinoFlit& ) const; // send one flit
+
+    void EjectLightweightFlit( const TocinoFlit& );
+
+    // Record statistics for a packet, given its head flit
+    void RecordLatency( const TocinoFlitStamp&, const TocinoAddress& );
+
+    // Deferred work, in the order it was marked
+    struct PendingWork
+    {
+        enum Kind { TRY_FORWARD_FLIT, TRANSMIT_END, TRY_SEND_FLITS } kind;
+        uint32_t port;
+
+        PendingWork( const Kind k, const uint32_t p )
+            : kind( k )
+            , port( p )
+        {}
+    };
+
+    void ScheduleWork( const PendingWork );
+    void DoPendingWork();
+    void DoWork( const PendingWork );
+    void RunWork( const PendingWork );
+
+    Ptr<Node> m_node;
+    uint32_t m_ifIndex;
+        
+    static const uint16_t DEFAULT_MTU = 1500;
+    uint32_t m_mtu;
+    
+    TocinoAddress m_address;
+
+    // current flits to be sent (per-VC)
+    std::vector< TocinoFlitQueue > m_outgoingFlits;
+
+    // per-VC limit on m_outgoingFlits, zero is unlimited
+    uint32_t m_injectionQueueMaxFlits;
+
+    TracedValue< uint32_t > m_outgoingFlitsMaxSize;
+
+    // set when SendEx refuses a packet, cleared when
+    // m_readyCallbacks are invoked
+    bool m_injectionBlocked;
+    std::vector< ReadyCallback > m_readyCallbacks;
+    uint32_t m_nextReadyCallback;
+    
+    // state for EjectFlit (per-VC)
+    std::vector< Ptr<Packet> > m_incomingPackets;
+    std::vector< TocinoAddress > m_incomingSources;
+    std::vector< TocinoFlitStamp > m_incomingStamps;
+
+    TocinoHistogram m_latencyHistogram;
+    TocinoHistogram m_hopCountHistogram;
+    TocinoHistogram m_hopQueueingHistogram;
+    
+    bool m_perSourceLatency;
+    SourceHistograms m_sourceLatencyHistograms;
+
+    TracedCallback< const TocinoAddress&, Time, uint32_t, Time >
+        m_packetLatencyTrace;
+ 
+    NetDevice::ReceiveCallback m_rxCallback;
+    NetDevice::PromiscReceiveCallback m_promiscRxCallback;
+    
+    static const uint32_t DEFAULT_NPORTS = 7;
+    static const uint32_t DEFAULT_NVCS = 4;
+
+    uint32_t m_nPorts; // port count must include injection/ejection port
+    uint32_t m_nVCs; // number of virtual channels on each port
+
+    std::vector< TocinoTx* > m_transmitters;
+    std::vector< TocinoRx* > m_receivers;
+    
+    TypeId m_routerTypeId;
+    TypeId m_arbiterTypeId;
+
+    FlowControl m_flowControl;
+    uint32_t m_inputQueueFlits;
+
+    std::string m_vcClasses;
+    TocinoVCAllocator m_vcAllocator;
+
+    InputVCSelection m_inputVCSelection;
+
+    bool m_roundRobinVCInject;
+    bool m_lightweightFlits;
+    bool m_expressTransmit;
+    bool m_coalesceWork;
+    uint32_t m_packetCounter;
+
+    // Work marked since DoPendingWork was last scheduled,
+    // and the work it is running now
+    std::vector< PendingWork > m_pendingWork;
+    std::vector< PendingWork > m_runningWork;
+
+    // Outstanding DoWork events, if not coalesced
+    uint32_t m_workEvents;
+
+    // Transmitters with a run in progress, by port number
+    uint32_t m_expressRuns;
+};
+
+} // namespace ns3
+
+#endif // __TOCINO_NET_DEVICE_H__
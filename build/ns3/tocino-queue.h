@@ -0,0 +1,249 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_QUEUE_H__
+#define __TOCINO_QUEUE_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/assert.h"
+
+namespace ns3
+{
+
+// Ring storage for TocinoQueue: inline, for a fixed
+// CAPACITY which must be a power of two, ...
+template< typename T, uint32_t CAPACITY >
+class TocinoQueueRing
+{
+    private:
+
+    // Poor man's static assertion
+    typedef char CapacityMustBePowerOfTwo[
+        ( CAPACITY & ( CAPACITY - 1 ) ) == 0 ? 1 : -1 ];
+
+    T m_ring[ CAPACITY ];
+
+    public:
+
+    uint32_t GetCapacity() const
+    {
+        return CAPACITY;
+    }
+
+    void Reserve( uint32_t depth )
+    {
+        NS_ASSERT( depth <= CAPACITY );
+    }
+
+    T& operator[]( uint32_t idx )
+    {
+        return m_ring[ idx & ( CAPACITY - 1 ) ];
+    }
+
+    const T& operator[]( uint32_t idx ) const
+    {
+        return m_ring[ idx & ( CAPACITY - 1 ) ];
+    }
+};
+
+// ... or, for a CAPACITY of zero, on the heap, grown
+// to the next power of two by SetMaxDepth()
+template< typename T >
+class TocinoQueueRing< T, 0 >
+{
+    private:
+
+    std::vector< T > m_ring;
+    uint32_t m_mask;
+
+    public:
+
+    TocinoQueueRing()
+        : m_mask( 0 )
+    {}
+
+    uint32_t GetCapacity() const
+    {
+        return m_ring.size();
+    }
+
+    // Only called while empty
+    void Reserve( uint32_t depth )
+    {
+        uint32_t capacity = 1;
+
+        while( capacity < depth )
+        {
+            capacity <<= 1;
+        }
+
+        if( capacity > m_ring.size() )
+        {
+            m_ring.assign( capacity, T() );
+            m_mask = capacity - 1;
+        }
+    }
+
+    T& operator[]( uint32_t idx )
+    {
+        return m_ring[ idx & m_mask ];
+    }
+
+    const T& operator[]( uint32_t idx ) const
+    {
+        return m_ring[ idx & m_mask ];
+    }
+};
+
+// A queue with IsAlmostFull().
+//
+// We do not inherit from the abstract base class
+// ns3::Queue, because that would constrain what
+// can be held in our queue.  The prototype for
+// Dequeue must return a Ptr<Packet>, for example.
+//
+// We do not inherit from Object, because the ns3
+// attribute system seems incompatible with class
+// templates.
+//
+// The queue is a ring buffer held inline, so a
+// vector of queues is one contiguous slab and
+// Enqueue/Dequeue never touch the heap.  CAPACITY
+// must be a power of two; SetMaxDepth() may further
+// limit the usable depth at run time.  A CAPACITY
+// of zero instead sizes the ring at run time, by
+// SetMaxDepth(), which allocates.  T must be
+// default-constructible.
+
+template< typename T, uint32_t CAPACITY = 8 >
+class TocinoQueue 
+{
+    private:
+
+    uint32_t m_maxDepth;
+    uint32_t m_reserve;
+
+    uint32_t m_head;
+    uint32_t m_size;
+
+    TocinoQueueRing< T, CAPACITY > m_ring;
+    
+    public:
+
+    typedef T value_type;
+    typedef const T& const_reference;
+    
+    static const uint32_t DEFAULT_MAX_DEPTH = CAPACITY;
+    static const uint32_t DEFAULT_RESERVE = 0;
+  
+    TocinoQueue()
+        : m_maxDepth( DEFAULT_MAX_DEPTH )
+        , m_reserve( DEFAULT_RESERVE )
+        , m_head( 0 )
+        , m_size( 0 )
+    {}
+
+    void SetMaxDepth( uint32_t depth )
+    {
+        NS_ASSERT( depth >= m_size );
+
+        if( depth > m_ring.GetCapacity() )
+        {
+            NS_ASSERT( IsEmpty() );
+            m_ring.Reserve( depth );
+            m_head = 0;
+        }
+
+        m_maxDepth = depth;
+    }
+
+    void SetReserve( uint32_t reserve )
+    {
+        NS_ASSERT( reserve < m_maxDepth );
+        m_reserve = reserve;
+    }
+
+    bool IsFull() const
+    {
+        return m_size == m_maxDepth;
+    }
+
+    bool IsEmpty() const
+    {
+        return m_size == 0;
+    }
+
+    uint32_t Size() const
+    {
+        return m_size;
+    }
+
+    private:
+
+    uint32_t RemainingEntries() const
+    {
+        return m_maxDepth - m_size;
+    }
+
+    public:
+
+    bool IsAlmostFull() const
+    {
+        if( RemainingEntries() > m_reserve )
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    void Enqueue( const T& v )
+    {
+        NS_ASSERT( !IsFull() );
+
+        m_ring[ m_head + m_size ] = v;
+        m_size++;
+    }
+
+    value_type Dequeue()
+    {
+        NS_ASSERT( !IsEmpty() );
+
+        value_type v = m_ring[ m_head ];
+
+        // Don't let the slot keep its contents alive
+        // (e.g. a Ptr<Packet>) until it is overwritten
+        m_ring[ m_head ] = value_type();
+
+        m_head = ( m_head + 1 ) & ( m_ring.GetCapacity() - 1 );
+        m_size--;
+
+        return v;
+    }
+
+    const_reference PeekFront() const
+    {
+        NS_ASSERT( !IsEmpty() );
+
+        return m_ring[ m_head ];
+    }
+
+    T& Front()
+    {
+        NS_ASSERT( !IsEmpty() );
+
+        return m_ring[ m_head ];
+    }
+    
+    const_reference At( uint32_t idx ) const
+    {
+        NS_ASSERT( idx < m_size );
+
+        return m_ring[ m_head + idx ];
+    }
+};
+
+}
+
+#endif // __TOCINO_QUEUE_H__
+
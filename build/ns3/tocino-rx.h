@@ -0,0 +1,222 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_RX_H__
+#define __TOCINO_RX_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+
+#include "tocino-crossbar.h"
+#include "tocino-flit.h"
+#include "tocino-flow-control.h"
+#include "tocino-histogram.h"
+#include "tocino-queue.h"
+#include "tocino-router.h"
+#include "tocino-routing-table.h"
+
+namespace ns3
+{
+
+class NetDevice;
+class TocinoChannel;
+class TocinoTx;
+
+class TocinoRx
+{
+    public:
+
+    // Default flits each input queue may hold, per VC;
+    // see the InputQueueFlits attribute of TocinoNetDevice
+    static const uint32_t DEFAULT_INPUT_QUEUE_FLITS = 8;
+
+    TocinoRx( const TocinoInputPort, TocinoNetDevice* );
+
+    uint32_t GetPortNumber() const;
+
+    Ptr<NetDevice> GetNetDevice();
+    Ptr<TocinoNetDevice> GetTocinoNetDevice();
+    
+    void SetChannel( Ptr<TocinoChannel> channel );
+    Ptr<TocinoChannel> GetChannel() const;
+
+    // The transmitter feeding us over a local channel,
+    // told of each input buffer we free under XON/XOFF
+    // flow control (TocinoTx::IsVCIdle)
+    void SetUpstream( TocinoTx* );
+
+    bool IsVCBlocked( const TocinoInputVC ) const;
+
+    Ptr<TocinoRouter> GetRouter() const;
+
+    void Receive( TocinoFlit );
+    
+    void TryForwardFlit();
+
+    // Could a flit take this route through the crossbar now?
+    bool CanForward( const TocinoRoute& ) const;
+
+    // Any flits waiting to be forwarded?
+    bool HasQueuedFlits() const;
+
+    bool AllQuiet() const;
+    void DumpState() const;
+
+    // Nanoseconds flits of an input VC waited in its
+    // queue, from arrival until forwarded
+    const TocinoHistogram& GetWaitHistogram( const TocinoInputVC ) const;
+    void ResetWaitStatistics();
+
+    private:
+  
+    void AnnounceRoutingDecision(
+            const TocinoFlit&,
+            const TocinoRoute& ) const;
+
+    const TocinoRoute RouteHead( const TocinoFlit&, const bool ) const;
+
+    // Route each head at the front of a queue again,
+    // under an adaptive router
+    void RerouteHeads();
+
+    // Of the flit at the front of an input queue
+    TocinoRoute GetFrontRoute( const TocinoInputVC ) const;
+
+    bool DestinationReached( const TocinoFlit& ) const;
+
+    // N.B.
+    // Only a head flit's entry holds a route.  It is not
+    // final until the head is forwarded, which is when the
+    // route goes into m_routingTable for the flits behind.
+    struct InputQueueEntry
+    {
+        TocinoFlit flit;
+        TocinoRoute route;
+        Time arrived;
+
+        // The head of a Valiant packet's second leg
+        bool wasCloakedHead;
+
+        InputQueueEntry()
+            : wasCloakedHead( false )
+        {}
+
+        InputQueueEntry(
+                const TocinoFlit& f,
+                const TocinoRoute& r,
+                const Time t,
+                const bool c )
+            : flit( f )
+            , route( r )
+            , arrived( t )
+            , wasCloakedHead( c )
+        {}
+    };
+
+    // Sized at run time, by InputQueueFlits
+    typedef TocinoQueue< InputQueueEntry, 0 > InputQueue;
+
+    InputQueue& GetInputQueue( const TocinoInputVC );
+    const InputQueue& GetInputQueue( const TocinoInputVC ) const;
+    
+    void SetReserveFlits( uint32_t );
+
+    // Under credit flow control, a buffer of the given
+    // VC has been freed
+    void ReturnCredit( const TocinoInputVC );
+    
+    bool EnqueueHelper(
+            const InputQueueEntry&,  
+            const TocinoInputVC );
+    
+    // FIXME: Out parameters are ugly. Replace this with
+    // std::tuple and std::tie ASAP so we can return
+    // both the packet and the boolean at once.
+    const InputQueueEntry DequeueHelper( 
+            const TocinoInputVC,
+            bool& );
+    
+    void RewriteFlitHeaderVC(
+            TocinoFlit&,
+            const TocinoOutputVC ) const;
+   
+    TocinoInputVC FindForwardableVC() const;
+
+    bool IsForwardable( const uint32_t ) const;
+
+    // The first forwardable VC of a mask, scanning up
+    // from the given VC and wrapping around
+    TocinoInputVC FirstForwardableVC( const uint32_t, const uint32_t ) const;
+
+    TocinoInputVC OldestForwardableVC() const;
+    TocinoInputVC PriorityForwardableVC() const;
+       
+    static const TocinoInputVC NO_FORWARDABLE_VC;
+
+    const TocinoInputPort m_inputPort;
+
+    TocinoNetDevice* m_tnd;
+    Ptr<TocinoChannel> m_channel;
+
+    // corresponding transmitter
+    TocinoTx * const m_tx;
+
+    // neighbor's transmitter, or NULL; see SetUpstream
+    TocinoTx* m_upstream;
+   
+    Ptr<TocinoRouter> m_router;
+    TocinoRoutingTable m_routingTable;
+    TocinoCrossbar m_crossbar;
+
+    // Support for encapsulated packet type
+    std::vector<bool> m_cloakedHeadIsNext;
+
+    // Stamp of each discarded outer head, for the
+    // cloaked head which follows it
+    std::vector< TocinoFlitStamp > m_bouncedStamps;
+
+    // Bit N set iff the input queue of VC N is not empty
+    uint32_t m_nonEmptyVCs;
+
+    // Last VC forwarded, for round-robin selection
+    uint32_t m_lastVC;
+
+    std::vector< TocinoHistogram > m_waitHistograms;
+
+    // This nested class controls access to our
+    // primary state variable
+    class TocinoInputQueues
+    {
+        private:
+        
+        // The input queues are per input virtual channel.
+        // These are used mainly for correctness: to
+        // tolerate XOFF delay.
+        std::vector< InputQueue > vec;
+
+        public:
+     
+        // If you're thinking about adding another 
+        // friend function here, you're wrong. -MAS
+        
+        friend 
+            TocinoRx::TocinoRx(
+                const TocinoInputPort,
+                TocinoNetDevice* );
+        
+        friend InputQueue&
+            TocinoRx::GetInputQueue(
+                const TocinoInputVC ); 
+        
+        friend const InputQueue&
+            TocinoRx::GetInputQueue(
+                const TocinoInputVC ) const;
+    } 
+    m_inputQueues;
+
+};
+
+} // namespace ns3
+
+#endif // __TOCINO_RX_H__
@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_TORUS_TOPOLOGY_HELPER_H__
+#define __TOCINO_TORUS_TOPOLOGY_HELPER_H__
+
+#include <vector>
+#include <string>
+#include <ostream>
+
+#include "ns3/net-device-container.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+
+#include "ns3/tocino-address.h"
+#include "ns3/tocino-misc.h"
+
+namespace ns3
+{
+
+class TocinoChannel;
+class TocinoNetDevice;
+
+// N.B.
+// The standard ns3 NetDeviceContainer is not a generic
+// class, so we roll our own.  Devices are stored flat,
+// in index order, X varying fastest; see
+// TocinoAddressToIndex and IndexToTocinoAddress.  A flat
+// vector keeps setup of large tori cheap.
+typedef std::vector< Ptr< TocinoNetDevice > > TocinoTorusNetDeviceContainer;
+
+// A k1 x k2 x ... x kn torus, n <= TOCINO_MAX_DIMENSIONS.
+// Each dimension may independently omit its wrap-around
+// links, making it a mesh in that dimension.
+class TocinoTorusTopologyHelper
+{
+    public:
+
+    // One radix and one wrap flag per dimension, X first
+    TocinoTorusTopologyHelper(
+            const std::vector< uint32_t >&,
+            const std::vector< bool >& );
+
+    const uint32_t DIMENSIONS;
+    const uint32_t NODES;
+
+    uint32_t GetRadix( const TocinoDimension ) const;
+    bool HasWrapAround( const TocinoDimension ) const;
+
+    // In the form expected by the attribute
+    // ns3::TocinoDimensionOrderRouter::WrapAroundRadices
+    std::string GetWrapAroundRadices() const;
+
+    // In the form expected by the attribute
+    // ns3::TocinoDimensionOrderRouter::LookupTableRadices
+    std::string GetRadices() const;
+
+    uint32_t TocinoAddressToIndex( const TocinoAddress& ) const;
+    TocinoAddress IndexToTocinoAddress( uint32_t ) const;
+
+    TocinoTorusNetDeviceContainer Install( const NodeContainer& );
+
+    uint32_t Middle( const TocinoDimension ) const;
+
+    // Does the channel cross the plane cutting the given
+    // dimension in half?
+    bool CrossesBisection(
+            Ptr<TocinoChannel>,
+            const TocinoDimension ) const;
+
+    void ReportBisectionBandwidth(
+            const TocinoTorusNetDeviceContainer&,
+            const Time,
+            const TocinoDimension ) const;
+
+    // Latency statistics merged over all devices, as
+    // comma-separated lines; see TocinoNetDevice::ReportLatency.
+    // Optionally followed by those of each device.
+    void ReportLatency(
+            const TocinoTorusNetDeviceContainer&,
+            std::ostream&,
+            const bool ) const;
+
+    // Partitioning for distributed simulation under MPI.
+    // The torus is cut into contiguous slabs along X.
+    uint32_t GetSlab( const TocinoAddress&, const uint32_t ) const;
+
+    // Create NODES nodes, in index order, each with its
+    // slab as system id, ready for Install under MPI
+    NodeContainer CreateNodes( const uint32_t ) const;
+
+    // Least lookahead over channels which join two slabs
+    Time GetSlabLookahead(
+            const TocinoTorusNetDeviceContainer&,
+            const uint32_t ) const;
+
+    private:
+
+    static uint32_t CountNodes( const std::vector< uint32_t >& );
+
+    uint32_t GetCoordinate( const uint32_t, const TocinoDimension ) const;
+
+    // Index of the neighbor of a node, one hop away in
+    // the given dimension and direction, wrapping
+    uint32_t GetNeighbor(
+            const uint32_t,
+            const TocinoDimension,
+            const TocinoDirection ) const;
+
+    std::vector< uint32_t > m_radix;
+    std::vector< bool > m_wrap;
+
+    // index distance between neighbors, per-dimension
+    std::vector< uint32_t > m_stride;
+};
+
+}
+
+#endif // __TOCINO_TORUS_TOPOLOGY_HELPER_H__
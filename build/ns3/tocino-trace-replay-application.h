@@ -0,0 +1,127 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_TRACE_REPLAY_APPLICATION_H__
+#define __TOCINO_TRACE_REPLAY_APPLICATION_H__
+
+#include <vector>
+#include <deque>
+#include <map>
+#include <string>
+
+#include "ns3/ptr.h"
+#include "ns3/application.h"
+#include "ns3/net-device.h"
+#include "ns3/event-id.h"
+#include "ns3/traced-callback.h"
+
+#include "tocino-net-device.h"
+#include "tocino-trace.h"
+#include "tocino-placement.h"
+
+namespace ns3
+{
+
+class NodeContainer;
+
+// Replays one rank of a recorded MPI trace; see
+// tocino-trace.h for the format.
+//
+// Records are executed in order.  A send completes once
+// all of its packets have been accepted by the NetDevice,
+// as an eager MPI send would.  A receive blocks until the
+// bytes it names have arrived from its peer; bytes from a
+// peer are matched in order, so message boundaries need
+// not be carried in the packets.  A zero-byte message is
+// sent, and received, as one byte.  A compute record
+// simply waits.
+//
+// The trace is streamed from disk as it is replayed, so a
+// rank holds only a buffer of records in memory, and no
+// open file between refills of that buffer.
+class TocinoTraceReplayApplication : public Application
+{
+    public:
+
+    static TypeId GetTypeId();
+
+    TocinoTraceReplayApplication();
+
+    // Rank, all nodes in index order, the placement of
+    // ranks on them, and the trace file prefix
+    void Initialize(
+            const uint32_t,
+            const NodeContainer*,
+            Ptr<TocinoPlacement>,
+            const std::string& );
+
+    bool IsFinished() const;
+    Time GetFinishTime() const;
+
+    uint64_t GetRecordsReplayed() const;
+    uint64_t GetBytesSent() const;
+    uint64_t GetBytesReceived() const;
+
+    // Signature of the Finished trace source: the time
+    // from start to the end of this rank's trace
+    typedef void (* FinishedCallback)( Time );
+
+    private:
+
+    void ReplayNext();
+    void Finish();
+
+    void TrySendPending();
+
+    // NetDevice ready callback, following a refused send
+    void DeviceReady( Ptr<NetDevice> );
+
+    void StartApplication();
+    void StopApplication();
+
+    bool AcceptPacket(
+            Ptr<NetDevice>,
+            Ptr<const Packet>,
+            uint16_t,
+            const Address& );
+
+    uint32_t m_packetSize;
+
+    uint32_t m_rank;
+    std::string m_filename;
+
+    Ptr<TocinoPlacement> m_placement;
+    const NodeContainer* m_nodeContainer;
+    Ptr<TocinoNetDevice> m_netDevice;
+
+    // Ranks of the nodes we may hear from
+    std::map< Address, uint32_t > m_rankOfAddress;
+
+    TocinoTraceReader m_reader;
+
+    bool m_running;
+    bool m_finished;
+    Time m_startTime;
+    Time m_finishTime;
+
+    EventId m_computeEvent;
+
+    // Packets of the current send not yet accepted
+    std::deque< Ptr<Packet> > m_pendingPackets;
+    Address m_pendingDestAddress;
+
+    // Per peer rank, bytes arrived but not yet received
+    std::vector< uint64_t > m_available;
+
+    // The receive we are blocked on, if any
+    uint32_t m_waitingPeer;
+    uint64_t m_waitingBytes;
+
+    uint64_t m_recordsReplayed;
+    uint64_t m_bytesSent;
+    uint64_t m_bytesReceived;
+
+    TracedCallback< Time > m_finishedTrace;
+};
+
+}
+
+#endif // __TOCINO_TRACE_REPLAY_APPLICATION_H__
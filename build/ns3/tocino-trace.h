@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_TRACE_H__
+#define __TOCINO_TRACE_H__
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <istream>
+#include <fstream>
+
+namespace ns3
+{
+
+// One operation of one rank of a recorded MPI job
+struct TocinoTraceRecord
+{
+    enum Type
+    {
+        INVALID = 0,
+        SEND = 1,
+        RECV = 2,
+        COMPUTE = 3
+    };
+
+    Type type;
+
+    // Rank sent to or received from; unused by COMPUTE
+    uint32_t peer;
+
+    // Bytes sent or received, or nanoseconds of COMPUTE
+    uint64_t value;
+
+    TocinoTraceRecord()
+        : type( INVALID )
+        , peer( 0 )
+        , value( 0 )
+    {}
+
+    TocinoTraceRecord( const Type t, const uint32_t p, const uint64_t v )
+        : type( t )
+        , peer( p )
+        , value( v )
+    {}
+};
+
+// N.B.
+// A trace is one file per rank, named by
+// TocinoTraceFileName.  Each holds a 16 byte header,
+//      "TOCTRACE" uint32(version) uint32(rank)
+// followed by 16 byte records,
+//      uint8(type) uint8[3](zero) uint32(peer) uint64(value)
+// all little-endian.  Fixed-size records let us read a
+// trace of any length through a small buffer.
+
+std::string TocinoTraceFileName( const std::string&, const uint32_t );
+
+// Reads the records of one rank in order, a buffer at a
+// time, so memory use is independent of trace length.
+//
+// N.B.
+// A job may have more ranks than a process may have open
+// files, so all readers share a pool of at most
+// TOCINO_TRACE_MAX_OPEN_READERS open files.  A reader
+// whose file was closed to make room for another's
+// reopens it at its next refill, where it left off.
+const uint32_t TOCINO_TRACE_MAX_OPEN_READERS = 64;
+
+class TocinoTraceReader
+{
+    public:
+
+    // 64 KB per rank
+    static const uint32_t DEFAULT_BUFFER_RECORDS = 4096;
+
+    TocinoTraceReader( const uint32_t bufferRecords = DEFAULT_BUFFER_RECORDS );
+
+    ~TocinoTraceReader();
+
+    // Copies share no open file; each reopens its own
+    TocinoTraceReader& operator=( const TocinoTraceReader& );
+
+    // False if not a readable trace
+    bool Open( const std::string& );
+
+    // True once Open has succeeded
+    bool IsOpen() const;
+
+    uint32_t GetRank() const;
+
+    // False at the end of the trace
+    bool Next( TocinoTraceRecord& );
+
+    private:
+
+    bool Refill();
+
+    std::string m_filename;
+    bool m_open;
+
+    // Of the first record not yet buffered
+    uint64_t m_offset;
+
+    uint32_t m_rank;
+
+    std::vector< uint8_t > m_buffer;
+    uint32_t m_records;
+    uint32_t m_next;
+};
+
+class TocinoTraceWriter
+{
+    public:
+
+    // Create the trace of the given rank, replacing any
+    // existing file
+    TocinoTraceWriter( const std::string&, const uint32_t );
+
+    // Append to a trace created as above
+    explicit TocinoTraceWriter( const std::string& );
+
+    bool IsOpen() const;
+
+    void Write( const TocinoTraceRecord& );
+
+    private:
+
+    std::ofstream m_file;
+};
+
+// Convert a text trace, one operation per line,
+//      <rank> send <peer> <bytes>
+//      <rank> recv <peer> <bytes>
+//      <rank> compute <nanoseconds>
+// with blank lines and #-comments ignored, into one file
+// per rank named with the given prefix.  Returns the
+// number of ranks, or zero on a malformed trace.
+//
+// At most the given number of files are open at once;
+// when another rank must be written, the file written
+// longest ago is closed, and reopened when next needed.
+const uint32_t TOCINO_TRACE_MAX_OPEN_WRITERS = 64;
+
+uint32_t TocinoConvertTextTrace(
+        std::istream&,
+        const std::string&,
+        const uint32_t maxOpenWriters = TOCINO_TRACE_MAX_OPEN_WRITERS );
+
+}
+
+#endif // __TOCINO_TRACE_H__
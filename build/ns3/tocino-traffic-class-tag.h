@@ -0,0 +1,38 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_TRAFFIC_CLASS_TAG_H__
+#define __TOCINO_TRAFFIC_CLASS_TAG_H__
+
+#include "ns3/packet.h"
+#include "ns3/tag.h"
+
+namespace ns3 {
+
+// Chooses the traffic class, and so the VCs, a packet is
+// sent on; see TocinoVCAllocator.  Untagged packets are
+// class 0.  TocinoNetDevice removes the tag on Send.
+class TocinoTrafficClassTag : public Tag
+{
+    public:
+    static TypeId GetTypeId();
+
+    virtual TypeId GetInstanceTypeId() const;
+
+    virtual uint32_t GetSerializedSize() const;
+    virtual void Serialize( TagBuffer buf ) const;
+    virtual void Deserialize( TagBuffer buf );
+
+    virtual void Print( std::ostream &os ) const;
+
+    TocinoTrafficClassTag();
+    TocinoTrafficClassTag( uint32_t );
+
+    uint32_t GetTrafficClass() const;
+
+    private:
+
+    uint32_t m_trafficClass;
+};
+
+} // namespace ns3
+
+#endif // __TOCINO_TRAFFIC_CLASS_TAG_H__
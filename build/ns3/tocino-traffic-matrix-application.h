@@ -0,0 +1,162 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_TRAFFIC_MATRIX_APPLICATION_H__
+#define __TOCINO_TRAFFIC_MATRIX_APPLICATION_H__
+
+#include <vector>
+#include <utility>
+#include <limits>
+
+#include "ns3/ptr.h"
+#include "ns3/application.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/net-device.h"
+
+#include "tocino-net-device.h"
+
+namespace ns3
+{
+
+class NodeContainer;
+
+typedef std::vector< uint32_t > TocinoTrafficVector;
+typedef std::vector< TocinoTrafficVector > TocinoTrafficMatrix;
+
+// Only the nonzero entries of each row, as (destination,
+// traffic) pairs, for large networks where a dense matrix
+// would not fit and most rows are nearly all zero.  The
+// last entry of a row may be TOCINO_ALL_OTHERS, below.
+typedef std::pair< uint32_t, uint32_t > TocinoSparseTrafficEntry;
+typedef std::vector< TocinoSparseTrafficEntry > TocinoSparseTrafficVector;
+typedef std::vector< TocinoSparseTrafficVector > TocinoSparseTrafficMatrix;
+   
+typedef NetDevice::ReceiveCallback ReceiveCallback;
+
+// N.B.
+// The function 
+//      ns3::UniformVariable::GetInteger(s, l)
+// is implemented via call to 
+//      GetValue (s, l + 1)
+// without check for overflow. This means we must
+// not use  
+//      std::numeric_limits< uint32_t >::max()
+// as the value for TOCINO_TOTAL_TRAFFIC, or else
+// the +1 will overflow and we will be picking from
+// the range [0,0] and get 0 every time.
+// -MAS
+
+const uint32_t TOCINO_TOTAL_TRAFFIC =
+    std::numeric_limits< uint32_t >::max() - 1;
+
+// A destination in a sparse row standing for every node
+// but the source, each equally likely, so that uniform
+// traffic costs one entry per row rather than N-1
+const uint32_t TOCINO_ALL_OTHERS =
+    std::numeric_limits< uint32_t >::max();
+
+class TocinoTrafficMatrixApplication : public Application
+{
+    public:
+
+    static TypeId GetTypeId();
+
+    TocinoTrafficMatrixApplication();
+
+    void Initialize(
+            const uint32_t,
+            const NodeContainer*,
+            const TocinoTrafficMatrix& );
+
+    void Initialize(
+            const uint32_t,
+            const NodeContainer*,
+            const TocinoSparseTrafficMatrix& );
+
+    void SetPacketSize( uint32_t );
+
+    void SetReceiveCallback( ReceiveCallback cb );
+
+    uint32_t GetPacketsSent() const;
+    uint32_t GetPacketsReceived() const;
+
+    void ResetStatistics();
+
+    int64_t AssignStreams( int64_t );
+
+    private:
+
+    static const uint32_t DO_NOT_SEND;
+
+    void InitializeDevice( const uint32_t, const NodeContainer* );
+
+    void AddDestination( const uint32_t, const uint32_t );
+
+    uint32_t SelectRandomDestination();
+
+    void ScheduleSend();
+    void ScheduleNextSend();
+
+    // Attempt to send m_pendingPacket
+    bool TrySendPending();
+
+    // NetDevice ready callback, following a refused send
+    void DeviceReady( Ptr<NetDevice> );
+    
+    void StartApplication();
+    void StopApplication();
+  
+    bool AcceptPacket(
+            Ptr<NetDevice>,
+            Ptr<const Packet>,
+            uint16_t,
+            const Address& );
+
+    EventId m_sendEvent;
+    
+    Ptr<ExponentialRandomVariable>
+        m_sendIntervalRandomVariable;
+
+    Ptr<UniformRandomVariable>
+        m_destinationRandomVariable;
+
+    Time m_meanTimeBetweenSends;
+    Time m_maxTimeBetweenSends;
+
+    uint32_t m_packetSize;
+  
+    uint32_t m_nodeNumber;
+    uint32_t m_totalNodes;
+
+    uint32_t m_packetsSent;
+    uint32_t m_packetsReceived;
+
+    Ptr<TocinoNetDevice> m_netDevice;
+
+    // ISSUE-REVIEW: it would be better if this
+    // could be a const reference
+    const NodeContainer* m_nodeContainer;
+
+    // Our row of the traffic matrix, compiled for binary
+    // search: the destinations with nonzero traffic, and
+    // the running total of traffic up to and including
+    // each.  A draw r selects the first destination whose
+    // total exceeds r, or none if r is beyond the last.
+    // Should that be TOCINO_ALL_OTHERS, the position of r
+    // within its range picks the node.
+    std::vector< uint32_t > m_destinations;
+    std::vector< uint32_t > m_cumulativeTraffic;
+    
+    ReceiveCallback m_receiveCallback;
+
+    // A packet the NetDevice refused, held until it is ready
+    Ptr<Packet> m_pendingPacket;
+    Address m_pendingDestAddress;
+    Address m_pendingViaAddress;
+
+    bool m_doVLB;
+
+    uint32_t m_trafficClass;
+};
+
+}
+
+#endif // __TOCINO_TRAFFIC_MATRIX_APPLICATION_H__
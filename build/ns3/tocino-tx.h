@@ -0,0 +1,217 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_TX_H__
+#define __TOCINO_TX_H__
+
+#include <stdint.h>
+
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+
+#include "tocino-arbiter.h"
+#include "tocino-flit.h"
+#include "tocino-flow-control.h"
+#include "tocino-queue.h"
+
+namespace ns3
+{
+   
+class NetDevice;
+class TocinoArbiter;
+class TocinoChannel;
+class TocinoNetDevice;
+
+class TocinoTx
+{
+    public:
+
+    TocinoTx( const TocinoOutputPort, TocinoNetDevice* );
+  
+    uint32_t GetPortNumber() const;
+
+    void SetXState( const TocinoFlowControlState& );
+
+    bool IsVCPaused( const TocinoOutputVC ) const;
+
+    void RemotePause( const TocinoInputVC );
+    void RemoteResume( const TocinoInputVC );
+
+    // Credit flow control: credits received from our
+    // neighbor, and a credit owed to it
+    void AddCredits( const TocinoCredits& );
+    void RemoteCredit( const TocinoInputVC );
+
+    // Free buffers downstream, per VC
+    uint32_t GetCredits( const TocinoOutputVC ) const;
+
+    // XON/XOFF flow control: our neighbor has freed an
+    // input buffer holding a flit we sent on this VC
+    void DownstreamFreed( const TocinoInputVC );
+
+    // Could a head flit take this VC now, and keep it to
+    // its tail, without waiting on any other packet?  No
+    // queue owns or waits for the VC, and nothing sent on
+    // it is still buffered downstream.
+    bool IsVCIdle( const TocinoOutputVC ) const;
+    
+    void SetChannel( Ptr<TocinoChannel> channel );
+    Ptr<TocinoChannel> GetChannel() const;
+
+    Ptr<TocinoArbiter> GetArbiter() const;
+
+    Ptr<NetDevice> GetNetDevice();
+    Ptr<TocinoNetDevice> GetTocinoNetDevice();
+    
+    void Transmit();
+    
+    // Called at the end of transmission on the wire,
+    // or via TocinoNetDevice::ScheduleTransmitEnd
+    void TransmitEnd();
+
+    // Express mode: perform the arbitration and dequeue of
+    // each flit of our run which has started by now
+    void CatchUp();
+
+    // Express mode: stop our run, if it is fed by the
+    // given input port
+    void StopRunFrom( const TocinoInputPort );
+   
+    bool CanAcceptFlit(
+            const TocinoInputPort,
+            const TocinoOutputVC ) const;
+
+    void AcceptFlit( 
+            const TocinoInputPort,
+            const TocinoOutputVC,
+            const TocinoFlit& );
+    
+    bool IsQueueEmpty( 
+            const TocinoInputPort, 
+            const TocinoOutputVC ) const;
+    
+    bool IsNextFlitHead(
+            const TocinoInputPort, 
+            const TocinoOutputVC ) const;
+
+    bool IsNextFlitTail(
+            const TocinoInputPort, 
+            const TocinoOutputVC ) const;
+
+    // Flits queued on an output VC, from all input ports
+    uint32_t GetOccupancy( const TocinoOutputVC ) const;
+
+    bool AllQuiet() const;
+    void DumpState() const;
+
+    void ReportStatistics() const;
+
+    private:
+    
+    const TocinoFlit& PeekNextFlit(
+            const TocinoInputPort, 
+            const TocinoOutputVC ) const;
+    
+    typedef TocinoQueue< TocinoFlit > OutputQueue;
+
+    OutputQueue& GetOutputQueue( 
+            const TocinoInputPort,
+            const TocinoOutputVC );
+    
+    const OutputQueue& GetOutputQueue( 
+            const TocinoInputPort,
+            const TocinoOutputVC ) const;
+
+    void SendToChannel( const TocinoFlit& );
+    void FusedTransmitEnd();
+
+    bool StartRun( const TocinoArbiterAllocation&, const TocinoFlit& );
+    void StopRun();
+    void RunEnd();
+    void DoTransmitFlowControl();
+    void DoTransmitCredits();
+    void DoTransmit();
+
+    bool UsesCredits() const;
+    bool AreCreditsUrgent() const;
+    void ConsumeCredit( const TocinoOutputVC );
+
+    const TocinoOutputPort m_outputPort;
+  
+    TocinoFlowControlState m_xState;
+    TocinoFlowControlState m_remoteXState;
+    
+    TocinoVCBitSet m_doUpdateXState;
+
+    // Under credit flow control, m_xState is derived from
+    // m_credits: a VC is XOFF exactly when it has none
+    std::vector< uint32_t > m_credits;
+
+    // Credits owed to our neighbor, per VC.  These may
+    // exceed what one credit flit can carry.
+    std::vector< uint32_t > m_pendingCredits;
+    uint32_t m_totalPendingCredits;
+
+    // Under XON/XOFF flow control, flits sent on each VC
+    // which our neighbor has yet to free.  Only a local
+    // channel reports them freed (TocinoRx::SetUpstream),
+    // so over a remote one the count never returns to zero.
+    std::vector< uint32_t > m_downstreamFlits;
+
+    enum TocinoTransmitterState {IDLE, BUSY} m_state;
+ 
+    TocinoNetDevice* m_tnd;
+    Ptr<TocinoChannel> m_channel;
+    Ptr<TocinoArbiter> m_arbiter;
+
+    // Express mode, if our channel supports it
+    bool m_express;
+
+    // The run in progress: flits of one packet, sent to the
+    // channel back-to-back, which still wait in m_runQueue
+    // until CatchUp reaches the time each one starts
+    bool m_running;
+    TocinoArbiterAllocation m_runQueue;
+    std::vector< Time > m_runStarts;
+    uint32_t m_runNext;
+    EventId m_runEndEvent;
+
+    // This nested class controls access to our
+    // primary state variable
+    class TocinoOutputQueues
+    {
+        private:
+
+        // The output queues are virtualized per input, to
+        // avoid head-of-line blocking.  These queues are
+        // mostly for performance.
+        //
+        // All of them live in a single slab, indexed by
+        // ( inputPort * nVCs ) + outputVC.
+        std::vector< OutputQueue > vec;
+
+        public:
+        
+        // If you're thinking about adding another 
+        // friend function here, you're wrong. -MAS
+        
+        friend
+            TocinoTx::TocinoTx( 
+                const TocinoOutputPort, TocinoNetDevice* );
+
+        friend OutputQueue&
+            TocinoTx::GetOutputQueue(
+                    const TocinoInputPort,
+                    const TocinoOutputVC );
+        
+        friend const OutputQueue& 
+            TocinoTx::GetOutputQueue(
+                    const TocinoInputPort,
+                    const TocinoOutputVC ) const;
+    }
+    m_outputQueues;
+};
+
+} // namespace ns3
+
+#endif // __TOCINO_TX_H__
@@ -0,0 +1,77 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_VALIANT_ROUTER_H__
+#define __TOCINO_VALIANT_ROUTER_H__
+
+#include "ns3/random-variable-stream.h"
+
+#include "tocino-dimension-order-router.h"
+
+namespace ns3
+{
+
+// Valiant load balancing, done by the routers themselves.
+//
+// The router at the source picks a random intermediate
+// node and records it, with a phase, in the head flit.
+// Packets travel in dimension order to the intermediate,
+// and from there in dimension order to the destination.
+// Unlike TocinoNetDevice::SendVia, there is no outer head
+// flit, and the intermediate merely flips the phase.
+//
+// In UGAL mode the source instead weighs the minimal path
+// against the Valiant one, by hop count times the flits
+// queued at its first hop, and takes the cheaper.
+//
+// The first phase runs on the first-leg VC pairs of the
+// packet's class, the second on its second-leg pairs (see
+// TocinoVCAllocator), each with its own dateline, so that
+// the two phases cannot deadlock one another.  With the
+// default four VCs these are pairs 0-1 and 2-3.  Minimal
+// packets are routed as if in the second phase from the
+// start.
+class TocinoValiantRouter : public TocinoDimensionOrderRouter
+{
+    public:
+
+    enum Mode
+    {
+        VALIANT,
+        UGAL
+    };
+
+    static TypeId GetTypeId( void );
+
+    TocinoValiantRouter();
+
+    void PrepareHead( TocinoFlit& );
+
+    TocinoRoute Route( const TocinoFlit& ) const;
+
+    private:
+
+    // Comma-separated extent of each dimension, X first
+    void SetRadices( std::string );
+
+    uint32_t GetRadix( const TocinoDimension ) const;
+
+    TocinoAddress PickIntermediate() const;
+
+    uint32_t CountHops( const TocinoAddress&, const TocinoAddress& ) const;
+
+    // Flits queued at the first hop from here toward an
+    // address other than our own
+    uint32_t GetFirstHopOccupancy( const TocinoAddress& ) const;
+
+    bool PreferMinimal( const TocinoAddress&, const TocinoAddress& ) const;
+
+    Mode m_mode;
+
+    // per-dimension, zero if unknown
+    uint32_t m_extent[TOCINO_MAX_DIMENSIONS];
+
+    Ptr<UniformRandomVariable> m_random;
+};
+
+}
+
+#endif //__TOCINO_VALIANT_ROUTER_H__
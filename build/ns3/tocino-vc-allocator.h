@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_VC_ALLOCATOR_H__
+#define __TOCINO_VC_ALLOCATOR_H__
+
+#include <string>
+#include <vector>
+
+#include "tocino-misc.h"
+
+namespace ns3
+{
+
+// Maps traffic classes onto ranges of VCs, and answers
+// the routers' questions about which VC a packet may
+// use next.
+//
+// The VCClasses attribute of TocinoNetDevice gives the
+// VCs of each class, lowest first, e.g. "4,4" puts class
+// 0 (say, requests) on VCs 0-3 and class 1 (replies) on
+// VCs 4-7.  An empty string is one class of every VC.
+// A packet never leaves the range of the class it was
+// injected in, so no class can block another; replies
+// drain however many requests are stuck.
+//
+// Within a class, VCs come in dateline pairs: a packet
+// uses the base (even) VC of a pair until it crosses a
+// dateline, then the high (odd) VC until it changes
+// dimension.  Packets bounced through an intermediate
+// node spend their first leg on the lower half of the
+// pairs of their class and their second leg on the
+// upper half, with the extra pair going to the first
+// leg if the count is odd.  Other packets may use any
+// pair.
+class TocinoVCAllocator
+{
+    public:
+
+    enum Leg
+    {
+        ANY_LEG,
+        FIRST_LEG,
+        SECOND_LEG
+    };
+
+    TocinoVCAllocator();
+
+    // VCs per port, and the VCClasses string
+    void Initialize( const uint32_t, const std::string& );
+
+    uint32_t GetNClasses() const;
+
+    // Class owning a VC
+    uint32_t GetClass( const TocinoVC ) const;
+
+    // Lowest VC, and number of VCs, of a class
+    TocinoVC GetClassBase( const uint32_t ) const;
+    uint32_t GetClassVCs( const uint32_t ) const;
+
+    // Dateline pairs a class has for a leg
+    uint32_t GetPairs( const uint32_t, const Leg ) const;
+
+    // Base VC of the i-th pair of a leg
+    TocinoVC GetPairBase( const uint32_t, const Leg, const uint32_t ) const;
+
+    // Injection VC of a class; successive counter values
+    // rotate across the pairs of the leg
+    TocinoVC GetInjectionVC( const uint32_t, const Leg, const uint32_t ) const;
+
+    // Base VC of the pair holding a VC
+    TocinoVC ResetDateline( const TocinoVC ) const;
+
+    // High VC of the pair whose base is given
+    TocinoVC CrossDateline( const TocinoVC ) const;
+
+    bool IsSecondLeg( const TocinoVC ) const;
+
+    // Base VC of the pair of a leg, in the same class,
+    // corresponding to the pair holding a VC
+    TocinoVC MoveToLeg( const TocinoVC, const Leg ) const;
+
+    private:
+
+    // Pair of its class holding a VC
+    uint32_t GetPairIndex( const TocinoVC ) const;
+
+    // First pair of a leg, and pairs given to the first
+    uint32_t GetFirstPair( const uint32_t, const Leg ) const;
+    uint32_t GetFirstLegPairs( const uint32_t ) const;
+
+    uint32_t m_nVCs;
+
+    // per-class
+    std::vector< uint32_t > m_base;
+    std::vector< uint32_t > m_count;
+
+    // per-VC
+    std::vector< uint32_t > m_class;
+};
+
+}
+
+#endif // __TOCINO_VC_ALLOCATOR_H__
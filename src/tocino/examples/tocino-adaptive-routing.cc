@@ -0,0 +1,201 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+// Compares accepted throughput against offered load, for
+// dimension-order and adaptive routing on a 3D torus.
+//
+// Every node sends to a single partner, chosen by one of
+// the classic adversarial permutations:
+//
+//   transpose   (x,y,z) -> (y,z,x)
+//   tornado     each coordinate + ceil(k/2)-1, mod k
+//
+// Injection is bounded, so that offered load beyond
+// saturation backs up into the senders, rather than
+// into unbounded queues.  Throughput counts only what
+// arrives before the senders stop; the network is then
+// left to drain.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+#include "ns3/core-module.h"
+#include "ns3/node-container.h"
+
+#include "ns3/tocino-3d-torus-topology-helper.h"
+#include "ns3/tocino-traffic-matrix-application.h"
+#include "ns3/tocino-dimension-order-router.h"
+#include "ns3/tocino-adaptive-router.h"
+
+using namespace ns3;
+
+namespace
+{
+
+Time g_windowEnd;
+uint64_t g_packetsInWindow;
+
+bool
+CountPacket(
+        Ptr<NetDevice>,
+        Ptr<const Packet>,
+        uint16_t,
+        const Address& )
+{
+    if( Simulator::Now() <= g_windowEnd )
+    {
+        g_packetsInWindow++;
+    }
+
+    return true;
+}
+
+uint32_t
+Partner(
+        const Tocino3DTorusTopologyHelper& helper,
+        const std::string& pattern,
+        const uint32_t src )
+{
+    const uint32_t K = helper.RADIX;
+    const TocinoAddress ta = helper.IndexToTocinoAddress( src );
+
+    if( pattern == "transpose" )
+    {
+        return helper.CoordinatesToIndex( ta.GetY(), ta.GetZ(), ta.GetX() );
+    }
+
+    NS_ABORT_MSG_UNLESS( pattern == "tornado", "Unknown pattern " << pattern );
+
+    const uint32_t SHIFT = ( K+1 )/2 - 1;
+
+    return helper.CoordinatesToIndex(
+            ( ta.GetX() + SHIFT ) % K,
+            ( ta.GetY() + SHIFT ) % K,
+            ( ta.GetZ() + SHIFT ) % K );
+}
+
+// Returns accepted throughput, in Gbps per node
+double
+Run(
+        const uint32_t radix,
+        const std::string& pattern,
+        const TypeId& routerType,
+        const Time meanTimeBetweenSends,
+        const uint32_t packetSize,
+        const Time duration )
+{
+    Config::SetDefault( "ns3::TocinoNetDevice::RouterType",
+            TypeIdValue( routerType ) );
+
+    Tocino3DTorusTopologyHelper helper( radix );
+
+    const uint32_t NODES = helper.NODES;
+
+    TocinoTrafficMatrix trafficMatrix( NODES );
+
+    for( uint32_t src = 0; src < NODES; ++src )
+    {
+        trafficMatrix[src].assign( NODES, 0 );
+
+        const uint32_t dst = Partner( helper, pattern, src );
+
+        // Nodes which map to themselves stay silent
+        if( dst != src )
+        {
+            trafficMatrix[src][dst] = TOCINO_TOTAL_TRAFFIC;
+        }
+    }
+
+    NodeContainer machines;
+    machines.Create( NODES );
+
+    helper.Install( machines );
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        Ptr<TocinoTrafficMatrixApplication> app =
+            CreateObject<TocinoTrafficMatrixApplication>();
+
+        app->Initialize( node, &machines, trafficMatrix );
+        app->AssignStreams( node * 2 );
+        app->SetReceiveCallback( MakeCallback( &CountPacket ) );
+
+        app->SetAttribute( "MeanTimeBetweenSends", TimeValue( meanTimeBetweenSends ) );
+        app->SetAttribute( "MaxTimeBetweenSends", TimeValue( meanTimeBetweenSends * 10 ) );
+
+        app->SetStartTime( Seconds( 0.0 ) );
+        app->SetStopTime( duration );
+        app->SetPacketSize( packetSize );
+
+        machines.Get( node )->AddApplication( app );
+    }
+
+    g_windowEnd = duration;
+    g_packetsInWindow = 0;
+
+    Simulator::Run();
+    Simulator::Destroy();
+
+    return static_cast<double>( g_packetsInWindow ) * packetSize * 8
+        / duration.GetSeconds() / NODES / 1e9;
+}
+
+}
+
+int
+main( int argc, char *argv[] )
+{
+    uint32_t radix = 4;
+    uint32_t packetSize = 123;
+    double duration = 50e-6;
+    std::string pattern = "transpose";
+
+    CommandLine cmd;
+    cmd.AddValue( "radix", "Nodes per torus dimension", radix );
+    cmd.AddValue( "packetSize", "Bytes per packet", packetSize );
+    cmd.AddValue( "duration", "Seconds of offered traffic", duration );
+    cmd.AddValue( "pattern", "transpose or tornado", pattern );
+    cmd.Parse( argc, argv );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::EnableWrapAround",
+            UintegerValue( radix ) );
+
+    Config::SetDefault(
+            "ns3::TocinoNetDevice::InjectionQueueMaxFlits",
+            UintegerValue( 32 ) );
+
+    const Time DURATION = Seconds( duration );
+    
+    // Mean time between sends, in nanoseconds
+    const uint32_t INTERVALS[] = { 800, 400, 200, 100, 50, 25 };
+    const uint32_t N_INTERVALS = sizeof( INTERVALS ) / sizeof( INTERVALS[0] );
+
+    std::cout << "pattern=" << pattern
+        << " nodes=" << radix*radix*radix
+        << " packetSize=" << packetSize << std::endl;
+
+    std::cout << "offered(Gbps/node)  dor(Gbps/node)  adaptive(Gbps/node)" << std::endl;
+
+    for( uint32_t i = 0; i < N_INTERVALS; ++i )
+    {
+        const Time INTERVAL = NanoSeconds( INTERVALS[i] );
+
+        const double offered = packetSize * 8.0 / INTERVAL.GetSeconds() / 1e9;
+
+        const double dor = Run( radix, pattern,
+                TocinoDimensionOrderRouter::GetTypeId(),
+                INTERVAL, packetSize, DURATION );
+
+        const double adaptive = Run( radix, pattern,
+                TocinoAdaptiveRouter::GetTypeId(),
+                INTERVAL, packetSize, DURATION );
+
+        std::cout << std::fixed << std::setprecision( 3 )
+            << std::setw( 18 ) << offered
+            << std::setw( 16 ) << dor
+            << std::setw( 21 ) << adaptive << std::endl;
+    }
+
+    return 0;
+}
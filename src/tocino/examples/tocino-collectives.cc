@@ -0,0 +1,128 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+// Completion time of MPI-style collectives on a k x k x k
+// torus, for comparing routing and arbitration choices by
+// time-to-solution rather than by packet latency.
+//
+// Each collective runs on every node, repeated back to
+// back; a repetition is complete when its last rank is.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/node-container.h"
+
+#include "ns3/tocino-torus-topology-helper.h"
+#include "ns3/tocino-collective-application.h"
+#include "ns3/tocino-net-device.h"
+
+using namespace ns3;
+
+namespace
+{
+
+void
+Run(
+        const uint32_t radix,
+        const std::string& algorithm,
+        const uint32_t messageSize,
+        const uint32_t iterations )
+{
+    std::vector< uint32_t > radices( 3, radix );
+    std::vector< bool > wrap( 3, true );
+
+    TocinoTorusTopologyHelper helper( radices, wrap );
+
+    NodeContainer machines;
+    machines.Create( helper.NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+    std::vector< Ptr<TocinoCollectiveApplication> > apps;
+
+    for( uint32_t rank = 0; rank < helper.NODES; ++rank )
+    {
+        Ptr<TocinoCollectiveApplication> app =
+            CreateObject<TocinoCollectiveApplication>();
+
+        app->SetAttribute( "Algorithm", StringValue( algorithm ) );
+        app->SetAttribute( "MessageSize", UintegerValue( messageSize ) );
+        app->SetAttribute( "Iterations", UintegerValue( iterations ) );
+        app->Initialize( rank, &machines );
+
+        machines.Get( rank )->AddApplication( app );
+        apps.push_back( app );
+    }
+
+    Simulator::Run();
+
+    Time total;
+
+    for( uint32_t i = 0; i < iterations; ++i )
+    {
+        total += TocinoCollectiveApplication::GetCompletionTime( apps, i );
+    }
+
+    std::cout << std::setw( 28 ) << algorithm
+        << std::setw( 8 ) << apps[0]->GetStepCount()
+        << std::setw( 16 ) << ( total / iterations ).GetNanoSeconds()
+        << std::endl;
+
+    Simulator::Destroy();
+}
+
+}
+
+int
+main( int argc, char *argv[] )
+{
+    uint32_t radix = 4;
+    uint32_t messageSize = 16384;
+    uint32_t iterations = 3;
+    std::string arbiter = "ns3::TocinoSimpleArbiter";
+
+    CommandLine cmd;
+    cmd.AddValue( "radix", "Nodes per torus dimension", radix );
+    cmd.AddValue( "messageSize", "Bytes per rank, or per pair for alltoall", messageSize );
+    cmd.AddValue( "iterations", "Repetitions of each collective", iterations );
+    cmd.AddValue( "arbiter", "TypeId of the output port arbiter", arbiter );
+    cmd.Parse( argc, argv );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::EnableWrapAround",
+            UintegerValue( radix ) );
+
+    Config::SetDefault(
+            "ns3::TocinoNetDevice::ArbiterType",
+            TypeIdValue( TypeId::LookupByName( arbiter ) ) );
+
+    Config::SetDefault(
+            "ns3::TocinoNetDevice::InjectionQueueMaxFlits",
+            UintegerValue( 32 ) );
+
+    const char* ALGORITHMS[] =
+    {
+        "RingAllreduce",
+        "RecursiveDoublingAllreduce",
+        "PairwiseAlltoall",
+        "BinomialBroadcast"
+    };
+
+    const uint32_t N_ALGORITHMS = sizeof( ALGORITHMS ) / sizeof( ALGORITHMS[0] );
+
+    std::cout << "nodes=" << radix*radix*radix
+        << " messageSize=" << messageSize
+        << " arbiter=" << arbiter << std::endl;
+
+    std::cout << "                   collective   steps  completion(ns)" << std::endl;
+
+    for( uint32_t i = 0; i < N_ALGORITHMS; ++i )
+    {
+        Run( radix, ALGORITHMS[i], messageSize, iterations );
+    }
+
+    return 0;
+}
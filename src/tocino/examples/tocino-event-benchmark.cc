@@ -0,0 +1,128 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+// Counts the simulator events needed to deliver all-to-all
+// traffic across a 3D torus.
+//
+// ns-3 has no public event counter, but event uids are handed
+// out sequentially, so the uid of one last event scheduled
+// after Run() tells us how many came before it.
+
+#include <iostream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/node-container.h"
+
+#include "ns3/tocino-3d-torus-topology-helper.h"
+#include "ns3/tocino-traffic-matrix-application.h"
+
+using namespace ns3;
+
+namespace
+{
+
+void
+Nothing()
+{}
+
+}
+
+int
+main( int argc, char *argv[] )
+{
+    uint32_t radix = 3;
+    uint32_t packetSize = 123;
+    double duration = 0.5;
+    bool lightweightFlits = false;
+    bool expressTransmit = false;
+    bool coalesceWork = true;
+
+    CommandLine cmd;
+    cmd.AddValue( "radix", "Nodes per torus dimension", radix );
+    cmd.AddValue( "packetSize", "Bytes per packet", packetSize );
+    cmd.AddValue( "duration", "Seconds of offered traffic", duration );
+    cmd.AddValue( "lightweightFlits", "Use lightweight flits", lightweightFlits );
+    cmd.AddValue( "expressTransmit", "Send runs of flits in one event", expressTransmit );
+    cmd.AddValue( "coalesceWork", "Run deferred work from one event per device", coalesceWork );
+    cmd.Parse( argc, argv );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::EnableWrapAround",
+            UintegerValue( radix ) );
+
+    Config::SetDefault(
+            "ns3::TocinoNetDevice::LightweightFlits",
+            BooleanValue( lightweightFlits ) );
+
+    Config::SetDefault(
+            "ns3::TocinoNetDevice::ExpressTransmit",
+            BooleanValue( expressTransmit ) );
+
+    Config::SetDefault(
+            "ns3::TocinoNetDevice::CoalesceWork",
+            BooleanValue( coalesceWork ) );
+
+    Tocino3DTorusTopologyHelper helper( radix );
+
+    const uint32_t NODES = helper.NODES;
+
+    TocinoTrafficMatrix trafficMatrix( NODES );
+
+    for( uint32_t src = 0; src < NODES; ++src )
+    {
+        trafficMatrix[src].assign( NODES, TOCINO_TOTAL_TRAFFIC/NODES );
+    }
+
+    NodeContainer machines;
+    machines.Create( NODES );
+
+    helper.Install( machines );
+
+    std::vector< Ptr<TocinoTrafficMatrixApplication> > applications;
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        Ptr<TocinoTrafficMatrixApplication> app =
+            CreateObject<TocinoTrafficMatrixApplication>();
+
+        applications.push_back( app );
+
+        app->Initialize( node, &machines, trafficMatrix );
+        app->AssignStreams( node * 2 );
+
+        app->SetStartTime( Seconds( 0.0 ) );
+        app->SetStopTime( Seconds( duration ) );
+        app->SetPacketSize( packetSize );
+
+        machines.Get( node )->AddApplication( app );
+    }
+
+    SystemWallClockMs clock;
+    clock.Start();
+
+    Simulator::Run();
+
+    const int64_t elapsedMs = clock.End();
+    const uint64_t events = Simulator::Schedule( Seconds( 0 ), &Nothing ).GetUid();
+
+    uint64_t packets = 0;
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        packets += applications[node]->GetPacketsReceived();
+    }
+
+    std::cout << "nodes=" << NODES
+        << " packetSize=" << packetSize
+        << " packets=" << packets << std::endl;
+
+    std::cout << "events=" << events
+        << " (" << static_cast<double>( events ) / packets
+        << " per packet)" << std::endl;
+
+    std::cout << "wall clock " << elapsedMs << " ms" << std::endl;
+
+    Simulator::Destroy();
+
+    return 0;
+}
@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+// Packet latency against offered load, under uniform
+// random traffic on a k x k x k torus, or another of the
+// synthetic patterns named by --pattern.
+//
+// Latency runs from Send to ejection of the tail flit,
+// so it includes time spent waiting to inject.  Each
+// row reports the latency percentiles over all packets
+// sent while the senders were active.  With --summary,
+// the full comma-separated statistics of each run are
+// printed too, network-wide and per node.  With --stats,
+// the per-link statistics of each run are written to
+// <stats><interval>ns.csv, sampled every --sampleInterval
+// seconds if given, and always once at the end.
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/node-container.h"
+
+#include "ns3/tocino-torus-topology-helper.h"
+#include "ns3/tocino-stats-collector.h"
+#include "ns3/tocino-traffic-patterns.h"
+#include "ns3/tocino-traffic-matrix-application.h"
+#include "ns3/tocino-net-device.h"
+
+using namespace ns3;
+
+namespace
+{
+
+void
+Run(
+        const uint32_t radix,
+        const std::string& pattern,
+        const Time meanTimeBetweenSends,
+        const uint32_t packetSize,
+        const Time duration,
+        const bool summary,
+        const std::string& stats,
+        const Time sampleInterval )
+{
+    std::vector< uint32_t > radices( 3, radix );
+    std::vector< bool > wrap( 3, true );
+
+    TocinoTorusTopologyHelper helper( radices, wrap );
+
+    const uint32_t NODES = helper.NODES;
+
+    const TocinoSparseTrafficMatrix trafficMatrix =
+        TocinoTrafficPatterns( helper ).Create( pattern );
+
+    NodeContainer machines;
+    machines.Create( NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+    std::vector< Ptr<TocinoTrafficMatrixApplication> > applications;
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        Ptr<TocinoTrafficMatrixApplication> app =
+            CreateObject<TocinoTrafficMatrixApplication>();
+
+        applications.push_back( app );
+
+        app->Initialize( node, &machines, trafficMatrix );
+        app->AssignStreams( node * 2 );
+
+        app->SetAttribute( "MeanTimeBetweenSends", TimeValue( meanTimeBetweenSends ) );
+        app->SetAttribute( "MaxTimeBetweenSends", TimeValue( meanTimeBetweenSends * 10 ) );
+
+        app->SetStartTime( Seconds( 0.0 ) );
+        app->SetStopTime( duration );
+        app->SetPacketSize( packetSize );
+
+        machines.Get( node )->AddApplication( app );
+    }
+
+    TocinoStatsCollector collector( netDevices );
+
+    if( sampleInterval.IsStrictlyPositive() )
+    {
+        collector.SampleEvery( sampleInterval, duration );
+    }
+
+    Simulator::Run();
+
+    if( !stats.empty() )
+    {
+        collector.Sample();
+
+        std::ostringstream filename;
+        filename << stats << meanTimeBetweenSends.GetNanoSeconds() << "ns.csv";
+
+        std::ofstream csv( filename.str().c_str() );
+        collector.WriteCsv( csv );
+    }
+
+    TocinoHistogram latency;
+    TocinoHistogram hopCount;
+    uint64_t packetsSent = 0;
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        latency.Merge( netDevices[node]->GetLatencyHistogram() );
+        hopCount.Merge( netDevices[node]->GetHopCountHistogram() );
+        packetsSent += applications[node]->GetPacketsSent();
+    }
+
+    const double offered = packetSize * 8.0 / meanTimeBetweenSends.GetSeconds() / 1e9;
+    
+    const double accepted = static_cast<double>( packetsSent ) * packetSize * 8
+        / duration.GetSeconds() / NODES / 1e9;
+
+    std::cout << std::fixed << std::setprecision( 3 )
+        << std::setw( 18 ) << offered
+        << std::setw( 18 ) << accepted
+        << std::setw( 10 ) << latency.GetPercentile( 0.5 )
+        << std::setw( 10 ) << latency.GetPercentile( 0.99 )
+        << std::setw( 11 ) << latency.GetPercentile( 0.999 )
+        << std::setw( 10 ) << hopCount.GetMean() << std::endl;
+
+    if( summary )
+    {
+        helper.ReportLatency( netDevices, std::cout, true );
+    }
+
+    Simulator::Destroy();
+}
+
+}
+
+int
+main( int argc, char *argv[] )
+{
+    uint32_t radix = 4;
+    uint32_t packetSize = 123;
+    double duration = 50e-6;
+    bool summary = false;
+    std::string pattern = "uniform";
+    std::string stats;
+    double sampleInterval = 0;
+
+    CommandLine cmd;
+    cmd.AddValue( "radix", "Nodes per torus dimension", radix );
+    cmd.AddValue( "pattern", "uniform, transpose, bitcomplement, bitreverse, shuffle, tornado or neighbor", pattern );
+    cmd.AddValue( "packetSize", "Bytes per packet", packetSize );
+    cmd.AddValue( "duration", "Seconds of offered traffic", duration );
+    cmd.AddValue( "summary", "Print the statistics of each run", summary );
+    cmd.AddValue( "stats", "Write per-link statistics to files with this prefix", stats );
+    cmd.AddValue( "sampleInterval", "Seconds between per-link samples", sampleInterval );
+    cmd.Parse( argc, argv );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::EnableWrapAround",
+            UintegerValue( radix ) );
+
+    Config::SetDefault(
+            "ns3::TocinoNetDevice::InjectionQueueMaxFlits",
+            UintegerValue( 32 ) );
+
+    // Mean time between sends, in nanoseconds
+    const uint32_t INTERVALS[] = { 1600, 800, 400, 200, 100, 50 };
+    const uint32_t N_INTERVALS = sizeof( INTERVALS ) / sizeof( INTERVALS[0] );
+
+    std::cout << "nodes=" << radix*radix*radix
+        << " pattern=" << pattern
+        << " packetSize=" << packetSize << std::endl;
+
+    std::cout << "offered(Gbps/node)  sent(Gbps/node)  p50(ns)   p99(ns)  p99.9(ns)  hops" << std::endl;
+
+    for( uint32_t i = 0; i < N_INTERVALS; ++i )
+    {
+        Run( radix, pattern, NanoSeconds( INTERVALS[i] ), packetSize,
+                Seconds( duration ), summary, stats, Seconds( sampleInterval ) );
+    }
+
+    return 0;
+}
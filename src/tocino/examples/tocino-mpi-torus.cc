@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+// All-to-all traffic on a 3D torus split across MPI ranks.
+//
+// Run with, e.g.
+//   mpirun -np 3 ./waf --run tocino-mpi-torus
+//
+// Each rank simulates one X-slab of the torus, and reports
+// the packets sent and received by its own nodes.  Streams
+// are assigned per node, so the totals, summed over ranks,
+// do not depend on the number of ranks.
+
+#include <iostream>
+
+#include "ns3/core-module.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/node-container.h"
+
+#include "ns3/tocino-3d-torus-topology-helper.h"
+#include "ns3/tocino-traffic-matrix-application.h"
+
+using namespace ns3;
+
+int
+main( int argc, char *argv[] )
+{
+    uint32_t radix = 4;
+    uint32_t packetSize = 123;
+    double duration = 0.05;
+
+    CommandLine cmd;
+    cmd.AddValue( "radix", "Nodes per torus dimension", radix );
+    cmd.AddValue( "packetSize", "Bytes per packet", packetSize );
+    cmd.AddValue( "duration", "Seconds of offered traffic", duration );
+    cmd.Parse( argc, argv );
+
+    GlobalValue::Bind( "SimulatorImplementationType",
+            StringValue( "ns3::NullMessageSimulatorImpl" ) );
+
+    MpiInterface::Enable( &argc, &argv );
+
+    const uint32_t RANK = MpiInterface::GetSystemId();
+    const uint32_t RANKS = MpiInterface::GetSize();
+
+    NS_ABORT_MSG_IF( RANKS > radix, "At most one rank per X plane" );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::EnableWrapAround",
+            UintegerValue( radix ) );
+
+    Tocino3DTorusTopologyHelper helper( radix );
+
+    const uint32_t NODES = helper.NODES;
+
+    TocinoTrafficMatrix trafficMatrix( NODES );
+
+    for( uint32_t src = 0; src < NODES; ++src )
+    {
+        trafficMatrix[src].assign( NODES, TOCINO_TOTAL_TRAFFIC/NODES );
+    }
+
+    NodeContainer machines = helper.CreateNodes( RANKS );
+
+    helper.Install( machines );
+
+    std::vector< Ptr<TocinoTrafficMatrixApplication> > applications;
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        if( machines.Get( node )->GetSystemId() != RANK )
+        {
+            continue;
+        }
+
+        Ptr<TocinoTrafficMatrixApplication> app =
+            CreateObject<TocinoTrafficMatrixApplication>();
+
+        applications.push_back( app );
+
+        app->Initialize( node, &machines, trafficMatrix );
+        app->AssignStreams( node * 2 );
+
+        app->SetStartTime( Seconds( 0.0 ) );
+        app->SetStopTime( Seconds( duration ) );
+        app->SetPacketSize( packetSize );
+
+        machines.Get( node )->AddApplication( app );
+    }
+
+    // Null messages never run dry, so we must say when to stop;
+    // in-flight packets drain in well under a millisecond
+    Simulator::Stop( Seconds( duration ) + MilliSeconds( 1 ) );
+
+    SystemWallClockMs clock;
+    clock.Start();
+
+    Simulator::Run();
+
+    const int64_t elapsedMs = clock.End();
+
+    uint32_t sent = 0;
+    uint32_t received = 0;
+
+    for( uint32_t i = 0; i < applications.size(); ++i )
+    {
+        sent += applications[i]->GetPacketsSent();
+        received += applications[i]->GetPacketsReceived();
+    }
+
+    std::cout << "rank " << RANK << "/" << RANKS
+        << " nodes=" << applications.size()
+        << " sent=" << sent
+        << " received=" << received
+        << " wall clock " << elapsedMs << " ms" << std::endl;
+
+    Simulator::Destroy();
+    MpiInterface::Disable();
+
+    return 0;
+}
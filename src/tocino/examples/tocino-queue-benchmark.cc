@@ -0,0 +1,157 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+// Micro-benchmark of TocinoQueue against the std::deque-based
+// implementation it replaced.
+//
+// We model the output queues of one TocinoTx (7 input ports by
+// 4 VCs) holding TocinoFlits, and repeatedly fill and drain
+// them in an interleaved pattern resembling the arbiter's.
+
+#include <deque>
+#include <iostream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/packet.h"
+
+#include "ns3/tocino-flit.h"
+#include "ns3/tocino-flit-header.h"
+#include "ns3/tocino-queue.h"
+
+using namespace ns3;
+
+namespace
+{
+
+// The original TocinoQueue, less the parts we don't exercise
+template< typename T >
+class DequeQueue
+{
+    private:
+
+    uint32_t m_maxDepth;
+    std::deque<T> m_queue;
+
+    public:
+
+    DequeQueue()
+        : m_maxDepth( 8 )
+    {}
+
+    bool IsFull() const
+    {
+        return m_queue.size() == m_maxDepth;
+    }
+
+    bool IsEmpty() const
+    {
+        return m_queue.size() == 0;
+    }
+
+    void Enqueue( const T& v )
+    {
+        NS_ASSERT( !IsFull() );
+        m_queue.push_back( v );
+    }
+
+    T Dequeue()
+    {
+        NS_ASSERT( !IsEmpty() );
+        T v = m_queue.front();
+        m_queue.pop_front();
+        return v;
+    }
+};
+
+template< typename Q >
+int64_t
+RunBenchmark(
+        const uint32_t QUEUES,
+        const uint32_t ROUNDS,
+        const TocinoFlit& flit,
+        uint32_t& checksum )
+{
+    std::vector< Q > queues( QUEUES );
+
+    SystemWallClockMs clock;
+    clock.Start();
+
+    for( uint32_t round = 0; round < ROUNDS; ++round )
+    {
+        // Fill a varying number of flits into each queue
+        for( uint32_t q = 0; q < QUEUES; ++q )
+        {
+            const uint32_t DEPTH = ( round + q ) % 8 + 1;
+
+            for( uint32_t i = 0; i < DEPTH && !queues[q].IsFull(); ++i )
+            {
+                queues[q].Enqueue( flit );
+            }
+        }
+
+        // Drain them one flit per queue at a time
+        bool anyLeft = true;
+
+        while( anyLeft )
+        {
+            anyLeft = false;
+
+            for( uint32_t q = 0; q < QUEUES; ++q )
+            {
+                if( !queues[q].IsEmpty() )
+                {
+                    checksum += queues[q].Dequeue().GetVirtualChannel().AsUInt32();
+                    anyLeft = true;
+                }
+            }
+        }
+    }
+
+    return clock.End();
+}
+
+}
+
+int
+main( int argc, char *argv[] )
+{
+    uint32_t rounds = 200000;
+    uint32_t ports = 7;
+    uint32_t vcs = 4;
+
+    CommandLine cmd;
+    cmd.AddValue( "rounds", "Number of fill/drain rounds", rounds );
+    cmd.AddValue( "ports", "Input ports per transmitter", ports );
+    cmd.AddValue( "vcs", "Virtual channels per port", vcs );
+    cmd.Parse( argc, argv );
+
+    TocinoFlitHeader h( TocinoAddress( 0, 0, 0 ), TocinoAddress( 1, 1, 1 ) );
+    h.SetHead();
+    h.SetTail();
+    h.SetVirtualChannel( 1 );
+    h.SetLength( 20 );
+
+    Ptr<Packet> p = Create<Packet>( 20 );
+    p->AddHeader( h );
+
+    const TocinoFlit flit( p );
+    const uint32_t QUEUES = ports * vcs;
+
+    uint32_t dequeChecksum = 0;
+    uint32_t ringChecksum = 0;
+
+    const int64_t dequeMs = RunBenchmark< DequeQueue< TocinoFlit > >(
+            QUEUES, rounds, flit, dequeChecksum );
+
+    const int64_t ringMs = RunBenchmark< TocinoQueue< TocinoFlit > >(
+            QUEUES, rounds, flit, ringChecksum );
+
+    NS_ABORT_MSG_UNLESS( dequeChecksum == ringChecksum,
+            "Queue implementations disagree" );
+
+    std::cout << "queues=" << QUEUES << " rounds=" << rounds << std::endl;
+    std::cout << "std::deque:  " << dequeMs << " ms" << std::endl;
+    std::cout << "ring buffer: " << ringMs << " ms" << std::endl;
+
+    return 0;
+}
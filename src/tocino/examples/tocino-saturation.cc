@@ -0,0 +1,497 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+// Sweeps offered load for one traffic pattern, topology,
+// router and arbiter, to find saturation throughput.
+//
+// Each run has three phases:
+//
+//   warm-up   senders active, nothing measured
+//   measure   senders active, throughput and latency kept
+//   drain     senders stopped, the network left to empty
+//
+// Statistics are reset at the end of the warm-up, via
+// ResetStatistics on the traffic applications and
+// ResetLatencyStatistics on the devices.  Accepted
+// throughput counts only packets arriving during the
+// measurement window; latency covers every packet ejected
+// after the warm-up, including those drained at the end.
+//
+// Steady state is judged by comparing the packets accepted
+// in each half of the window.  A run whose halves differ
+// by more than --tolerance is marked unsteady, and wants a
+// longer --warmup.  Runs are independent, so each one is a
+// separate process, --jobs at a time.
+//
+// Link-level flow control, channel delay and input queue
+// depth may be varied too, to compare XON/XOFF with credits.
+// The buffers each needs at the given delay are printed
+// first: the XON/XOFF reserve, which must be less than the
+// input queue depth, and the credit round trip, the depth
+// beyond which credits no longer limit a single VC.
+//
+// The receivers' choice of input VC may be varied with
+// --inputVCSelection.  To show its effect on the dateline
+// VCs, the 99th percentile time flits waited in input
+// queues is printed for base (even) and dateline (odd)
+// VCs separately.
+//
+// Simulation speed is given in simulator events per
+// wall-clock second.  ns-3 has no public event counter,
+// but uids are handed out sequentially, so the uid of one
+// last event scheduled after Run() tells us how many came
+// before it.
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "ns3/core-module.h"
+#include "ns3/node-container.h"
+
+#include "ns3/tocino-torus-topology-helper.h"
+#include "ns3/tocino-traffic-patterns.h"
+#include "ns3/tocino-traffic-matrix-application.h"
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-channel.h"
+
+using namespace ns3;
+
+namespace
+{
+
+struct Setup
+{
+    std::vector< uint32_t > radix;
+    bool wrap;
+    std::string pattern;
+    uint32_t packetSize;
+    Time warmup;
+    Time measure;
+};
+
+// Plain data, so that a child can write it down a pipe
+struct Result
+{
+    double offered;
+    double accepted;
+    double meanLatency;
+    uint64_t p99Latency;
+    uint64_t p999Latency;
+    uint64_t p99BaseWait;
+    uint64_t p99DatelineWait;
+    bool steady;
+    uint64_t events;
+    double wallSeconds;
+};
+
+typedef std::vector< Ptr<TocinoTrafficMatrixApplication> > Applications;
+
+uint64_t
+CountReceived( const Applications& applications )
+{
+    uint64_t packets = 0;
+
+    for( uint32_t i = 0; i < applications.size(); ++i )
+    {
+        packets += applications[i]->GetPacketsReceived();
+    }
+
+    return packets;
+}
+
+void
+EndWarmup(
+        const Applications* applications,
+        const TocinoTorusNetDeviceContainer* netDevices )
+{
+    for( uint32_t i = 0; i < applications->size(); ++i )
+    {
+        (*applications)[i]->ResetStatistics();
+        (*netDevices)[i]->ResetLatencyStatistics();
+    }
+}
+
+void
+Snapshot( const Applications* applications, uint64_t* packets )
+{
+    *packets = CountReceived( *applications );
+}
+
+void
+Nothing()
+{}
+
+std::vector< uint32_t >
+ParseList( const std::string& list )
+{
+    std::vector< uint32_t > values;
+    std::istringstream iss( list );
+    std::string item;
+
+    while( std::getline( iss, item, ',' ) )
+    {
+        values.push_back( atoi( item.c_str() ) );
+    }
+
+    return values;
+}
+
+std::vector< double >
+ParseLoads( const std::string& list )
+{
+    std::vector< double > values;
+    std::istringstream iss( list );
+    std::string item;
+
+    while( std::getline( iss, item, ',' ) )
+    {
+        values.push_back( atof( item.c_str() ) );
+    }
+
+    return values;
+}
+
+// Offered load in Gbps per node
+Result
+Run( const Setup& config, const double load, const double tolerance )
+{
+    TocinoTorusTopologyHelper helper(
+            config.radix,
+            std::vector< bool >( config.radix.size(), config.wrap ) );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::WrapAroundRadices",
+            StringValue( helper.GetWrapAroundRadices() ) );
+
+    const uint32_t NODES = helper.NODES;
+
+    const TocinoSparseTrafficMatrix trafficMatrix =
+        TocinoTrafficPatterns( helper ).Create( config.pattern );
+
+    NodeContainer machines;
+    machines.Create( NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+    const Time meanTimeBetweenSends =
+        NanoSeconds( config.packetSize * 8 / load );
+
+    const Time windowStart = config.warmup;
+    const Time windowMiddle = config.warmup + config.measure / 2;
+    const Time windowEnd = config.warmup + config.measure;
+
+    Applications applications;
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        Ptr<TocinoTrafficMatrixApplication> app =
+            CreateObject<TocinoTrafficMatrixApplication>();
+
+        applications.push_back( app );
+
+        app->Initialize( node, &machines, trafficMatrix );
+        app->AssignStreams( node * 2 );
+
+        app->SetAttribute( "MeanTimeBetweenSends", TimeValue( meanTimeBetweenSends ) );
+        app->SetAttribute( "MaxTimeBetweenSends", TimeValue( meanTimeBetweenSends * 10 ) );
+
+        app->SetStartTime( Seconds( 0.0 ) );
+        app->SetStopTime( windowEnd );
+        app->SetPacketSize( config.packetSize );
+
+        machines.Get( node )->AddApplication( app );
+    }
+
+    uint64_t firstHalf = 0;
+    uint64_t bothHalves = 0;
+
+    Simulator::Schedule( windowStart, &EndWarmup, &applications, &netDevices );
+    Simulator::Schedule( windowMiddle, &Snapshot, &applications, &firstHalf );
+    Simulator::Schedule( windowEnd, &Snapshot, &applications, &bothHalves );
+
+    SystemWallClockMs clock;
+    clock.Start();
+
+    Simulator::Run();
+
+    const int64_t elapsedMs = clock.End();
+
+    Result result;
+
+    result.events = Simulator::Schedule( Seconds( 0 ), &Nothing ).GetUid();
+    result.wallSeconds = elapsedMs / 1000.0;
+
+    TocinoHistogram latency;
+    TocinoHistogram baseWait;
+    TocinoHistogram datelineWait;
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        latency.Merge( netDevices[node]->GetLatencyHistogram() );
+
+        for( uint32_t vc = 0; vc < netDevices[node]->GetNVCs(); ++vc )
+        {
+            TocinoHistogram& wait = ( vc % 2 ) ? datelineWait : baseWait;
+
+            wait.Merge( netDevices[node]->GetInputVCWaitHistogram( vc ) );
+        }
+    }
+
+    result.offered = load;
+
+    result.accepted = static_cast<double>( bothHalves ) * config.packetSize * 8
+        / config.measure.GetSeconds() / NODES / 1e9;
+
+    result.meanLatency = latency.GetMean();
+    result.p99Latency = latency.GetPercentile( 0.99 );
+    result.p999Latency = latency.GetPercentile( 0.999 );
+    result.p99BaseWait = baseWait.GetPercentile( 0.99 );
+    result.p99DatelineWait = datelineWait.GetPercentile( 0.99 );
+
+    const uint64_t secondHalf = bothHalves - firstHalf;
+    const uint64_t larger = std::max( firstHalf, secondHalf );
+    const uint64_t smaller = std::min( firstHalf, secondHalf );
+
+    result.steady = ( larger == 0 ) ||
+        ( larger - smaller <= tolerance * larger );
+
+    Simulator::Destroy();
+
+    return result;
+}
+
+// Run each load in a child process, at most jobs at once,
+// collecting the results in order
+std::vector< Result >
+RunAll(
+        const Setup& config,
+        const std::vector< double >& loads,
+        const double tolerance,
+        const uint32_t jobs )
+{
+    std::vector< Result > results( loads.size() );
+
+    // Child pid and read end of its pipe, by load
+    std::vector< pid_t > pids( loads.size(), -1 );
+    std::vector< int > fds( loads.size(), -1 );
+
+    uint32_t next = 0;
+    uint32_t running = 0;
+    uint32_t done = 0;
+
+    while( done < loads.size() )
+    {
+        while( ( running < jobs ) && ( next < loads.size() ) )
+        {
+            int fd[2];
+            NS_ABORT_MSG_IF( pipe( fd ) != 0, "pipe failed" );
+
+            const pid_t pid = fork();
+            NS_ABORT_MSG_IF( pid < 0, "fork failed" );
+
+            if( pid == 0 )
+            {
+                close( fd[0] );
+
+                const Result result = Run( config, loads[next], tolerance );
+
+                const ssize_t written = write( fd[1], &result, sizeof( result ) );
+                _exit( ( written == sizeof( result ) ) ? 0 : 1 );
+            }
+
+            close( fd[1] );
+
+            pids[next] = pid;
+            fds[next] = fd[0];
+
+            next++;
+            running++;
+        }
+
+        int status;
+        const pid_t pid = wait( &status );
+        NS_ABORT_MSG_IF( pid < 0, "wait failed" );
+
+        const uint32_t i =
+            std::find( pids.begin(), pids.end(), pid ) - pids.begin();
+
+        NS_ABORT_MSG_IF( i == pids.size(), "unknown child" );
+
+        // N.B.
+        // A Result is far smaller than PIPE_BUF, so the
+        // child's write completes without blocking before
+        // it exits, and we may read it only now.
+        const ssize_t got = read( fds[i], &results[i], sizeof( Result ) );
+        close( fds[i] );
+
+        NS_ABORT_MSG_IF( !WIFEXITED( status ) || ( WEXITSTATUS( status ) != 0 ) ||
+                ( got != sizeof( Result ) ), "run at " << loads[i] << " Gbps failed" );
+
+        running--;
+        done++;
+    }
+
+    return results;
+}
+
+}
+
+int
+main( int argc, char *argv[] )
+{
+    std::string radix = "4,4,4";
+    bool wrap = true;
+    std::string pattern = "uniform";
+    std::string router = "ns3::TocinoDimensionOrderRouter";
+    std::string arbiter = "ns3::TocinoSimpleArbiter";
+    uint32_t packetSize = 123;
+    std::string loads = "1,2,4,6,8,10,12,14,16";
+    double warmup = 10e-6;
+    double measure = 20e-6;
+    double tolerance = 0.05;
+    uint32_t jobs = sysconf( _SC_NPROCESSORS_ONLN );
+    bool lightweightFlits = false;
+    std::string flowControl = "XonXoff";
+    double delay = 0;
+    uint32_t inputQueueFlits = 8;
+    std::string inputVCSelection = "LowestFirst";
+
+    CommandLine cmd;
+    cmd.AddValue( "radix", "Nodes per dimension, comma-separated, X first", radix );
+    cmd.AddValue( "wrap", "Wrap-around links in every dimension", wrap );
+    cmd.AddValue( "pattern", "uniform, transpose, bitcomplement, bitreverse, shuffle, tornado or neighbor", pattern );
+    cmd.AddValue( "router", "TypeId of the router", router );
+    cmd.AddValue( "arbiter", "TypeId of the output port arbiter", arbiter );
+    cmd.AddValue( "packetSize", "Bytes per packet", packetSize );
+    cmd.AddValue( "loads", "Offered loads to sweep, Gbps per node, comma-separated", loads );
+    cmd.AddValue( "warmup", "Seconds of traffic before measuring", warmup );
+    cmd.AddValue( "measure", "Seconds of traffic measured", measure );
+    cmd.AddValue( "tolerance", "Largest relative change between window halves deemed steady", tolerance );
+    cmd.AddValue( "jobs", "Runs to execute in parallel", jobs );
+    cmd.AddValue( "lightweightFlits", "Use lightweight flits", lightweightFlits );
+    cmd.AddValue( "flowControl", "XonXoff or Credit", flowControl );
+    cmd.AddValue( "delay", "Channel delay, in ns", delay );
+    cmd.AddValue( "inputQueueFlits", "Depth of each input queue, per VC", inputQueueFlits );
+    cmd.AddValue( "inputVCSelection", "LowestFirst, RoundRobin, OldestFirst or ClassPriority", inputVCSelection );
+    cmd.Parse( argc, argv );
+
+    Config::SetDefault(
+            "ns3::TocinoNetDevice::FlowControl",
+            StringValue( flowControl ) );
+
+    Config::SetDefault(
+            "ns3::TocinoNetDevice::InputQueueFlits",
+            UintegerValue( inputQueueFlits ) );
+
+    Config::SetDefault(
+            "ns3::TocinoNetDevice::InputVCSelection",
+            StringValue( inputVCSelection ) );
+
+    Config::SetDefault(
+            "ns3::TocinoChannel::Delay",
+            TimeValue( NanoSeconds( delay ) ) );
+
+    Config::SetDefault(
+            "ns3::TocinoNetDevice::RouterType",
+            TypeIdValue( TypeId::LookupByName( router ) ) );
+
+    Config::SetDefault(
+            "ns3::TocinoNetDevice::ArbiterType",
+            TypeIdValue( TypeId::LookupByName( arbiter ) ) );
+
+    Config::SetDefault(
+            "ns3::TocinoNetDevice::LightweightFlits",
+            BooleanValue( lightweightFlits ) );
+
+    // Offered load beyond saturation must back up into
+    // the senders, not into unbounded injection queues
+    Config::SetDefault(
+            "ns3::TocinoNetDevice::InjectionQueueMaxFlits",
+            UintegerValue( 32 ) );
+
+    Setup config;
+    config.radix = ParseList( radix );
+    config.wrap = wrap;
+    config.pattern = pattern;
+    config.packetSize = packetSize;
+    config.warmup = Seconds( warmup );
+    config.measure = Seconds( measure );
+
+    const std::vector< double > LOADS = ParseLoads( loads );
+
+    NS_ABORT_MSG_IF( LOADS.empty(), "No loads given" );
+    NS_ABORT_MSG_IF( jobs == 0, "Need at least one job" );
+
+    std::cout << "radix=" << radix
+        << " wrap=" << wrap
+        << " pattern=" << pattern
+        << " router=" << router
+        << " arbiter=" << arbiter
+        << " inputVCSelection=" << inputVCSelection
+        << " packetSize=" << packetSize
+        << " jobs=" << jobs << std::endl;
+
+    const Ptr<TocinoChannel> channel = CreateObject<TocinoChannel>();
+
+    const uint32_t reserve = channel->FlitBuffersRequired();
+
+    std::cout << "flowControl=" << flowControl
+        << " delay=" << delay << "ns"
+        << " inputQueueFlits=" << inputQueueFlits
+        << " xon/xoff reserve=" << reserve
+        << " credit round trip=" << channel->CreditBuffersRequired()
+        << " (flits/VC)" << std::endl;
+
+    if( ( flowControl == "XonXoff" ) && ( reserve >= inputQueueFlits ) )
+    {
+        std::cout << "XON/XOFF cannot work with queues this shallow" << std::endl;
+        return 1;
+    }
+
+    SystemWallClockMs clock;
+    clock.Start();
+
+    const std::vector< Result > results =
+        RunAll( config, LOADS, tolerance, jobs );
+
+    const int64_t elapsedMs = clock.End();
+
+    std::cout << "offered(Gbps/node)  accepted(Gbps/node)  mean(ns)   p99(ns)  p99.9(ns)"
+        "  wait p99 base/dateline(ns)  steady  events/s" << std::endl;
+
+    double saturation = 0;
+
+    for( uint32_t i = 0; i < results.size(); ++i )
+    {
+        const Result& r = results[i];
+
+        std::cout << std::fixed << std::setprecision( 3 )
+            << std::setw( 18 ) << r.offered
+            << std::setw( 21 ) << r.accepted
+            << std::setw( 10 ) << std::setprecision( 1 ) << r.meanLatency
+            << std::setw( 10 ) << r.p99Latency
+            << std::setw( 11 ) << r.p999Latency
+            << std::setw( 17 ) << r.p99BaseWait
+            << "/" << std::left << std::setw( 11 ) << r.p99DatelineWait << std::right
+            << std::setw( 8 ) << ( r.steady ? "yes" : "no" )
+            << std::setw( 10 ) << std::setprecision( 0 )
+            << ( ( r.wallSeconds > 0 ) ? r.events / r.wallSeconds : 0 )
+            << std::endl;
+
+        saturation = std::max( saturation, r.accepted );
+    }
+
+    std::cout << std::setprecision( 3 )
+        << "saturation throughput " << saturation << " Gbps/node" << std::endl;
+
+    std::cout << "wall clock " << elapsedMs << " ms" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+// Replay a recorded MPI trace on a k x k x k torus.
+//
+// Given --text, a text trace is first converted to one
+// binary file per rank, named with --prefix; see
+// tocino-trace.h for both formats.  Otherwise the binary
+// files named by --prefix are replayed directly, and
+// --ranks must say how many there are.  Ranks are placed
+// on nodes by the TypeId given as --placement.
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/node-container.h"
+
+#include "ns3/tocino-torus-topology-helper.h"
+#include "ns3/tocino-trace.h"
+#include "ns3/tocino-placement.h"
+#include "ns3/tocino-trace-replay-application.h"
+#include "ns3/tocino-net-device.h"
+
+using namespace ns3;
+
+int
+main( int argc, char *argv[] )
+{
+    uint32_t radix = 4;
+    std::string text;
+    std::string prefix = "tocino-trace";
+    uint32_t ranks = 0;
+    std::string placementType = "ns3::TocinoLinearPlacement";
+
+    CommandLine cmd;
+    cmd.AddValue( "radix", "Nodes per torus dimension", radix );
+    cmd.AddValue( "text", "Text trace to convert before replay", text );
+    cmd.AddValue( "prefix", "Prefix of the per-rank binary trace files", prefix );
+    cmd.AddValue( "ranks", "Ranks in the binary trace, without --text", ranks );
+    cmd.AddValue( "placement", "TypeId of the rank placement", placementType );
+    cmd.Parse( argc, argv );
+
+    if( !text.empty() )
+    {
+        std::ifstream is( text.c_str() );
+        ranks = TocinoConvertTextTrace( is, prefix );
+
+        if( ranks == 0 )
+        {
+            std::cerr << "cannot convert " << text << std::endl;
+            return 1;
+        }
+    }
+
+    if( ranks == 0 )
+    {
+        std::cerr << "need --text or --ranks" << std::endl;
+        return 1;
+    }
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::EnableWrapAround",
+            UintegerValue( radix ) );
+
+    Config::SetDefault(
+            "ns3::TocinoNetDevice::InjectionQueueMaxFlits",
+            UintegerValue( 32 ) );
+
+    std::vector< uint32_t > radices( 3, radix );
+    std::vector< bool > wrap( 3, true );
+
+    TocinoTorusTopologyHelper helper( radices, wrap );
+
+    NodeContainer machines;
+    machines.Create( helper.NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+    ObjectFactory factory;
+    factory.SetTypeId( placementType );
+
+    Ptr<TocinoPlacement> placement = factory.Create<TocinoPlacement>();
+    placement->Place( ranks, helper.NODES );
+
+    std::vector< Ptr<TocinoTraceReplayApplication> > apps;
+
+    for( uint32_t rank = 0; rank < ranks; ++rank )
+    {
+        Ptr<TocinoTraceReplayApplication> app =
+            CreateObject<TocinoTraceReplayApplication>();
+
+        app->Initialize( rank, &machines, placement, prefix );
+        machines.Get( placement->GetNode( rank ) )->AddApplication( app );
+
+        apps.push_back( app );
+    }
+
+    Simulator::Run();
+
+    Time end;
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    uint32_t unfinished = 0;
+
+    for( uint32_t rank = 0; rank < ranks; ++rank )
+    {
+        records += apps[rank]->GetRecordsReplayed();
+        bytes += apps[rank]->GetBytesSent();
+
+        if( apps[rank]->IsFinished() )
+        {
+            end = std::max( end, apps[rank]->GetFinishTime() );
+        }
+        else
+        {
+            unfinished++;
+        }
+    }
+
+    std::cout << "ranks=" << ranks
+        << " nodes=" << helper.NODES
+        << " placement=" << placementType << std::endl;
+
+    std::cout << "records=" << records
+        << " bytes=" << bytes
+        << " completion(ns)=" << end.GetNanoSeconds()
+        << " unfinished=" << unfinished << std::endl;
+
+    Simulator::Destroy();
+
+    return ( unfinished == 0 ) ? 0 : 1;
+}
@@ -2,55 +2,39 @@
 #ifndef __TOCINO_3D_TORUS_TOPOLOGY_HELPER_H__
 #define __TOCINO_3D_TORUS_TOPOLOGY_HELPER_H__
 
-#include "ns3/net-device-container.h"
-#include "ns3/node-container.h"
 #include "ns3/nstime.h"
 
-#include "ns3/tocino-address.h"
-#include "ns3/tocino-misc.h"
+#include "tocino-torus-topology-helper.h"
 
 namespace ns3
 {
 
 class TocinoChannel;
-class TocinoNetDevice;
 
-// N.B.
-// It's very useful to keep the net devices in a
-// multi-dimensional container that reflects the
-// topology.  The standard ns3 NetDeviceContainer
-// is not a generic class, and thus cannot be
-// made multi-dimensional.  We are forced to roll
-// our own. -MAS
+// Retained for existing users; devices are stored
+// flat, see TocinoTorusNetDeviceContainer
+typedef TocinoTorusNetDeviceContainer Tocino3DTorusNetDeviceContainer;
 
-// A 3D vector of NetDevices
-typedef std::vector<
-    std::vector< 
-        std::vector< 
-            Ptr< TocinoNetDevice > 
-        >
-    >
-> Tocino3DTorusNetDeviceContainer;
-
-class Tocino3DTorusTopologyHelper
+// A RADIX x RADIX x RADIX torus with wrap-around
+// links in every dimension
+class Tocino3DTorusTopologyHelper : public TocinoTorusTopologyHelper
 {
     public:
 
     Tocino3DTorusTopologyHelper( uint32_t );
 
     const uint32_t RADIX;
-    const uint32_t NODES;
     
     uint32_t CoordinatesToIndex(
             const uint32_t,
             const uint32_t,
             const uint32_t ) const;
 
-    uint32_t TocinoAddressToIndex( const TocinoAddress& ) const;
-    TocinoAddress IndexToTocinoAddress( uint32_t ) const;
-    
-    Tocino3DTorusNetDeviceContainer Install( const NodeContainer& );
-  
+    using TocinoTorusTopologyHelper::Middle;
+    using TocinoTorusTopologyHelper::CrossesBisection;
+    using TocinoTorusTopologyHelper::ReportBisectionBandwidth;
+
+    // As above, for the X dimension
     uint32_t Middle() const;
 
     bool CrossesBisection( Ptr<TocinoChannel> ) const;
@@ -58,13 +42,6 @@ class Tocino3DTorusTopologyHelper
     void ReportBisectionBandwidth( 
             const Tocino3DTorusNetDeviceContainer&,
             const Time ) const;
-    
-    private:
-   
-    // ISSUE-REVIEW:
-    // Better names? Make public?
-    int Inc( const int ) const;
-    int Dec( const int ) const;
 };
 
 }
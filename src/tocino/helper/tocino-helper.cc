@@ -2,14 +2,100 @@
 
 #include "tocino-helper.h"
 
+#include "ns3/abort.h"
 #include "ns3/object.h"
+#include "ns3/node.h"
+#include "ns3/global-value.h"
+#include "ns3/string.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/mpi-receiver.h"
+#include "ns3/remote-channel-bundle.h"
+#include "ns3/remote-channel-bundle-manager.h"
 
 #include "ns3/tocino-channel.h"
 #include "ns3/tocino-net-device.h"
+#include "ns3/tocino-remote-channel.h"
 #include "ns3/tocino-rx.h"
 
 namespace ns3 {
 
+namespace {
+
+bool
+IsRemote( Ptr<TocinoNetDevice> tx_nd, Ptr<TocinoNetDevice> rx_nd )
+{
+    if( !MpiInterface::IsEnabled() )
+    {
+        return false;
+    }
+
+    NS_ASSERT_MSG( tx_nd->GetNode() != NULL && rx_nd->GetNode() != NULL,
+            "Under MPI, net devices must be added to nodes before connecting them" );
+
+    return tx_nd->GetNode()->GetSystemId() != rx_nd->GetNode()->GetSystemId();
+}
+
+void
+AddToBundle( Ptr<TocinoChannel> c, uint32_t remoteSystemId )
+{
+    Ptr<RemoteChannelBundle> bundle =
+        RemoteChannelBundleManager::Find( remoteSystemId );
+
+    if( bundle == NULL )
+    {
+        bundle = RemoteChannelBundleManager::Add( remoteSystemId );
+    }
+
+    bundle->AddChannel( c, c->GetLookahead() );
+}
+
+void
+ConnectRemote( Ptr<TocinoChannel> c,
+               Ptr<TocinoNetDevice> tx_nd,
+               Ptr<TocinoNetDevice> rx_nd )
+{
+    // N.B.
+    // The mpi module discovers remote links, and their
+    // lookahead, only through point-to-point net devices.
+    // We register our channels with the null message
+    // machinery ourselves.  The granted-time-window
+    // DistributedSimulatorImpl offers no such hook.
+
+    StringValue impl;
+    GlobalValue::GetValueByName( "SimulatorImplementationType", impl );
+
+    NS_ABORT_MSG_UNLESS( impl.Get() == "ns3::NullMessageSimulatorImpl",
+            "Tocino across MPI ranks requires ns3::NullMessageSimulatorImpl" );
+
+    const uint32_t LOCAL = MpiInterface::GetSystemId();
+    const uint32_t TX_SYSTEM = tx_nd->GetNode()->GetSystemId();
+    const uint32_t RX_SYSTEM = rx_nd->GetNode()->GetSystemId();
+
+    if( TX_SYSTEM == LOCAL )
+    {
+        AddToBundle( c, RX_SYSTEM );
+    }
+    else if( RX_SYSTEM == LOCAL )
+    {
+        AddToBundle( c, TX_SYSTEM );
+
+        if( rx_nd->GetObject<MpiReceiver>() == NULL )
+        {
+            // Raw pointer; a Ptr would keep the device
+            // alive through its own aggregate
+            Ptr<MpiReceiver> mpiRec = CreateObject<MpiReceiver>();
+
+            mpiRec->SetReceiveCallback(
+                    MakeBoundCallback( &TocinoRemoteChannel::Receive,
+                        PeekPointer( rx_nd ) ) );
+
+            rx_nd->AggregateObject( mpiRec );
+        }
+    }
+}
+
+}
+
 void
 TocinoChannelHelper( Ptr<TocinoNetDevice> tx_nd, TocinoOutputPort tx_port,
                      Ptr<TocinoNetDevice> rx_nd, TocinoInputPort rx_port )
@@ -17,12 +103,39 @@ TocinoChannelHelper( Ptr<TocinoNetDevice> tx_nd, TocinoOutputPort tx_port,
     uint32_t txPortNum = tx_port.AsUInt32();
     uint32_t rxPortNum = rx_port.AsUInt32();
 
-    Ptr<TocinoChannel> c = CreateObject<TocinoChannel>();
+    NS_ABORT_MSG_IF( tx_nd->GetFlowControl() != rx_nd->GetFlowControl(),
+            "Both ends of a Tocino link must use the same flow control" );
+
+    NS_ABORT_MSG_IF( tx_nd->GetInputQueueFlits() != rx_nd->GetInputQueueFlits(),
+            "Both ends of a Tocino link must have equally deep input queues" );
+
+    const bool remote = IsRemote( tx_nd, rx_nd );
+
+    Ptr<TocinoChannel> c;
+    
+    if( remote )
+    {
+        c = CreateObject<TocinoRemoteChannel>();
+    }
+    else
+    {
+        c = CreateObject<TocinoChannel>();
+    }
     
     tx_nd->SetChannel( txPortNum, c );
     
     c->SetTransmitter( tx_nd->GetTransmitter( txPortNum ) );
     c->SetReceiver( rx_nd->GetReceiver( rxPortNum ) );
+
+    if( remote )
+    {
+        ConnectRemote( c, tx_nd, rx_nd );
+    }
+    else
+    {
+        rx_nd->GetReceiver( rxPortNum )->SetUpstream(
+                tx_nd->GetTransmitter( txPortNum ) );
+    }
 }
 
 }
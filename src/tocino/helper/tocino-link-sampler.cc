@@ -0,0 +1,271 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/assert.h"
+#include "ns3/simulator.h"
+
+#include "tocino-link-sampler.h"
+
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-channel.h"
+#include "ns3/tocino-tx.h"
+
+namespace ns3
+{
+
+TocinoLinkSampler::TocinoLinkSampler(
+        const TocinoTorusNetDeviceContainer& netDevices,
+        const uint32_t capacity )
+    : m_capacity( capacity )
+    , m_nVCs( 0 )
+    , m_head( 0 )
+    , m_count( 0 )
+{
+    NS_ASSERT( !netDevices.empty() );
+
+    // One interval needs two samples
+    NS_ASSERT( m_capacity >= 2 );
+
+    m_nVCs = netDevices[0]->GetNVCs();
+
+    for( uint32_t node = 0; node < netDevices.size(); ++node )
+    {
+        Ptr<TocinoNetDevice> tnd = netDevices[node];
+
+        NS_ASSERT( tnd->GetNVCs() == m_nVCs );
+
+        for( uint32_t port = 0; port < tnd->GetNPorts(); ++port )
+        {
+            Ptr<TocinoChannel> channel =
+                tnd->GetTransmitter( port )->GetChannel();
+
+            if( channel != NULL )
+            {
+                m_channels.push_back( channel );
+                m_linkNode.push_back( node );
+                m_linkPort.push_back( port );
+            }
+        }
+    }
+
+    m_rings.resize( m_channels.size() );
+
+    for( uint32_t link = 0; link < m_rings.size(); ++link )
+    {
+        m_rings[link].busy.resize( m_capacity );
+        m_rings[link].vcFlits.resize( m_capacity * m_nVCs );
+    }
+
+    m_time.resize( m_capacity );
+}
+
+void
+TocinoLinkSampler::Start( const Time interval, const Time stop )
+{
+    NS_ASSERT( interval.IsStrictlyPositive() );
+
+    Stop();
+
+    m_sampleEvent = Simulator::ScheduleNow(
+            &TocinoLinkSampler::SamplePeriodically, this, interval, stop );
+}
+
+void
+TocinoLinkSampler::Stop()
+{
+    Simulator::Cancel( m_sampleEvent );
+}
+
+void
+TocinoLinkSampler::SamplePeriodically( const Time interval, const Time stop )
+{
+    Sample();
+
+    // Never reschedule forever, lest Simulator::Run not return
+    if( Simulator::Now() + interval <= stop )
+    {
+        m_sampleEvent = Simulator::Schedule( interval,
+                &TocinoLinkSampler::SamplePeriodically, this, interval, stop );
+    }
+}
+
+void
+TocinoLinkSampler::Sample()
+{
+    m_time[ m_head ] = Simulator::Now().GetNanoSeconds();
+
+    for( uint32_t link = 0; link < m_channels.size(); ++link )
+    {
+        Ring& ring = m_rings[link];
+
+        ring.busy[ m_head ] =
+            m_channels[link]->GetElapsedTransmitTime().GetNanoSeconds();
+
+        for( uint32_t vc = 0; vc < m_nVCs; ++vc )
+        {
+            ring.vcFlits[ m_head * m_nVCs + vc ] =
+                m_channels[link]->GetVCFlits( vc );
+        }
+    }
+
+    m_head = ( m_head + 1 ) % m_capacity;
+
+    if( m_count < m_capacity )
+    {
+        m_count++;
+    }
+}
+
+uint32_t
+TocinoLinkSampler::GetNLinks() const
+{
+    return m_channels.size();
+}
+
+uint32_t
+TocinoLinkSampler::GetNVCs() const
+{
+    return m_nVCs;
+}
+
+uint32_t
+TocinoLinkSampler::GetCapacity() const
+{
+    return m_capacity;
+}
+
+uint32_t
+TocinoLinkSampler::GetLinkNode( const uint32_t link ) const
+{
+    NS_ASSERT( link < GetNLinks() );
+    return m_linkNode[link];
+}
+
+uint32_t
+TocinoLinkSampler::GetLinkPort( const uint32_t link ) const
+{
+    NS_ASSERT( link < GetNLinks() );
+    return m_linkPort[link];
+}
+
+uint32_t
+TocinoLinkSampler::GetNSamples() const
+{
+    return m_count;
+}
+
+uint32_t
+TocinoLinkSampler::GetNIntervals() const
+{
+    return ( m_count == 0 ) ? 0 : m_count - 1;
+}
+
+uint32_t
+TocinoLinkSampler::GetSlot( const uint32_t i ) const
+{
+    NS_ASSERT( i < m_count );
+
+    // The oldest sample is at m_head once we have wrapped
+    return ( m_head + m_capacity - m_count + i ) % m_capacity;
+}
+
+Time
+TocinoLinkSampler::GetIntervalEnd( const uint32_t interval ) const
+{
+    NS_ASSERT( interval < GetNIntervals() );
+
+    return NanoSeconds( m_time[ GetSlot( interval + 1 ) ] );
+}
+
+double
+TocinoLinkSampler::GetUtilization(
+        const uint32_t interval,
+        const uint32_t link ) const
+{
+    NS_ASSERT( interval < GetNIntervals() );
+    NS_ASSERT( link < GetNLinks() );
+
+    const uint32_t begin = GetSlot( interval );
+    const uint32_t end = GetSlot( interval + 1 );
+
+    const uint64_t elapsed = m_time[end] - m_time[begin];
+
+    if( elapsed == 0 )
+    {
+        return 0;
+    }
+
+    const Ring& ring = m_rings[link];
+
+    return static_cast<double>( ring.busy[end] - ring.busy[begin] ) / elapsed;
+}
+
+uint32_t
+TocinoLinkSampler::GetVCFlits(
+        const uint32_t interval,
+        const uint32_t link,
+        const uint32_t vc ) const
+{
+    NS_ASSERT( interval < GetNIntervals() );
+    NS_ASSERT( link < GetNLinks() );
+    NS_ASSERT( vc < m_nVCs );
+
+    const uint32_t begin = GetSlot( interval );
+    const uint32_t end = GetSlot( interval + 1 );
+
+    const Ring& ring = m_rings[link];
+
+    return ring.vcFlits[ end * m_nVCs + vc ] - ring.vcFlits[ begin * m_nVCs + vc ];
+}
+
+void
+TocinoLinkSampler::WriteHeader( std::ostream& os ) const
+{
+    os << "time_ns";
+
+    for( uint32_t link = 0; link < GetNLinks(); ++link )
+    {
+        os << "," << m_linkNode[link] << ":" << m_linkPort[link];
+    }
+
+    os << "\n";
+}
+
+void
+TocinoLinkSampler::WriteUtilizationMatrix( std::ostream& os ) const
+{
+    WriteHeader( os );
+
+    for( uint32_t interval = 0; interval < GetNIntervals(); ++interval )
+    {
+        os << GetIntervalEnd( interval ).GetNanoSeconds();
+
+        for( uint32_t link = 0; link < GetNLinks(); ++link )
+        {
+            os << "," << GetUtilization( interval, link );
+        }
+
+        os << "\n";
+    }
+}
+
+void
+TocinoLinkSampler::WriteVCMatrix( std::ostream& os, const uint32_t vc ) const
+{
+    NS_ASSERT( vc < m_nVCs );
+
+    WriteHeader( os );
+
+    for( uint32_t interval = 0; interval < GetNIntervals(); ++interval )
+    {
+        os << GetIntervalEnd( interval ).GetNanoSeconds();
+
+        for( uint32_t link = 0; link < GetNLinks(); ++link )
+        {
+            os << "," << GetVCFlits( interval, link, vc );
+        }
+
+        os << "\n";
+    }
+}
+
+}
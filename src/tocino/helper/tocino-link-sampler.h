@@ -0,0 +1,112 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_LINK_SAMPLER_H__
+#define __TOCINO_LINK_SAMPLER_H__
+
+#include <stdint.h>
+#include <vector>
+#include <ostream>
+
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+
+#include "tocino-torus-topology-helper.h"
+
+namespace ns3
+{
+
+class TocinoChannel;
+
+// A time series of busy time and per-VC flit counts for
+// every channel, for spotting transient hotspots which
+// whole-run totals hide.
+//
+// One event samples all channels at once.  Each channel
+// keeps the most recent samples in a ring buffer, sized
+// up front, so sampling never allocates; once full, the
+// oldest sample is overwritten.  All rings advance
+// together, so they share one ring of sample times.
+//
+// Samples are exported as a time x link matrix of the
+// change between consecutive samples, one row per
+// interval and one column per link.
+class TocinoLinkSampler
+{
+    public:
+
+    // Devices to sample, and samples kept per channel
+    TocinoLinkSampler( const TocinoTorusNetDeviceContainer&, const uint32_t );
+
+    // Sample now and every interval thereafter, up to and
+    // including the given absolute time
+    void Start( const Time, const Time );
+    void Stop();
+
+    void Sample();
+
+    uint32_t GetNLinks() const;
+    uint32_t GetNVCs() const;
+    uint32_t GetCapacity() const;
+
+    // Node index and output port of a link
+    uint32_t GetLinkNode( const uint32_t ) const;
+    uint32_t GetLinkPort( const uint32_t ) const;
+
+    // Samples held, at most the capacity; there is one
+    // fewer interval
+    uint32_t GetNSamples() const;
+    uint32_t GetNIntervals() const;
+
+    // End of an interval, oldest first
+    Time GetIntervalEnd( const uint32_t ) const;
+
+    // Fraction of an interval that a link was busy
+    double GetUtilization( const uint32_t, const uint32_t ) const;
+
+    // Flits sent on a VC of a link during an interval
+    uint32_t GetVCFlits( const uint32_t, const uint32_t, const uint32_t ) const;
+
+    // Comma-separated, a header naming each link node:port
+    // then one row per interval: its end in ns, followed
+    // by the utilization of each link
+    void WriteUtilizationMatrix( std::ostream& ) const;
+
+    // As above, but flits sent on the given VC
+    void WriteVCMatrix( std::ostream&, const uint32_t ) const;
+
+    private:
+
+    void SamplePeriodically( const Time, const Time );
+
+    // Slot of the i-th oldest sample
+    uint32_t GetSlot( const uint32_t ) const;
+
+    void WriteHeader( std::ostream& ) const;
+
+    struct Ring
+    {
+        std::vector< uint64_t > busy;
+
+        // capacity x VCs, slot major
+        std::vector< uint32_t > vcFlits;
+    };
+
+    const uint32_t m_capacity;
+    uint32_t m_nVCs;
+
+    std::vector< Ptr<TocinoChannel> > m_channels;
+    std::vector< uint32_t > m_linkNode;
+    std::vector< uint32_t > m_linkPort;
+
+    std::vector< Ring > m_rings;
+    std::vector< uint64_t > m_time;
+
+    // Next slot to write, and slots written, up to capacity
+    uint32_t m_head;
+    uint32_t m_count;
+
+    EventId m_sampleEvent;
+};
+
+}
+
+#endif // __TOCINO_LINK_SAMPLER_H__
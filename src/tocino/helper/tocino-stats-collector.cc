@@ -0,0 +1,384 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#include <sstream>
+#include <string>
+
+#include "ns3/assert.h"
+#include "ns3/simulator.h"
+
+#include "tocino-stats-collector.h"
+
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-channel.h"
+#include "ns3/tocino-arbiter.h"
+#include "ns3/tocino-tx.h"
+
+namespace ns3
+{
+
+namespace
+{
+
+void
+WriteLittleEndian( std::ostream& os, uint64_t value, const uint32_t width )
+{
+    for( uint32_t i = 0; i < width; ++i )
+    {
+        os.put( static_cast<char>( value & 0xFF ) );
+        value >>= 8;
+    }
+}
+
+void
+WriteName( std::ostream& os, const std::string& name )
+{
+    WriteLittleEndian( os, name.size(), 4 );
+    os.write( name.data(), name.size() );
+}
+
+std::string
+VCName( const uint32_t vc )
+{
+    std::ostringstream oss;
+    oss << "vc" << vc << "_flits";
+    return oss.str();
+}
+
+}
+
+TocinoStatsCollector::TocinoStatsCollector(
+        const TocinoTorusNetDeviceContainer& netDevices )
+    : m_netDevices( netDevices )
+    , m_nVCs( 0 )
+    , m_rowsPerSample( 0 )
+{
+    NS_ASSERT( !m_netDevices.empty() );
+
+    m_nVCs = m_netDevices[0]->GetNVCs();
+
+    for( uint32_t i = 0; i < m_netDevices.size(); ++i )
+    {
+        NS_ASSERT( m_netDevices[i]->GetNVCs() == m_nVCs );
+
+        m_rowsPerSample += m_netDevices[i]->GetNPorts();
+    }
+
+    m_columns32.resize( VC_FLITS + m_nVCs );
+    m_columns64.resize( N_COLUMNS64 );
+}
+
+void
+TocinoStatsCollector::Sample()
+{
+    const uint64_t now = Simulator::Now().GetNanoSeconds();
+
+    for( uint32_t node = 0; node < m_netDevices.size(); ++node )
+    {
+        Ptr<TocinoNetDevice> tnd = m_netDevices[node];
+
+        for( uint32_t port = 0; port < tnd->GetNPorts(); ++port )
+        {
+            const TocinoTx* tx = tnd->GetTransmitter( port );
+            Ptr<TocinoChannel> channel = tx->GetChannel();
+            Ptr<TocinoArbiter> arbiter = tx->GetArbiter();
+
+            m_columns64[ TIME_NS ].push_back( now );
+            m_columns32[ NODE ].push_back( node );
+            m_columns32[ PORT ].push_back( port );
+
+            // N.B.
+            // The host port has no channel.  Neither do
+            // ports left unconnected in a mesh, nor those
+            // of nodes belonging to another MPI rank.
+            if( channel != NULL )
+            {
+                m_columns32[ BYTES ].push_back( channel->GetTotalBytesTransmitted() );
+                m_columns32[ FLITS ].push_back( channel->GetTotalFlitsTransmitted() );
+                m_columns32[ LLC_BYTES ].push_back( channel->GetLLCBytesTransmitted() );
+                m_columns32[ LLC_FLITS ].push_back( channel->GetLLCFlitsTransmitted() );
+
+                m_columns64[ BUSY_NS ].push_back(
+                        channel->GetElapsedTransmitTime().GetNanoSeconds() );
+                m_columns64[ LLC_BUSY_NS ].push_back(
+                        channel->GetLLCTransmitTime().GetNanoSeconds() );
+
+                for( uint32_t vc = 0; vc < m_nVCs; ++vc )
+                {
+                    m_columns32[ VC_FLITS + vc ].push_back( channel->GetVCFlits( vc ) );
+                }
+            }
+            else
+            {
+                m_columns32[ BYTES ].push_back( 0 );
+                m_columns32[ FLITS ].push_back( 0 );
+                m_columns32[ LLC_BYTES ].push_back( 0 );
+                m_columns32[ LLC_FLITS ].push_back( 0 );
+                m_columns64[ BUSY_NS ].push_back( 0 );
+                m_columns64[ LLC_BUSY_NS ].push_back( 0 );
+
+                for( uint32_t vc = 0; vc < m_nVCs; ++vc )
+                {
+                    m_columns32[ VC_FLITS + vc ].push_back( 0 );
+                }
+            }
+
+            TocinoArbiterStallCounts stalls;
+
+            if( arbiter != NULL )
+            {
+                stalls = arbiter->GetStallCounts();
+            }
+
+            m_columns32[ STALL_ALLOCATED_QUEUE_EMPTY ].push_back(
+                    stalls.allocatedQueueIsEmpty );
+            m_columns32[ STALL_ALLOCATED_QUEUE_XOFF ].push_back(
+                    stalls.allocatedQueueNotEmptyButXOFF );
+            m_columns32[ STALL_UNALLOCATED_QUEUES_EMPTY ].push_back(
+                    stalls.unallocatedButAllQueuesEmpty );
+            m_columns32[ STALL_UNALLOCATED_QUEUES_XOFF ].push_back(
+                    stalls.unallocatedButAllNonEmptyQueuesAreXOFF );
+        }
+    }
+}
+
+void
+TocinoStatsCollector::SampleEvery( const Time interval, const Time stop )
+{
+    NS_ASSERT( interval.IsStrictlyPositive() );
+
+    Cancel();
+
+    m_sampleEvent = Simulator::ScheduleNow(
+            &TocinoStatsCollector::SamplePeriodically, this, interval, stop );
+}
+
+void
+TocinoStatsCollector::SamplePeriodically( const Time interval, const Time stop )
+{
+    Sample();
+
+    // N.B.
+    // We must not reschedule forever, or Simulator::Run
+    // would never return on its own.
+    if( Simulator::Now() + interval <= stop )
+    {
+        m_sampleEvent = Simulator::Schedule( interval,
+                &TocinoStatsCollector::SamplePeriodically, this, interval, stop );
+    }
+}
+
+void
+TocinoStatsCollector::Cancel()
+{
+    Simulator::Cancel( m_sampleEvent );
+}
+
+void
+TocinoStatsCollector::Clear()
+{
+    for( uint32_t i = 0; i < m_columns32.size(); ++i )
+    {
+        m_columns32[i].clear();
+    }
+
+    for( uint32_t i = 0; i < m_columns64.size(); ++i )
+    {
+        m_columns64[i].clear();
+    }
+}
+
+uint32_t
+TocinoStatsCollector::GetNRows() const
+{
+    return m_columns64[ TIME_NS ].size();
+}
+
+uint32_t
+TocinoStatsCollector::GetNVCs() const
+{
+    return m_nVCs;
+}
+
+uint32_t
+TocinoStatsCollector::GetRowsPerSample() const
+{
+    return m_rowsPerSample;
+}
+
+uint32_t
+TocinoStatsCollector::Get( const Column32 column, const uint32_t row ) const
+{
+    NS_ASSERT( column < VC_FLITS );
+    NS_ASSERT( row < GetNRows() );
+
+    return m_columns32[ column ][ row ];
+}
+
+uint64_t
+TocinoStatsCollector::Get( const Column64 column, const uint32_t row ) const
+{
+    NS_ASSERT( column < N_COLUMNS64 );
+    NS_ASSERT( row < GetNRows() );
+
+    return m_columns64[ column ][ row ];
+}
+
+uint32_t
+TocinoStatsCollector::GetVCFlits( const uint32_t vc, const uint32_t row ) const
+{
+    NS_ASSERT( vc < m_nVCs );
+    NS_ASSERT( row < GetNRows() );
+
+    return m_columns32[ VC_FLITS + vc ][ row ];
+}
+
+double
+TocinoStatsCollector::GetUtilization( const uint32_t row ) const
+{
+    NS_ASSERT( row < GetNRows() );
+
+    // Samples are appended a whole table at a time, so the
+    // previous sample of this transmitter is one table back
+    uint64_t elapsed = m_columns64[ TIME_NS ][ row ];
+    uint64_t busy = m_columns64[ BUSY_NS ][ row ];
+
+    if( row >= m_rowsPerSample )
+    {
+        elapsed -= m_columns64[ TIME_NS ][ row - m_rowsPerSample ];
+        busy -= m_columns64[ BUSY_NS ][ row - m_rowsPerSample ];
+    }
+
+    if( elapsed == 0 )
+    {
+        return 0;
+    }
+
+    return static_cast<double>( busy ) / elapsed;
+}
+
+const char*
+TocinoStatsCollector::GetName( const Column32 column )
+{
+    static const char* NAMES[] =
+    {
+        "node",
+        "port",
+        "bytes",
+        "flits",
+        "llc_bytes",
+        "llc_flits",
+        "stall_allocated_queue_empty",
+        "stall_allocated_queue_xoff",
+        "stall_unallocated_queues_empty",
+        "stall_unallocated_queues_xoff"
+    };
+
+    NS_ASSERT( column < VC_FLITS );
+
+    return NAMES[ column ];
+}
+
+const char*
+TocinoStatsCollector::GetName( const Column64 column )
+{
+    static const char* NAMES[] =
+    {
+        "time_ns",
+        "busy_ns",
+        "llc_busy_ns"
+    };
+
+    NS_ASSERT( column < N_COLUMNS64 );
+
+    return NAMES[ column ];
+}
+
+void
+TocinoStatsCollector::WriteCsv( std::ostream& os ) const
+{
+    os << GetName( TIME_NS );
+
+    for( uint32_t col = 0; col < VC_FLITS; ++col )
+    {
+        os << "," << GetName( static_cast<Column32>( col ) );
+    }
+
+    os << "," << GetName( BUSY_NS )
+        << "," << GetName( LLC_BUSY_NS )
+        << ",llc_share,utilization";
+
+    for( uint32_t vc = 0; vc < m_nVCs; ++vc )
+    {
+        os << "," << VCName( vc );
+    }
+
+    os << "\n";
+
+    for( uint32_t row = 0; row < GetNRows(); ++row )
+    {
+        os << m_columns64[ TIME_NS ][ row ];
+
+        for( uint32_t col = 0; col < VC_FLITS; ++col )
+        {
+            os << "," << m_columns32[ col ][ row ];
+        }
+
+        const uint32_t bytes = m_columns32[ BYTES ][ row ];
+
+        const double llcShare = ( bytes == 0 ) ? 0 :
+            static_cast<double>( m_columns32[ LLC_BYTES ][ row ] ) / bytes;
+
+        os << "," << m_columns64[ BUSY_NS ][ row ]
+            << "," << m_columns64[ LLC_BUSY_NS ][ row ]
+            << "," << llcShare
+            << "," << GetUtilization( row );
+
+        for( uint32_t vc = 0; vc < m_nVCs; ++vc )
+        {
+            os << "," << m_columns32[ VC_FLITS + vc ][ row ];
+        }
+
+        os << "\n";
+    }
+}
+
+void
+TocinoStatsCollector::WriteBinary( std::ostream& os ) const
+{
+    const uint32_t ROWS = GetNRows();
+
+    os.write( "TOCSTAT1", 8 );
+    WriteLittleEndian( os, m_columns64.size() + m_columns32.size(), 4 );
+    WriteLittleEndian( os, ROWS, 4 );
+
+    for( uint32_t col = 0; col < m_columns64.size(); ++col )
+    {
+        WriteName( os, GetName( static_cast<Column64>( col ) ) );
+        WriteLittleEndian( os, 8, 4 );
+
+        for( uint32_t row = 0; row < ROWS; ++row )
+        {
+            WriteLittleEndian( os, m_columns64[ col ][ row ], 8 );
+        }
+    }
+
+    for( uint32_t col = 0; col < m_columns32.size(); ++col )
+    {
+        if( col < VC_FLITS )
+        {
+            WriteName( os, GetName( static_cast<Column32>( col ) ) );
+        }
+        else
+        {
+            WriteName( os, VCName( col - VC_FLITS ) );
+        }
+
+        WriteLittleEndian( os, 4, 4 );
+
+        for( uint32_t row = 0; row < ROWS; ++row )
+        {
+            WriteLittleEndian( os, m_columns32[ col ][ row ], 4 );
+        }
+    }
+}
+
+}
@@ -0,0 +1,116 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_STATS_COLLECTOR_H__
+#define __TOCINO_STATS_COLLECTOR_H__
+
+#include <stdint.h>
+#include <vector>
+#include <ostream>
+
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+
+#include "tocino-torus-topology-helper.h"
+
+namespace ns3
+{
+
+// Gathers the channel and arbiter counters of every
+// transmitter into an in-memory table, one row per
+// transmitter per sample, for export at the end of a run.
+//
+// Unlike the ReportStatistics methods, which only speak
+// through NS_LOG_LOGIC, this works in optimized builds and
+// costs nothing until sampled.  The table is columnar: each
+// column is a flat vector, so a sample is a few push_backs
+// per transmitter and a dump is a linear walk.
+//
+// Counters are cumulative since the start of the run; the
+// per-sample utilization in the CSV is derived from the
+// difference between consecutive samples.
+class TocinoStatsCollector
+{
+    public:
+
+    TocinoStatsCollector( const TocinoTorusNetDeviceContainer& );
+
+    // 32-bit columns, followed by one per VC
+    enum Column32
+    {
+        NODE,
+        PORT,
+        BYTES,
+        FLITS,
+        LLC_BYTES,
+        LLC_FLITS,
+        STALL_ALLOCATED_QUEUE_EMPTY,
+        STALL_ALLOCATED_QUEUE_XOFF,
+        STALL_UNALLOCATED_QUEUES_EMPTY,
+        STALL_UNALLOCATED_QUEUES_XOFF,
+        VC_FLITS
+    };
+
+    enum Column64
+    {
+        TIME_NS,
+        BUSY_NS,
+        LLC_BUSY_NS,
+        N_COLUMNS64
+    };
+
+    // Append one row per transmitter, as of now
+    void Sample();
+
+    // Sample now and every interval thereafter, up to and
+    // including the given absolute time.  The last sample
+    // is the caller's to take if the run ends before then.
+    void SampleEvery( const Time, const Time );
+    void Cancel();
+
+    void Clear();
+
+    uint32_t GetNRows() const;
+    uint32_t GetNVCs() const;
+
+    // Transmitters sampled, i.e. rows per sample
+    uint32_t GetRowsPerSample() const;
+
+    uint32_t Get( const Column32, const uint32_t ) const;
+    uint64_t Get( const Column64, const uint32_t ) const;
+    uint32_t GetVCFlits( const uint32_t, const uint32_t ) const;
+
+    // Fraction of the time since the previous sample of the
+    // same transmitter, or the start of the run, that its
+    // channel was busy
+    double GetUtilization( const uint32_t ) const;
+
+    void WriteCsv( std::ostream& ) const;
+
+    // Little-endian:
+    //      "TOCSTAT1" uint32(columns) uint32(rows)
+    // then per column:
+    //      uint32(name length) name uint32(width) data
+    // where width is 4 or 8 bytes per row.  Derived
+    // columns, LLC share and utilization, are omitted.
+    void WriteBinary( std::ostream& ) const;
+
+    private:
+
+    void SamplePeriodically( const Time, const Time );
+
+    static const char* GetName( const Column32 );
+    static const char* GetName( const Column64 );
+
+    TocinoTorusNetDeviceContainer m_netDevices;
+
+    uint32_t m_nVCs;
+    uint32_t m_rowsPerSample;
+
+    std::vector< std::vector< uint32_t > > m_columns32;
+    std::vector< std::vector< uint64_t > > m_columns64;
+
+    EventId m_sampleEvent;
+};
+
+}
+
+#endif // __TOCINO_STATS_COLLECTOR_H__
@@ -0,0 +1,446 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+#include "ns3/log.h"
+
+#include "tocino-torus-topology-helper.h"
+#include "tocino-helper.h"
+
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-channel.h"
+
+namespace ns3
+{
+
+// IndexToTocinoAddress fills in exactly four coordinates
+STATIC_ASSERT( TOCINO_MAX_DIMENSIONS == 4, address_has_four_coordinates );
+
+TocinoTorusTopologyHelper::TocinoTorusTopologyHelper(
+        const std::vector< uint32_t >& radix,
+        const std::vector< bool >& wrap )
+    : DIMENSIONS( radix.size() )
+    , NODES( CountNodes( radix ) )
+    , m_radix( radix )
+    , m_wrap( wrap )
+{
+    NS_ASSERT( DIMENSIONS > 0 );
+    NS_ASSERT( DIMENSIONS <= TOCINO_MAX_DIMENSIONS );
+    NS_ASSERT( m_wrap.size() == DIMENSIONS );
+
+    uint32_t stride = 1;
+
+    for( uint32_t dim = 0; dim < DIMENSIONS; ++dim )
+    {
+        NS_ASSERT( m_radix[dim] > 0 );
+
+        // Coordinates are one byte, except W which is less
+        NS_ASSERT( m_radix[dim] <=
+                std::numeric_limits< TocinoAddress::Coordinate >::max() + 1u );
+        NS_ASSERT( ( dim != TOCINO_DIMENSION_W.AsUInt32() ) ||
+                ( m_radix[dim] <= TocinoAddress::MAX_W + 1u ) );
+
+        m_stride.push_back( stride );
+        stride *= m_radix[dim];
+    }
+}
+
+uint32_t
+TocinoTorusTopologyHelper::CountNodes( const std::vector< uint32_t >& radix )
+{
+    uint32_t nodes = 1;
+
+    for( uint32_t dim = 0; dim < radix.size(); ++dim )
+    {
+        nodes *= radix[dim];
+    }
+
+    return nodes;
+}
+
+uint32_t
+TocinoTorusTopologyHelper::GetRadix( const TocinoDimension dim ) const
+{
+    if( dim < DIMENSIONS )
+    {
+        return m_radix[ dim.AsUInt32() ];
+    }
+
+    // Absent dimensions behave as radix one
+    return 1;
+}
+
+bool
+TocinoTorusTopologyHelper::HasWrapAround( const TocinoDimension dim ) const
+{
+    if( dim < DIMENSIONS )
+    {
+        return m_wrap[ dim.AsUInt32() ];
+    }
+
+    return false;
+}
+
+std::string
+TocinoTorusTopologyHelper::GetWrapAroundRadices() const
+{
+    std::ostringstream oss;
+
+    for( uint32_t dim = 0; dim < DIMENSIONS; ++dim )
+    {
+        if( dim > 0 )
+        {
+            oss << ",";
+        }
+
+        oss << ( m_wrap[dim] ? m_radix[dim] : 0 );
+    }
+
+    return oss.str();
+}
+
+std::string
+TocinoTorusTopologyHelper::GetRadices() const
+{
+    std::ostringstream oss;
+
+    for( uint32_t dim = 0; dim < DIMENSIONS; ++dim )
+    {
+        if( dim > 0 )
+        {
+            oss << ",";
+        }
+
+        oss << m_radix[dim];
+    }
+
+    return oss.str();
+}
+
+uint32_t
+TocinoTorusTopologyHelper::TocinoAddressToIndex( const TocinoAddress& ta ) const
+{
+    uint32_t idx = 0;
+
+    for( uint32_t dim = 0; dim < DIMENSIONS; ++dim )
+    {
+        const uint32_t coord = ta.GetCoordinate( dim );
+
+        NS_ASSERT( coord < m_radix[dim] );
+
+        idx += coord * m_stride[dim];
+    }
+
+    return idx;
+}
+
+uint32_t
+TocinoTorusTopologyHelper::GetCoordinate(
+        const uint32_t idx,
+        const TocinoDimension dim ) const
+{
+    const uint32_t d = dim.AsUInt32();
+
+    return ( idx / m_stride[d] ) % m_radix[d];
+}
+
+TocinoAddress
+TocinoTorusTopologyHelper::IndexToTocinoAddress( uint32_t idx ) const
+{
+    NS_ASSERT( idx < NODES );
+
+    TocinoAddress::Coordinate coord[ TOCINO_MAX_DIMENSIONS ] = { 0 };
+
+    for( uint32_t dim = 0; dim < DIMENSIONS; ++dim )
+    {
+        coord[dim] = GetCoordinate( idx, dim );
+    }
+
+    return TocinoAddress( coord[0], coord[1], coord[2], coord[3] );
+}
+
+uint32_t
+TocinoTorusTopologyHelper::GetNeighbor(
+        const uint32_t idx,
+        const TocinoDimension dim,
+        const TocinoDirection dir ) const
+{
+    const uint32_t d = dim.AsUInt32();
+    const uint32_t coord = GetCoordinate( idx, dim );
+
+    uint32_t next;
+
+    if( dir == TOCINO_DIRECTION_POS )
+    {
+        next = ( coord + 1 ) % m_radix[d];
+    }
+    else
+    {
+        next = ( coord + m_radix[d] - 1 ) % m_radix[d];
+    }
+
+    return idx - ( coord * m_stride[d] ) + ( next * m_stride[d] );
+}
+
+TocinoTorusNetDeviceContainer
+TocinoTorusTopologyHelper::Install( const NodeContainer& nc )
+{
+    NS_ASSERT( nc.GetN() == NODES );
+
+    TocinoTorusNetDeviceContainer netDevices( NODES );
+
+    // Create the net devices
+    for( uint32_t idx = 0; idx < NODES; ++idx )
+    {
+        Ptr<TocinoNetDevice> tnd = CreateObject<TocinoNetDevice>();
+
+        netDevices[idx] = tnd;
+
+        // A port pair per dimension, plus the host port
+        tnd->SetNPorts( 2 * DIMENSIONS + 1 );
+
+        tnd->Initialize();
+        tnd->SetAddress( IndexToTocinoAddress( idx ) );
+
+        // Attach net device to the correct node
+        //
+        // N.B. This must precede creation of the
+        // channels, which consult the node's system
+        // id when running under MPI.
+        Ptr<Node> node = nc.Get( idx );
+        NS_ASSERT( node != NULL );
+
+        node->AddDevice( tnd );
+    }
+
+    // Create channels and interconnect net devices
+    for( uint32_t idx = 0; idx < NODES; ++idx )
+    {
+        Ptr<TocinoNetDevice> cur = netDevices[idx];
+
+        for( TocinoDimension dim = 0; dim < DIMENSIONS; ++dim )
+        {
+            const uint32_t radix = m_radix[ dim.AsUInt32() ];
+            const bool wrap = m_wrap[ dim.AsUInt32() ];
+            const uint32_t coord = GetCoordinate( idx, dim );
+
+            // Nothing to connect to
+            if( radix == 1 ) continue;
+
+            if( wrap || ( coord < radix-1 ) )
+            {
+                TocinoChannelHelper(
+                        cur,
+                        TocinoGetPort( dim, TOCINO_DIRECTION_POS ),
+                        netDevices[ GetNeighbor( idx, dim, TOCINO_DIRECTION_POS ) ],
+                        TocinoGetPort( dim, TOCINO_DIRECTION_NEG ) );
+            }
+
+            if( wrap || ( coord > 0 ) )
+            {
+                TocinoChannelHelper(
+                        cur,
+                        TocinoGetPort( dim, TOCINO_DIRECTION_NEG ),
+                        netDevices[ GetNeighbor( idx, dim, TOCINO_DIRECTION_NEG ) ],
+                        TocinoGetPort( dim, TOCINO_DIRECTION_POS ) );
+            }
+        }
+    }
+
+    return netDevices;
+}
+
+NodeContainer
+TocinoTorusTopologyHelper::CreateNodes( const uint32_t slabs ) const
+{
+    NodeContainer nc;
+
+    // Node i must end up at index i; see Install
+    for( uint32_t idx = 0; idx < NODES; ++idx )
+    {
+        nc.Create( 1, GetSlab( IndexToTocinoAddress( idx ), slabs ) );
+    }
+
+    return nc;
+}
+
+uint32_t
+TocinoTorusTopologyHelper::Middle( const TocinoDimension dim ) const
+{
+    // N.B. Truncation here means we return
+    // the "lower middle" for even radix.
+    return ( GetRadix( dim )-1 ) / 2;
+}
+
+bool
+TocinoTorusTopologyHelper::CrossesBisection(
+        Ptr<TocinoChannel> chan,
+        const TocinoDimension dim ) const
+{
+    const uint32_t RADIX = GetRadix( dim );
+    const uint32_t MIDDLE = Middle( dim );
+
+    uint32_t txCoord =
+        chan->GetTocinoDevice( TocinoChannel::TX_DEV )->GetTocinoAddress().GetCoordinate( dim );
+
+    uint32_t rxCoord =
+        chan->GetTocinoDevice( TocinoChannel::RX_DEV )->GetTocinoAddress().GetCoordinate( dim );
+
+    // include links the cross the "middle"
+    if( ( txCoord == MIDDLE ) && ( rxCoord == MIDDLE+1 ) )
+    {
+        return true;
+    }
+
+    if( ( txCoord == MIDDLE+1 ) && ( rxCoord == MIDDLE ) )
+    {
+        return true;
+    }
+
+    // include wrap-around links
+    if( ( txCoord == RADIX-1 ) && ( rxCoord == 0 ) )
+    {
+        return true;
+    }
+
+    if( ( txCoord == 0 ) && ( rxCoord == RADIX-1 ) )
+    {
+        return true;
+    }
+
+    return false;
+}
+
+void
+TocinoTorusTopologyHelper::ReportBisectionBandwidth(
+        const TocinoTorusNetDeviceContainer& netDevices,
+        const Time duration,
+        const TocinoDimension dim ) const
+{
+    // N.B.  We require an even radix in order to bisect
+    // the volume into equally-sized halves.
+    NS_ASSERT( ( GetRadix( dim ) & 1 ) == 0 );
+
+    uint32_t bisectionBytes = 0;
+
+    for( uint32_t idx = 0; idx < netDevices.size(); ++idx )
+    {
+        Ptr<TocinoNetDevice> tnd = netDevices[idx];
+
+        for( uint32_t port = 0; port < tnd->GetNPorts()-1; ++port )
+        {
+            Ptr<TocinoChannel> chan = tnd->GetChannel( port );
+
+            // Mesh edges have no channel
+            if( chan == NULL ) continue;
+
+            if( CrossesBisection( chan, dim ) )
+            {
+                bisectionBytes += chan->GetTotalBytesTransmitted();
+            }
+        }
+    }
+
+    //NS_LOG_UNCOND( "Total bytes crossing bisection: " << bisectionBytes );
+
+    double bps = static_cast<double>(bisectionBytes) * 8 / duration.GetSeconds();
+
+    std::cout << "Bisection bandwidth: " << bps/1024 << " Kbps" << std::endl;
+    std::cout << "Bisection bandwidth: " << bps/1024/1024 << " Mbps" << std::endl;
+    std::cout << "Bisection bandwidth: " << bps/1024/1024/1024 << " Gbps" << std::endl;
+}
+
+void
+TocinoTorusTopologyHelper::ReportLatency(
+        const TocinoTorusNetDeviceContainer& netDevices,
+        std::ostream& os,
+        const bool perDevice ) const
+{
+    TocinoHistogram latency;
+    TocinoHistogram hopCount;
+    TocinoHistogram hopQueueing;
+
+    for( uint32_t idx = 0; idx < netDevices.size(); ++idx )
+    {
+        Ptr<TocinoNetDevice> tnd = netDevices[idx];
+
+        latency.Merge( tnd->GetLatencyHistogram() );
+        hopCount.Merge( tnd->GetHopCountHistogram() );
+        hopQueueing.Merge( tnd->GetHopQueueingHistogram() );
+    }
+
+    TocinoNetDevice::ReportLatencyHeader( os );
+
+    os << "latency_ns,*,*,";
+    latency.PrintSummary( os );
+    os << std::endl;
+
+    os << "hops,*,*,";
+    hopCount.PrintSummary( os );
+    os << std::endl;
+
+    os << "hop_queueing_ns,*,*,";
+    hopQueueing.PrintSummary( os );
+    os << std::endl;
+
+    if( !perDevice ) return;
+
+    for( uint32_t idx = 0; idx < netDevices.size(); ++idx )
+    {
+        netDevices[idx]->ReportLatency( os );
+    }
+}
+
+uint32_t
+TocinoTorusTopologyHelper::GetSlab(
+        const TocinoAddress& ta,
+        const uint32_t slabs ) const
+{
+    const uint32_t RADIX = GetRadix( TOCINO_DIMENSION_X );
+
+    NS_ASSERT( slabs > 0 );
+    NS_ASSERT( slabs <= RADIX );
+
+    // Spread any remainder evenly; slab sizes differ by
+    // at most one plane
+    return ( ta.GetX() * slabs ) / RADIX;
+}
+
+Time
+TocinoTorusTopologyHelper::GetSlabLookahead(
+        const TocinoTorusNetDeviceContainer& netDevices,
+        const uint32_t slabs ) const
+{
+    Time lookahead = Time::Max();
+
+    for( uint32_t idx = 0; idx < netDevices.size(); ++idx )
+    {
+        Ptr<TocinoNetDevice> tnd = netDevices[idx];
+
+        for( uint32_t port = 0; port < tnd->GetNPorts()-1; ++port )
+        {
+            Ptr<TocinoChannel> chan = tnd->GetChannel( port );
+
+            // Mesh edges have no channel
+            if( chan == NULL ) continue;
+
+            const uint32_t txSlab = GetSlab(
+                chan->GetTocinoDevice( TocinoChannel::TX_DEV )->GetTocinoAddress(),
+                slabs );
+
+            const uint32_t rxSlab = GetSlab(
+                chan->GetTocinoDevice( TocinoChannel::RX_DEV )->GetTocinoAddress(),
+                slabs );
+
+            if( txSlab != rxSlab )
+            {
+                lookahead = std::min( lookahead, chan->GetLookahead() );
+            }
+        }
+    }
+
+    return lookahead;
+}
+
+}
@@ -0,0 +1,333 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#include <algorithm>
+
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+
+#include "tocino-traffic-patterns.h"
+
+namespace ns3
+{
+
+TocinoTrafficPatterns::TocinoTrafficPatterns(
+        const TocinoTorusTopologyHelper& helper )
+    : m_nodes( helper.NODES )
+{
+    uint32_t stride = 1;
+
+    for( uint32_t dim = 0; dim < helper.DIMENSIONS; ++dim )
+    {
+        m_radix.push_back( helper.GetRadix( dim ) );
+        m_stride.push_back( stride );
+        stride *= m_radix[dim];
+    }
+
+    NS_ASSERT( stride == m_nodes );
+}
+
+uint32_t
+TocinoTrafficPatterns::GetNNodes() const
+{
+    return m_nodes;
+}
+
+uint32_t
+TocinoTrafficPatterns::GetCoordinate(
+        const uint32_t idx,
+        const uint32_t dim ) const
+{
+    return ( idx / m_stride[dim] ) % m_radix[dim];
+}
+
+uint32_t
+TocinoTrafficPatterns::GetIndex( const std::vector< uint32_t >& coord ) const
+{
+    NS_ASSERT( coord.size() == m_radix.size() );
+
+    uint32_t idx = 0;
+
+    for( uint32_t dim = 0; dim < m_radix.size(); ++dim )
+    {
+        NS_ASSERT( coord[dim] < m_radix[dim] );
+
+        idx += coord[dim] * m_stride[dim];
+    }
+
+    return idx;
+}
+
+uint32_t
+TocinoTrafficPatterns::GetIndexBits() const
+{
+    uint32_t bits = 0;
+
+    while( ( 1u << bits ) < m_nodes )
+    {
+        bits++;
+    }
+
+    NS_ABORT_MSG_IF( ( 1u << bits ) != m_nodes,
+            "Bit permutations need a power-of-two node count" );
+
+    return bits;
+}
+
+uint32_t
+TocinoTrafficPatterns::Spread(
+        TocinoSparseTrafficVector& row,
+        const std::vector< uint32_t >& dests,
+        const uint32_t src,
+        const uint32_t traffic )
+{
+    const uint32_t count = dests.size() -
+        std::count( dests.begin(), dests.end(), src );
+
+    if( count == 0 )
+    {
+        return 0;
+    }
+
+    // N.B.
+    // The remainder goes one apiece to the first few, so
+    // that the row sums to exactly the traffic given.
+    // Otherwise a node would now and then skip a send.
+    const uint32_t share = traffic / count;
+    uint32_t remainder = traffic % count;
+
+    for( uint32_t i = 0; i < dests.size(); ++i )
+    {
+        if( dests[i] != src )
+        {
+            row.push_back( TocinoSparseTrafficEntry( dests[i], share ) );
+
+            if( remainder > 0 )
+            {
+                row.back().second++;
+                remainder--;
+            }
+        }
+    }
+
+    return traffic;
+}
+
+TocinoSparseTrafficMatrix
+TocinoTrafficPatterns::UniformRandom() const
+{
+    return Hotspot( std::vector< uint32_t >(), 0 );
+}
+
+TocinoSparseTrafficMatrix
+TocinoTrafficPatterns::Hotspot(
+        const std::vector< uint32_t >& hot,
+        const double fraction ) const
+{
+    NS_ASSERT( ( fraction >= 0 ) && ( fraction <= 1 ) );
+
+    // Ascending and distinct, as a sparse row must be
+    std::vector< uint32_t > hotNodes( hot );
+    std::sort( hotNodes.begin(), hotNodes.end() );
+    hotNodes.erase( std::unique( hotNodes.begin(), hotNodes.end() ), hotNodes.end() );
+
+    NS_ASSERT( hotNodes.empty() || ( hotNodes.back() < m_nodes ) );
+
+    TocinoSparseTrafficMatrix matrix( m_nodes );
+
+    if( m_nodes == 1 )
+    {
+        // Nowhere to send
+        return matrix;
+    }
+
+    for( uint32_t src = 0; src < m_nodes; ++src )
+    {
+        TocinoSparseTrafficVector& row = matrix[src];
+
+        // Should there be no hot node but itself, a node
+        // sends its hot share uniformly instead
+        const uint32_t hotTraffic = Spread( row, hotNodes, src,
+                static_cast<uint32_t>( fraction * TOCINO_TOTAL_TRAFFIC ) );
+
+        // The rest, hot nodes included, to all but itself
+        if( hotTraffic < TOCINO_TOTAL_TRAFFIC )
+        {
+            row.push_back( TocinoSparseTrafficEntry(
+                        TOCINO_ALL_OTHERS, TOCINO_TOTAL_TRAFFIC - hotTraffic ) );
+        }
+    }
+
+    return matrix;
+}
+
+TocinoSparseTrafficMatrix
+TocinoTrafficPatterns::Permutation( const std::vector< uint32_t >& dest ) const
+{
+    NS_ASSERT( dest.size() == m_nodes );
+
+    TocinoSparseTrafficMatrix matrix( m_nodes );
+
+    for( uint32_t src = 0; src < m_nodes; ++src )
+    {
+        NS_ASSERT( dest[src] < m_nodes );
+
+        if( dest[src] != src )
+        {
+            matrix[src].push_back(
+                    TocinoSparseTrafficEntry( dest[src], TOCINO_TOTAL_TRAFFIC ) );
+        }
+    }
+
+    return matrix;
+}
+
+TocinoSparseTrafficMatrix
+TocinoTrafficPatterns::Transpose() const
+{
+    const uint32_t DIMS = m_radix.size();
+
+    for( uint32_t dim = 0; dim < DIMS; ++dim )
+    {
+        NS_ABORT_MSG_IF( m_radix[dim] != m_radix[ DIMS-1-dim ],
+                "Transpose needs symmetric radices" );
+    }
+
+    std::vector< uint32_t > dest( m_nodes );
+    std::vector< uint32_t > coord( DIMS );
+
+    for( uint32_t src = 0; src < m_nodes; ++src )
+    {
+        for( uint32_t dim = 0; dim < DIMS; ++dim )
+        {
+            coord[dim] = GetCoordinate( src, DIMS-1-dim );
+        }
+
+        dest[src] = GetIndex( coord );
+    }
+
+    return Permutation( dest );
+}
+
+TocinoSparseTrafficMatrix
+TocinoTrafficPatterns::BitComplement() const
+{
+    std::vector< uint32_t > dest( m_nodes );
+    std::vector< uint32_t > coord( m_radix.size() );
+
+    for( uint32_t src = 0; src < m_nodes; ++src )
+    {
+        for( uint32_t dim = 0; dim < m_radix.size(); ++dim )
+        {
+            coord[dim] = m_radix[dim] - 1 - GetCoordinate( src, dim );
+        }
+
+        dest[src] = GetIndex( coord );
+    }
+
+    return Permutation( dest );
+}
+
+TocinoSparseTrafficMatrix
+TocinoTrafficPatterns::BitReverse() const
+{
+    const uint32_t BITS = GetIndexBits();
+
+    std::vector< uint32_t > dest( m_nodes );
+
+    for( uint32_t src = 0; src < m_nodes; ++src )
+    {
+        uint32_t reversed = 0;
+
+        for( uint32_t bit = 0; bit < BITS; ++bit )
+        {
+            if( src & ( 1u << bit ) )
+            {
+                reversed |= 1u << ( BITS-1-bit );
+            }
+        }
+
+        dest[src] = reversed;
+    }
+
+    return Permutation( dest );
+}
+
+TocinoSparseTrafficMatrix
+TocinoTrafficPatterns::Shuffle() const
+{
+    const uint32_t BITS = GetIndexBits();
+
+    std::vector< uint32_t > dest( m_nodes );
+
+    for( uint32_t src = 0; src < m_nodes; ++src )
+    {
+        if( BITS == 0 )
+        {
+            dest[src] = src;
+        }
+        else
+        {
+            dest[src] = ( ( src << 1 ) | ( src >> ( BITS-1 ) ) ) & ( m_nodes-1 );
+        }
+    }
+
+    return Permutation( dest );
+}
+
+TocinoSparseTrafficMatrix
+TocinoTrafficPatterns::Tornado() const
+{
+    std::vector< uint32_t > dest( m_nodes );
+    std::vector< uint32_t > coord( m_radix.size() );
+
+    for( uint32_t src = 0; src < m_nodes; ++src )
+    {
+        for( uint32_t dim = 0; dim < m_radix.size(); ++dim )
+        {
+            const uint32_t k = m_radix[dim];
+            const uint32_t shift = ( k + 1 ) / 2 - 1;
+
+            coord[dim] = ( GetCoordinate( src, dim ) + shift ) % k;
+        }
+
+        dest[src] = GetIndex( coord );
+    }
+
+    return Permutation( dest );
+}
+
+TocinoSparseTrafficMatrix
+TocinoTrafficPatterns::NearestNeighbor() const
+{
+    std::vector< uint32_t > dest( m_nodes );
+    std::vector< uint32_t > coord( m_radix.size() );
+
+    for( uint32_t src = 0; src < m_nodes; ++src )
+    {
+        for( uint32_t dim = 0; dim < m_radix.size(); ++dim )
+        {
+            coord[dim] = ( GetCoordinate( src, dim ) + 1 ) % m_radix[dim];
+        }
+
+        dest[src] = GetIndex( coord );
+    }
+
+    return Permutation( dest );
+}
+
+TocinoSparseTrafficMatrix
+TocinoTrafficPatterns::Create( const std::string& name ) const
+{
+    if( name == "uniform" ) return UniformRandom();
+    if( name == "transpose" ) return Transpose();
+    if( name == "bitcomplement" ) return BitComplement();
+    if( name == "bitreverse" ) return BitReverse();
+    if( name == "shuffle" ) return Shuffle();
+    if( name == "tornado" ) return Tornado();
+    if( name == "neighbor" ) return NearestNeighbor();
+
+    NS_ABORT_MSG( "Unknown traffic pattern " << name );
+
+    return TocinoSparseTrafficMatrix();
+}
+
+}
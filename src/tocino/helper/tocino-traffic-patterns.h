@@ -0,0 +1,104 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_TRAFFIC_PATTERNS_H__
+#define __TOCINO_TRAFFIC_PATTERNS_H__
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include "ns3/tocino-traffic-matrix-application.h"
+
+#include "tocino-torus-topology-helper.h"
+
+namespace ns3
+{
+
+// The standard synthetic traffic patterns, after Dally and
+// Towles, as sparse matrices for a torus of any shape.
+//
+// Node indices are those of TocinoTorusTopologyHelper,
+// X varying fastest.  Patterns defined on coordinates
+// work for any radices; those defined on the bits of
+// the index require a power-of-two node count.
+//
+// Permutations cost one entry per node, so even a 32K
+// node machine needs well under a megabyte.  A node which
+// a permutation maps onto itself sends nothing, rather
+// than loop traffic back through its own host port.
+// Uniform random traffic is a single TOCINO_ALL_OTHERS
+// entry per node, and hotspot traffic adds one entry per
+// hot node, so neither grows as N squared.
+class TocinoTrafficPatterns
+{
+    public:
+
+    TocinoTrafficPatterns( const TocinoTorusTopologyHelper& );
+
+    uint32_t GetNNodes() const;
+
+    // Every other node equally likely
+    TocinoSparseTrafficMatrix UniformRandom() const;
+
+    // Coordinates reversed, e.g. (x,y) to (y,x); the
+    // radices must be symmetric likewise
+    TocinoSparseTrafficMatrix Transpose() const;
+
+    // Each coordinate c to k-1-c, which for power-of-two
+    // radices complements every bit of the index
+    TocinoSparseTrafficMatrix BitComplement() const;
+
+    // Bits of the index reversed
+    TocinoSparseTrafficMatrix BitReverse() const;
+
+    // Bits of the index rotated left by one
+    TocinoSparseTrafficMatrix Shuffle() const;
+
+    // Each coordinate c to c + ceil(k/2) - 1, mod k,
+    // nearly halfway around every ring
+    TocinoSparseTrafficMatrix Tornado() const;
+
+    // Each coordinate c to c + 1, mod k
+    TocinoSparseTrafficMatrix NearestNeighbor() const;
+
+    // The given fraction of each node's traffic split
+    // evenly among the hot nodes, the rest uniform random
+    TocinoSparseTrafficMatrix Hotspot(
+            const std::vector< uint32_t >&,
+            const double ) const;
+
+    // An arbitrary permutation, destination by source
+    TocinoSparseTrafficMatrix Permutation(
+            const std::vector< uint32_t >& ) const;
+
+    // Any of the above that take no parameters, by the
+    // lowercase name: uniform, transpose, bitcomplement,
+    // bitreverse, shuffle, tornado or neighbor
+    TocinoSparseTrafficMatrix Create( const std::string& ) const;
+
+    private:
+
+    uint32_t GetCoordinate( const uint32_t, const uint32_t ) const;
+
+    // Index of a node given one coordinate per dimension
+    uint32_t GetIndex( const std::vector< uint32_t >& ) const;
+
+    // Bits in the index; the node count must be 2^bits
+    uint32_t GetIndexBits() const;
+
+    // Append traffic spread evenly over the given sorted
+    // destinations, skipping the source; returns the
+    // traffic added, zero if there was nowhere to go
+    static uint32_t Spread(
+            TocinoSparseTrafficVector&,
+            const std::vector< uint32_t >&,
+            const uint32_t,
+            const uint32_t );
+
+    std::vector< uint32_t > m_radix;
+    std::vector< uint32_t > m_stride;
+    uint32_t m_nodes;
+};
+
+}
+
+#endif // __TOCINO_TRAFFIC_PATTERNS_H__
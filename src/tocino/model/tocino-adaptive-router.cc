@@ -0,0 +1,264 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include <limits>
+
+#include "ns3/log.h"
+
+#include "tocino-adaptive-router.h"
+#include "tocino-misc.h"
+#include "tocino-flit.h"
+#include "tocino-rx.h"
+#include "tocino-tx.h"
+#include "tocino-flit-id-tag.h"
+
+NS_LOG_COMPONENT_DEFINE ("TocinoAdaptiveRouter");
+
+#ifdef NS_LOG_APPEND_CONTEXT
+#pragma push_macro("NS_LOG_APPEND_CONTEXT")
+#undef NS_LOG_APPEND_CONTEXT
+#define NS_LOG_APPEND_CONTEXT \
+    { std::clog << "(" \
+                << (int) m_tnd->GetTocinoAddress().GetX() << "," \
+                << (int) m_tnd->GetTocinoAddress().GetY() << "," \
+                << (int) m_tnd->GetTocinoAddress().GetZ() << ") " \
+                << m_inputPort << " "; }
+#endif
+
+namespace ns3
+{
+
+NS_OBJECT_ENSURE_REGISTERED (TocinoAdaptiveRouter);
+
+TypeId TocinoAdaptiveRouter::GetTypeId(void)
+{
+    static TypeId tid = TypeId( "ns3::TocinoAdaptiveRouter" )
+        .SetParent<TocinoDimensionOrderRouter>()
+        .AddConstructor<TocinoAdaptiveRouter>();
+    return tid;
+}
+
+TocinoAdaptiveRouter::TocinoAdaptiveRouter()
+{}
+
+bool
+TocinoAdaptiveRouter::IsAdaptive() const
+{
+    return true;
+}
+
+bool
+TocinoAdaptiveRouter::IsEscapeVC( const TocinoVC vc ) const
+{
+    const TocinoVCAllocator& vca = m_tnd->GetVCAllocator();
+    
+    return vc < vca.GetClassBase( vca.GetClass( vc ) ).AsUInt32() + ESCAPE_VCS;
+}
+
+bool
+TocinoAdaptiveRouter::IsMinimalDirection(
+        const TocinoAddress::Coordinate src,
+        const TocinoAddress::Coordinate dst,
+        const TocinoDimension dim,
+        const TocinoDirection dir ) const
+{
+    NS_ASSERT( src != dst );
+
+    if( !TopologyHasWrapAround( dim ) )
+    {
+        if( dst > src )
+        {
+            return dir == TOCINO_DIRECTION_POS;
+        }
+        
+        return dir == TOCINO_DIRECTION_NEG;
+    }
+
+    const uint32_t radix = GetWrapAroundRadix( dim );
+    
+    // Hops needed in each direction
+    const uint32_t pos = ( dst + radix - src ) % radix;
+    const uint32_t neg = radix - pos;
+
+    // N.B. At exactly half way round, both are minimal
+    if( dir == TOCINO_DIRECTION_POS )
+    {
+        return pos <= neg;
+    }
+
+    return neg <= pos;
+}
+
+TocinoRoute
+TocinoAdaptiveRouter::AdaptiveRoute(
+        const TocinoAddress& localAddr,
+        const TocinoAddress& destAddr,
+        const TocinoInputVC inputVC ) const
+{
+    TocinoRoute best( TOCINO_INVALID_ROUTE );
+    uint32_t bestOccupancy = std::numeric_limits<uint32_t>::max();
+
+    // The adaptive VCs of the class, above its escape pair
+    const TocinoVCAllocator& vca = m_tnd->GetVCAllocator();
+    const uint32_t cls = vca.GetClass( inputVC );
+
+    const uint32_t firstVC = vca.GetClassBase( cls ).AsUInt32() + ESCAPE_VCS;
+    const uint32_t endVC = vca.GetClassBase( cls ).AsUInt32() + vca.GetClassVCs( cls );
+
+    const TocinoRx* rx = m_tnd->GetReceiver( m_inputPort );
+
+    // Ties go to the lowest dimension, then positive
+    // direction, then lowest VC, so that an idle network
+    // routes just as dimension order would
+    for( TocinoDimension dim = TOCINO_DIMENSION_X;
+            dim < TocinoAddress::MAX_DIM; ++dim )
+    {
+        const TocinoAddress::Coordinate localCoord = localAddr.GetCoordinate( dim );
+        const TocinoAddress::Coordinate destCoord = destAddr.GetCoordinate( dim );
+
+        if( localCoord == destCoord )
+        {
+            continue;
+        }
+
+        for( TocinoDirection dir = TOCINO_DIRECTION_POS;
+                dir < 2; ++dir )
+        {
+            if( !IsMinimalDirection( localCoord, destCoord, dim, dir ) )
+            {
+                continue;
+            }
+
+            const TocinoOutputPort outputPort = TocinoGetPort( dim, dir );
+            const TocinoTx* tx = m_tnd->GetTransmitter( outputPort );
+
+            // N.B.
+            // A head may take an adaptive VC only if it is
+            // idle: then the packet never waits behind
+            // another on it, and can only be held up where
+            // its head waits at the front of an input queue.
+            // There TocinoRx routes it again until it moves
+            // (IsAdaptive), and the escape VC is always among
+            // its choices, which is Duato's condition.
+            TocinoRoute idle( TOCINO_INVALID_ROUTE );
+
+            for( TocinoOutputVC outputVC = firstVC;
+                    outputVC < endVC; ++outputVC )
+            {
+                const TocinoRoute route( outputPort, inputVC, outputVC );
+
+                if( tx->IsVCIdle( outputVC ) && rx->CanForward( route ) )
+                {
+                    idle = route;
+                    break;
+                }
+            }
+
+            if( idle == TOCINO_INVALID_ROUTE )
+            {
+                continue;
+            }
+
+            // Congestion on the link, over all its VCs
+            uint32_t occupancy = 0;
+
+            for( TocinoOutputVC outputVC = 0;
+                    outputVC < m_tnd->GetNVCs(); ++outputVC )
+            {
+                occupancy += tx->GetOccupancy( outputVC );
+            }
+
+            if( occupancy < bestOccupancy )
+            {
+                best = idle;
+                bestOccupancy = occupancy;
+            }
+        }
+    }
+
+    return best;
+}
+
+TocinoRoute
+TocinoAdaptiveRouter::EscapeRoute(
+        const TocinoAddress& localAddr,
+        const TocinoAddress& destAddr,
+        const TocinoInputVC inputVC ) const
+{
+    // Enter the escape network afresh, in dimension
+    // order from here, on the base VC of the pair
+    const TocinoVCAllocator& vca = m_tnd->GetVCAllocator();
+    const TocinoVC escapeVC = vca.GetClassBase( vca.GetClass( inputVC ) );
+
+    TocinoDimension outputDim = TOCINO_INVALID_DIMENSION;
+
+    TocinoAddress::Coordinate localCoord = -1;
+    TocinoAddress::Coordinate destCoord = -1;
+
+    for( outputDim = TOCINO_DIMENSION_X;
+            outputDim < TocinoAddress::MAX_DIM; ++outputDim )
+    {
+        localCoord = localAddr.GetCoordinate( outputDim );
+        destCoord = destAddr.GetCoordinate( outputDim );
+
+        if( localCoord != destCoord )
+        {
+            break;
+        }
+    }
+    
+    NS_ASSERT( outputDim < TocinoAddress::MAX_DIM );
+
+    const TocinoDirection outputDir =
+        DetermineRoutingDirection( localCoord, destCoord, outputDim );
+    
+    TocinoOutputVC outputVC = escapeVC;
+
+    if( TopologyHasWrapAround( outputDim ) &&
+        RouteCrossesDateline( localCoord, outputDir, outputDim ) )
+    {
+        outputVC = vca.CrossDateline( escapeVC );
+    }
+
+    return TocinoRoute( TocinoGetPort( outputDim, outputDir ), inputVC, outputVC );
+}
+
+TocinoRoute
+TocinoAdaptiveRouter::Route( const TocinoFlit& flit ) const 
+{
+    NS_ASSERT( !flit.IsNull() );
+    
+    NS_LOG_FUNCTION( GetTocinoFlitIdString( flit ) );
+    NS_ASSERT( flit.IsHead() );
+    
+    const TocinoInputVC inputVC = flit.GetVirtualChannel();
+    
+    const TocinoVCAllocator& vca = m_tnd->GetVCAllocator();
+
+    NS_ASSERT_MSG( vca.GetClassVCs( vca.GetClass( inputVC ) ) > ESCAPE_VCS,
+            "Adaptive routing needs VCs beyond the escape pair" );
+    
+    const TocinoAddress localAddr = m_tnd->GetTocinoAddress();
+    const TocinoAddress destAddr = flit.GetDestination();
+
+    const bool injecting = ( m_inputPort == m_tnd->GetHostPort() );
+
+    if( ( destAddr == localAddr ) ||
+        ( !injecting && IsEscapeVC( inputVC ) ) )
+    {
+        // Delivery, or onward through the escape network;
+        // once escaped, a flow never returns to adaptive VCs
+        return TocinoDimensionOrderRouter::Route( flit );
+    }
+
+    TocinoRoute route = AdaptiveRoute( localAddr, destAddr, inputVC );
+
+    if( route != TOCINO_INVALID_ROUTE )
+    {
+        return route;
+    }
+
+    NS_LOG_LOGIC( "adaptive VCs congested, escaping" );
+
+    return EscapeRoute( localAddr, destAddr, inputVC );
+}
+
+}
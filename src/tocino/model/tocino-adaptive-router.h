@@ -0,0 +1,57 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_ADAPTIVE_ROUTER_H__
+#define __TOCINO_ADAPTIVE_ROUTER_H__
+
+#include "tocino-dimension-order-router.h"
+
+namespace ns3
+{
+
+// Minimal adaptive routing.  Among the output ports which
+// bring a flit closer to its destination, pick the least
+// congested.  The lowest VC pair of each traffic class is
+// an escape network, routed exactly as
+// TocinoDimensionOrderRouter would, and the other VCs of
+// the class are adaptive.  A head flit takes an adaptive
+// VC only when it is idle, and is routed again for as long
+// as it waits at the front of an input queue, so it can
+// always fall back on the escape VC.
+class TocinoAdaptiveRouter : public TocinoDimensionOrderRouter
+{
+    public:
+
+    static TypeId GetTypeId( void );
+
+    TocinoAdaptiveRouter();
+
+    TocinoRoute Route( const TocinoFlit& ) const;
+
+    bool IsAdaptive() const;
+
+    // The escape VC pair
+    static const uint32_t ESCAPE_VCS = 2;
+
+    bool IsEscapeVC( const TocinoVC ) const;
+
+    private:
+
+    bool IsMinimalDirection(
+            const TocinoAddress::Coordinate,
+            const TocinoAddress::Coordinate,
+            const TocinoDimension,
+            const TocinoDirection ) const;
+
+    TocinoRoute AdaptiveRoute(
+            const TocinoAddress&,
+            const TocinoAddress&,
+            const TocinoInputVC ) const;
+
+    TocinoRoute EscapeRoute(
+            const TocinoAddress&,
+            const TocinoAddress&,
+            const TocinoInputVC ) const;
+};
+
+}
+
+#endif //__TOCINO_ADAPTIVE_ROUTER_H__
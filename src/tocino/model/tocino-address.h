@@ -3,6 +3,8 @@
 #define __TOCINO_ADDRESS_H__
 
 #include <stdint.h>
+#include <sstream>
+#include <string>
 
 #include "ns3/mac48-address.h"
 
@@ -30,12 +32,14 @@ class TocinoAddress
     
     typedef uint8_t Coordinate;
     
-    TocinoAddress( Coordinate x, Coordinate y, Coordinate z, uint8_t res = 0 )
+    TocinoAddress( Coordinate x, Coordinate y, Coordinate z, Coordinate w = 0 )
     {
+        NS_ASSERT( w <= MAX_W );
+
         m_address.x = x;
         m_address.y = y;
         m_address.z = z;
-        m_address.reserved = res;
+        m_address.w = w;
         m_address.multicast = 0;
         
         m_isValid = true;
@@ -96,6 +100,9 @@ class TocinoAddress
         buf[1] = m_address.y;
         buf[0] = m_address.z;
 
+        // W is rare; fold it into the OUI rather than collide
+        buf[3] ^= m_address.w;
+
         Mac48Address a;
         a.CopyFrom( buf );
 
@@ -116,14 +123,30 @@ class TocinoAddress
     {
         return m_address.z;
     }
+    
+    Coordinate GetW() const
+    {
+        return m_address.w;
+    }
   
-    static const int MAX_DIM = 3;
+    static const int MAX_DIM = TOCINO_MAX_DIMENSIONS;
+
+    // N.B.
+    // The 4th dimension lives in the 7 bits formerly reserved,
+    // so its radix is limited to 128.  This keeps the address,
+    // and so the head flit, at 4 bytes.
+    static const Coordinate MAX_W = 127;
 
     Coordinate GetCoordinate( TocinoDimension d ) const
     {
         NS_ASSERT( d != TOCINO_INVALID_DIMENSION );
         NS_ASSERT( d < MAX_DIM );
 
+        if( d == TOCINO_DIMENSION_W )
+        {
+            return m_address.w;
+        }
+
         return m_address.coord[ d.AsUInt32() ];
     }
 
@@ -150,10 +173,10 @@ class TocinoAddress
                 {
                     Coordinate x, y, z;
                 };
-                Coordinate coord[MAX_DIM];
+                Coordinate coord[3];
             };
 
-            uint8_t reserved  : 7;
+            uint8_t w         : 7;
             uint8_t multicast : 1;
         };
         uint32_t raw;
@@ -163,6 +186,26 @@ class TocinoAddress
     bool m_isValid;
 };
 
+// Colon-separated coordinates, e.g. "1:2:0:0", which are
+// safe to embed in comma-separated output
+inline std::string
+TocinoAddressToString( const TocinoAddress& ta )
+{
+    std::ostringstream oss;
+
+    for( int dim = 0; dim < TocinoAddress::MAX_DIM; ++dim )
+    {
+        if( dim > 0 )
+        {
+            oss << ":";
+        }
+
+        oss << static_cast<unsigned>( ta.GetCoordinate( dim ) );
+    }
+
+    return oss.str();
+}
+
 }
 
 #endif /* __TOCINO_ADDRESS_H__ */
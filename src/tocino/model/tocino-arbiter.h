@@ -5,6 +5,7 @@
 #include "ns3/object.h"
 #include "ns3/ptr.h"
 
+#include "tocino-flow-control.h"
 #include "tocino-misc.h"
 
 namespace ns3
@@ -46,6 +47,23 @@ struct TocinoArbiterAllocation
     }
 };
 
+// Why an arbiter found no candidate, counted once per
+// VC each time Arbitrate returns DO_NOTHING
+struct TocinoArbiterStallCounts
+{
+    uint32_t allocatedQueueIsEmpty;
+    uint32_t allocatedQueueNotEmptyButXOFF;
+    uint32_t unallocatedButAllQueuesEmpty;
+    uint32_t unallocatedButAllNonEmptyQueuesAreXOFF;
+
+    TocinoArbiterStallCounts()
+        : allocatedQueueIsEmpty( 0 )
+        , allocatedQueueNotEmptyButXOFF( 0 )
+        , unallocatedButAllQueuesEmpty( 0 )
+        , unallocatedButAllNonEmptyQueuesAreXOFF( 0 )
+    {}
+};
+
 struct TocinoArbiter : public Object
 {
     static TypeId GetTypeId( void );
@@ -68,6 +86,15 @@ struct TocinoArbiter : public Object
 
     virtual void ReportStatistics() const = 0;
 
+    virtual TocinoArbiterStallCounts GetStallCounts() const = 0;
+
+    // Notifications from TocinoTx, for arbiters which
+    // track queue and XON/XOFF state incrementally rather
+    // than polling it on every call to Arbitrate.
+    virtual void FlitEnqueued( const TocinoInputPort, const TocinoOutputVC ) {}
+    virtual void FlitDequeued( const TocinoInputPort, const TocinoOutputVC ) {}
+    virtual void XStateChanged( const TocinoFlowControlState& ) {}
+
     static const TocinoArbiterAllocation DO_NOTHING;
 };
 
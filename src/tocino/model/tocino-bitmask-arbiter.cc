@@ -0,0 +1,377 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#include "tocino-bitmask-arbiter.h"
+
+#include "ns3/log.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+
+#include "tocino-misc.h"
+#include "tocino-net-device.h"
+#include "tocino-tx.h"
+
+NS_LOG_COMPONENT_DEFINE ("TocinoBitmaskArbiter");
+
+#ifdef NS_LOG_APPEND_CONTEXT
+#pragma push_macro("NS_LOG_APPEND_CONTEXT")
+#undef NS_LOG_APPEND_CONTEXT
+#define NS_LOG_APPEND_CONTEXT \
+    { std::clog << "(" \
+                << (int) m_tnd->GetTocinoAddress().GetX() << "," \
+                << (int) m_tnd->GetTocinoAddress().GetY() << "," \
+                << (int) m_tnd->GetTocinoAddress().GetZ() << ") " \
+                << m_ttx->GetPortNumber() << " "; }
+#endif
+
+namespace ns3
+{
+
+NS_OBJECT_ENSURE_REGISTERED (TocinoBitmaskArbiter);
+
+TypeId TocinoBitmaskArbiter::GetTypeId(void)
+{
+    static TypeId tid = TypeId( "ns3::TocinoBitmaskArbiter" )
+        .SetParent<TocinoArbiter>()
+        .AddAttribute( "Priority",
+            "How to rotate priority among candidates.",
+            EnumValue( ROUND_ROBIN ),
+            MakeEnumAccessor( &TocinoBitmaskArbiter::m_priority ),
+            MakeEnumChecker( ROUND_ROBIN, "RoundRobin",
+                             LFSR, "LFSR" ) )
+        .AddAttribute( "Seed",
+            "Initial LFSR state, when Priority is LFSR.",
+            UintegerValue( 1 ),
+            MakeUintegerAccessor( &TocinoBitmaskArbiter::m_seed ),
+            MakeUintegerChecker<uint32_t>() )
+        .AddConstructor<TocinoBitmaskArbiter>();
+    return tid;
+}
+
+TocinoBitmaskArbiter::TocinoBitmaskArbiter()
+    : m_tnd( NULL )
+    , m_ttx( NULL )
+    , m_nPorts( 0 )
+    , m_nVCs( 0 )
+    , m_nonEmptyVCs( 0 )
+    , m_xonVCs( 0 )
+    , m_ownedVCs( 0 )
+    , m_priority( ROUND_ROBIN )
+    , m_seed( 1 )
+    , m_lfsr( 1 )
+    , m_lastVC( 0 )
+    , m_stallAllocatedQueueIsEmpty( 0 )
+    , m_stallAllocatedQueueNotEmptyButXOFF( 0 )
+    , m_stallUnallocatedButAllQueuesEmpty( 0 )
+    , m_stallUnallocatedButAllNonEmptyQueuesAreXOFF( 0 )
+{}
+
+void TocinoBitmaskArbiter::Initialize( const TocinoNetDevice* tnd, const TocinoTx* ttx )
+{
+    m_tnd = tnd;
+    m_ttx = ttx;
+
+    m_nPorts = m_tnd->GetNPorts();
+    m_nVCs = m_tnd->GetNVCs();
+
+    // One bit per port, and one bit per VC
+    NS_ASSERT( m_nPorts <= 32 );
+    NS_ASSERT( m_nVCs <= TOCINO_MAX_VCS );
+
+    for( uint32_t vc = 0; vc < TOCINO_MAX_VCS; ++vc )
+    {
+        m_readyPorts[ vc ] = 0;
+        m_owner[ vc ] = TOCINO_INVALID_PORT.AsUInt32();
+        m_lastPort[ vc ] = m_nPorts - 1;
+    }
+
+    m_nonEmptyVCs = 0;
+    m_ownedVCs = 0;
+    m_lastVC = m_nVCs - 1;
+
+    XStateChanged( TocinoAllXON );
+
+    // A 16-bit LFSR must never be seeded with zero
+    m_lfsr = m_seed & 0xFFFF;
+    if( m_lfsr == 0 )
+    {
+        m_lfsr = 1;
+    }
+}
+
+void
+TocinoBitmaskArbiter::FlitEnqueued(
+        const TocinoInputPort inputPort,
+        const TocinoOutputVC outputVC )
+{
+    const uint32_t vc = outputVC.AsUInt32();
+
+    m_readyPorts[ vc ] |= ( 1u << inputPort.AsUInt32() );
+    m_nonEmptyVCs |= ( 1u << vc );
+}
+
+void
+TocinoBitmaskArbiter::FlitDequeued(
+        const TocinoInputPort inputPort,
+        const TocinoOutputVC outputVC )
+{
+    if( m_ttx->IsQueueEmpty( inputPort, outputVC ) )
+    {
+        const uint32_t vc = outputVC.AsUInt32();
+
+        m_readyPorts[ vc ] &= ~( 1u << inputPort.AsUInt32() );
+
+        if( m_readyPorts[ vc ] == 0 )
+        {
+            m_nonEmptyVCs &= ~( 1u << vc );
+        }
+    }
+}
+
+void
+TocinoBitmaskArbiter::XStateChanged( const TocinoFlowControlState& xState )
+{
+    const uint32_t ALL_VCS = ( 1u << m_nVCs ) - 1;
+
+    m_xonVCs = static_cast<uint32_t>( xState.to_ulong() ) & ALL_VCS;
+}
+
+uint32_t
+TocinoBitmaskArbiter::GetCandidateVCs() const
+{
+    // We can transmit on an output VC iff
+    //  -It is XON
+    //  -Some queue is not empty, and
+    //  -If allocated, the owner's queue is not empty
+
+    uint32_t candidates = m_xonVCs & m_nonEmptyVCs;
+    uint32_t owned = candidates & m_ownedVCs;
+
+    while( owned != 0 )
+    {
+        const uint32_t vc = __builtin_ctz( owned );
+        owned &= owned - 1;
+
+        if( ( m_readyPorts[ vc ] & ( 1u << m_owner[ vc ] ) ) == 0 )
+        {
+            candidates &= ~( 1u << vc );
+        }
+    }
+
+    return candidates;
+}
+
+uint32_t
+TocinoBitmaskArbiter::NextPriority( const uint32_t last, const uint32_t width )
+{
+    if( m_priority == ROUND_ROBIN )
+    {
+        return ( last + 1 ) % width;
+    }
+
+    // Galois LFSR, x^16 + x^14 + x^13 + x^11 + 1
+    m_lfsr = ( m_lfsr >> 1 ) ^ ( -( m_lfsr & 1u ) & 0xB400u );
+
+    return m_lfsr % width;
+}
+
+uint32_t
+TocinoBitmaskArbiter::SelectBit( const uint32_t mask, const uint32_t start )
+{
+    // The first asserted bit at or after start, wrapping around
+    NS_ASSERT( mask != 0 );
+    NS_ASSERT( start < 32 );
+
+    const uint32_t upper = mask & ~( ( 1u << start ) - 1 );
+
+    if( upper != 0 )
+    {
+        return __builtin_ctz( upper );
+    }
+
+    return __builtin_ctz( mask );
+}
+
+void
+TocinoBitmaskArbiter::UpdateState( const TocinoArbiterAllocation winner )
+{
+    const uint32_t inputPort = winner.inputPort.AsUInt32();
+    const uint32_t outputVC = winner.outputVC.AsUInt32();
+
+    if( m_ttx->IsNextFlitTail( inputPort, outputVC ) )
+    {
+        // Flow ending, reset
+        m_ownedVCs &= ~( 1u << outputVC );
+        m_owner[ outputVC ] = TOCINO_INVALID_PORT.AsUInt32();
+    }
+    else
+    {
+        // Remember mapping
+        m_ownedVCs |= ( 1u << outputVC );
+        m_owner[ outputVC ] = inputPort;
+
+        if (m_ttx->IsNextFlitHead( inputPort, outputVC ) )
+        {
+            NS_LOG_LOGIC( "outputVC=" << outputVC
+                    << " allocated to inputPort=" << inputPort );
+        }
+    }
+}
+
+void
+TocinoBitmaskArbiter::CollectStallInfo()
+{
+    // Given that we *know* we will stall (no candidates)
+    // keep track of the reason why
+
+    for( uint32_t vc = 0; vc < m_nVCs; ++vc )
+    {
+        const uint32_t VC_BIT = 1u << vc;
+
+        if( m_ownedVCs & VC_BIT )
+        {
+            if( ( m_readyPorts[ vc ] & ( 1u << m_owner[ vc ] ) ) == 0 )
+            {
+                m_stallAllocatedQueueIsEmpty++;
+            }
+            else
+            {
+                NS_ASSERT( ( m_xonVCs & VC_BIT ) == 0 );
+
+                m_stallAllocatedQueueNotEmptyButXOFF++;
+            }
+        }
+        else
+        {
+            if( m_readyPorts[ vc ] == 0 )
+            {
+                m_stallUnallocatedButAllQueuesEmpty++;
+            }
+            else
+            {
+                NS_ASSERT( ( m_xonVCs & VC_BIT ) == 0 );
+
+                m_stallUnallocatedButAllNonEmptyQueuesAreXOFF++;
+            }
+        }
+    }
+}
+
+TocinoArbiterAllocation
+TocinoBitmaskArbiter::Arbitrate()
+{
+    const uint32_t candidateVCs = GetCandidateVCs();
+
+    if( candidateVCs == 0 )
+    {
+        CollectStallInfo();
+
+        NS_LOG_LOGIC( "no candidates" );
+        return DO_NOTHING;
+    }
+
+    const uint32_t vc =
+        SelectBit( candidateVCs, NextPriority( m_lastVC, m_nVCs ) );
+
+    uint32_t port;
+
+    if( m_ownedVCs & ( 1u << vc ) )
+    {
+        // can only select the allocated queue
+        port = m_owner[ vc ];
+
+        NS_ASSERT( !m_ttx->IsNextFlitHead( port, vc ) );
+    }
+    else
+    {
+        // can select any queue that is ready
+        port = SelectBit( m_readyPorts[ vc ],
+                NextPriority( m_lastPort[ vc ], m_nPorts ) );
+
+        NS_ASSERT( m_ttx->IsNextFlitHead( port, vc ) );
+    }
+
+    NS_ASSERT( !m_ttx->IsQueueEmpty( port, vc ) );
+    NS_ASSERT( !m_ttx->IsVCPaused( vc ) );
+
+    m_lastVC = vc;
+    m_lastPort[ vc ] = port;
+
+    const TocinoArbiterAllocation winner( port, vc );
+
+    UpdateState( winner );
+
+    NS_LOG_LOGIC( "winner is inputPort=" << winner.inputPort
+            << ", outputVC=" << winner.outputVC );
+
+    return winner;
+}
+
+TocinoArbiterAllocation
+TocinoBitmaskArbiter::GetVCOwner( const TocinoOutputVC outputVC ) const
+{
+    NS_ASSERT( outputVC < m_nVCs );
+
+    const uint32_t vc = outputVC.AsUInt32();
+
+    if( m_ownedVCs & ( 1u << vc ) )
+    {
+        return TocinoArbiterAllocation( m_owner[ vc ], vc );
+    }
+
+    return TocinoArbiterAllocation( TOCINO_INVALID_PORT, TOCINO_INVALID_VC );
+}
+
+TocinoArbiterStallCounts
+TocinoBitmaskArbiter::GetStallCounts() const
+{
+    TocinoArbiterStallCounts counts;
+
+    counts.allocatedQueueIsEmpty = m_stallAllocatedQueueIsEmpty;
+    counts.allocatedQueueNotEmptyButXOFF = m_stallAllocatedQueueNotEmptyButXOFF;
+    counts.unallocatedButAllQueuesEmpty = m_stallUnallocatedButAllQueuesEmpty;
+    counts.unallocatedButAllNonEmptyQueuesAreXOFF =
+        m_stallUnallocatedButAllNonEmptyQueuesAreXOFF;
+
+    return counts;
+}
+
+void
+TocinoBitmaskArbiter::ReportStatistics() const
+{
+    // We have a reason per VC per stall
+
+    uint32_t totalStallReasons =
+        m_stallAllocatedQueueIsEmpty +
+        m_stallAllocatedQueueNotEmptyButXOFF +
+        m_stallUnallocatedButAllQueuesEmpty +
+        m_stallUnallocatedButAllNonEmptyQueuesAreXOFF;
+
+    NS_LOG_LOGIC( "stalls due to allocated queue being empty: "
+            << m_stallAllocatedQueueIsEmpty
+            << " ("
+            << ( static_cast<double>(m_stallAllocatedQueueIsEmpty) /
+                totalStallReasons * 100 )
+            << "%)" );
+
+    NS_LOG_LOGIC( "stalls due to allocated queue not empty, but XOFF: "
+            << m_stallAllocatedQueueNotEmptyButXOFF
+            << " ("
+            << ( static_cast<double>(m_stallAllocatedQueueNotEmptyButXOFF) /
+                totalStallReasons * 100 )
+            << "%)" );
+
+    NS_LOG_LOGIC( "stalls when no queue is allocated but all queues are empty: "
+            << m_stallUnallocatedButAllQueuesEmpty
+            << " ("
+            << ( static_cast<double>(m_stallUnallocatedButAllQueuesEmpty) /
+                totalStallReasons * 100 )
+            << "%)" );
+
+    NS_LOG_LOGIC( "stalls when no queue is allocated but all non-empty queues are XOFF: "
+            << m_stallUnallocatedButAllNonEmptyQueuesAreXOFF
+            << " ("
+            << ( static_cast<double>(m_stallUnallocatedButAllNonEmptyQueuesAreXOFF) /
+                totalStallReasons * 100 )
+            << "%)" );
+}
+
+}
@@ -19,6 +19,36 @@
 
 NS_LOG_COMPONENT_DEFINE ("TocinoChannel");
 
+namespace
+{
+
+// N.B.
+// Formatted on demand, rather than when the channel is
+// wired up, so setup of large tori costs no string work.
+std::string
+TocinoEndpointString( const ns3::TocinoAddress& addr )
+{
+    std::ostringstream oss;
+
+    oss << "("
+        << static_cast<unsigned>( addr.GetX() )
+        << ","
+        << static_cast<unsigned>( addr.GetY() )
+        << ","
+        << static_cast<unsigned>( addr.GetZ() );
+
+    if( addr.GetW() != 0 )
+    {
+        oss << "," << static_cast<unsigned>( addr.GetW() );
+    }
+
+    oss << ")";
+
+    return oss.str();
+}
+
+}
+
 namespace ns3 {
 
 NS_OBJECT_ENSURE_REGISTERED( TocinoChannel );
@@ -44,13 +74,14 @@ TypeId TocinoChannel::GetTypeId( void )
 TocinoChannel::TocinoChannel()
     : m_delay( Seconds( 0 ) )
     , m_bps( DataRate( "10Gbps" ) )
-    , m_flit( NULL )
+    , m_flit()
     , m_tx( NULL )
     , m_rx( NULL )
     , m_state( IDLE )
     , m_totalBytesTransmitted( 0 )
     , m_totalFlitsTransmitted( 0 )
     , m_totalTransmitTime( Seconds( 0 ) )
+    , m_transmitEndTime( Seconds( 0 ) )
     , m_LLCBytesTransmitted( 0 )
     , m_LLCFlitsTransmitted( 0 )
     , m_LLCTransmitTime( Seconds( 0 ) )
@@ -59,30 +90,15 @@ TocinoChannel::TocinoChannel()
 TocinoChannel::~TocinoChannel()
 {};
 
-Time TocinoChannel::GetTransmissionTime(Ptr<Packet> p)
+Time TocinoChannel::GetTransmissionTime( const TocinoFlit& flit ) const
 {
-    return Seconds( m_bps.CalculateTxTime( p->GetSize() ) );
+    return Seconds( m_bps.CalculateTxTime( flit.GetSize() ) );
 }
 
 void TocinoChannel::SetTransmitter(TocinoTx* tx)
 {
     m_tx = tx;
 
-    std::ostringstream oss;
-    
-    Ptr<TocinoNetDevice> txNetDevice = m_tx->GetTocinoNetDevice();
-    TocinoAddress txAdd = txNetDevice->GetTocinoAddress();
-
-    oss << "("
-        << static_cast<unsigned>( txAdd.GetX() )
-        << ","
-        << static_cast<unsigned>( txAdd.GetY() )
-        << ","
-        << static_cast<unsigned>( txAdd.GetZ() )
-        << ")";
-
-    m_txString = oss.str();
-
     m_vcUsageHistogram.resize( m_tx->GetTocinoNetDevice()->GetNVCs(), 0 );
 }
 
@@ -90,21 +106,6 @@ void TocinoChannel::SetTransmitter(TocinoTx* tx)
 void TocinoChannel::SetReceiver(TocinoRx* rx)
 {
     m_rx = rx;
-    
-    std::ostringstream oss;
-    
-    Ptr<TocinoNetDevice> rxNetDevice = m_rx->GetTocinoNetDevice();
-    TocinoAddress rxAdd = rxNetDevice->GetTocinoAddress();
-
-    oss << "("
-        << static_cast<unsigned>( rxAdd.GetX() )
-        << ","
-        << static_cast<unsigned>( rxAdd.GetY() )
-        << ","
-        << static_cast<unsigned>( rxAdd.GetZ() )
-        << ")";
-
-    m_rxString = oss.str();
 }
 
 uint32_t TocinoChannel::GetNDevices() const
@@ -136,33 +137,40 @@ TocinoChannel::GetTocinoDevice(uint32_t i) const
     return Ptr<TocinoNetDevice>( m_rx->GetTocinoNetDevice() );
 }
 
-bool
-TocinoChannel::TransmitStart (Ptr<Packet> flit)
+Time
+TocinoChannel::RecordTransmission( const TocinoFlit& flit, const Time start )
 {
-    Time transmit_time;
-  
-    NS_ASSERT( m_state == IDLE );
-
-    m_flit = flit;
-    
-    transmit_time = GetTransmissionTime( flit );
+    const Time transmit_time = GetTransmissionTime( flit );
   
-    m_totalBytesTransmitted += flit->GetSize();
+    m_totalBytesTransmitted += flit.GetSize();
     m_totalFlitsTransmitted++;
 
     m_totalTransmitTime += transmit_time;
+    m_transmitEndTime = start + transmit_time;
 
-    if( IsTocinoFlowControlFlit( flit ) )
+    if( flit.IsFlowControl() )
     {
-        m_LLCBytesTransmitted += flit->GetSize();
+        m_LLCBytesTransmitted += flit.GetSize();
         m_LLCFlitsTransmitted++;
 
         m_LLCTransmitTime += transmit_time;
     }
 
-    TocinoOutputVC vc = GetTocinoFlitVirtualChannel( flit );
+    TocinoOutputVC vc = flit.GetVirtualChannel();
     m_vcUsageHistogram[ vc.AsUInt32() ]++;
 
+    return transmit_time;
+}
+
+bool
+TocinoChannel::TransmitStart( const TocinoFlit& flit )
+{
+    NS_ASSERT( m_state == IDLE );
+
+    m_flit = flit;
+    
+    Time transmit_time = RecordTransmission( flit, Simulator::Now() );
+
     Simulator::Schedule(transmit_time, &TocinoChannel::TransmitEnd, this);
     return true;
 }
@@ -179,6 +187,107 @@ TocinoChannel::TransmitEnd ()
                                    m_flit);
 }
 
+void
+TocinoChannel::TransmitStartFused( const TocinoFlit& flit )
+{
+    NS_ASSERT( m_state == IDLE );
+
+    m_flit = flit;
+
+    RecordTransmission( flit, Simulator::Now() );
+}
+
+void
+TocinoChannel::TransmitEndFused()
+{
+    TransmitEnd();
+}
+
+bool
+TocinoChannel::SupportsExpress() const
+{
+    return true;
+}
+
+Time
+TocinoChannel::TransmitExpress( const TocinoFlit& flit, const Time start )
+{
+    NS_ASSERT( start >= Simulator::Now() );
+
+    const Time transmit_time = RecordTransmission( flit, start );
+
+    ExpressFlit ef;
+
+    ef.flit = flit;
+    ef.start = start;
+    ef.arrival = start + transmit_time + m_delay;
+
+    NS_ASSERT( m_expressFlits.empty() ||
+            ( ef.arrival > m_expressFlits.back().arrival ) );
+
+    m_expressFlits.push_back( ef );
+
+    if( m_expressFlits.size() == 1 )
+    {
+        Simulator::ScheduleWithContext( m_rx->GetNetDevice()->GetNode()->GetId(),
+                ef.arrival - Simulator::Now(),
+                &TocinoChannel::ExpressArrive,
+                this );
+    }
+
+    return transmit_time;
+}
+
+void
+TocinoChannel::WithdrawExpress( const uint32_t flits )
+{
+    // N.B.
+    // Only flits yet to start are withdrawn.  The first
+    // flit of a run starts at once, so the flit whose
+    // ExpressArrive is pending is never among them.
+    NS_ASSERT( flits < m_expressFlits.size() );
+
+    for( uint32_t i = 0; i < flits; ++i )
+    {
+        const TocinoFlit& flit = m_expressFlits.back().flit;
+        
+        const Time transmit_time = GetTransmissionTime( flit );
+
+        NS_ASSERT( !flit.IsFlowControl() );
+
+        m_totalBytesTransmitted -= flit.GetSize();
+        m_totalFlitsTransmitted--;
+
+        m_totalTransmitTime -= transmit_time;
+        m_transmitEndTime -= transmit_time;
+
+        TocinoOutputVC vc = flit.GetVirtualChannel();
+        m_vcUsageHistogram[ vc.AsUInt32() ]--;
+
+        m_expressFlits.pop_back();
+    }
+}
+
+void
+TocinoChannel::ExpressArrive()
+{
+    NS_ASSERT( !m_expressFlits.empty() );
+    NS_ASSERT( m_expressFlits.front().arrival == Simulator::Now() );
+
+    const TocinoFlit flit = m_expressFlits.front().flit;
+
+    m_expressFlits.pop_front();
+
+    if( !m_expressFlits.empty() )
+    {
+        Simulator::Schedule( m_expressFlits.front().arrival - Simulator::Now(),
+                &TocinoChannel::ExpressArrive,
+                this );
+    }
+
+    m_rx->Receive( flit );
+}
+
 uint32_t
 TocinoChannel::FlitBuffersRequired() const
 {
@@ -197,14 +306,51 @@ TocinoChannel::FlitBuffersRequired() const
     // We ignore that here, but take it into account later.
     
     const int SIZE_MAX_FLIT = TocinoFlitHeader::FLIT_LENGTH;
-    const int SIZE_LLC_FLIT = GetTocinoFlowControlFlit(0)->GetSize();
+    const int SIZE_LLC_FLIT = GetPooledTocinoFlowControlFlit( TocinoAllXOFF ).GetSize();
 
+    // N.B.
+    // CalculateTxTime() takes bytes, not bits.
     Time window = 
-        Seconds( m_bps.CalculateTxTime( (SIZE_MAX_FLIT+SIZE_LLC_FLIT)*8 ) + m_delay );
+        Seconds( m_bps.CalculateTxTime( SIZE_MAX_FLIT+SIZE_LLC_FLIT ) ) + m_delay;
+
+    uint32_t flits = DensestFlitsWithin( window );
 
+    // Add one to account for possibility that receiver
+    // may have put a flit on the wire *just* prior to
+    // receipt of LLC flit
+    flits++;
+
+    //NS_LOG_LOGIC( flits << " buffers required" );
+
+    return flits;
+}
+
+uint32_t
+TocinoChannel::CreditBuffersRequired() const
+{
+    // Credit flow control is always safe, whatever the
+    // depth of the input queues.  But a VC can only stream
+    // at the full rate of the channel if it never runs out
+    // of credits, i.e. if it has a buffer for every flit
+    // sent during one credit round trip:
+    //  - a flit crosses the channel
+    //  - the reverse transmitter finishes a max size flit
+    //  - the credit flit crosses back
+    
+    const int SIZE_MAX_FLIT = TocinoFlitHeader::FLIT_LENGTH;
+    const int SIZE_CREDIT_FLIT = GetPooledTocinoCreditFlit( TocinoCredits() ).GetSize();
+    
+    Time roundTrip = 
+        Seconds( m_bps.CalculateTxTime( SIZE_MAX_FLIT+SIZE_CREDIT_FLIT ) ) + m_delay + m_delay;
+
+    return DensestFlitsWithin( roundTrip );
+}
+
+uint32_t
+TocinoChannel::DensestFlitsWithin( const Time window ) const
+{
     // What's the worst case number of flits that could
-    // have been sent over a single VC during this
-    // vulnerable period?
+    // be sent over a single VC during this window?
     //
     // We need to determine the most *dense* flit
     // pattern (the most flits in the fewest bytes).
@@ -227,12 +373,14 @@ TocinoChannel::FlitBuffersRequired() const
     // never happen on a single VC and would require
     // an unreasonable about of reserve buffer space.
     
+    const int SIZE_MAX_FLIT = TocinoFlitHeader::FLIT_LENGTH;
+
     // Non-repeating part, a single min-tail flit
     
     const int SIZE_MIN_TAIL_FLIT = TocinoFlitHeader::SIZE_OTHER+1;
     
     Time noRep =
-        Seconds( m_bps.CalculateTxTime( SIZE_MIN_TAIL_FLIT*8 ) );
+        Seconds( m_bps.CalculateTxTime( SIZE_MIN_TAIL_FLIT ) );
 
     // Repeating pattern A is simply:
     //  - 1 minimum payload head-tail flit
@@ -240,14 +388,14 @@ TocinoChannel::FlitBuffersRequired() const
     const int SIZE_MIN_HEADTAIL_FLIT = TocinoFlitHeader::SIZE_HEAD+1;
 
     Time patA = 
-        Seconds( m_bps.CalculateTxTime( SIZE_MIN_HEADTAIL_FLIT*8 ) );
+        Seconds( m_bps.CalculateTxTime( SIZE_MIN_HEADTAIL_FLIT ) );
     
     // Repeating pattern B is:
     //  - 1 full head flit
     //  - 1 minimum-size tail flit
    
     Time patB = 
-        Seconds( m_bps.CalculateTxTime( (SIZE_MAX_FLIT+SIZE_MIN_TAIL_FLIT)*8 ) );
+        Seconds( m_bps.CalculateTxTime( SIZE_MAX_FLIT+SIZE_MIN_TAIL_FLIT ) );
 
     // Worst case is whichever pattern takes less time
 
@@ -260,31 +408,90 @@ TocinoChannel::FlitBuffersRequired() const
     uint32_t flits =
         ceil( ( ( (window-noRep).GetDouble() / rep.GetDouble() ) + 1 ) );
 
-    // Add one to account for possibility that receiver
-    // may have put a flit on the wire *just* prior to
-    // receipt of LLC flit
-    flits++;
+    return flits;
+}
 
-    //NS_LOG_LOGIC( flits << " buffers required" );
+Time
+TocinoChannel::GetLookahead() const
+{
+    // Everything that crosses a channel, data or LLC, pays
+    // at least the serialization time of the smallest flit
+    // plus the wire delay before reaching the receiver.
 
-    return flits;
+    const uint32_t SIZE_MIN_TAIL_FLIT = TocinoFlitHeader::SIZE_OTHER+1;
+    const uint32_t SIZE_LLC_FLIT = GetPooledTocinoFlowControlFlit( TocinoAllXOFF ).GetSize();
+
+    const uint32_t SIZE_MIN_FLIT = std::min( SIZE_MIN_TAIL_FLIT, SIZE_LLC_FLIT );
+
+    return Seconds( m_bps.CalculateTxTime( SIZE_MIN_FLIT ) ) + m_delay;
+}
+
+uint32_t
+TocinoChannel::GetUnstartedExpressFlits() const
+{
+    // N.B.
+    // RecordTransmission counts every flit of an express
+    // run when the run begins, so the getters take back
+    // those yet to start
+    const Time now = Simulator::Now();
+
+    uint32_t unstarted = 0;
+
+    while( ( unstarted < m_expressFlits.size() ) &&
+            ( m_expressFlits[ m_expressFlits.size() - unstarted - 1 ].start > now ) )
+    {
+        unstarted++;
+    }
+
+    return unstarted;
 }
 
 uint32_t
 TocinoChannel::GetTotalBytesTransmitted() const
 {
-    return m_totalBytesTransmitted;
+    uint32_t bytes = m_totalBytesTransmitted;
+
+    const uint32_t unstarted = GetUnstartedExpressFlits();
+
+    for( uint32_t i = m_expressFlits.size() - unstarted; i < m_expressFlits.size(); ++i )
+    {
+        bytes -= m_expressFlits[i].flit.GetSize();
+    }
+
+    return bytes;
 }
 
 uint32_t
 TocinoChannel::GetTotalFlitsTransmitted() const
 {
-    return m_totalFlitsTransmitted;
+    return m_totalFlitsTransmitted - GetUnstartedExpressFlits();
 }
 
 Time
 TocinoChannel::GetTotalTransmitTime() const
 {
+    Time total = m_totalTransmitTime;
+
+    const uint32_t unstarted = GetUnstartedExpressFlits();
+
+    for( uint32_t i = m_expressFlits.size() - unstarted; i < m_expressFlits.size(); ++i )
+    {
+        total -= GetTransmissionTime( m_expressFlits[i].flit );
+    }
+
+    return total;
+}
+
+Time
+TocinoChannel::GetElapsedTransmitTime() const
+{
+    const Time now = Simulator::Now();
+
+    if( m_transmitEndTime > now )
+    {
+        return m_totalTransmitTime - ( m_transmitEndTime - now );
+    }
+
     return m_totalTransmitTime;
 }
 
@@ -306,25 +513,52 @@ TocinoChannel::GetLLCTransmitTime() const
     return m_LLCTransmitTime;
 }
 
+uint32_t
+TocinoChannel::GetVCFlits( const TocinoVC vc ) const
+{
+    NS_ASSERT( vc.AsUInt32() < m_vcUsageHistogram.size() );
+
+    uint32_t flits = m_vcUsageHistogram[ vc.AsUInt32() ];
+
+    const uint32_t unstarted = GetUnstartedExpressFlits();
+
+    for( uint32_t i = m_expressFlits.size() - unstarted; i < m_expressFlits.size(); ++i )
+    {
+        if( m_expressFlits[i].flit.GetVirtualChannel() == vc )
+        {
+            flits--;
+        }
+    }
+
+    return flits;
+}
+
 void
 TocinoChannel::ReportStatistics() const
 {
     std::ostringstream prefix;
     
-    prefix << m_txString << " --> " << m_rxString << ": ";
+    prefix << TocinoEndpointString( m_tx->GetTocinoNetDevice()->GetTocinoAddress() )
+        << " --> "
+        << TocinoEndpointString( m_rx->GetTocinoNetDevice()->GetTocinoAddress() )
+        << ": ";
+
+    const uint32_t totalBytesTransmitted = GetTotalBytesTransmitted();
+    const uint32_t totalFlitsTransmitted = GetTotalFlitsTransmitted();
+    const Time totalTransmitTime = GetTotalTransmitTime();
 
     // Bytes
-    uint32_t dataBytesTransmitted = m_totalBytesTransmitted - m_LLCBytesTransmitted;
+    uint32_t dataBytesTransmitted = totalBytesTransmitted - m_LLCBytesTransmitted;
 
     double dataBytesPercentage =
-        static_cast<double>(dataBytesTransmitted) / m_totalBytesTransmitted * 100;
+        static_cast<double>(dataBytesTransmitted) / totalBytesTransmitted * 100;
 
     double LLCBytesPercentage =
-        static_cast<double>(m_LLCBytesTransmitted) / m_totalBytesTransmitted * 100;
+        static_cast<double>(m_LLCBytesTransmitted) / totalBytesTransmitted * 100;
 
     NS_LOG_LOGIC( prefix.str()
             << "total bytes: "
-            << m_totalBytesTransmitted );
+            << totalBytesTransmitted );
     
     NS_LOG_LOGIC( prefix.str() 
             << "data bytes: " 
@@ -341,17 +575,17 @@ TocinoChannel::ReportStatistics() const
             << "%)" );
 
     // Flits
-    uint32_t dataFlitsTransmitted = m_totalFlitsTransmitted - m_LLCFlitsTransmitted;
+    uint32_t dataFlitsTransmitted = totalFlitsTransmitted - m_LLCFlitsTransmitted;
     
     double dataFlitsPercentage =
-        static_cast<double>(dataFlitsTransmitted) / m_totalFlitsTransmitted * 100;
+        static_cast<double>(dataFlitsTransmitted) / totalFlitsTransmitted * 100;
 
     double LLCFlitsPercentage =
-        static_cast<double>(m_LLCFlitsTransmitted) / m_totalFlitsTransmitted * 100;
+        static_cast<double>(m_LLCFlitsTransmitted) / totalFlitsTransmitted * 100;
 
     NS_LOG_LOGIC( prefix.str()
             << "total flits: "
-            << m_totalFlitsTransmitted );
+            << totalFlitsTransmitted );
     
     NS_LOG_LOGIC( prefix.str() 
             << "data flits: " 
@@ -368,13 +602,13 @@ TocinoChannel::ReportStatistics() const
             << "%)" );
 
     // Utilization
-    Time dataTransmitTime = m_totalTransmitTime - m_LLCTransmitTime;
-    Time idleTime = Simulator::Now() - m_totalTransmitTime;
+    Time dataTransmitTime = totalTransmitTime - m_LLCTransmitTime;
+    Time idleTime = Simulator::Now() - totalTransmitTime;
   
     const double totalSeconds = Simulator::Now().GetSeconds();
 
     double percentTimeBusy = 
-        m_totalTransmitTime.GetSeconds() / totalSeconds * 100;
+        totalTransmitTime.GetSeconds() / totalSeconds * 100;
 
     double percentTimeIdle =
         idleTime.GetSeconds() / totalSeconds * 100;
@@ -407,7 +641,7 @@ TocinoChannel::ReportStatistics() const
 
     // Throughput
     double totalMbps =
-        static_cast<double>(m_totalBytesTransmitted) * 8 / totalSeconds / 1024 / 1024;
+        static_cast<double>(totalBytesTransmitted) * 8 / totalSeconds / 1024 / 1024;
     
     double dataMbps =
         static_cast<double>(dataBytesTransmitted) * 8 / totalSeconds / 1024 / 1024;
@@ -436,7 +670,7 @@ TocinoChannel::ReportStatistics() const
                 << "vc " 
                 << vc
                 << " "
-                << m_vcUsageHistogram[ vc ] );
+                << GetVCFlits( vc ) );
     }
     
     NS_LOG_LOGIC( prefix.str() );
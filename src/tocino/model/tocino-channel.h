@@ -2,11 +2,15 @@
 #ifndef __TOCINO_CHANNEL_H__
 #define __TOCINO_CHANNEL_H__
 
+#include <deque>
+
 #include "ns3/channel.h"
 #include "ns3/nstime.h"
 #include "ns3/data-rate.h"
 #include "ns3/packet.h"
 
+#include "tocino-flit.h"
+
 namespace ns3 
 {
 
@@ -23,8 +27,28 @@ public:
     TocinoChannel();
     virtual ~TocinoChannel();
     
-    bool TransmitStart(Ptr<Packet> p);
-    Time GetTransmissionTime(Ptr<Packet> p);
+    virtual bool TransmitStart( const TocinoFlit& );
+    Time GetTransmissionTime( const TocinoFlit& ) const;
+
+    // Express transmission, see TocinoTx::StartRun.  As
+    // TransmitStart, but with no event of our own to end
+    // the transmission: the transmitter calls TransmitEndFused
+    // from its event instead.
+    void TransmitStartFused( const TocinoFlit& );
+    void TransmitEndFused();
+
+    // Express transmission of one flit of a run, starting at
+    // the given time, which may lie ahead of now.  Arrivals
+    // at the receiver are scheduled one at a time, in order,
+    // so that flits which have yet to start may be withdrawn.
+    // Statistics count the flit at once; GetElapsedTransmitTime
+    // is still exact, as a run is sent back-to-back.
+    // Returns the transmission time.
+    Time TransmitExpress( const TocinoFlit&, const Time start );
+    void WithdrawExpress( const uint32_t flits );
+
+    // Whether the express calls above may be used
+    virtual bool SupportsExpress() const;
     
     void SetTransmitter(TocinoTx* tx);
     void SetReceiver(TocinoRx* rx);
@@ -36,46 +60,89 @@ public:
     Ptr<NetDevice> GetDevice(uint32_t i) const;
     Ptr<TocinoNetDevice> GetTocinoDevice(uint32_t i) const;
 
+    // Reserve flits per VC needed by XON/XOFF flow control
     uint32_t FlitBuffersRequired() const;
+
+    // Flits per VC needed by credit flow control to keep
+    // a single VC streaming at the full channel rate
+    uint32_t CreditBuffersRequired() const;
+
+    // Least simulated time between a transmitter acting
+    // and the receiver observing it, for any flit
+    Time GetLookahead() const;
    
+    // Statistics count only flits which have started, even
+    // when an express run has committed to more
     uint32_t GetTotalBytesTransmitted() const;
     uint32_t GetTotalFlitsTransmitted() const;
     Time GetTotalTransmitTime() const;
+
+    // As GetTotalTransmitTime, less the remainder of any
+    // flit still being serialized, so never more than Now
+    Time GetElapsedTransmitTime() const;
     
     uint32_t GetLLCBytesTransmitted() const;
     uint32_t GetLLCFlitsTransmitted() const;
     Time GetLLCTransmitTime() const;
+
+    // Flits transmitted on the given VC
+    uint32_t GetVCFlits( const TocinoVC ) const;
     
     void ReportStatistics() const;
 
-private:
+protected:
     
-    void TransmitEnd ();
+    virtual void TransmitEnd ();
+
+    // Most flits a single VC could carry in the given time
+    uint32_t DensestFlitsWithin( const Time ) const;
+
+    // Statistics for a flit starting at the given time
+    Time RecordTransmission( const TocinoFlit&, const Time start );
+
+    // Deliver the next flit sent by TransmitExpress
+    void ExpressArrive();
+
+    // Flits sent by TransmitExpress which have yet to
+    // start; these are the last in m_expressFlits
+    uint32_t GetUnstartedExpressFlits() const;
     
     // channel parameters
     Time m_delay;
     DataRate m_bps;
     
-    Ptr<Packet> m_flit;
+    TocinoFlit m_flit;
     
     TocinoTx* m_tx;
     TocinoRx* m_rx;
-   
-    std::string m_txString;
-    std::string m_rxString;
 
     enum TocinoChannelState {IDLE, BUSY};
     TocinoChannelState m_state;
 
+private:
+
     uint32_t m_totalBytesTransmitted;
     uint32_t m_totalFlitsTransmitted;
     Time m_totalTransmitTime;
+    Time m_transmitEndTime;
     
     uint32_t m_LLCBytesTransmitted;
     uint32_t m_LLCFlitsTransmitted;
     Time m_LLCTransmitTime;
     
     std::vector< uint32_t > m_vcUsageHistogram;
+
+    // Flits sent by TransmitExpress yet to arrive, in
+    // order; an ExpressArrive event is pending for the
+    // first whenever this is not empty
+    struct ExpressFlit
+    {
+        TocinoFlit flit;
+        Time start;
+        Time arrival;
+    };
+
+    std::deque< ExpressFlit > m_expressFlits;
 };
 
 } // namespace ns3
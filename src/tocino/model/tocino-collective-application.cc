@@ -0,0 +1,479 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include <algorithm>
+
+#include "tocino-collective-application.h"
+
+#include "ns3/node-container.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE( "TocinoCollectiveApplication" );
+
+NS_OBJECT_ENSURE_REGISTERED( TocinoCollectiveApplication );
+
+namespace
+{
+
+// Every packet begins with its step number
+const uint32_t STEP_BYTES = 4;
+
+}
+
+TypeId 
+TocinoCollectiveApplication::GetTypeId()
+{
+    static TypeId tid = TypeId( "ns3::TocinoCollectiveApplication" )
+        .SetParent<Application>()
+        .AddConstructor<TocinoCollectiveApplication>()
+        .AddAttribute(
+                "Algorithm",
+                "Which collective to run.",
+                EnumValue( RING_ALLREDUCE ),
+                MakeEnumAccessor(
+                    &TocinoCollectiveApplication::m_algorithm ),
+                MakeEnumChecker(
+                    RING_ALLREDUCE, "RingAllreduce",
+                    RECURSIVE_DOUBLING_ALLREDUCE, "RecursiveDoublingAllreduce",
+                    PAIRWISE_ALLTOALL, "PairwiseAlltoall",
+                    BINOMIAL_BROADCAST, "BinomialBroadcast" ) )
+        .AddAttribute(
+                "MessageSize",
+                "Bytes reduced per rank, sent to each other rank, or broadcast.",
+                UintegerValue( 4096 ),
+                MakeUintegerAccessor(
+                    &TocinoCollectiveApplication::m_messageSize ),
+                MakeUintegerChecker< uint32_t >( 1 ) )
+        .AddAttribute(
+                "PacketSize",
+                "Most bytes in one packet.",
+                UintegerValue( 1024 ),
+                MakeUintegerAccessor(
+                    &TocinoCollectiveApplication::m_packetSize ),
+                MakeUintegerChecker< uint32_t >( STEP_BYTES ) )
+        .AddAttribute(
+                "Iterations",
+                "Times to repeat the collective.",
+                UintegerValue( 1 ),
+                MakeUintegerAccessor(
+                    &TocinoCollectiveApplication::m_iterations ),
+                MakeUintegerChecker< uint32_t >( 1 ) )
+        .AddAttribute(
+                "Root",
+                "Rank which broadcasts.",
+                UintegerValue( 0 ),
+                MakeUintegerAccessor(
+                    &TocinoCollectiveApplication::m_root ),
+                MakeUintegerChecker< uint32_t >() )
+        .AddTraceSource( "Complete",
+            "This rank has finished a repetition of the collective.",
+            MakeTraceSourceAccessor(
+                &TocinoCollectiveApplication::m_completeTrace ),
+            "ns3::TocinoCollectiveApplication::CompleteCallback" )
+        ;
+    return tid;
+}
+
+const uint32_t TocinoCollectiveApplication::NO_PEER =
+    std::numeric_limits< uint32_t >::max();
+
+TocinoCollectiveApplication::TocinoCollectiveApplication()
+    : m_algorithm( RING_ALLREDUCE )
+    , m_messageSize( 4096 )
+    , m_packetSize( 1024 )
+    , m_iterations( 1 )
+    , m_root( 0 )
+    , m_rank( 0 )
+    , m_ranks( 0 )
+    , m_iteration( 0 )
+    , m_step( 0 )
+    , m_running( false )
+    , m_packetsSent( 0 )
+    , m_packetsReceived( 0 )
+    , m_netDevice( NULL )
+    , m_nodeContainer( NULL )
+{}
+
+void 
+TocinoCollectiveApplication::Initialize(
+        const uint32_t rank,
+        const NodeContainer* nodeContainer )
+{
+    NS_ASSERT( nodeContainer != NULL );
+
+    m_rank = rank;
+    m_nodeContainer = nodeContainer;
+    m_ranks = nodeContainer->GetN();
+
+    NS_ASSERT( m_rank < m_ranks );
+
+    Ptr<Node> node = m_nodeContainer->Get( m_rank );
+    NS_ASSERT( node->GetNDevices() == 1 );
+
+    // Throws if not a TocinoNetDevice, by design
+    m_netDevice = DynamicCast<TocinoNetDevice>( node->GetDevice(0) );
+
+    m_netDevice->SetReceiveCallback( 
+            MakeCallback( &TocinoCollectiveApplication::AcceptPacket, this ) );
+
+    m_netDevice->AddReadyCallback( 
+            MakeCallback( &TocinoCollectiveApplication::DeviceReady, this ) );
+}
+
+void
+TocinoCollectiveApplication::BuildSchedule()
+{
+    const uint32_t P = m_ranks;
+    const uint32_t R = m_rank;
+
+    m_schedule.clear();
+
+    switch( m_algorithm )
+    {
+        case RING_ALLREDUCE:
+        {
+            // Reduce-scatter, then allgather, of P chunks,
+            // each step passing one chunk to the right
+            const uint32_t CHUNK = ( m_messageSize + P - 1 ) / P;
+
+            for( uint32_t i = 0; P > 1 && i < 2 * ( P - 1 ); ++i )
+            {
+                Step s;
+                s.sendTo = ( R + 1 ) % P;
+                s.sendBytes = CHUNK;
+                s.receiveFrom = ( R + P - 1 ) % P;
+                s.receiveBytes = CHUNK;
+                m_schedule.push_back( s );
+            }
+            break;
+        }
+        case RECURSIVE_DOUBLING_ALLREDUCE:
+        {
+            NS_ABORT_MSG_IF( ( P & ( P - 1 ) ) != 0,
+                    "Recursive doubling needs a power of two ranks" );
+
+            // Exchange everything with the partner across
+            // each bit of the rank in turn
+            for( uint32_t mask = 1; mask < P; mask <<= 1 )
+            {
+                Step s;
+                s.sendTo = R ^ mask;
+                s.sendBytes = m_messageSize;
+                s.receiveFrom = R ^ mask;
+                s.receiveBytes = m_messageSize;
+                m_schedule.push_back( s );
+            }
+            break;
+        }
+        case PAIRWISE_ALLTOALL:
+        {
+            // Step k sends to the rank k to the right while
+            // receiving from the rank k to the left
+            for( uint32_t k = 1; k < P; ++k )
+            {
+                Step s;
+                s.sendTo = ( R + k ) % P;
+                s.sendBytes = m_messageSize;
+                s.receiveFrom = ( R + P - k ) % P;
+                s.receiveBytes = m_messageSize;
+                m_schedule.push_back( s );
+            }
+            break;
+        }
+        case BINOMIAL_BROADCAST:
+        {
+            NS_ASSERT( m_root < P );
+
+            // Relative to the root, ranks below mask have
+            // the data and pass it on to rank + mask
+            const uint32_t V = ( R + P - m_root ) % P;
+
+            for( uint32_t mask = 1; mask < P; mask <<= 1 )
+            {
+                Step s;
+
+                if( ( V < mask ) && ( V + mask < P ) )
+                {
+                    s.sendTo = ( V + mask + m_root ) % P;
+                    s.sendBytes = m_messageSize;
+                }
+                else if( ( V >= mask ) && ( V < 2 * mask ) )
+                {
+                    s.receiveFrom = ( V - mask + m_root ) % P;
+                    s.receiveBytes = m_messageSize;
+                }
+
+                m_schedule.push_back( s );
+            }
+            break;
+        }
+        default:
+            NS_ASSERT_MSG( false, "Unknown collective" );
+    }
+}
+
+uint32_t
+TocinoCollectiveApplication::GetPacketCount( const uint32_t bytes ) const
+{
+    if( bytes <= m_packetSize )
+    {
+        return 1;
+    }
+
+    return ( bytes + m_packetSize - 1 ) / m_packetSize;
+}
+
+uint32_t
+TocinoCollectiveApplication::GetStepCount() const
+{
+    return m_schedule.size();
+}
+
+uint32_t
+TocinoCollectiveApplication::GetPacketsSent() const
+{
+    return m_packetsSent;
+}
+
+uint32_t
+TocinoCollectiveApplication::GetPacketsReceived() const
+{
+    return m_packetsReceived;
+}
+
+uint32_t
+TocinoCollectiveApplication::GetIterationsCompleted() const
+{
+    return m_finishTimes.size();
+}
+
+const std::vector< Time >&
+TocinoCollectiveApplication::GetFinishTimes() const
+{
+    return m_finishTimes;
+}
+
+Time
+TocinoCollectiveApplication::GetCompletionTime(
+        const std::vector< Ptr<TocinoCollectiveApplication> >& apps,
+        const uint32_t iteration )
+{
+    NS_ASSERT( !apps.empty() );
+
+    Time begin = apps[0]->m_startTime;
+    Time end;
+
+    for( uint32_t i = 0; i < apps.size(); ++i )
+    {
+        NS_ASSERT( iteration < apps[i]->m_finishTimes.size() );
+
+        if( iteration == 0 )
+        {
+            begin = std::min( begin, apps[i]->m_startTime );
+        }
+        else
+        {
+            begin = std::max( begin, apps[i]->m_finishTimes[ iteration - 1 ] );
+        }
+
+        end = std::max( end, apps[i]->m_finishTimes[ iteration ] );
+    }
+
+    return end - begin;
+}
+
+void
+TocinoCollectiveApplication::StartApplication()
+{
+    NS_ASSERT( m_netDevice != NULL );
+
+    BuildSchedule();
+
+    m_iteration = 0;
+    m_step = 0;
+    m_finishTimes.clear();
+    m_startTime = Simulator::Now();
+    m_iterationStart = m_startTime;
+
+    if( m_schedule.empty() )
+    {
+        // A single rank has nothing to do
+        m_finishTimes.assign( m_iterations, m_startTime );
+        return;
+    }
+
+    m_running = true;
+
+    StartStep();
+    TryAdvance();
+}
+
+void
+TocinoCollectiveApplication::StartStep()
+{
+    NS_ASSERT( m_pendingPackets.empty() );
+
+    const Step& s = m_schedule[ m_step ];
+
+    if( s.sendTo == NO_PEER )
+    {
+        return;
+    }
+
+    const uint32_t STEP = m_iteration * m_schedule.size() + m_step;
+
+    const uint8_t tag[ STEP_BYTES ] =
+    {
+        static_cast<uint8_t>( STEP ),
+        static_cast<uint8_t>( STEP >> 8 ),
+        static_cast<uint8_t>( STEP >> 16 ),
+        static_cast<uint8_t>( STEP >> 24 )
+    };
+
+    uint32_t remaining = s.sendBytes;
+
+    for( uint32_t i = 0; i < GetPacketCount( s.sendBytes ); ++i )
+    {
+        const uint32_t LEN =
+            std::max( std::min( remaining, m_packetSize ), STEP_BYTES );
+
+        Ptr<Packet> p = Create<Packet>( tag, STEP_BYTES );
+        p->AddAtEnd( Create<Packet>( LEN - STEP_BYTES ) );
+
+        m_pendingPackets.push_back( p );
+
+        remaining -= std::min( remaining, m_packetSize );
+    }
+
+    m_pendingDestAddress =
+        m_nodeContainer->Get( s.sendTo )->GetDevice(0)->GetAddress();
+
+    TrySendPending();
+}
+
+void
+TocinoCollectiveApplication::TryAdvance()
+{
+    while( m_running )
+    {
+        if( !m_pendingPackets.empty() )
+        {
+            // Still sending
+            return;
+        }
+
+        const Step& s = m_schedule[ m_step ];
+        const uint32_t STEP = m_iteration * m_schedule.size() + m_step;
+
+        if( s.receiveFrom != NO_PEER )
+        {
+            std::map< uint32_t, uint32_t >::iterator it = m_received.find( STEP );
+
+            if( ( it == m_received.end() ) ||
+                ( it->second < GetPacketCount( s.receiveBytes ) ) )
+            {
+                // Still receiving
+                return;
+            }
+
+            NS_ASSERT( it->second == GetPacketCount( s.receiveBytes ) );
+
+            m_received.erase( it );
+        }
+
+        m_step++;
+
+        if( m_step == m_schedule.size() )
+        {
+            const Time now = Simulator::Now();
+
+            NS_LOG_LOGIC( "rank " << m_rank << " finished iteration "
+                    << m_iteration << " in " << now - m_iterationStart );
+
+            m_finishTimes.push_back( now );
+            m_completeTrace( m_iteration, now - m_iterationStart );
+
+            m_iteration++;
+            m_step = 0;
+            m_iterationStart = now;
+
+            if( m_iteration == m_iterations )
+            {
+                m_running = false;
+                return;
+            }
+        }
+
+        StartStep();
+    }
+}
+
+void
+TocinoCollectiveApplication::TrySendPending()
+{
+    while( !m_pendingPackets.empty() )
+    {
+        if( !m_netDevice->Send( m_pendingPackets.front(), m_pendingDestAddress, 0 ) )
+        {
+            // Hold off until DeviceReady
+            return;
+        }
+
+        m_pendingPackets.pop_front();
+        m_packetsSent++;
+    }
+}
+
+void
+TocinoCollectiveApplication::DeviceReady( Ptr<NetDevice> )
+{
+    if( !m_running )
+    {
+        return;
+    }
+
+    TrySendPending();
+    TryAdvance();
+}
+
+bool
+TocinoCollectiveApplication::AcceptPacket(
+        Ptr<NetDevice>,
+        Ptr<const Packet> p,
+        uint16_t,
+        const Address& )
+{
+    m_packetsReceived++;
+
+    NS_ASSERT( p->GetSize() >= STEP_BYTES );
+
+    uint8_t tag[ STEP_BYTES ];
+    p->CopyData( tag, STEP_BYTES );
+
+    const uint32_t STEP =
+        tag[0] | ( tag[1] << 8 ) | ( tag[2] << 16 ) | ( tag[3] << 24 );
+
+    m_received[ STEP ]++;
+
+    TryAdvance();
+
+    return true;
+}
+
+void
+TocinoCollectiveApplication::StopApplication()
+{
+    m_running = false;
+
+    // Never sent, so never counted
+    m_pendingPackets.clear();
+}
+
+}
@@ -4,6 +4,7 @@
 #include "ns3/log.h"
 
 #include "tocino-crossbar.h"
+#include "tocino-flit.h"
 #include "tocino-net-device.h"
 #include "tocino-router.h"
 #include "tocino-rx.h"
@@ -121,10 +122,10 @@ TocinoCrossbar::IsForwardable(
 
 void
 TocinoCrossbar::ForwardFlit(
-        Ptr<Packet> flit,
+        const TocinoFlit& flit,
         const TocinoRoute route )
 {
-    NS_ASSERT( flit != NULL );
+    NS_ASSERT( !flit.IsNull() );
     NS_ASSERT( route != TOCINO_INVALID_ROUTE );
     NS_ASSERT( IsForwardable( route ) );
 
@@ -138,8 +139,8 @@ TocinoCrossbar::ForwardFlit(
             << " to outputPort=" << outputPort
             << ", outputVC=" << outputVC );
    
-    const bool isHead = IsTocinoFlitHead( flit );
-    const bool isTail = IsTocinoFlitTail( flit );
+    const bool isHead = flit.IsHead();
+    const bool isTail = flit.IsTail();
   
     const TocinoInputVC currentTableEntry = 
         GetForwardingTableEntry( outputPort, outputVC );
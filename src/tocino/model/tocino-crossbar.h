@@ -10,7 +10,7 @@
 namespace ns3
 {
 
-class Packet;
+class TocinoFlit;
 class TocinoNetDevice;
 class TocinoRx;
 class TocinoRoutingTable;
@@ -28,7 +28,7 @@ class TocinoCrossbar
 
     bool IsForwardable( const TocinoRoute ) const;
     
-    void ForwardFlit( Ptr<Packet>, const TocinoRoute );
+    void ForwardFlit( const TocinoFlit&, const TocinoRoute );
 
     private:
    
@@ -1,12 +1,16 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include <sstream>
+
 #include "ns3/packet.h"
 #include "ns3/log.h"
 #include "ns3/uinteger.h"
 #include "ns3/boolean.h"
+#include "ns3/string.h"
+#include "ns3/abort.h"
 
 #include "tocino-dimension-order-router.h"
 #include "tocino-misc.h"
-#include "tocino-flit-header.h"
+#include "tocino-flit.h"
 #include "tocino-rx.h"
 #include "tocino-tx.h"
 #include "tocino-flit-id-tag.h"
@@ -29,6 +33,9 @@ namespace ns3
 
 NS_OBJECT_ENSURE_REGISTERED (TocinoDimensionOrderRouter);
 
+// CompileLookupTable fills in exactly four coordinates
+STATIC_ASSERT( TOCINO_MAX_DIMENSIONS == 4, lookup_table_has_four_coordinates );
+
 TypeId TocinoDimensionOrderRouter::GetTypeId(void)
 {
     static TypeId tid = TypeId( "ns3::TocinoDimensionOrderRouter" )
@@ -38,6 +45,21 @@ TypeId TocinoDimensionOrderRouter::GetTypeId(void)
             UintegerValue( 0 ),
             MakeUintegerAccessor( &TocinoDimensionOrderRouter::EnableWrapAround ),
             MakeUintegerChecker<uint32_t>() )
+        .AddAttribute( "WrapAroundRadices", 
+            "Per-dimension radix of wrap-around links, e.g. \"8,8,0\"; zero disables.",
+            StringValue( "" ),
+            MakeStringAccessor( &TocinoDimensionOrderRouter::SetWrapAroundRadices ),
+            MakeStringChecker() )
+        .AddAttribute( "LookupTableRadices", 
+            "Extent of each dimension, e.g. \"8,8,4\"; if set, routes are compiled into a per-destination table.",
+            StringValue( "" ),
+            MakeStringAccessor( &TocinoDimensionOrderRouter::SetLookupTableRadices ),
+            MakeStringChecker() )
+        .AddAttribute( "ShareLookupTable", 
+            "All input ports of a device share one lookup table.",
+            BooleanValue( true ),
+            MakeBooleanAccessor( &TocinoDimensionOrderRouter::m_shareLookupTable ),
+            MakeBooleanChecker() )
         .AddAttribute( "OutOfOrderOK", 
             "It's OK to route packets in such a way that they may arrive out of order.",
             BooleanValue( false ),
@@ -51,8 +73,16 @@ TocinoDimensionOrderRouter::TocinoDimensionOrderRouter()
     : m_tnd( NULL )
     , m_inputPort( TOCINO_INVALID_PORT )
     , m_wrap( false )
-    , m_radix( 0 )
-{}
+    , m_outOfOrderOK( false )
+    , m_lookupTableNodes( 0 )
+    , m_shareLookupTable( true )
+{
+    for( uint32_t dim = 0; dim < TOCINO_MAX_DIMENSIONS; ++dim )
+    {
+        m_radix[dim] = 0;
+        m_lookupTableRadix[dim] = 0;
+    }
+}
 
 void 
 TocinoDimensionOrderRouter::Initialize( 
@@ -63,15 +93,60 @@ TocinoDimensionOrderRouter::Initialize(
     m_inputPort = inputPort;
 }
 
+void
+TocinoDimensionOrderRouter::ParseRadices( const std::string& radices, uint32_t* radix )
+{
+    std::istringstream iss( radices );
+    std::string token;
+    
+    uint32_t dim = 0;
+    
+    while( std::getline( iss, token, ',' ) )
+    {
+        NS_ASSERT_MSG( dim < TOCINO_MAX_DIMENSIONS,
+                "Too many dimensions in \"" << radices << "\"" );
+
+        std::istringstream tss( token );
+        uint32_t r = 0;
+        
+        tss >> r;
+        NS_ASSERT_MSG( !tss.fail(), "Bad radix in \"" << radices << "\"" );
+
+        radix[dim++] = r;
+    }
+
+    for( ; dim < TOCINO_MAX_DIMENSIONS; ++dim )
+    {
+        radix[dim] = 0;
+    }
+}
+
 bool TocinoDimensionOrderRouter::TopologyHasWrapAround() const
 {
     return m_wrap;
 }
 
+bool TocinoDimensionOrderRouter::TopologyHasWrapAround(
+        const TocinoDimension dim ) const
+{
+    NS_ASSERT( dim < TOCINO_MAX_DIMENSIONS );
+    
+    return m_radix[ dim.AsUInt32() ] != 0;
+}
+
+uint32_t TocinoDimensionOrderRouter::GetWrapAroundRadix(
+        const TocinoDimension dim ) const
+{
+    NS_ASSERT( dim < TOCINO_MAX_DIMENSIONS );
+    
+    return m_radix[ dim.AsUInt32() ];
+}
+
 TocinoDirection
 TocinoDimensionOrderRouter::DetermineRoutingDirection(
         const TocinoAddress::Coordinate src,
-        const TocinoAddress::Coordinate dst ) const
+        const TocinoAddress::Coordinate dst,
+        const TocinoDimension dim ) const
 {
     const int32_t delta = dst - src;
 
@@ -79,9 +154,11 @@ TocinoDimensionOrderRouter::DetermineRoutingDirection(
 
     bool routePositive = delta > 0;
     
-    if( TopologyHasWrapAround() )
+    if( TopologyHasWrapAround( dim ) )
     {
-        if( abs(delta) == static_cast<int32_t>( m_radix/2 ) )
+        const uint32_t radix = m_radix[ dim.AsUInt32() ];
+
+        if( abs(delta) == static_cast<int32_t>( radix/2 ) )
         {
             // Tie-breaker
             if( m_outOfOrderOK )
@@ -99,7 +176,7 @@ TocinoDimensionOrderRouter::DetermineRoutingDirection(
                 routePositive = ( src & 1 );
             }
         }
-        else if( abs(delta) > static_cast<int32_t>( m_radix/2 ) )
+        else if( abs(delta) > static_cast<int32_t>( radix/2 ) )
         {
             routePositive = !routePositive;
         }
@@ -114,28 +191,29 @@ TocinoDimensionOrderRouter::DetermineRoutingDirection(
 bool
 TocinoDimensionOrderRouter::RouteCrossesDateline(
         const TocinoAddress::Coordinate srcCoord,
-        const TocinoDirection dir ) const
+        const TocinoDirection dir,
+        const TocinoDimension dim ) const
 {
-    NS_ASSERT( TopologyHasWrapAround() );
+    NS_ASSERT( TopologyHasWrapAround( dim ) );
 
     if( (srcCoord == 0) && (dir == TOCINO_DIRECTION_NEG) )
         return true;
 
-    if( (srcCoord == m_radix-1) && (dir == TOCINO_DIRECTION_POS) )
+    if( (srcCoord == m_radix[ dim.AsUInt32() ]-1) && (dir == TOCINO_DIRECTION_POS) )
         return true;
 
     return false;
 }
 
 TocinoRoute
-TocinoDimensionOrderRouter::Route( Ptr<const Packet> flit ) const 
+TocinoDimensionOrderRouter::Route( const TocinoFlit& flit ) const 
 {
-    NS_ASSERT( flit != NULL );
+    NS_ASSERT( !flit.IsNull() );
     
     NS_LOG_FUNCTION( GetTocinoFlitIdString( flit ) );
-    NS_ASSERT( IsTocinoFlitHead( flit ) );
+    NS_ASSERT( flit.IsHead() );
     
-    const TocinoInputVC inputVC = GetTocinoFlitVirtualChannel( flit );
+    const TocinoInputVC inputVC = flit.GetVirtualChannel();
     
     // Default assumption is that we do not switch VCs
     TocinoOutputVC outputVC = inputVC.AsUInt32();
@@ -143,7 +221,7 @@ TocinoDimensionOrderRouter::Route( Ptr<const Packet> flit ) const
     TocinoOutputPort outputPort = TOCINO_INVALID_PORT;
 
     TocinoAddress localAddr = m_tnd->GetTocinoAddress();
-    TocinoAddress destAddr = GetTocinoFlitDestination( flit );
+    TocinoAddress destAddr = flit.GetDestination();
 
     if( destAddr == localAddr )
     {
@@ -163,56 +241,94 @@ TocinoDimensionOrderRouter::Route( Ptr<const Packet> flit ) const
     TocinoAddress::Coordinate localCoord = -1;
     TocinoAddress::Coordinate destCoord = -1;
 
-    // Dimension-order routing
-    for( outputDim = TOCINO_DIMENSION_X;
-            outputDim < TocinoAddress::MAX_DIM; ++outputDim )
+    bool crossesDateline = false;
+
+    if( m_lookupTableNodes > 0 )
     {
+        // Compiled dimension-order route
+        const uint8_t entry = LookupRoute( destAddr );
+
+        outputPort = entry & LOOKUP_PORT_MASK;
+        outputDim = TocinoGetDimension( outputPort );
+        outputDir = TocinoGetDirection( outputPort );
         localCoord = localAddr.GetCoordinate( outputDim );
-        destCoord = destAddr.GetCoordinate( outputDim );
+        
+        crossesDateline = ( entry & LOOKUP_DATELINE ) != 0;
 
-        if( localCoord != destCoord )
+        if( !injecting && (inputDim == outputDim) )
         {
-            break;
+            const TocinoDirection inputDir = 
+                TocinoGetOppositeDirection( TocinoGetDirection( m_inputPort ) );
+
+            // N.B.
+            // Minimal routes continue the way they were
+            // going, so this only differs for the second
+            // leg of a bounced (VLB) packet.
+            if( inputDir != outputDir )
+            {
+                outputDir = inputDir;
+                outputPort = TocinoGetPort( outputDim, outputDir );
+                
+                crossesDateline = TopologyHasWrapAround( outputDim ) &&
+                    RouteCrossesDateline( localCoord, outputDir, outputDim );
+            }
         }
     }
-    
-    if( injecting || (inputDim != outputDim) )
-    {
-        // Changing dimension, choose new direction
-        outputDir = DetermineRoutingDirection( localCoord, destCoord );
-    }
     else
     {
-        const TocinoDirection inputDir = 
-            TocinoGetOppositeDirection( TocinoGetDirection( m_inputPort ) );
+        // Dimension-order routing
+        for( outputDim = TOCINO_DIMENSION_X;
+                outputDim < TocinoAddress::MAX_DIM; ++outputDim )
+        {
+            localCoord = localAddr.GetCoordinate( outputDim );
+            destCoord = destAddr.GetCoordinate( outputDim );
 
-        // Continue in the same direction
-        outputDir = inputDir;
+            if( localCoord != destCoord )
+            {
+                break;
+            }
+        }
+        
+        if( injecting || (inputDim != outputDim) )
+        {
+            // Changing dimension, choose new direction
+            outputDir = DetermineRoutingDirection( localCoord, destCoord, outputDim );
+        }
+        else
+        {
+            const TocinoDirection inputDir = 
+                TocinoGetOppositeDirection( TocinoGetDirection( m_inputPort ) );
+
+            // Continue in the same direction
+            outputDir = inputDir;
+        }
+        
+        NS_ASSERT( outputDim != TOCINO_INVALID_DIMENSION );
+        NS_ASSERT( outputDir != TOCINO_INVALID_DIRECTION );
+        
+        outputPort = TocinoGetPort( outputDim, outputDir );
+        
+        crossesDateline = TopologyHasWrapAround( outputDim ) &&
+            RouteCrossesDateline( localCoord, outputDir, outputDim );
     }
-    
-    NS_ASSERT( outputDim != TOCINO_INVALID_DIMENSION );
-    NS_ASSERT( outputDir != TOCINO_INVALID_DIRECTION );
-    
-    outputPort = TocinoGetPort( outputDim, outputDir );
 
     NS_ASSERT( outputPort != TOCINO_INVALID_PORT );
 
     // Dateline algorithm for deadlock avoidance in rings/tori
     if( TopologyHasWrapAround() )
     {
+        const TocinoVCAllocator& vca = m_tnd->GetVCAllocator();
+
         // Are we changing dimension?
         if( !injecting && (inputDim != outputDim) )
         {
             // Reset to the base (even-numbered) VC of the pair
-            outputVC = inputVC.AsUInt32() & ~1;
+            outputVC = vca.ResetDateline( inputVC );
         }
-        else if( RouteCrossesDateline( localCoord, outputDir ) )
+        else if( crossesDateline )
         {
-            NS_ASSERT_MSG( inputVC < m_tnd->GetNVCs(), 
-                    "Flit on last VC cannot cross dateline!" );
-
             // Switch to the high (odd-numbered) VC of the pair
-            outputVC = inputVC.AsUInt32() + 1;
+            outputVC = vca.CrossDateline( inputVC );
         }
     }
 
@@ -226,8 +342,207 @@ TocinoDimensionOrderRouter::EnableWrapAround( uint32_t radix )
 {
     if( radix == 0 ) return;
 
-    m_radix = radix;
+    for( uint32_t dim = 0; dim < TOCINO_MAX_DIMENSIONS; ++dim )
+    {
+        m_radix[dim] = radix;
+    }
+
     m_wrap = true;
 }
 
+void 
+TocinoDimensionOrderRouter::SetWrapAroundRadices( std::string radices )
+{
+    if( radices.empty() ) return;
+
+    ParseRadices( radices, m_radix );
+    
+    m_wrap = false;
+
+    for( uint32_t dim = 0; dim < TOCINO_MAX_DIMENSIONS; ++dim )
+    {
+        if( m_radix[dim] != 0 )
+        {
+            m_wrap = true;
+        }
+    }
+}
+
+void 
+TocinoDimensionOrderRouter::SetLookupTableRadices( std::string radices )
+{
+    m_lookupTableNodes = 0;
+    m_lookupTable = NULL;
+    
+    if( radices.empty() ) return;
+
+    ParseRadices( radices, m_lookupTableRadix );
+
+    m_lookupTableNodes = 1;
+
+    for( uint32_t dim = 0; dim < TOCINO_MAX_DIMENSIONS; ++dim )
+    {
+        // Unmentioned dimensions have a single coordinate
+        if( m_lookupTableRadix[dim] == 0 )
+        {
+            m_lookupTableRadix[dim] = 1;
+        }
+
+        m_lookupTableNodes *= m_lookupTableRadix[dim];
+    }
+}
+
+uint8_t
+TocinoDimensionOrderRouter::LookupRoute( const TocinoAddress& destAddr ) const
+{
+    NS_ASSERT( m_lookupTableNodes > 0 );
+
+    if( m_lookupTable == NULL )
+    {
+        CompileLookupTable();
+    }
+
+    uint32_t idx = 0;
+    uint32_t stride = 1;
+
+    for( uint32_t dim = 0; dim < TOCINO_MAX_DIMENSIONS; ++dim )
+    {
+        const uint32_t coord = destAddr.GetCoordinate( dim );
+
+        NS_ASSERT_MSG( coord < m_lookupTableRadix[dim],
+                "Destination outside LookupTableRadices" );
+
+        idx += coord * stride;
+        stride *= m_lookupTableRadix[dim];
+    }
+
+    return m_lookupTable->entries[idx];
+}
+
+void
+TocinoDimensionOrderRouter::CompileLookupTable() const
+{
+    NS_ASSERT( m_lookupTable == NULL );
+    
+    if( m_shareLookupTable && ( m_inputPort != 0 ) )
+    {
+        // All input ports of a device route alike, so
+        // borrow the table of the router on port zero
+        Ptr<TocinoDimensionOrderRouter> first =
+            DynamicCast<TocinoDimensionOrderRouter>(
+                    m_tnd->GetReceiver( 0 )->GetRouter() );
+
+        NS_ASSERT( first != NULL );
+        NS_ASSERT( first->m_lookupTableNodes == m_lookupTableNodes );
+
+        if( first->m_lookupTable == NULL )
+        {
+            first->CompileLookupTable();
+        }
+
+        m_lookupTable = first->m_lookupTable;
+        return;
+    }
+    
+    // N.B.
+    // With OutOfOrderOK, ties are broken afresh for each
+    // packet, which no table can capture.
+    NS_ABORT_MSG_IF( m_outOfOrderOK,
+            "LookupTableRadices cannot be combined with OutOfOrderOK" );
+
+    const TocinoAddress localAddr = m_tnd->GetTocinoAddress();
+
+    m_lookupTable = Create<LookupTable>();
+    m_lookupTable->entries.resize( m_lookupTableNodes );
+
+    TocinoAddress::Coordinate coord[ TOCINO_MAX_DIMENSIONS ];
+
+    for( uint32_t idx = 0; idx < m_lookupTableNodes; ++idx )
+    {
+        uint32_t rem = idx;
+
+        for( uint32_t dim = 0; dim < TOCINO_MAX_DIMENSIONS; ++dim )
+        {
+            coord[dim] = rem % m_lookupTableRadix[dim];
+            rem /= m_lookupTableRadix[dim];
+        }
+
+        const TocinoAddress destAddr( coord[0], coord[1], coord[2], coord[3] );
+
+        if( destAddr == localAddr )
+        {
+            m_lookupTable->entries[idx] = m_tnd->GetHostPort();
+            continue;
+        }
+
+        TocinoDimension dim;
+
+        for( dim = TOCINO_DIMENSION_X; dim < TocinoAddress::MAX_DIM; ++dim )
+        {
+            if( localAddr.GetCoordinate( dim ) != destAddr.GetCoordinate( dim ) )
+            {
+                break;
+            }
+        }
+
+        const TocinoAddress::Coordinate localCoord = localAddr.GetCoordinate( dim );
+
+        const TocinoDirection dir = DetermineRoutingDirection(
+                localCoord, destAddr.GetCoordinate( dim ), dim );
+
+        uint8_t entry = TocinoGetPort( dim, dir ).AsUInt32();
+
+        NS_ASSERT( ( entry & ~LOOKUP_PORT_MASK ) == 0 );
+
+        if( TopologyHasWrapAround( dim ) &&
+            RouteCrossesDateline( localCoord, dir, dim ) )
+        {
+            entry |= LOOKUP_DATELINE;
+        }
+
+        m_lookupTable->entries[idx] = entry;
+    }
+
+    s_totalLookupTableBytes += m_lookupTable->GetBytes();
+
+    NS_LOG_LOGIC( "compiled lookup table of "
+            << m_lookupTable->GetBytes() << " bytes" );
+}
+
+TocinoDimensionOrderRouter::LookupTable::~LookupTable()
+{
+    s_totalLookupTableBytes -= GetBytes();
+}
+
+uint32_t
+TocinoDimensionOrderRouter::LookupTable::GetBytes() const
+{
+    return entries.size() * sizeof( entries[0] );
+}
+
+uint32_t
+TocinoDimensionOrderRouter::GetLookupTableBytes() const
+{
+    if( m_lookupTable == NULL )
+    {
+        return 0;
+    }
+
+    // A shared table is charged to its owner only
+    if( m_shareLookupTable && ( m_inputPort != 0 ) )
+    {
+        return 0;
+    }
+
+    return m_lookupTable->GetBytes();
+}
+
+uint64_t TocinoDimensionOrderRouter::s_totalLookupTableBytes = 0;
+
+uint64_t
+TocinoDimensionOrderRouter::GetTotalLookupTableBytes()
+{
+    return s_totalLookupTableBytes;
+}
+
 }
@@ -31,6 +31,8 @@ TocinoFlitHeader::TocinoFlitHeader()
     , m_virtualChannel( 0 )
     , m_length( 0 )
     , m_type( INVALID )
+    , m_intermediate( 0 )
+    , m_valiantPhase( MINIMAL )
     , m_cloakHead( false )
     , m_assumeHead( false )
 {}
@@ -44,6 +46,8 @@ TocinoFlitHeader::TocinoFlitHeader( TocinoAddress src, TocinoAddress dst )
     , m_virtualChannel( 0 )
     , m_length( 0 )
     , m_type( INVALID )
+    , m_intermediate( 0 )
+    , m_valiantPhase( MINIMAL )
     , m_cloakHead( false )
     , m_assumeHead( false )
 {}
@@ -112,8 +116,15 @@ void TocinoFlitHeader::Serialize( Buffer::Iterator i ) const
         
     if( m_isHead )
     {
+        // N.B.
+        // The Valiant routing fields borrow the first five
+        // bytes of the sequence number, which nothing uses
+        // yet, so that a head flit stays the same size.
+        WriteTo( i, m_intermediate );
+        i.WriteU8( m_valiantPhase );
+
         // TODO: set this to something real
-        uint8_t seqnum[6] = {0};
+        uint8_t seqnum[1] = {0};
         i.Write( seqnum, sizeof(seqnum) );
 
         // TODO: set this to something real
@@ -148,16 +159,23 @@ uint32_t TocinoFlitHeader::Deserialize( Buffer::Iterator i )
         
     if( m_isHead )
     {
+        Address a;
+
+        ReadFrom( i, a, TocinoAddress::GetLength() );
+        m_intermediate = TocinoAddress::ConvertFrom( a );
+
+        const uint8_t phase = i.ReadU8();
+        NS_ASSERT_MSG( phase <= MAX_VALIANT_PHASE, "Invalid Valiant phase" );
+        m_valiantPhase = static_cast<ValiantPhase>( phase );
+
         // FIXME: where does this go? 
-        uint8_t seqnum[6] = {0};
+        uint8_t seqnum[1] = {0};
         i.Read( seqnum, sizeof(seqnum) );
 
         // FIXME: where does this go? 
         uint8_t timestamp[8] = {0};
         i.Read( timestamp, sizeof(timestamp) );
   
-        Address a;
-
         ReadFrom( i, a, TocinoAddress::GetLength() );
         m_src = TocinoAddress::ConvertFrom( a );
 
@@ -265,6 +283,30 @@ TocinoFlitHeader::Type TocinoFlitHeader::GetType()
     return m_type;
 }
 
+void TocinoFlitHeader::SetIntermediate( TocinoAddress intermediate )
+{
+    NS_ASSERT( m_isHead );
+    m_intermediate = intermediate;
+}
+
+TocinoAddress TocinoFlitHeader::GetIntermediate()
+{
+    NS_ASSERT( m_isHead );
+    return m_intermediate;
+}
+
+void TocinoFlitHeader::SetValiantPhase( ValiantPhase phase )
+{
+    NS_ASSERT( m_isHead );
+    m_valiantPhase = phase;
+}
+
+TocinoFlitHeader::ValiantPhase TocinoFlitHeader::GetValiantPhase()
+{
+    NS_ASSERT( m_isHead );
+    return m_valiantPhase;
+}
+
 TocinoFlitHeader::Type TocinoFlitHeader::CheckedConvertToType( int t )
 {
     NS_ASSERT_MSG( ( t >= MIN_TYPE ) && ( t <= MAX_TYPE ),
@@ -62,12 +62,31 @@ class TocinoFlitHeader : public Header
         IPV4,
         IPV6,
         ENCAPSULATED_PACKET,
+        CREDIT,
         MIN_TYPE = INVALID,
-        MAX_TYPE = ENCAPSULATED_PACKET
+        MAX_TYPE = CREDIT
     };
 
     void SetType( Type );
     Type GetType();
+
+    // Router-level Valiant routing, see TocinoValiantRouter.
+    // A packet first heads for its intermediate address,
+    // then turns for its destination.  Packets which are
+    // not routed this way stay MINIMAL throughout.
+    enum ValiantPhase
+    {
+        MINIMAL,
+        TO_INTERMEDIATE,
+        FROM_INTERMEDIATE,
+        MAX_VALIANT_PHASE = FROM_INTERMEDIATE
+    };
+
+    void SetIntermediate( TocinoAddress );
+    TocinoAddress GetIntermediate();
+
+    void SetValiantPhase( ValiantPhase );
+    ValiantPhase GetValiantPhase();
     
     static Type CheckedConvertToType( int );
 
@@ -85,6 +104,9 @@ class TocinoFlitHeader : public Header
 
     Type m_type;
 
+    TocinoAddress m_intermediate;
+    ValiantPhase m_valiantPhase;
+
     bool m_cloakHead;
     bool m_assumeHead;
 };
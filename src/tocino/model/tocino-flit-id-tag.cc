@@ -77,6 +77,18 @@ TocinoFlitIdTag::GetAbsolutePacketNumber() const
     return m_absolutePacketNumber;
 }
 
+uint32_t
+TocinoFlitIdTag::GetRelativeFlitNumber() const
+{
+    return m_relativeFlitNumber;
+}
+
+uint32_t
+TocinoFlitIdTag::GetTotalFlitsInPacket() const
+{
+    return m_totalFlitsInPacket;
+}
+
 uint32_t
 TocinoFlitIdTag::NextPacketNumber()
 {
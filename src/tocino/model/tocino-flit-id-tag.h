@@ -26,6 +26,8 @@ class TocinoFlitIdTag : public Tag
     TocinoFlitIdTag( uint32_t, uint32_t, uint32_t );
 
     uint32_t GetAbsolutePacketNumber() const;
+    uint32_t GetRelativeFlitNumber() const;
+    uint32_t GetTotalFlitsInPacket() const;
 
     static uint32_t NextPacketNumber();
 
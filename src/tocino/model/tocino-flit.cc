@@ -0,0 +1,338 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include <sstream>
+
+#include "tocino-flit.h"
+#include "tocino-flit-id-tag.h"
+
+namespace ns3
+{
+
+TocinoDecodedFlitHeader::TocinoDecodedFlitHeader()
+    : src( 0 )
+    , dst( 0 )
+    , vc( 0 )
+    , length( 0 )
+    , isHead( false )
+    , isTail( false )
+    , type( TocinoFlitHeader::INVALID )
+    , intermediate( 0 )
+    , valiantPhase( TocinoFlitHeader::MINIMAL )
+    , xState( TocinoAllXOFF )
+    , credits()
+{}
+
+TocinoFlitStamp::TocinoFlitStamp()
+    : hops( 0 )
+{}
+
+TocinoFlit::TocinoFlit()
+    : m_packet( NULL )
+    , m_isLightweight( false )
+    , m_isCloaked( false )
+    , m_offset( 0 )
+    , m_length( 0 )
+    , m_absolutePacketNumber( 0 )
+    , m_relativeFlitNumber( 0 )
+    , m_totalFlitsInPacket( 0 )
+{}
+
+TocinoFlit::TocinoFlit( Ptr<Packet> p )
+    : m_packet( p )
+    , m_isLightweight( false )
+    , m_isCloaked( false )
+    , m_offset( 0 )
+    , m_length( 0 )
+    , m_absolutePacketNumber( 0 )
+    , m_relativeFlitNumber( 0 )
+    , m_totalFlitsInPacket( 0 )
+{
+    NS_ASSERT( m_packet != NULL );
+    Decode();
+}
+
+TocinoFlit::TocinoFlit(
+        Ptr<Packet> parent,
+        const uint32_t offset,
+        const uint32_t length,
+        const TocinoDecodedFlitHeader& header )
+    : m_packet( parent )
+    , m_header( header )
+    , m_isLightweight( true )
+    , m_isCloaked( false )
+    , m_offset( offset )
+    , m_length( length )
+    , m_absolutePacketNumber( 0 )
+    , m_relativeFlitNumber( 0 )
+    , m_totalFlitsInPacket( 0 )
+{
+    NS_ASSERT( m_packet != NULL );
+    NS_ASSERT( m_offset + m_length <= m_packet->GetSize() );
+    NS_ASSERT( m_header.type != TocinoFlitHeader::LLC );
+    NS_ASSERT( m_header.type != TocinoFlitHeader::CREDIT );
+}
+
+void
+TocinoFlit::Decode()
+{
+    TocinoFlitHeader h;
+    m_packet->PeekHeader( h );
+
+    m_header.isHead = h.IsHead();
+    m_header.isTail = h.IsTail();
+    m_header.vc = h.GetVirtualChannel().AsUInt32();
+    m_header.length = h.GetLength();
+    m_header.type = h.GetType();
+
+    if( m_header.isHead )
+    {
+        m_header.src = h.GetSource();
+        m_header.dst = h.GetDestination();
+        m_header.intermediate = h.GetIntermediate();
+        m_header.valiantPhase = h.GetValiantPhase();
+    }
+
+    if( m_header.type == TocinoFlitHeader::LLC )
+    {
+        m_header.xState = GetTocinoFlowControlState( m_packet );
+    }
+
+    if( m_header.type == TocinoFlitHeader::CREDIT )
+    {
+        m_header.credits = GetTocinoCredits( m_packet );
+    }
+}
+
+uint32_t
+TocinoFlit::GetHeaderSize() const
+{
+    if( m_header.isHead )
+    {
+        return TocinoFlitHeader::SIZE_HEAD;
+    }
+
+    return TocinoFlitHeader::SIZE_OTHER;
+}
+
+uint32_t
+TocinoFlit::GetSize() const
+{
+    if( m_isLightweight )
+    {
+        // A cloaked head is still a head flit on the wire
+        if( m_isCloaked )
+        {
+            return TocinoFlitHeader::SIZE_HEAD + m_length;
+        }
+
+        return GetHeaderSize() + m_length;
+    }
+
+    return m_packet->GetSize();
+}
+
+uint32_t
+TocinoFlit::GetPayloadOffset() const
+{
+    NS_ASSERT( m_isLightweight );
+    return m_offset;
+}
+
+uint32_t
+TocinoFlit::GetPayloadLength() const
+{
+    NS_ASSERT( m_isLightweight );
+    return m_length;
+}
+
+void
+TocinoFlit::SetFlitId(
+        uint32_t absolutePacketNumber,
+        uint32_t relativeFlitNumber,
+        uint32_t totalFlitsInPacket )
+{
+    NS_ASSERT( m_isLightweight );
+
+    m_absolutePacketNumber = absolutePacketNumber;
+    m_relativeFlitNumber = relativeFlitNumber;
+    m_totalFlitsInPacket = totalFlitsInPacket;
+}
+
+uint32_t
+TocinoFlit::GetAbsolutePacketNumber() const
+{
+    NS_ASSERT( m_isLightweight );
+    return m_absolutePacketNumber;
+}
+
+void
+TocinoFlit::SetVirtualChannel( const TocinoVC vc )
+{
+    NS_ASSERT( m_packet != NULL );
+
+    m_header.vc = vc.AsUInt32();
+
+    // Lightweight flits have nothing serialized to keep in step
+    if( !m_isLightweight )
+    {
+        Reencode();
+    }
+}
+
+void
+TocinoFlit::SetValiantRoute(
+        const TocinoAddress& intermediate,
+        const TocinoFlitHeader::ValiantPhase phase )
+{
+    NS_ASSERT( m_packet != NULL );
+    NS_ASSERT( m_header.isHead );
+
+    m_header.intermediate = intermediate;
+    m_header.valiantPhase = phase;
+
+    if( !m_isLightweight )
+    {
+        Reencode();
+    }
+}
+
+void
+TocinoFlit::Reencode()
+{
+    NS_ASSERT( !m_isLightweight );
+
+    // Rebuild the header from the decoded fields, rather
+    // than deserializing it again.  A cloaked head flit
+    // decodes as a body flit, so its hidden source and
+    // destination simply ride along as payload here.
+
+    m_packet->RemoveAtStart( GetHeaderSize() );
+
+    TocinoFlitHeader h( m_header.src, m_header.dst );
+
+    if( m_header.isHead )
+    {
+        h.SetHead();
+        h.SetIntermediate( m_header.intermediate );
+        h.SetValiantPhase( m_header.valiantPhase );
+    }
+
+    if( m_header.isTail )
+    {
+        h.SetTail();
+    }
+
+    h.SetType( m_header.type );
+    h.SetLength( m_header.length );
+    h.SetVirtualChannel( m_header.vc );
+
+    m_packet->AddHeader( h );
+}
+
+void
+TocinoFlit::Cloak()
+{
+    NS_ASSERT( m_isLightweight );
+    NS_ASSERT( m_header.isHead );
+
+    // The source and destination stay in m_header,
+    // hidden, just as they stay in the payload of
+    // a serialized cloaked head flit
+    m_header.isHead = false;
+    m_isCloaked = true;
+}
+
+void
+TocinoFlit::Uncloak()
+{
+    NS_ASSERT( m_packet != NULL );
+    NS_ASSERT( !m_header.isHead );
+
+    if( m_isLightweight )
+    {
+        NS_ASSERT( m_isCloaked );
+
+        m_header.isHead = true;
+        m_isCloaked = false;
+        return;
+    }
+
+    TocinoUncloakHeadFlit( m_packet );
+    Decode();
+
+    NS_ASSERT( m_header.isHead );
+}
+
+std::string
+TocinoFlit::GetIdString() const
+{
+    if( m_isLightweight )
+    {
+        // Same format as TocinoFlitIdTag::Print
+        std::ostringstream oss;
+
+        oss << "fid="
+            << m_absolutePacketNumber
+            << "["
+            << m_relativeFlitNumber
+            << "/"
+            << m_totalFlitsInPacket
+            << "]";
+
+        return oss.str();
+    }
+
+    return GetTocinoFlitIdString( m_packet );
+}
+
+std::string
+GetTocinoFlitIdString( const TocinoFlit& flit )
+{
+    return flit.GetIdString();
+}
+
+void
+TocinoAddIntermediateDestination(
+        TocinoFlitQueue& packet,
+        const TocinoAddress& intermediateDest )
+{
+    // See the TocinoFlittizedPacket version for details.
+    //
+    // We cloak the inner head flit, then staple a new
+    // "runt" head flit with the intermediate destination
+    // to the front of the packet.
+
+    TocinoFlit& innerHeadFlit = packet.front();
+
+    NS_ASSERT( innerHeadFlit.IsLightweight() );
+    NS_ASSERT( innerHeadFlit.IsHead() );
+
+    TocinoDecodedFlitHeader outerHeader;
+
+    outerHeader.src = innerHeadFlit.GetSource();
+    outerHeader.dst = intermediateDest;
+    outerHeader.isHead = true;
+    outerHeader.type = TocinoFlitHeader::ENCAPSULATED_PACKET;
+    outerHeader.length = TocinoFlitHeader::SIZE_HEAD;
+    outerHeader.vc = innerHeadFlit.GetVirtualChannel().AsUInt32();
+
+    const TocinoFlit outerHeadFlit(
+            innerHeadFlit.GetPacket(), 0, 0, outerHeader );
+
+    const uint32_t ABS_PACKET_NUM = packet.back().GetAbsolutePacketNumber();
+
+    innerHeadFlit.Cloak();
+
+    packet.push_front( outerHeadFlit );
+
+    const uint32_t TOTAL_FLITS = packet.size();
+
+    for( uint32_t i = 0; i < TOTAL_FLITS; ++i )
+    {
+        const uint32_t REL_FLIT_NUM = i+1;
+
+        packet[i].SetFlitId( ABS_PACKET_NUM, REL_FLIT_NUM, TOTAL_FLITS );
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,258 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_FLIT_H__
+#define __TOCINO_FLIT_H__
+
+#include <deque>
+#include <string>
+
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+
+#include "tocino-address.h"
+#include "tocino-flit-header.h"
+#include "tocino-flow-control.h"
+#include "tocino-misc.h"
+
+namespace ns3
+{
+
+// The fields of a TocinoFlitHeader which are consulted on
+// every hop, decoded once.
+//
+// Reading these is a plain load, unlike the PeekHeader()-based
+// accessors in tocino-flit-header.h which deserialize the whole
+// header on every call.
+struct TocinoDecodedFlitHeader
+{
+    TocinoAddress src;
+    TocinoAddress dst;
+
+    uint8_t vc;
+    uint8_t length;
+
+    bool isHead;
+    bool isTail;
+
+    TocinoFlitHeader::Type type;
+
+    // Only meaningful for head flits
+    TocinoAddress intermediate;
+    TocinoFlitHeader::ValiantPhase valiantPhase;
+
+    // Only meaningful for LLC flits
+    TocinoFlowControlState xState;
+
+    // Only meaningful for credit flits
+    TocinoCredits credits;
+
+    TocinoDecodedFlitHeader();
+};
+
+// Instrumentation carried by a flit through the fabric.
+// Only head flits are stamped; the tail of a packet is
+// ejected at most a few flit times after its head.  This
+// is never serialized, except across MPI ranks.
+struct TocinoFlitStamp
+{
+    Time injected;  // packet accepted by the source device
+    Time arrived;   // at the current router
+    Time queueing;  // total spent in routers so far
+    uint32_t hops;  // channels traversed
+
+    TocinoFlitStamp();
+};
+
+// A flit as it travels through the fabric: the serialized
+// Ptr<Packet> plus its decoded header.
+//
+// The two must never disagree.  All modifications of the
+// header therefore go through this class, which rewrites
+// the serialized bytes and the decoded copy together.
+//
+// A "lightweight" flit instead has no packet of its own.  It
+// refers to a byte range of its parent packet, which is shared
+// by every flit of that packet, and carries only the decoded
+// header and flit id.  Nothing is serialized or copied until
+// the parent is handed back at ejection.
+
+class TocinoFlit
+{
+    public:
+
+    TocinoFlit();
+    explicit TocinoFlit( Ptr<Packet> );
+
+    // Create a lightweight flit, carrying the given
+    // header and payload bytes [offset, offset+length)
+    // of the parent packet
+    TocinoFlit(
+            Ptr<Packet>,
+            const uint32_t offset,
+            const uint32_t length,
+            const TocinoDecodedFlitHeader& );
+
+    Ptr<Packet> GetPacket() const
+    {
+        return m_packet;
+    }
+
+    const TocinoDecodedFlitHeader& GetHeader() const
+    {
+        return m_header;
+    }
+
+    bool IsNull() const
+    {
+        return m_packet == NULL;
+    }
+
+    bool IsHead() const
+    {
+        return m_header.isHead;
+    }
+
+    bool IsTail() const
+    {
+        return m_header.isTail;
+    }
+
+    TocinoVC GetVirtualChannel() const
+    {
+        return TocinoVC( m_header.vc );
+    }
+
+    TocinoAddress GetSource() const
+    {
+        NS_ASSERT( m_header.isHead );
+        return m_header.src;
+    }
+
+    TocinoAddress GetDestination() const
+    {
+        NS_ASSERT( m_header.isHead );
+        return m_header.dst;
+    }
+
+    TocinoFlitHeader::Type GetType() const
+    {
+        return m_header.type;
+    }
+
+    TocinoAddress GetIntermediate() const
+    {
+        NS_ASSERT( m_header.isHead );
+        return m_header.intermediate;
+    }
+
+    TocinoFlitHeader::ValiantPhase GetValiantPhase() const
+    {
+        NS_ASSERT( m_header.isHead );
+        return m_header.valiantPhase;
+    }
+
+    // True of both XON/XOFF and credit flits
+    bool IsFlowControl() const
+    {
+        return ( m_header.type == TocinoFlitHeader::LLC ) ||
+            ( m_header.type == TocinoFlitHeader::CREDIT );
+    }
+
+    bool IsCredit() const
+    {
+        return m_header.type == TocinoFlitHeader::CREDIT;
+    }
+
+    const TocinoFlowControlState& GetFlowControlState() const
+    {
+        NS_ASSERT( m_header.type == TocinoFlitHeader::LLC );
+        return m_header.xState;
+    }
+
+    const TocinoCredits& GetCredits() const
+    {
+        NS_ASSERT( IsCredit() );
+        return m_header.credits;
+    }
+
+    bool IsLightweight() const
+    {
+        return m_isLightweight;
+    }
+
+    // Size on the wire, including the header
+    uint32_t GetSize() const;
+
+    uint32_t GetHeaderSize() const;
+
+    // For lightweight flits only; the byte range of
+    // the parent packet carried by this flit
+    uint32_t GetPayloadOffset() const;
+    uint32_t GetPayloadLength() const;
+
+    // For lightweight flits only
+    void SetFlitId( uint32_t, uint32_t, uint32_t );
+    uint32_t GetAbsolutePacketNumber() const;
+
+    // Rewrite the virtual channel of this flit
+    void SetVirtualChannel( const TocinoVC );
+
+    // Rewrite the Valiant routing fields of a head flit
+    void SetValiantRoute(
+            const TocinoAddress&,
+            const TocinoFlitHeader::ValiantPhase );
+
+    // For lightweight flits only; disguise a head
+    // flit as a body flit, see TocinoAddIntermediateDestination
+    void Cloak();
+
+    // Reveal a head flit cloaked by TocinoAddIntermediateDestination
+    void Uncloak();
+
+    std::string GetIdString() const;
+
+    TocinoFlitStamp& GetStamp()
+    {
+        return m_stamp;
+    }
+
+    const TocinoFlitStamp& GetStamp() const
+    {
+        return m_stamp;
+    }
+
+    private:
+
+    void Decode();
+
+    // Serialize the decoded header afresh, after a change
+    void Reencode();
+
+    Ptr<Packet> m_packet;
+    TocinoDecodedFlitHeader m_header;
+
+    // Lightweight flits only
+    bool m_isLightweight;
+    bool m_isCloaked;
+    uint32_t m_offset;
+    uint32_t m_length;
+    uint32_t m_absolutePacketNumber;
+    uint16_t m_relativeFlitNumber;
+    uint16_t m_totalFlitsInPacket;
+
+    TocinoFlitStamp m_stamp;
+};
+
+typedef std::deque< TocinoFlit > TocinoFlitQueue;
+
+std::string GetTocinoFlitIdString( const TocinoFlit& );
+
+// As for the TocinoFlittizedPacket version in tocino-misc.h,
+// but for a packet of lightweight flits
+void TocinoAddIntermediateDestination(
+        TocinoFlitQueue&,
+        const TocinoAddress& );
+
+} // namespace ns3
+
+#endif // __TOCINO_FLIT_H__
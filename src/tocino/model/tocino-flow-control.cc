@@ -1,14 +1,20 @@
 /* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
 
+#include <cstring>
+#include <map>
+
 #include "ns3/packet.h"
 
 #include "tocino-flow-control.h"
 #include "tocino-flit-header.h"
 #include "tocino-flit-id-tag.h"
+#include "tocino-flit.h"
 
 namespace ns3
 {
 
+const uint32_t TocinoCredits::MAX_CREDITS;
+
 Ptr<Packet>
 GetTocinoFlowControlFlit( const TocinoFlowControlState& s )
 {
@@ -35,13 +41,10 @@ GetTocinoFlowControlFlit( const TocinoFlowControlState& s )
 bool
 IsTocinoFlowControlFlit( Ptr<const Packet> flit )
 {
-    // Make a copy so we can safely RemoveHeader() later
-    Ptr<Packet> f = flit->Copy();
-
-    // We *must* remove, not merely peek, otherwise 
-    // subsequent CopyData() will return header & payload
+    // Peeking deserializes in place; no need to copy the
+    // packet just to look at its type
     TocinoFlitHeader h;
-    f->RemoveHeader(h);
+    flit->PeekHeader(h);
 
     if( h.GetType() == TocinoFlitHeader::LLC )
     {
@@ -58,22 +61,127 @@ GetTocinoFlowControlState( Ptr<const Packet> flit )
 {
     NS_ASSERT( IsTocinoFlowControlFlit( flit ) );
 
-    // Make a copy so we can safely RemoveHeader() later
-    Ptr<Packet> f = flit->Copy();
-
-    // We *must* remove, not merely peek, otherwise 
-    // subsequent CopyData() will return header & payload
     TocinoFlitHeader h;
-    f->RemoveHeader(h);
+    const uint32_t HEADER_SIZE = flit->PeekHeader(h);
 
     // ISSUE-REVIEW: ulong is bigger than we currently
     // need in order to represent 16 flits.  Consider
     // using 2B here instead.
     unsigned long data;
 
-    f->CopyData( reinterpret_cast<uint8_t*>( &data ), sizeof(data) );
+    // CopyData() always starts at the header, so copy the
+    // whole (tiny) flit onto the stack and skip past it,
+    // rather than copying the packet and removing the header
+    uint8_t buf[ 64 ];
+    const uint32_t SIZE = HEADER_SIZE + sizeof(data);
+    NS_ASSERT( SIZE <= sizeof(buf) );
+    NS_ASSERT( flit->GetSize() == SIZE );
+
+    flit->CopyData( buf, SIZE );
+    memcpy( &data, buf + HEADER_SIZE, sizeof(data) );
 
     return TocinoFlowControlState( data );
 }
 
+const TocinoFlit&
+GetPooledTocinoFlowControlFlit( const TocinoFlowControlState& s )
+{
+    typedef std::map< unsigned long, TocinoFlit > FlitPool;
+    static FlitPool pool;
+
+    const unsigned long key = s.to_ulong();
+    FlitPool::iterator it = pool.find( key );
+
+    if( it == pool.end() )
+    {
+        TocinoFlit f( GetTocinoFlowControlFlit( s ) );
+        it = pool.insert( std::make_pair( key, f ) ).first;
+    }
+
+    return it->second;
+}
+
+Ptr<Packet>
+GetTocinoCreditFlit( const TocinoCredits& c )
+{
+    uint64_t data = c.GetPacked();
+
+    Ptr<Packet> f =
+        Create<Packet>( reinterpret_cast<uint8_t*>( &data ), sizeof(data) );
+
+    // N.B.
+    // Unlike an XON/XOFF flit, a credit flit is not a head
+    // flit, so it carries only the short header.  Credits
+    // flow back for nearly every data flit, so every byte
+    // here is paid over and over.
+    TocinoFlitHeader h;
+    h.SetTail();
+    h.SetType( TocinoFlitHeader::CREDIT );
+    f->AddHeader(h);
+
+    TocinoFlitIdTag tag( TocinoFlitIdTag::NextPacketNumber(), 1, 1 );
+    f->AddPacketTag( tag );
+
+    return f;
+}
+
+bool
+IsTocinoCreditFlit( Ptr<const Packet> flit )
+{
+    TocinoFlitHeader h;
+    flit->PeekHeader(h);
+
+    if( h.GetType() == TocinoFlitHeader::CREDIT )
+    {
+        NS_ASSERT( !h.IsHead() );
+        NS_ASSERT( h.IsTail() );
+        return true;
+    }
+
+    return false;
+}
+
+TocinoCredits
+GetTocinoCredits( Ptr<const Packet> flit )
+{
+    NS_ASSERT( IsTocinoCreditFlit( flit ) );
+
+    TocinoFlitHeader h;
+    const uint32_t HEADER_SIZE = flit->PeekHeader(h);
+
+    uint64_t data;
+
+    uint8_t buf[ 64 ];
+    const uint32_t SIZE = HEADER_SIZE + sizeof(data);
+    NS_ASSERT( SIZE <= sizeof(buf) );
+    NS_ASSERT( flit->GetSize() == SIZE );
+
+    flit->CopyData( buf, SIZE );
+    memcpy( &data, buf + HEADER_SIZE, sizeof(data) );
+
+    return TocinoCredits( data );
+}
+
+const TocinoFlit&
+GetPooledTocinoCreditFlit( const TocinoCredits& c )
+{
+    // N.B.
+    // There are far more distinct credit flits than XON/XOFF
+    // flits, but a VC never has more credits outstanding than
+    // its receiver has buffers, so the pool stays small.
+    typedef std::map< uint64_t, TocinoFlit > FlitPool;
+    static FlitPool pool;
+
+    const uint64_t key = c.GetPacked();
+    FlitPool::iterator it = pool.find( key );
+
+    if( it == pool.end() )
+    {
+        TocinoFlit f( GetTocinoCreditFlit( c ) );
+        it = pool.insert( std::make_pair( key, f ) ).first;
+    }
+
+    return it->second;
+}
+
 }
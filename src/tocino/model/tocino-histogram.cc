@@ -0,0 +1,166 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "ns3/assert.h"
+
+#include "tocino-histogram.h"
+
+namespace ns3
+{
+
+TocinoHistogram::TocinoHistogram()
+    : m_count( 0 )
+    , m_min( std::numeric_limits< uint64_t >::max() )
+    , m_max( 0 )
+    , m_sum( 0 )
+{}
+
+uint32_t
+TocinoHistogram::GetBucket( const uint64_t v )
+{
+    if( v < 2*SUB_BUCKETS )
+    {
+        return v;
+    }
+
+    // Keep the top SUB_BUCKET_BITS+1 bits of the value
+    const uint32_t msb = 63 - __builtin_clzll( v );
+    const uint32_t shift = msb - SUB_BUCKET_BITS;
+
+    return shift * SUB_BUCKETS + ( v >> shift );
+}
+
+uint64_t
+TocinoHistogram::GetBucketHigh( const uint32_t bucket )
+{
+    if( bucket < 2*SUB_BUCKETS )
+    {
+        return bucket;
+    }
+    
+    // Inverse of GetBucket
+    const uint32_t shift = bucket / SUB_BUCKETS - 1;
+    const uint64_t top = bucket - shift * SUB_BUCKETS;
+
+    return ( ( top + 1 ) << shift ) - 1;
+}
+
+void
+TocinoHistogram::Add( const uint64_t v )
+{
+    const uint32_t bucket = GetBucket( v );
+
+    if( bucket >= m_buckets.size() )
+    {
+        m_buckets.resize( bucket + 1, 0 );
+    }
+
+    m_buckets[bucket]++;
+
+    m_count++;
+    m_min = std::min( m_min, v );
+    m_max = std::max( m_max, v );
+    m_sum += v;
+}
+
+void
+TocinoHistogram::Merge( const TocinoHistogram& other )
+{
+    if( other.m_buckets.size() > m_buckets.size() )
+    {
+        m_buckets.resize( other.m_buckets.size(), 0 );
+    }
+
+    for( uint32_t i = 0; i < other.m_buckets.size(); ++i )
+    {
+        m_buckets[i] += other.m_buckets[i];
+    }
+
+    m_count += other.m_count;
+    m_min = std::min( m_min, other.m_min );
+    m_max = std::max( m_max, other.m_max );
+    m_sum += other.m_sum;
+}
+
+void
+TocinoHistogram::Reset()
+{
+    *this = TocinoHistogram();
+}
+
+uint64_t
+TocinoHistogram::GetCount() const
+{
+    return m_count;
+}
+
+uint64_t
+TocinoHistogram::GetMin() const
+{
+    return m_count > 0 ? m_min : 0;
+}
+
+uint64_t
+TocinoHistogram::GetMax() const
+{
+    return m_max;
+}
+
+double
+TocinoHistogram::GetMean() const
+{
+    return m_count > 0 ? m_sum / m_count : 0;
+}
+
+uint64_t
+TocinoHistogram::GetPercentile( const double quantile ) const
+{
+    NS_ASSERT( ( quantile >= 0 ) && ( quantile <= 1 ) );
+
+    if( m_count == 0 )
+    {
+        return 0;
+    }
+
+    // The rank of the value we want, counting from one
+    const uint64_t rank = std::max< uint64_t >( 1,
+            static_cast< uint64_t >( std::ceil( quantile * m_count ) ) );
+
+    uint64_t seen = 0;
+
+    for( uint32_t bucket = 0; bucket < m_buckets.size(); ++bucket )
+    {
+        seen += m_buckets[bucket];
+
+        if( seen >= rank )
+        {
+            return std::min( GetBucketHigh( bucket ), m_max );
+        }
+    }
+
+    NS_ASSERT_MSG( false, "Bucket counts do not add up" );
+    return m_max;
+}
+
+void
+TocinoHistogram::PrintSummaryHeader( std::ostream& os )
+{
+    os << "count,min,mean,p50,p99,p999,max";
+}
+
+void
+TocinoHistogram::PrintSummary( std::ostream& os ) const
+{
+    os << GetCount() << ","
+       << GetMin() << ","
+       << GetMean() << ","
+       << GetPercentile( 0.5 ) << ","
+       << GetPercentile( 0.99 ) << ","
+       << GetPercentile( 0.999 ) << ","
+       << GetMax();
+}
+
+}
@@ -28,20 +28,16 @@ void TocinoCustomizeLogging()
     LogSetTimePrinter( &TocinoTimePrinter );
 }
 
+// N.B.
+// Ports are numbered in pairs, one pair per dimension,
+// positive direction first: X+ X- Y+ Y- Z+ Z- W+ W-
+
 TocinoDirection
 TocinoGetDirection( const TocinoPort port )
 {
-    if( (port == TOCINO_PORT_X_POS) ||
-        (port == TOCINO_PORT_Y_POS) ||
-        (port == TOCINO_PORT_Z_POS) )
-    {
-        return TOCINO_DIRECTION_POS;
-    }
-    else if( (port == TOCINO_PORT_X_NEG) ||
-             (port == TOCINO_PORT_Y_NEG) ||
-             (port == TOCINO_PORT_Z_NEG) )
+    if( port < 2 * TOCINO_MAX_DIMENSIONS )
     {
-        return TOCINO_DIRECTION_NEG;
+        return TocinoDirection( port.AsUInt32() & 1 );
     }
     
     return TOCINO_INVALID_DIRECTION;
@@ -50,20 +46,9 @@ TocinoGetDirection( const TocinoPort port )
 TocinoDimension
 TocinoGetDimension( const TocinoPort port )
 {
-    if( (port == TOCINO_PORT_X_POS) ||
-        (port == TOCINO_PORT_X_NEG) )
+    if( port < 2 * TOCINO_MAX_DIMENSIONS )
     {
-        return TOCINO_DIMENSION_X;
-    }
-    else if( (port == TOCINO_PORT_Y_POS) ||
-             (port == TOCINO_PORT_Y_NEG) )
-    {
-        return TOCINO_DIMENSION_Y;
-    }
-    else if( (port == TOCINO_PORT_Z_POS) ||
-             (port == TOCINO_PORT_Z_NEG) )
-    {
-        return TOCINO_DIMENSION_Z;
+        return TocinoDimension( port.AsUInt32() / 2 );
     }
     
     return TOCINO_INVALID_DIMENSION;
@@ -74,29 +59,10 @@ TocinoGetPort(
         const TocinoDimension dim,
         const TocinoDirection dir )
 {
-    if( (dim == TOCINO_DIMENSION_X) && (dir == TOCINO_DIRECTION_POS) )
-    {
-        return TOCINO_PORT_X_POS;
-    }
-    else if( (dim == TOCINO_DIMENSION_X) && (dir == TOCINO_DIRECTION_NEG) )
+    if( (dim < TOCINO_MAX_DIMENSIONS) &&
+        ((dir == TOCINO_DIRECTION_POS) || (dir == TOCINO_DIRECTION_NEG)) )
     {
-        return TOCINO_PORT_X_NEG;
-    }
-    else if( (dim == TOCINO_DIMENSION_Y) && (dir == TOCINO_DIRECTION_POS) )
-    {
-        return TOCINO_PORT_Y_POS;
-    }
-    else if( (dim == TOCINO_DIMENSION_Y) && (dir == TOCINO_DIRECTION_NEG) )
-    {
-        return TOCINO_PORT_Y_NEG;
-    }
-    else if( (dim == TOCINO_DIMENSION_Z) && (dir == TOCINO_DIRECTION_POS) )
-    {
-        return TOCINO_PORT_Z_POS;
-    }
-    else if( (dim == TOCINO_DIMENSION_Z) && (dir == TOCINO_DIRECTION_NEG) )
-    {
-        return TOCINO_PORT_Z_NEG;
+        return TocinoPort( 2 * dim.AsUInt32() + dir.AsUInt32() );
     }
 
     return TOCINO_INVALID_PORT;
@@ -156,15 +122,20 @@ TocinoDimensionToString(
     {
         oss << "Z";
     }
+    else if( dim == TOCINO_DIMENSION_W )
+    {
+        oss << "W";
+    }
 
     return oss.str();
 }
 
 std::string
 TocinoPortToString(
-        const TocinoPort port )
+        const TocinoPort port,
+        const TocinoPort hostPort )
 {
-    if( port == TOCINO_PORT_HOST )
+    if( port == hostPort )
     {
         return "host";
     }
@@ -38,9 +38,10 @@ DEFINE_TOCINO_TYPE_SAFE_UINT32( TocinoDimension );
 const TocinoDimension TOCINO_DIMENSION_X( 0 );
 const TocinoDimension TOCINO_DIMENSION_Y( 1 );
 const TocinoDimension TOCINO_DIMENSION_Z( 2 );
+const TocinoDimension TOCINO_DIMENSION_W( 3 );
 const TocinoDimension TOCINO_INVALID_DIMENSION( std::numeric_limits<uint32_t>::max() );
 
-const uint32_t TOCINO_MAX_DIMENSIONS = 3;
+const uint32_t TOCINO_MAX_DIMENSIONS = 4;
 
 //
 // Ports
@@ -66,10 +67,15 @@ const TocinoPort TOCINO_PORT_Y_POS( 2 );
 const TocinoPort TOCINO_PORT_Y_NEG( 3 );
 const TocinoPort TOCINO_PORT_Z_POS( 4 );
 const TocinoPort TOCINO_PORT_Z_NEG( 5 );
-const TocinoPort TOCINO_PORT_HOST( 6 );
+const TocinoPort TOCINO_PORT_W_POS( 6 );
+const TocinoPort TOCINO_PORT_W_NEG( 7 );
 const TocinoPort TOCINO_INVALID_PORT( std::numeric_limits<uint32_t>::max() );
 
-const uint32_t TOCINO_MAX_PORTS = 7;
+// N.B.
+// The host port has no fixed number; it follows the last
+// network port, see TocinoNetDevice::GetHostPort().
+
+const uint32_t TOCINO_MAX_PORTS = 2 * TOCINO_MAX_DIMENSIONS + 1;
 
 //
 // Virtual Channels
@@ -109,7 +115,7 @@ TocinoDirection TocinoGetOppositeDirection( const TocinoDirection );
 
 std::string TocinoDirectionToString( const TocinoDirection );
 std::string TocinoDimensionToString( const TocinoDimension );
-std::string TocinoPortToString( const TocinoPort );
+std::string TocinoPortToString( const TocinoPort, const TocinoPort hostPort );
 
 typedef std::deque< Ptr<Packet> > TocinoFlittizedPacket;
 
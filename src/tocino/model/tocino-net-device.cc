@@ -3,15 +3,20 @@
 #include <cstdio>
 
 #include "ns3/log.h"
+#include "ns3/abort.h"
 #include "ns3/data-rate.h"
 #include "ns3/uinteger.h"
 #include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
 #include "ns3/node.h"
 #include "ns3/channel.h"
 #include "ns3/ethernet-header.h"
 #include "ns3/ethernet-trailer.h"
 #include "ns3/pointer.h"
 #include "ns3/object-factory.h"
+#include "ns3/simulator.h"
+#include "ns3/trace-source-accessor.h"
 
 #include "tocino-net-device.h"
 #include "tocino-rx.h"
@@ -21,6 +26,7 @@
 #include "tocino-dimension-order-router.h"
 #include "tocino-simple-arbiter.h"
 #include "tocino-flit-id-tag.h"
+#include "tocino-traffic-class-tag.h"
 
 NS_LOG_COMPONENT_DEFINE ("TocinoNetDevice");
 
@@ -62,11 +68,73 @@ TypeId TocinoNetDevice::GetTypeId(void)
             TypeIdValue( TocinoSimpleArbiter::GetTypeId() ),
             MakeTypeIdAccessor( &TocinoNetDevice::m_arbiterTypeId ),
             MakeTypeIdChecker() )
+        .AddAttribute( "FlowControl",
+            "Link-level flow control, XON/XOFF or credits.",
+            EnumValue( TocinoNetDevice::XON_XOFF ),
+            MakeEnumAccessor( &TocinoNetDevice::m_flowControl ),
+            MakeEnumChecker(
+                TocinoNetDevice::XON_XOFF, "XonXoff",
+                TocinoNetDevice::CREDIT, "Credit" ) )
+        .AddAttribute( "InputQueueFlits",
+            "Depth of each input queue, per virtual channel.",
+            UintegerValue( TocinoRx::DEFAULT_INPUT_QUEUE_FLITS ),
+            MakeUintegerAccessor( &TocinoNetDevice::m_inputQueueFlits ),
+            MakeUintegerChecker<uint32_t>( 1 ) )
+        .AddAttribute( "VCClasses",
+            "Comma-separated VCs of each traffic class, lowest first; empty is one class.",
+            StringValue( "" ),
+            MakeStringAccessor( &TocinoNetDevice::m_vcClasses ),
+            MakeStringChecker() )
+        .AddAttribute( "InputVCSelection",
+            "How each receiver picks the input VC to forward from next.",
+            EnumValue( TocinoNetDevice::LOWEST_VC ),
+            MakeEnumAccessor( &TocinoNetDevice::m_inputVCSelection ),
+            MakeEnumChecker(
+                TocinoNetDevice::LOWEST_VC, "LowestFirst",
+                TocinoNetDevice::ROUND_ROBIN_VC, "RoundRobin",
+                TocinoNetDevice::OLDEST_FIRST, "OldestFirst",
+                TocinoNetDevice::CLASS_PRIORITY, "ClassPriority" ) )
         .AddAttribute( "RoundRobinVCInject", 
             "Round-robin switch injection VC on each packets.",
             BooleanValue( false ),
             MakeBooleanAccessor( &TocinoNetDevice::m_roundRobinVCInject),
             MakeBooleanChecker() )
+        .AddAttribute( "LightweightFlits", 
+            "Carry flits as references into the original packet, rather than as packets.",
+            BooleanValue( false ),
+            MakeBooleanAccessor( &TocinoNetDevice::m_lightweightFlits),
+            MakeBooleanChecker() )
+        .AddAttribute( "ExpressTransmit", 
+            "Send consecutive flits of a packet in one event when nothing can contend for the link.  "
+            "Flits keep their flit-at-a-time timing, but simultaneous arrivals at a router may be "
+            "handled in another order, so arbitration between them, and the latency of the packets "
+            "involved, may differ.",
+            BooleanValue( false ),
+            MakeBooleanAccessor( &TocinoNetDevice::m_expressTransmit ),
+            MakeBooleanChecker() )
+        .AddAttribute( "CoalesceWork", 
+            "Run deferred receiver and transmitter work from one event per device, rather than one event each.",
+            BooleanValue( true ),
+            MakeBooleanAccessor( &TocinoNetDevice::m_coalesceWork ),
+            MakeBooleanChecker() )
+        .AddAttribute( "InjectionQueueMaxFlits", 
+            "Flits which may wait for injection on each VC before Send() refuses packets, zero for no limit.",
+            UintegerValue( 0 ),
+            MakeUintegerAccessor( &TocinoNetDevice::m_injectionQueueMaxFlits ),
+            MakeUintegerChecker<uint32_t>() )
+        .AddAttribute( "PerSourceLatency", 
+            "Keep a latency histogram per source, as well as the total.",
+            BooleanValue( false ),
+            MakeBooleanAccessor( &TocinoNetDevice::m_perSourceLatency ),
+            MakeBooleanChecker() )
+        .AddTraceSource( "PacketLatency",
+            "A packet has been ejected.",
+            MakeTraceSourceAccessor( &TocinoNetDevice::m_packetLatencyTrace ),
+            "ns3::TocinoNetDevice::PacketLatencyCallback" )
+        .AddTraceSource( "InjectionQueueHighWater",
+            "Most flits ever waiting for injection on any one VC.",
+            MakeTraceSourceAccessor( &TocinoNetDevice::m_outgoingFlitsMaxSize ),
+            "ns3::TracedValue::Uint32Callback" )
         .AddConstructor<TocinoNetDevice>();
     return tid;
 }
@@ -76,15 +144,27 @@ TocinoNetDevice::TocinoNetDevice()
     , m_ifIndex( 0 )
     , m_mtu( DEFAULT_MTU )
     , m_address( 0 )
+    , m_injectionQueueMaxFlits( 0 )
     , m_outgoingFlitsMaxSize( 0 )
+    , m_injectionBlocked( false )
+    , m_nextReadyCallback( 0 )
+    , m_perSourceLatency( false )
     , m_rxCallback( NULL )
     , m_promiscRxCallback( NULL )
     , m_nPorts( DEFAULT_NPORTS )
     , m_nVCs( DEFAULT_NVCS )
     , m_routerTypeId( TocinoDimensionOrderRouter::GetTypeId() )
     , m_arbiterTypeId( TocinoSimpleArbiter::GetTypeId() )
+    , m_flowControl( XON_XOFF )
+    , m_inputQueueFlits( TocinoRx::DEFAULT_INPUT_QUEUE_FLITS )
+    , m_inputVCSelection( LOWEST_VC )
     , m_roundRobinVCInject( false )
+    , m_lightweightFlits( false )
+    , m_expressTransmit( false )
+    , m_coalesceWork( true )
     , m_packetCounter( 0 )
+    , m_workEvents( 0 )
+    , m_expressRuns( 0 )
 {}
 
 void
@@ -94,9 +174,12 @@ TocinoNetDevice::Initialize()
     m_outgoingFlits.resize( m_nVCs );
     m_incomingPackets.resize( m_nVCs, NULL );
     m_incomingSources.resize( m_nVCs );
+    m_incomingStamps.resize( m_nVCs );
     m_receivers.resize( m_nPorts );
     m_transmitters.resize( m_nPorts );
 
+    m_vcAllocator.Initialize( m_nVCs, m_vcClasses );
+
     // create receivers and routers
     // create transmitters and arbiters
     for( uint32_t i = 0; i < m_nPorts; i++ )
@@ -289,6 +372,62 @@ TocinoNetDevice::Flitter( const Ptr<Packet> p, const TocinoAddress& src, const T
     return q;
 }
 
+TocinoFlitQueue
+TocinoNetDevice::LightweightFlitter( const Ptr<Packet> p, const TocinoAddress& src, const TocinoAddress& dst, const TocinoInputVC vc, const TocinoFlitHeader::Type type )
+{
+    uint32_t start = 0;
+    bool isFirstFlit = true;
+    
+    TocinoFlitQueue q;
+   
+    uint32_t remainder = p->GetSize();
+
+    do
+    {
+        const uint32_t LIMIT = isFirstFlit ? 
+            TocinoFlitHeader::MAX_PAYLOAD_HEAD :
+            TocinoFlitHeader::MAX_PAYLOAD_OTHER;
+        
+        const bool isLastFlit = (remainder <= LIMIT);
+       
+        const uint32_t LEN = isLastFlit ? remainder : LIMIT;
+    
+        TocinoDecodedFlitHeader h;
+
+        // Unlike a serialized non-head flit, we keep the
+        // addresses; they cost nothing here
+        h.src = src;
+        h.dst = dst;
+        h.isHead = isFirstFlit;
+        h.isTail = isLastFlit;
+        h.type = isFirstFlit ? type : TocinoFlitHeader::INVALID;
+        h.length = LEN;
+        h.vc = vc.AsUInt32();
+
+        q.push_back( TocinoFlit( p, start, LEN, h ) );
+
+        isFirstFlit = false;
+    
+        start += LEN;
+        remainder -= LEN;
+    }
+    while( remainder > 0 );
+
+    NS_ASSERT_MSG( q.size() > 0, "Flitter must always produce at least one flit" );
+
+    const uint32_t ABS_PACKET_NUM = TocinoFlitIdTag::NextPacketNumber();
+    const uint32_t TOTAL_FLITS = q.size();
+
+    for( uint32_t i = 0; i < TOTAL_FLITS; ++i )
+    {
+        const uint32_t REL_FLIT_NUM = i+1;
+
+        q[i].SetFlitId( ABS_PACKET_NUM, REL_FLIT_NUM, TOTAL_FLITS );
+    }
+
+    return q;
+}
+
 bool 
 TocinoNetDevice::SendEx(
         Ptr<Packet> packet,
@@ -312,56 +451,139 @@ TocinoNetDevice::SendEx(
     p->AddHeader( eh );
     p->AddTrailer( et );
 
-    uint32_t injectionVC = TOCINO_INVALID_VC;
+    TocinoTrafficClassTag classTag;
+    p->RemovePacketTag( classTag );
 
-    if( m_roundRobinVCInject )
+    const uint32_t trafficClass = classTag.GetTrafficClass();
+
+    NS_ABORT_MSG_IF( trafficClass >= m_vcAllocator.GetNClasses(),
+            "No VCs for traffic class " << trafficClass );
+
+    // N.B.
+    // A packet bounced through an intermediate node must
+    // start on a pair of its first leg.  We inject on the
+    // base (even-numbered) VC of a pair. The high
+    // (odd-numbered) VCs are reserved for deadlock
+    // avoidance via dateline algorithm.
+    const TocinoVCAllocator::Leg leg = via.IsValid() ?
+        TocinoVCAllocator::FIRST_LEG : TocinoVCAllocator::ANY_LEG;
+
+    // Round-robin across the VC pairs of the class, or
+    // always its lowest
+    const uint32_t injectionVC = m_vcAllocator.GetInjectionVC(
+            trafficClass, leg, m_roundRobinVCInject ? m_packetCounter : 0 ).AsUInt32();
+
+    NS_ASSERT( injectionVC < m_outgoingFlits.size() );
+
+    TocinoFlitQueue& outgoing = m_outgoingFlits[injectionVC];
+
+    if( m_injectionQueueMaxFlits > 0 && !outgoing.empty() )
     {
-        // Round-robin across all the VC pairs
-        //
         // N.B.
-        // We may inject on the base (even-numbered)
-        // VC of each pair. The high (odd-numbered) 
-        // VCs are reserved for deadlock avoidance via
-        // dateline algorithm.
-        injectionVC = (m_packetCounter*2) % m_nVCs;
-        m_packetCounter++;
+        // We only refuse a packet if something is already
+        // waiting; otherwise a packet larger than the limit
+        // could never be sent at all.
+        const uint32_t FLITS = GetFlitCount( p, via.IsValid() );
+
+        if( outgoing.size() + FLITS > m_injectionQueueMaxFlits )
+        {
+            NS_LOG_LOGIC( "injection queue full on VC " << injectionVC );
+
+            m_injectionBlocked = true;
+            return false;
+        }
     }
-    else
+
+    if( m_roundRobinVCInject )
     {
-        // Always inject on VC 0
-        injectionVC = 0;
+        m_packetCounter++;
     }
 
-    TocinoFlittizedPacket fp
-        = Flitter( p, src, dest, injectionVC, TocinoFlitHeader::ETHERNET );
+    // add the new flits to the end of the outgoing flit Q
 
-    if( via.IsValid() )
+    if( m_lightweightFlits )
     {
-        TocinoAddIntermediateDestination( fp, via );
+        TocinoFlitQueue fq = LightweightFlitter(
+                p, src, dest, injectionVC, TocinoFlitHeader::ETHERNET );
+
+        if( via.IsValid() )
+        {
+            TocinoAddIntermediateDestination( fq, via );
+        }
+
+        for( uint32_t i = 0; i < fq.size(); ++i )
+        {
+            fq[i].GetStamp().injected = Simulator::Now();
+        }
+
+        outgoing.insert( outgoing.end(), fq.begin(), fq.end() );
     }
+    else
+    {
+        TocinoFlittizedPacket fp
+            = Flitter( p, src, dest, injectionVC, TocinoFlitHeader::ETHERNET );
 
-    NS_ASSERT( injectionVC < m_outgoingFlits.size() );
+        if( via.IsValid() )
+        {
+            TocinoAddIntermediateDestination( fp, via );
+        }
 
-    // add the new flits to the end of the outgoing flit Q
-    // ISSUE-REVIEW: this can grow unbounded?
-    m_outgoingFlits[injectionVC].insert(
-            m_outgoingFlits[injectionVC].end(), fp.begin(), fp.end() );
+        // N.B.
+        // This is the only place a data flit's header is ever
+        // deserialized.  From here on, every hop reads the
+        // decoded copy carried along in the TocinoFlit.
+        for( uint32_t i = 0; i < fp.size(); ++i )
+        {
+            outgoing.push_back( TocinoFlit( fp[i] ) );
+            outgoing.back().GetStamp().injected = Simulator::Now();
+        }
+    }
 
     for( uint32_t vc = 0; vc < m_nVCs; ++vc )
     {
         //NS_ASSERT_MSG( m_outgoingFlits[vc].size() < 100, 
         //      "Crazy large packet queue?" );
 
-        m_outgoingFlitsMaxSize =
-            std::max( m_outgoingFlitsMaxSize, m_outgoingFlits[vc].size() );
+        const uint32_t SIZE = m_outgoingFlits[vc].size();
+
+        if( SIZE > m_outgoingFlitsMaxSize )
+        {
+            m_outgoingFlitsMaxSize = SIZE;
+        }
     }
 
     TrySendFlits();
 
-    // Tocino is a lossless network
     return true;
 }
 
+uint32_t
+TocinoNetDevice::GetFlitCount(
+        const Ptr<const Packet> p,
+        const bool hasVia ) const
+{
+    // Mirrors the arithmetic in Flitter
+    const uint32_t SIZE = p->GetSize();
+
+    uint32_t flits = 1;
+
+    if( SIZE > TocinoFlitHeader::MAX_PAYLOAD_HEAD )
+    {
+        const uint32_t REST = SIZE - TocinoFlitHeader::MAX_PAYLOAD_HEAD;
+
+        flits += ( REST + TocinoFlitHeader::MAX_PAYLOAD_OTHER - 1 )
+            / TocinoFlitHeader::MAX_PAYLOAD_OTHER;
+    }
+
+    if( hasVia )
+    {
+        // TocinoAddIntermediateDestination adds an outer head
+        flits++;
+    }
+
+    return flits;
+}
+
 bool
 TocinoNetDevice::Send( 
         Ptr<Packet> packet,
@@ -432,6 +654,12 @@ bool TocinoNetDevice::SupportsSendFrom( void ) const
     return true;
 }
 
+void
+TocinoNetDevice::AddReadyCallback( ReadyCallback cb )
+{
+    m_readyCallbacks.push_back( cb );
+}
+
 void
 TocinoNetDevice::SetChannel(
         uint32_t port,
@@ -453,10 +681,10 @@ TocinoNetDevice::GetChannel(
     return m_transmitters[port]->GetChannel();
 }
 
-void TocinoNetDevice::InjectFlit( Ptr<Packet> f ) const
+void TocinoNetDevice::InjectFlit( const TocinoFlit& f ) const
 {
-    const bool head = IsTocinoFlitHead( f );
-    const bool tail = IsTocinoFlitTail( f );
+    const bool head = f.IsHead();
+    const bool tail = f.IsTail();
 
     if( head && tail )  
     {
@@ -482,6 +710,8 @@ void TocinoNetDevice::InjectFlit( Ptr<Packet> f ) const
 void TocinoNetDevice::TrySendFlits()
 {
     NS_LOG_FUNCTION_NOARGS();
+
+    bool injected = false;
    
     for( uint32_t vc = 0; vc < m_nVCs; ++vc )
     {
@@ -492,9 +722,9 @@ void TocinoNetDevice::TrySendFlits()
 
         while( !m_outgoingFlits[vc].empty() )
         {
-            Ptr<Packet> flit = m_outgoingFlits[vc].front();
+            TocinoFlit flit = m_outgoingFlits[vc].front();
 
-            NS_ASSERT( vc == GetTocinoFlitVirtualChannel( flit ) );
+            NS_ASSERT( vc == flit.GetVirtualChannel() );
 
             if( m_receivers[ GetHostPort() ]->IsVCBlocked( vc ) )
             {
@@ -507,46 +737,179 @@ void TocinoNetDevice::TrySendFlits()
             m_outgoingFlits[vc].pop_front();
 
             InjectFlit(flit);
+
+            injected = true;
+        }
+    }
+
+    if( m_injectionBlocked && injected )
+    {
+        // Space has freed up; a refused sender may retry.
+        // Clear the flag first, the callback may send again.
+        m_injectionBlocked = false;
+
+        // Every sender may be holding a refused packet.  Start
+        // with a different one each time, lest the first to
+        // register always take the space and starve the rest.
+        const uint32_t N = m_readyCallbacks.size();
+
+        for( uint32_t i = 0; i < N; ++i )
+        {
+            m_readyCallbacks[ ( m_nextReadyCallback + i ) % N ]( this );
+        }
+
+        if( N > 0 )
+        {
+            m_nextReadyCallback = ( m_nextReadyCallback + 1 ) % N;
         }
     }
 }
 
-void TocinoNetDevice::EjectFlit( Ptr<Packet> f )
+void
+TocinoNetDevice::ScheduleTryForwardFlit( const TocinoInputPort inputPort )
 {
-    NS_LOG_FUNCTION( GetTocinoFlitIdString( f ) );
-    
-    TocinoFlitHeader h;
-    f->RemoveHeader( h );
+    NS_ASSERT( inputPort < m_nPorts );
+
+    ScheduleWork( PendingWork( PendingWork::TRY_FORWARD_FLIT, inputPort.AsUInt32() ) );
+}
+
+void
+TocinoNetDevice::ScheduleTransmitEnd( const TocinoOutputPort outputPort )
+{
+    NS_ASSERT( outputPort < m_nPorts );
+
+    ScheduleWork( PendingWork( PendingWork::TRANSMIT_END, outputPort.AsUInt32() ) );
+}
+
+void
+TocinoNetDevice::ScheduleTrySendFlits()
+{
+    ScheduleWork( PendingWork( PendingWork::TRY_SEND_FLITS, 0 ) );
+}
+
+void
+TocinoNetDevice::ScheduleWork( const PendingWork work )
+{
+    if( !m_coalesceWork )
+    {
+        m_workEvents++;
+        Simulator::ScheduleNow( &TocinoNetDevice::DoWork, this, work );
+        return;
+    }
+
+    // N.B.
+    // At most one outstanding event per device.  Work marked
+    // before it runs joins it, in order.  Work marked while
+    // it runs waits for the next event, behind anything else
+    // scheduled now in the meantime.  Nothing else in the
+    // device schedules events for the current time, so its
+    // work runs exactly as one ScheduleNow event per piece
+    // of work would.
+    m_pendingWork.push_back( work );
+
+    if( m_pendingWork.size() == 1 )
+    {
+        Simulator::ScheduleNow( &TocinoNetDevice::DoPendingWork, this );
+    }
+}
+
+void
+TocinoNetDevice::DoPendingWork()
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    NS_ASSERT( !m_pendingWork.empty() );
+    NS_ASSERT( m_runningWork.empty() );
+
+    CatchUpExpressRuns( TOCINO_INVALID_PORT );
+
+    m_runningWork.swap( m_pendingWork );
+
+    for( uint32_t i = 0; i < m_runningWork.size(); ++i )
+    {
+        RunWork( m_runningWork[i] );
+    }
+
+    m_runningWork.clear();
+}
+
+void
+TocinoNetDevice::DoWork( const PendingWork work )
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    NS_ASSERT( m_workEvents > 0 );
+    m_workEvents--;
+
+    CatchUpExpressRuns( TOCINO_INVALID_PORT );
+
+    RunWork( work );
+}
+
+void
+TocinoNetDevice::RunWork( const PendingWork work )
+{
+    switch( work.kind )
+    {
+        case PendingWork::TRY_FORWARD_FLIT:
+            m_receivers[ work.port ]->TryForwardFlit();
+            break;
+
+        case PendingWork::TRANSMIT_END:
+            m_transmitters[ work.port ]->TransmitEnd();
+            break;
+
+        case PendingWork::TRY_SEND_FLITS:
+            TrySendFlits();
+            break;
+    }
+}
+
+void TocinoNetDevice::EjectFlit( const TocinoFlit& flit )
+{
+    NS_LOG_FUNCTION( GetTocinoFlitIdString( flit ) );
+
+    if( flit.IsLightweight() )
+    {
+        EjectLightweightFlit( flit );
+        return;
+    }
+   
+    // Strip the header without deserializing it again;
+    // everything we need is in the decoded copy.
+    Ptr<Packet> f = flit.GetPacket();
+    f->RemoveAtStart( flit.GetHeaderSize() );
   
     NS_ASSERT( m_incomingPackets.size() == m_nVCs );
     NS_ASSERT( m_incomingSources.size() == m_nVCs );
 
-    const uint32_t vc = h.GetVirtualChannel().AsUInt32();
+    const uint32_t vc = flit.GetVirtualChannel().AsUInt32();
 
     Ptr< Packet >& pkt = m_incomingPackets[vc];
     TocinoAddress& src = m_incomingSources[vc];
 
     if( pkt == NULL )
     {
-        NS_ASSERT_MSG( h.IsHead(), "First flit must be head flit" );
-        NS_ASSERT_MSG( h.GetDestination() == m_address,
+        NS_ASSERT_MSG( flit.IsHead(), "First flit must be head flit" );
+        NS_ASSERT_MSG( flit.GetDestination() == m_address,
             "Ejected packet for foreign address?" );
 
-        NS_ASSERT_MSG( h.GetType() == TocinoFlitHeader::ETHERNET,
+        NS_ASSERT_MSG( flit.GetType() == TocinoFlitHeader::ETHERNET,
             "Ejected packet type is not ethernet?" );
         
         pkt = f;
-        src = h.GetSource();
+        src = flit.GetSource();
+        m_incomingStamps[vc] = flit.GetStamp();
     }
     else
     {
-        NS_ASSERT( !h.IsHead() );
+        NS_ASSERT( !flit.IsHead() );
         pkt->AddAtEnd( f );
     }
         
     NS_ASSERT( pkt != NULL );
 
-    if( h.IsTail() )
+    if( flit.IsTail() )
     {
         EthernetHeader eh;
         EthernetTrailer et;
@@ -564,11 +927,168 @@ void TocinoNetDevice::EjectFlit( Ptr<Packet> f )
         bool success = pkt->RemovePacketTag( tag );
         NS_ASSERT_MSG( success == true, "Expected TocinoFlitIdTag" );
 
+        RecordLatency( m_incomingStamps[vc], src );
+
+        m_rxCallback( this, pkt, eh.GetLengthType(), src );
+        pkt = NULL;
+    }
+}
+
+void TocinoNetDevice::EjectLightweightFlit( const TocinoFlit& flit )
+{
+    // Every flit refers to the same parent packet, so there
+    // is nothing to reassemble.  We need only check that
+    // the flits arrived in order, and hand back the parent.
+
+    NS_ASSERT( m_incomingPackets.size() == m_nVCs );
+    NS_ASSERT( m_incomingSources.size() == m_nVCs );
+
+    const uint32_t vc = flit.GetVirtualChannel().AsUInt32();
+
+    Ptr< Packet >& pkt = m_incomingPackets[vc];
+    TocinoAddress& src = m_incomingSources[vc];
+
+    if( pkt == NULL )
+    {
+        NS_ASSERT_MSG( flit.IsHead(), "First flit must be head flit" );
+        NS_ASSERT_MSG( flit.GetDestination() == m_address,
+            "Ejected packet for foreign address?" );
+
+        NS_ASSERT_MSG( flit.GetType() == TocinoFlitHeader::ETHERNET,
+            "Ejected packet type is not ethernet?" );
+
+        NS_ASSERT( flit.GetPayloadOffset() == 0 );
+        
+        pkt = flit.GetPacket();
+        src = flit.GetSource();
+        m_incomingStamps[vc] = flit.GetStamp();
+    }
+    else
+    {
+        NS_ASSERT( !flit.IsHead() );
+        NS_ASSERT_MSG( flit.GetPacket() == pkt,
+            "Interleaved flits from different packets?" );
+    }
+
+    if( flit.IsTail() )
+    {
+        NS_ASSERT( flit.GetPayloadOffset() + flit.GetPayloadLength()
+                == pkt->GetSize() );
+
+        EthernetHeader eh;
+        EthernetTrailer et;
+
+        pkt->RemoveHeader( eh );
+        pkt->RemoveTrailer( et );
+
+        NS_ASSERT_MSG( eh.GetSource() == src.AsMac48Address(),
+            "Encapsulated Ethernet frame has a difference source than head flit" );
+        
+        NS_ASSERT_MSG( eh.GetDestination() == m_address.AsMac48Address(),
+            "Encapsulated Ethernet frame has a foreign destination address?" );
+
+        RecordLatency( m_incomingStamps[vc], src );
+
         m_rxCallback( this, pkt, eh.GetLengthType(), src );
         pkt = NULL;
     }
 }
 
+void
+TocinoNetDevice::RecordLatency(
+        const TocinoFlitStamp& stamp,
+        const TocinoAddress& src )
+{
+    const Time latency = Simulator::Now() - stamp.injected;
+
+    // Source and destination routers, and one per hop
+    // between, share the queueing
+    const uint32_t routers = stamp.hops + 1;
+
+    m_latencyHistogram.Add( latency.GetNanoSeconds() );
+    m_hopCountHistogram.Add( stamp.hops );
+    m_hopQueueingHistogram.Add( stamp.queueing.GetNanoSeconds() / routers );
+
+    if( m_perSourceLatency )
+    {
+        m_sourceLatencyHistograms[src].Add( latency.GetNanoSeconds() );
+    }
+
+    m_packetLatencyTrace( src, latency, stamp.hops, stamp.queueing );
+}
+
+const TocinoHistogram&
+TocinoNetDevice::GetLatencyHistogram() const
+{
+    return m_latencyHistogram;
+}
+
+const TocinoHistogram&
+TocinoNetDevice::GetHopCountHistogram() const
+{
+    return m_hopCountHistogram;
+}
+
+const TocinoHistogram&
+TocinoNetDevice::GetHopQueueingHistogram() const
+{
+    return m_hopQueueingHistogram;
+}
+
+const TocinoNetDevice::SourceHistograms&
+TocinoNetDevice::GetSourceLatencyHistograms() const
+{
+    return m_sourceLatencyHistograms;
+}
+
+void
+TocinoNetDevice::ResetLatencyStatistics()
+{
+    m_latencyHistogram.Reset();
+    m_hopCountHistogram.Reset();
+    m_hopQueueingHistogram.Reset();
+    m_sourceLatencyHistograms.clear();
+
+    for( uint32_t port = 0; port < m_receivers.size(); ++port )
+    {
+        m_receivers[port]->ResetWaitStatistics();
+    }
+}
+
+void
+TocinoNetDevice::ReportLatencyHeader( std::ostream& os )
+{
+    os << "metric,source,destination,";
+    TocinoHistogram::PrintSummaryHeader( os );
+    os << std::endl;
+}
+
+void
+TocinoNetDevice::ReportLatency( std::ostream& os ) const
+{
+    const std::string dst = TocinoAddressToString( m_address );
+
+    os << "latency_ns,*," << dst << ",";
+    m_latencyHistogram.PrintSummary( os );
+    os << std::endl;
+
+    os << "hops,*," << dst << ",";
+    m_hopCountHistogram.PrintSummary( os );
+    os << std::endl;
+
+    os << "hop_queueing_ns,*," << dst << ",";
+    m_hopQueueingHistogram.PrintSummary( os );
+    os << std::endl;
+
+    for( SourceHistograms::const_iterator it = m_sourceLatencyHistograms.begin();
+            it != m_sourceLatencyHistograms.end(); ++it )
+    {
+        os << "latency_ns," << TocinoAddressToString( it->first ) << "," << dst << ",";
+        it->second.PrintSummary( os );
+        os << std::endl;
+    }
+}
+
 const TypeId&
 TocinoNetDevice::GetRouterTypeId() const
 {
@@ -581,6 +1101,18 @@ TocinoNetDevice::GetArbiterTypeId() const
     return m_arbiterTypeId;
 }
 
+TocinoNetDevice::FlowControl
+TocinoNetDevice::GetFlowControl() const
+{
+    return m_flowControl;
+}
+
+uint32_t
+TocinoNetDevice::GetInputQueueFlits() const
+{
+    return m_inputQueueFlits;
+}
+
 TocinoRx*
 TocinoNetDevice::GetReceiver(
         const TocinoInputPort inputPort ) const
@@ -627,6 +1159,85 @@ TocinoNetDevice::SetNVCs( uint32_t vcs )
     m_nVCs = vcs;
 }
 
+const TocinoVCAllocator&
+TocinoNetDevice::GetVCAllocator() const
+{
+    return m_vcAllocator;
+}
+
+TocinoNetDevice::InputVCSelection
+TocinoNetDevice::GetInputVCSelection() const
+{
+    return m_inputVCSelection;
+}
+
+TocinoHistogram
+TocinoNetDevice::GetInputVCWaitHistogram( const TocinoInputVC inputVC ) const
+{
+    TocinoHistogram wait;
+
+    for( uint32_t port = 0; port < m_receivers.size(); ++port )
+    {
+        if( port != GetHostPort() )
+        {
+            wait.Merge( m_receivers[port]->GetWaitHistogram( inputVC ) );
+        }
+    }
+
+    return wait;
+}
+
+bool
+TocinoNetDevice::GetExpressTransmit() const
+{
+    return m_expressTransmit;
+}
+
+void
+TocinoNetDevice::SetExpressRun(
+        const TocinoOutputPort outputPort,
+        const bool running )
+{
+    NS_ASSERT( outputPort < m_nPorts );
+
+    const uint32_t PORT_BIT = 1u << outputPort.AsUInt32();
+
+    if( running )
+    {
+        m_expressRuns |= PORT_BIT;
+    }
+    else
+    {
+        m_expressRuns &= ~PORT_BIT;
+    }
+}
+
+void
+TocinoNetDevice::CatchUpExpressRuns( const TocinoInputPort inputPort )
+{
+    if( m_expressRuns == 0 )
+    {
+        return;
+    }
+
+    // All runs first, so that stopping one sees
+    // the others as they are now
+    for( uint32_t runs = m_expressRuns; runs != 0; runs &= runs - 1 )
+    {
+        m_transmitters[ __builtin_ctz( runs ) ]->CatchUp();
+    }
+
+    if( inputPort == TOCINO_INVALID_PORT )
+    {
+        return;
+    }
+
+    for( uint32_t runs = m_expressRuns; runs != 0; runs &= runs - 1 )
+    {
+        m_transmitters[ __builtin_ctz( runs ) ]->StopRunFrom( inputPort );
+    }
+}
+
 uint32_t
 TocinoNetDevice::GetHostPort() const
 {
@@ -637,6 +1248,12 @@ bool TocinoNetDevice::AllQuiet() const
 {
     bool quiet = true;
 
+    if( !m_pendingWork.empty() || ( m_workEvents > 0 ) )
+    {
+        NS_LOG_LOGIC( "Not quiet: deferred work scheduled" );
+        quiet = false;
+    }
+
     for( uint32_t vc = 0; vc < m_nVCs; ++vc )
     {
         if( !m_outgoingFlits[vc].empty() )
@@ -0,0 +1,101 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#include <algorithm>
+
+#include "ns3/abort.h"
+
+#include "tocino-placement.h"
+
+namespace ns3
+{
+
+NS_OBJECT_ENSURE_REGISTERED( TocinoPlacement );
+NS_OBJECT_ENSURE_REGISTERED( TocinoLinearPlacement );
+NS_OBJECT_ENSURE_REGISTERED( TocinoRandomPlacement );
+
+TypeId
+TocinoPlacement::GetTypeId( void )
+{
+    static TypeId tid = TypeId( "ns3::TocinoPlacement" )
+        .SetParent<Object>();
+    return tid;
+}
+
+uint32_t
+TocinoPlacement::GetNode( const uint32_t rank ) const
+{
+    NS_ASSERT_MSG( rank < m_node.size(), "Rank not placed" );
+
+    return m_node[rank];
+}
+
+uint32_t
+TocinoPlacement::GetRanks() const
+{
+    return m_node.size();
+}
+
+TypeId
+TocinoLinearPlacement::GetTypeId( void )
+{
+    static TypeId tid = TypeId( "ns3::TocinoLinearPlacement" )
+        .SetParent<TocinoPlacement>()
+        .AddConstructor<TocinoLinearPlacement>();
+    return tid;
+}
+
+void
+TocinoLinearPlacement::Place( const uint32_t ranks, const uint32_t nodes )
+{
+    NS_ABORT_MSG_IF( ranks > nodes, "More ranks than nodes" );
+
+    m_node.resize( ranks );
+
+    for( uint32_t rank = 0; rank < ranks; ++rank )
+    {
+        m_node[rank] = rank;
+    }
+}
+
+TypeId
+TocinoRandomPlacement::GetTypeId( void )
+{
+    static TypeId tid = TypeId( "ns3::TocinoRandomPlacement" )
+        .SetParent<TocinoPlacement>()
+        .AddConstructor<TocinoRandomPlacement>();
+    return tid;
+}
+
+TocinoRandomPlacement::TocinoRandomPlacement()
+    : m_random( CreateObject<UniformRandomVariable>() )
+{}
+
+void
+TocinoRandomPlacement::Place( const uint32_t ranks, const uint32_t nodes )
+{
+    NS_ABORT_MSG_IF( ranks > nodes, "More ranks than nodes" );
+
+    std::vector< uint32_t > shuffled( nodes );
+
+    for( uint32_t i = 0; i < nodes; ++i )
+    {
+        shuffled[i] = i;
+    }
+
+    // Fisher-Yates, as far as we need
+    for( uint32_t i = 0; i < ranks; ++i )
+    {
+        const uint32_t j = m_random->GetInteger( i, nodes - 1 );
+        std::swap( shuffled[i], shuffled[j] );
+    }
+
+    m_node.assign( shuffled.begin(), shuffled.begin() + ranks );
+}
+
+int64_t
+TocinoRandomPlacement::AssignStreams( int64_t stream )
+{
+    m_random->SetStream( stream );
+    return 1;
+}
+
+}
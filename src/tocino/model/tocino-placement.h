@@ -0,0 +1,64 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_PLACEMENT_H__
+#define __TOCINO_PLACEMENT_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/random-variable-stream.h"
+
+namespace ns3
+{
+
+// Maps the ranks of a job onto node indices, as used by
+// TocinoTorusTopologyHelper and its containers
+class TocinoPlacement : public Object
+{
+    public:
+
+    static TypeId GetTypeId( void );
+
+    // Ranks to place, and nodes to place them on
+    virtual void Place( const uint32_t, const uint32_t ) = 0;
+
+    uint32_t GetNode( const uint32_t ) const;
+    uint32_t GetRanks() const;
+
+    protected:
+
+    std::vector< uint32_t > m_node;
+};
+
+// Rank i on node i
+class TocinoLinearPlacement : public TocinoPlacement
+{
+    public:
+
+    static TypeId GetTypeId( void );
+
+    void Place( const uint32_t, const uint32_t );
+};
+
+// Ranks scattered uniformly at random, one per node
+class TocinoRandomPlacement : public TocinoPlacement
+{
+    public:
+
+    static TypeId GetTypeId( void );
+
+    TocinoRandomPlacement();
+
+    void Place( const uint32_t, const uint32_t );
+
+    int64_t AssignStreams( int64_t );
+
+    private:
+
+    Ptr<UniformRandomVariable> m_random;
+};
+
+}
+
+#endif // __TOCINO_PLACEMENT_H__
@@ -0,0 +1,255 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include <vector>
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/mpi-interface.h"
+
+#include "tocino-remote-channel.h"
+#include "tocino-flit-id-tag.h"
+#include "tocino-flow-control.h"
+#include "tocino-net-device.h"
+#include "tocino-rx.h"
+
+NS_LOG_COMPONENT_DEFINE ("TocinoRemoteChannel");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED( TocinoRemoteChannel );
+
+namespace
+{
+
+// Wire format, all multi-byte fields big-endian:
+//
+//  LLC flit:   port(1) kind(1) xState(2)
+//  credit:     port(1) kind(1) credits(8)
+//  data flit:  port(1) kind(1) packet(4) flit(2) total(2)
+//              injected(8) queueing(8) hops(2) flitBytes
+//
+// LLC and credit flits are rebuilt from the pool on arrival,
+// so only their XON/XOFF state or credits cross ranks.  Times are in units
+// of the simulator resolution, which all ranks share.
+
+enum { KIND_DATA = 0, KIND_LLC = 1, KIND_CREDIT = 2 };
+
+const uint32_t SIZE_LLC = 4;
+const uint32_t SIZE_CREDIT = 10;
+const uint32_t SIZE_DATA_PREAMBLE = 28;
+
+void
+WriteU16( uint8_t* buf, const uint16_t v )
+{
+    buf[0] = v >> 8;
+    buf[1] = v & 0xff;
+}
+
+uint16_t
+ReadU16( const uint8_t* buf )
+{
+    return ( buf[0] << 8 ) | buf[1];
+}
+
+void
+WriteU32( uint8_t* buf, const uint32_t v )
+{
+    WriteU16( buf, v >> 16 );
+    WriteU16( buf+2, v & 0xffff );
+}
+
+uint32_t
+ReadU32( const uint8_t* buf )
+{
+    return ( ReadU16( buf ) << 16 ) | ReadU16( buf+2 );
+}
+
+void
+WriteU64( uint8_t* buf, const uint64_t v )
+{
+    WriteU32( buf, v >> 32 );
+    WriteU32( buf+4, v & 0xffffffff );
+}
+
+uint64_t
+ReadU64( const uint8_t* buf )
+{
+    return ( static_cast<uint64_t>( ReadU32( buf ) ) << 32 ) | ReadU32( buf+4 );
+}
+
+}
+
+TypeId TocinoRemoteChannel::GetTypeId( void )
+{
+  static TypeId tid = TypeId("ns3::TocinoRemoteChannel")
+    .SetParent<TocinoChannel>()
+    .AddConstructor<TocinoRemoteChannel>()
+    ;
+  return tid;
+}
+
+TocinoRemoteChannel::TocinoRemoteChannel()
+{}
+
+TocinoRemoteChannel::~TocinoRemoteChannel()
+{}
+
+bool
+TocinoRemoteChannel::TransmitStart( const TocinoFlit& flit )
+{
+    NS_ABORT_MSG_IF( flit.IsLightweight(),
+            "Lightweight flits cannot cross MPI ranks" );
+
+    const Time rxTime =
+        Simulator::Now() + GetTransmissionTime( flit ) + m_delay;
+
+    Ptr<Packet> msg = Serialize( flit, m_rx->GetPortNumber() );
+
+    Ptr<NetDevice> dst = m_rx->GetNetDevice();
+
+    MpiInterface::SendPacket(
+            msg, rxTime, dst->GetNode()->GetId(), dst->GetIfIndex() );
+
+    // Statistics, and scheduling of TransmitEnd
+    return TocinoChannel::TransmitStart( flit );
+}
+
+Ptr<Packet>
+TocinoRemoteChannel::Serialize( const TocinoFlit& flit, const uint8_t port )
+{
+    Ptr<Packet> msg;
+
+    if( flit.IsCredit() )
+    {
+        uint8_t buf[SIZE_CREDIT];
+
+        buf[0] = port;
+        buf[1] = KIND_CREDIT;
+        WriteU64( buf+2, flit.GetCredits().GetPacked() );
+
+        msg = Create<Packet>( buf, SIZE_CREDIT );
+    }
+    else if( flit.IsFlowControl() )
+    {
+        uint8_t buf[SIZE_LLC];
+
+        buf[0] = port;
+        buf[1] = KIND_LLC;
+        WriteU16( buf+2, flit.GetFlowControlState().to_ulong() );
+
+        msg = Create<Packet>( buf, SIZE_LLC );
+    }
+    else
+    {
+        Ptr<Packet> p = flit.GetPacket();
+
+        TocinoFlitIdTag tag;
+        bool found = p->PeekPacketTag( tag );
+        NS_ASSERT_MSG( found, "Flit without TocinoFlitIdTag?" );
+
+        const uint32_t SIZE = SIZE_DATA_PREAMBLE + p->GetSize();
+        std::vector< uint8_t > buf( SIZE );
+
+        buf[0] = port;
+        buf[1] = KIND_DATA;
+        WriteU32( &buf[2], tag.GetAbsolutePacketNumber() );
+        WriteU16( &buf[6], tag.GetRelativeFlitNumber() );
+        WriteU16( &buf[8], tag.GetTotalFlitsInPacket() );
+
+        const TocinoFlitStamp& stamp = flit.GetStamp();
+
+        WriteU64( &buf[10], stamp.injected.GetTimeStep() );
+        WriteU64( &buf[18], stamp.queueing.GetTimeStep() );
+        WriteU16( &buf[26], stamp.hops );
+
+        p->CopyData( &buf[SIZE_DATA_PREAMBLE], p->GetSize() );
+
+        msg = Create<Packet>( &buf[0], SIZE );
+    }
+
+    return msg;
+}
+
+bool
+TocinoRemoteChannel::SupportsExpress() const
+{
+    return false;
+}
+
+void 
+TocinoRemoteChannel::TransmitEnd ()
+{
+    // The flit is already on its way
+    m_state = IDLE;
+}
+
+TocinoFlit
+TocinoRemoteChannel::Deserialize( Ptr<const Packet> msg, uint32_t& port )
+{
+    const uint32_t SIZE = msg->GetSize();
+
+    NS_ASSERT( SIZE >= SIZE_LLC );
+
+    std::vector< uint8_t > buf( SIZE );
+    msg->CopyData( &buf[0], SIZE );
+
+    port = buf[0];
+
+    TocinoFlit flit;
+
+    if( buf[1] == KIND_LLC )
+    {
+        NS_ASSERT( SIZE == SIZE_LLC );
+
+        const TocinoFlowControlState xState( ReadU16( &buf[2] ) );
+
+        flit = GetPooledTocinoFlowControlFlit( xState );
+    }
+    else if( buf[1] == KIND_CREDIT )
+    {
+        NS_ASSERT( SIZE == SIZE_CREDIT );
+
+        const TocinoCredits credits( ReadU64( &buf[2] ) );
+
+        flit = GetPooledTocinoCreditFlit( credits );
+    }
+    else
+    {
+        NS_ASSERT( buf[1] == KIND_DATA );
+        NS_ASSERT( SIZE > SIZE_DATA_PREAMBLE );
+
+        Ptr<Packet> p = Create<Packet>(
+                &buf[SIZE_DATA_PREAMBLE], SIZE - SIZE_DATA_PREAMBLE );
+
+        TocinoFlitIdTag tag(
+                ReadU32( &buf[2] ),
+                ReadU16( &buf[6] ),
+                ReadU16( &buf[8] ) );
+
+        p->AddPacketTag( tag );
+
+        flit = TocinoFlit( p );
+
+        TocinoFlitStamp& stamp = flit.GetStamp();
+
+        stamp.injected = TimeStep( ReadU64( &buf[10] ) );
+        stamp.queueing = TimeStep( ReadU64( &buf[18] ) );
+        stamp.hops = ReadU16( &buf[26] );
+    }
+
+    return flit;
+}
+
+void
+TocinoRemoteChannel::Receive( TocinoNetDevice* tnd, Ptr<Packet> msg )
+{
+    uint32_t port = 0;
+
+    const TocinoFlit flit = Deserialize( msg, port );
+
+    tnd->GetReceiver( port )->Receive( flit );
+}
+
+} // namespace ns3
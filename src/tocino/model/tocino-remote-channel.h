@@ -0,0 +1,50 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TOCINO_REMOTE_CHANNEL_H__
+#define __TOCINO_REMOTE_CHANNEL_H__
+
+#include "tocino-channel.h"
+
+namespace ns3 
+{
+
+class TocinoNetDevice;
+
+// A TocinoChannel whose receiver lives in another MPI rank.
+//
+// Each flit is serialized and handed to MpiInterface when its
+// transmission starts, to arrive after its transmission time
+// plus the channel delay.  Sending at the start, rather than
+// the end, is what lets GetLookahead() include the flit time;
+// the channel delay alone defaults to zero.
+
+class TocinoRemoteChannel : public TocinoChannel
+{
+public:
+
+    static TypeId GetTypeId();
+    
+    TocinoRemoteChannel();
+    virtual ~TocinoRemoteChannel();
+    
+    virtual bool TransmitStart( const TocinoFlit& );
+
+    // Flits cross ranks as they start, and cannot be withdrawn
+    virtual bool SupportsExpress() const;
+
+    // Accept a flit sent by a TocinoRemoteChannel in
+    // another rank; the target of each MpiReceiver
+    static void Receive( TocinoNetDevice*, Ptr<Packet> );
+
+    // The message carrying a flit to the given port of the
+    // receiving device, and back again
+    static Ptr<Packet> Serialize( const TocinoFlit&, const uint8_t port );
+    static TocinoFlit Deserialize( Ptr<const Packet>, uint32_t& port );
+
+private:
+    
+    virtual void TransmitEnd ();
+};
+
+} // namespace ns3
+
+#endif // __TOCINO_REMOTE_CHANNEL_H__
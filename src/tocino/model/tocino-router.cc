@@ -1,5 +1,6 @@
 /* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
 #include "tocino-router.h"
+#include "tocino-flit.h"
 
 #include "ns3/log.h"
 
@@ -17,4 +18,14 @@ TypeId TocinoRouter::GetTypeId(void)
     return tid;
 }
 
+void
+TocinoRouter::PrepareHead( TocinoFlit& )
+{}
+
+bool
+TocinoRouter::IsAdaptive() const
+{
+    return false;
+}
+
 }
@@ -10,7 +10,7 @@
 namespace ns3
 {
 
-class Packet;
+class TocinoFlit;
 class TocinoNetDevice;
 class TocinoRx;
 
@@ -82,7 +82,19 @@ struct TocinoRouter : public Object
             const TocinoNetDevice*, 
             const TocinoInputPort ) = 0;
     
-    virtual TocinoRoute Route( Ptr<const Packet> ) const = 0;
+    virtual TocinoRoute Route( const TocinoFlit& ) const = 0;
+
+    // Called on every head flit just before Route, this is
+    // the one place a router may rewrite the routing fields
+    // of a header, as Route cannot.  Does nothing unless
+    // overridden.
+    virtual void PrepareHead( TocinoFlit& );
+
+    // If true, TocinoRx routes a head flit again each time
+    // it finds the head at the front of its input queue,
+    // until it is forwarded, so the route may follow the
+    // network's state.  False unless overridden.
+    virtual bool IsAdaptive() const;
 };
 
 }
@@ -3,6 +3,7 @@
 #include <cstdio>
 #include <sstream>
 
+#include "ns3/abort.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 
@@ -27,6 +28,8 @@ NS_LOG_COMPONENT_DEFINE ("TocinoRx");
 
 namespace ns3 {
 
+const uint32_t TocinoRx::DEFAULT_INPUT_QUEUE_FLITS;
+
 TocinoRx::TocinoRx( 
         const TocinoInputPort inputPort,
         TocinoNetDevice* tnd
@@ -34,10 +37,18 @@ TocinoRx::TocinoRx(
     : m_inputPort( inputPort )
     , m_tnd( tnd )
     , m_tx( tnd->GetTransmitter( inputPort.AsUInt32() ) )
+    , m_upstream( NULL )
     , m_routingTable( tnd->GetNVCs() )
     , m_crossbar( tnd, inputPort )
+    , m_nonEmptyVCs( 0 )
+    , m_lastVC( tnd->GetNVCs() - 1 )
 {
     m_inputQueues.vec.resize( m_tnd->GetNVCs() );
+
+    for( TocinoInputVC inputVC = 0; inputVC < m_tnd->GetNVCs(); ++inputVC )
+    {
+        GetInputQueue( inputVC ).SetMaxDepth( m_tnd->GetInputQueueFlits() );
+    }
     
     ObjectFactory routerFactory;
     routerFactory.SetTypeId( m_tnd->GetRouterTypeId() );
@@ -45,6 +56,9 @@ TocinoRx::TocinoRx(
     m_router->Initialize( m_tnd, inputPort );
 
     m_cloakedHeadIsNext.resize( m_tnd->GetNVCs(), false );
+    m_bouncedStamps.resize( m_tnd->GetNVCs() );
+
+    m_waitHistograms.resize( m_tnd->GetNVCs() );
 }
 
 uint32_t
@@ -69,8 +83,20 @@ void
 TocinoRx::SetChannel( Ptr<TocinoChannel> chan )
 {
     m_channel = chan;
+
+    if( m_tnd->GetFlowControl() == TocinoNetDevice::CREDIT )
+    {
+        // Our neighbor never sends more than we can hold
+        return;
+    }
     
     const uint32_t reserve = chan->FlitBuffersRequired();
+
+    NS_ABORT_MSG_IF( reserve >= m_tnd->GetInputQueueFlits(),
+            "XON/XOFF needs " << reserve << " reserve flits per VC, "
+            "but input queues hold only " << m_tnd->GetInputQueueFlits()
+            << "; shorten the channel Delay or use credit flow control" );
+
     SetReserveFlits( reserve );
 }
 
@@ -80,6 +106,18 @@ TocinoRx::GetChannel() const
     return m_channel;
 }
 
+void
+TocinoRx::SetUpstream( TocinoTx* upstream )
+{
+    m_upstream = upstream;
+}
+
+Ptr<TocinoRouter>
+TocinoRx::GetRouter() const
+{
+    return m_router;
+}
+
 bool
 TocinoRx::IsVCBlocked( const TocinoInputVC inputVC ) const
 {
@@ -107,13 +145,15 @@ TocinoRx::EnqueueHelper(
         const InputQueueEntry& qe,
         const TocinoInputVC inputVC )
 {
-    NS_ASSERT_MSG( GetTocinoFlitVirtualChannel( qe.flit ) == inputVC,
+    NS_ASSERT_MSG( qe.flit.GetVirtualChannel() == inputVC,
         "attempt to enqueue flit with mismatched VC" );
      
     bool wasNotBlocked = !IsVCBlocked( inputVC );
 
     GetInputQueue( inputVC ).Enqueue( qe );
 
+    m_nonEmptyVCs |= ( 1u << inputVC.AsUInt32() );
+
     bool isNowBlocked = IsVCBlocked( inputVC );
     
     bool enqueueTriggeredBlock = wasNotBlocked && isNowBlocked;
@@ -123,13 +163,13 @@ TocinoRx::EnqueueHelper(
 
 void
 TocinoRx::AnnounceRoutingDecision(
-        Ptr<const Packet> flit,
+        const TocinoFlit& flit,
         const TocinoRoute& route ) const
 {
 #ifdef NS3_LOG_ENABLE
     std::ostringstream logPrefix;
 
-    if( IsTocinoFlitHead( flit ) )
+    if( flit.IsHead() )
     {
         logPrefix << "new route via ";
     }
@@ -143,7 +183,7 @@ TocinoRx::AnnounceRoutingDecision(
     const TocinoOutputVC outputVC = route.outputVC;
 
     NS_LOG_LOGIC( logPrefix.str()
-            << TocinoPortToString( outputPort )
+            << TocinoPortToString( outputPort, m_tnd->GetHostPort() )
             << " (outputPort=" << outputPort
             << ", inputVC=" << inputVC
             << ", outputVC=" << outputVC << ")" );
@@ -151,10 +191,10 @@ TocinoRx::AnnounceRoutingDecision(
 }
 
 bool
-TocinoRx::DestinationReached( Ptr<const Packet> flit ) const
+TocinoRx::DestinationReached( const TocinoFlit& flit ) const
 {
     TocinoAddress localAddr = m_tnd->GetTocinoAddress();
-    TocinoAddress destAddr = GetTocinoFlitDestination( flit );
+    TocinoAddress destAddr = flit.GetDestination();
 
     if( destAddr == localAddr )
     {
@@ -165,94 +205,155 @@ TocinoRx::DestinationReached( Ptr<const Packet> flit ) const
 }
 
 const TocinoRoute
-TocinoRx::MakeRoutingDecision(
-        Ptr<const Packet> flit,
-        bool wasCloakedHead )
+TocinoRx::RouteHead(
+        const TocinoFlit& flit,
+        const bool wasCloakedHead ) const
 {
-    const TocinoInputVC inputVC = GetTocinoFlitVirtualChannel( flit );
-    
-    const bool isHead = IsTocinoFlitHead( flit );
-    const bool isTail = IsTocinoFlitTail( flit );
+    NS_ASSERT( flit.IsHead() );
 
-    TocinoRoute route( TOCINO_INVALID_ROUTE );
+    TocinoRoute route = m_router->Route( flit );
 
-    if( isHead )
+    if( wasCloakedHead ) 
     {
-        route = m_router->Route( flit );
-    
-        if( wasCloakedHead ) 
-        {
-            // Switch output VC to the base of the next pair
-            route.outputVC = (route.outputVC.AsUInt32() & ~1) + 2;
-        }
+        // Switch output VC to the base of a second-leg pair
+        route.outputVC = m_tnd->GetVCAllocator().MoveToLeg(
+                route.outputVC, TocinoVCAllocator::SECOND_LEG );
+    }
 
-        if( !isTail )
+    NS_ASSERT( route != TOCINO_INVALID_ROUTE );
+
+    return route;
+}
+
+void
+TocinoRx::RerouteHeads()
+{
+    // N.B.
+    // An adaptive router picks among VCs by what is free
+    // right now, so a head is routed again each time we
+    // look, up to the moment it is forwarded.  One which
+    // waits can then fall back on the escape VC, which is
+    // always among its choices; see TocinoAdaptiveRouter.
+
+    for( uint32_t mask = m_nonEmptyVCs; mask != 0; mask &= mask - 1 )
+    {
+        InputQueueEntry& qe = GetInputQueue( __builtin_ctz( mask ) ).Front();
+
+        if( qe.flit.IsHead() )
         {
-            m_routingTable.InstallRoute( inputVC, route );
+            qe.route = RouteHead( qe.flit, qe.wasCloakedHead );
         }
     }
-    else
-    {
-        route = m_routingTable.GetRoute( inputVC );
-    }
-        
-    NS_ASSERT( route != TOCINO_INVALID_ROUTE );
+}
 
-    if( isTail && !isHead )
+TocinoRoute
+TocinoRx::GetFrontRoute( const TocinoInputVC inputVC ) const
+{
+    const InputQueueEntry& qe = GetInputQueue( inputVC ).PeekFront();
+
+    if( qe.flit.IsHead() )
     {
-        NS_LOG_LOGIC( "removing route for inputVC=" << inputVC );
-        m_routingTable.RemoveRoute( inputVC );
+        return qe.route;
     }
 
-    return route;
+    // Installed when the head of this packet was forwarded
+    return m_routingTable.GetRoute( inputVC );
+}
+
+bool
+TocinoRx::CanForward( const TocinoRoute& route ) const
+{
+    return m_crossbar.IsForwardable( route );
 }
 
 void
-TocinoRx::Receive( Ptr<Packet> flit )
+TocinoRx::Receive( TocinoFlit flit )
 {
     NS_LOG_FUNCTION( GetTocinoFlitIdString( flit ) );
     
     NS_ASSERT( m_router != NULL );
+
+    // N.B.
+    // A data flit here would be forwarded to an output
+    // queue; the run it feeds, if any, must stop.
+    m_tnd->CatchUpExpressRuns(
+            flit.IsFlowControl() ? TocinoInputPort( TOCINO_INVALID_PORT ) : m_inputPort );
     
-    if( IsTocinoFlowControlFlit( flit ) )
+    if( flit.IsCredit() )
+    {
+        NS_LOG_LOGIC( "got credit flit" );
+        m_tx->AddCredits( flit.GetCredits() );
+
+        return;
+    }
+
+    if( flit.IsFlowControl() )
     {
         NS_LOG_LOGIC( "got flow control flit" );
-        TocinoFlowControlState newXState = GetTocinoFlowControlState( flit );
-        m_tx->SetXState( newXState );
+        m_tx->SetXState( flit.GetFlowControlState() );
 
         return;
     }
 
-    const TocinoInputVC inputVC = GetTocinoFlitVirtualChannel( flit );
+    const TocinoInputVC inputVC = flit.GetVirtualChannel();
   
     bool wasCloakedHead = false;
 
     if( m_cloakedHeadIsNext[ inputVC.AsUInt32() ] )
     {
-        TocinoUncloakHeadFlit( flit );
+        flit.Uncloak();
         m_cloakedHeadIsNext[ inputVC.AsUInt32() ] = false;
         wasCloakedHead = true;
     }
+
+    if( flit.IsHead() )
+    {
+        TocinoFlitStamp& stamp = flit.GetStamp();
+
+        stamp.arrived = Simulator::Now();
+
+        if( wasCloakedHead )
+        {
+            // Resume where the outer head left off; it
+            // already counted the hop to get here
+            const TocinoFlitStamp& outer = m_bouncedStamps[ inputVC.AsUInt32() ];
+
+            stamp.hops = outer.hops;
+            stamp.queueing = outer.queueing;
+        }
+        else if( m_inputPort != m_tnd->GetHostPort() )
+        {
+            stamp.hops++;
+        }
+    }
         
-    if( IsTocinoFlitHead( flit ) &&
-        IsTocinoEncapsulatedPacket( flit ) &&
+    if( flit.IsHead() &&
+        ( flit.GetType() == TocinoFlitHeader::ENCAPSULATED_PACKET ) &&
         DestinationReached( flit ) )
     {
         NS_LOG_LOGIC( "encapsulated packet has reached intermediate destination" );
         
         m_cloakedHeadIsNext[ inputVC.AsUInt32() ] = true;
+        m_bouncedStamps[ inputVC.AsUInt32() ] = flit.GetStamp();
         
-        // Returning here effectively discards outer head flit
+        // Returning here effectively discards outer head flit,
+        // which never took up an input queue entry
+        ReturnCredit( inputVC );
         return;
     }
     
-    const TocinoRoute route = MakeRoutingDecision( flit, wasCloakedHead );
-    
-    AnnounceRoutingDecision( flit, route );
+    if( flit.IsHead() )
+    {
+        m_router->PrepareHead( flit );
+    }
 
-    bool blocked = EnqueueHelper( InputQueueEntry( flit, route ), inputVC );
+    const TocinoRoute route = flit.IsHead() ?
+        RouteHead( flit, wasCloakedHead ) : TOCINO_INVALID_ROUTE;
+    
+    bool blocked = EnqueueHelper(
+            InputQueueEntry( flit, route, Simulator::Now(), wasCloakedHead ), inputVC );
     
-    if( blocked )
+    if( blocked && ( m_tnd->GetFlowControl() == TocinoNetDevice::XON_XOFF ) )
     {
         // FIXME:
         // We intend to model an ejection port that can never be full. Yet,
@@ -277,9 +378,14 @@ TocinoRx::DequeueHelper(
 
     const InputQueueEntry qe = GetInputQueue( inputVC ).Dequeue();
 
+    if( GetInputQueue( inputVC ).IsEmpty() )
+    {
+        m_nonEmptyVCs &= ~( 1u << inputVC.AsUInt32() );
+    }
+
     bool isNoLongerBlocked = !IsVCBlocked( inputVC );
     
-    NS_ASSERT_MSG( GetTocinoFlitVirtualChannel( qe.flit ) == inputVC,
+    NS_ASSERT_MSG( qe.flit.GetVirtualChannel() == inputVC,
             "Dequeued flit has wrong VC?" );
             
     dequeueTriggeredUnblock = wasBlocked && isNoLongerBlocked;
@@ -289,54 +395,138 @@ TocinoRx::DequeueHelper(
 
 void
 TocinoRx::RewriteFlitHeaderVC(
-        Ptr<Packet> flit,
+        TocinoFlit& flit,
         const TocinoOutputVC newVC ) const
 {
-    TocinoFlitHeader h;
-    flit->RemoveHeader( h );
-   
-    const TocinoInputVC currentVC = h.GetVirtualChannel();
+    const TocinoInputVC currentVC = flit.GetVirtualChannel();
 
     NS_ASSERT_MSG( newVC != currentVC, "Pointless rewrite?" );
 
-    h.SetVirtualChannel( newVC.AsUInt32() );
-
-    flit->AddHeader( h );
+    flit.SetVirtualChannel( newVC.AsUInt32() );
 }
 
 const TocinoInputVC TocinoRx::NO_FORWARDABLE_VC( TOCINO_INVALID_VC );
 
+bool
+TocinoRx::IsForwardable( const uint32_t vc ) const
+{
+    return m_crossbar.IsForwardable( GetFrontRoute( vc ) );
+}
+
 TocinoInputVC
-TocinoRx::FindForwardableVC() const
+TocinoRx::FirstForwardableVC( const uint32_t mask, const uint32_t start ) const
 {
-    NS_LOG_FUNCTION_NOARGS();
-    
-    NS_ASSERT( m_router != NULL );
+    NS_ASSERT( start < TOCINO_MAX_VCS );
 
-    // ISSUE-REVIEW: Potential starvation of higher VCs 
-    for( TocinoInputVC inputVC = 0; inputVC < m_tnd->GetNVCs(); ++inputVC )
+    const uint32_t upper = mask & ~( ( 1u << start ) - 1 );
+
+    uint32_t candidates[2] = { upper, mask & ~upper };
+
+    for( uint32_t i = 0; i < 2; ++i )
+    {
+        while( candidates[i] != 0 )
+        {
+            const uint32_t vc = __builtin_ctz( candidates[i] );
+
+            if( IsForwardable( vc ) )
+            {
+                return vc;
+            }
+
+            candidates[i] &= candidates[i] - 1;
+        }
+    }
+
+    return NO_FORWARDABLE_VC;
+}
+
+TocinoInputVC
+TocinoRx::OldestForwardableVC() const
+{
+    TocinoInputVC oldest = NO_FORWARDABLE_VC;
+    Time oldestArrival;
+
+    // Ties go to the lowest VC
+    for( uint32_t mask = m_nonEmptyVCs; mask != 0; mask &= mask - 1 )
     {
-        const InputQueue& queue = GetInputQueue( inputVC );
+        const uint32_t vc = __builtin_ctz( mask );
+
+        const Time arrived = GetInputQueue( vc ).PeekFront().arrived;
 
-        if( queue.IsEmpty() )
+        if( ( oldest == NO_FORWARDABLE_VC || arrived < oldestArrival ) &&
+            IsForwardable( vc ) )
         {
-            continue;
+            oldest = vc;
+            oldestArrival = arrived;
         }
-        
-        const InputQueueEntry& qe = queue.PeekFront();
+    }
+
+    return oldest;
+}
+
+TocinoInputVC
+TocinoRx::PriorityForwardableVC() const
+{
+    const TocinoVCAllocator& vca = m_tnd->GetVCAllocator();
+
+    const uint32_t start = ( m_lastVC + 1 ) % m_tnd->GetNVCs();
+
+    // Highest class first, round-robin within a class
+    for( uint32_t cls = vca.GetNClasses(); cls-- > 0; )
+    {
+        const uint32_t classVCs =
+            ( ( 1u << vca.GetClassVCs( cls ) ) - 1 ) << vca.GetClassBase( cls ).AsUInt32();
+
+        const uint32_t mask = m_nonEmptyVCs & classVCs;
 
-        if( !m_crossbar.IsForwardable( qe.route ) )
+        if( mask == 0 )
         {
-            // This VC is not currently forwardable
             continue;
         }
-            
-        return inputVC;
+
+        const TocinoInputVC vc = FirstForwardableVC( mask, start );
+
+        if( vc != NO_FORWARDABLE_VC )
+        {
+            return vc;
+        }
     }
 
     return NO_FORWARDABLE_VC;
 }
 
+TocinoInputVC
+TocinoRx::FindForwardableVC() const
+{
+    NS_LOG_FUNCTION_NOARGS();
+    
+    NS_ASSERT( m_router != NULL );
+
+    if( m_nonEmptyVCs == 0 )
+    {
+        return NO_FORWARDABLE_VC;
+    }
+
+    switch( m_tnd->GetInputVCSelection() )
+    {
+        case TocinoNetDevice::ROUND_ROBIN_VC:
+            return FirstForwardableVC( m_nonEmptyVCs,
+                    ( m_lastVC + 1 ) % m_tnd->GetNVCs() );
+
+        case TocinoNetDevice::OLDEST_FIRST:
+            return OldestForwardableVC();
+
+        case TocinoNetDevice::CLASS_PRIORITY:
+            return PriorityForwardableVC();
+
+        default:
+            // N.B.
+            // Higher VCs, including the dateline VCs, can
+            // starve under load.
+            return FirstForwardableVC( m_nonEmptyVCs, 0 );
+    }
+}
+
 void
 TocinoRx::TryForwardFlit()
 {
@@ -344,6 +534,11 @@ TocinoRx::TryForwardFlit()
     
     NS_ASSERT( m_router != NULL );
 
+    if( m_router->IsAdaptive() )
+    {
+        RerouteHeads();
+    }
+
     const TocinoInputVC inputVC = FindForwardableVC();
 
     if( inputVC == NO_FORWARDABLE_VC )
@@ -354,10 +549,38 @@ TocinoRx::TryForwardFlit()
     
     bool unblocked = false;
 
-    const InputQueueEntry qe = DequeueHelper( inputVC, unblocked );
+    InputQueueEntry qe = DequeueHelper( inputVC, unblocked );
+
+    const bool isHead = qe.flit.IsHead();
+    const bool isTail = qe.flit.IsTail();
+
+    if( isHead )
+    {
+        if( !isTail )
+        {
+            m_routingTable.InstallRoute( inputVC, qe.route );
+        }
+    }
+    else
+    {
+        qe.route = m_routingTable.GetRoute( inputVC );
+
+        if( isTail )
+        {
+            NS_LOG_LOGIC( "removing route for inputVC=" << inputVC );
+            m_routingTable.RemoveRoute( inputVC );
+        }
+    }
+
+    AnnounceRoutingDecision( qe.flit, qe.route );
     
     NS_ASSERT( qe.route.inputVC == inputVC );
 
+    m_lastVC = inputVC.AsUInt32();
+
+    m_waitHistograms[ m_lastVC ].Add(
+            ( Simulator::Now() - qe.arrived ).GetNanoSeconds() );
+
     const TocinoOutputVC outputVC = qe.route.outputVC;
 
     if( inputVC != outputVC )
@@ -368,6 +591,8 @@ TocinoRx::TryForwardFlit()
     
     // Forward the flit along its route
     m_crossbar.ForwardFlit( qe.flit, qe.route );
+
+    ReturnCredit( inputVC );
     
     // If we just became unblocked ask our corresponding
     // transmitter to resume the remote node
@@ -377,7 +602,7 @@ TocinoRx::TryForwardFlit()
         {
             // Special handling for injection port
 
-            // ScheduleNow here, rather than direct call to
+            // Deferring, rather than direct call to
             // TrySendFlits, avoids mind-bending reentrancy due to:
             //    Recieve -> 
             //      TryRouteFlit -> 
@@ -387,9 +612,9 @@ TocinoRx::TryForwardFlit()
             // Otherwise we can end up with multiple Receives in
             // flight at once, which is very confusing.
 
-            Simulator::ScheduleNow( &TocinoNetDevice::TrySendFlits, m_tnd );
+            m_tnd->ScheduleTrySendFlits();
         }
-        else
+        else if( m_tnd->GetFlowControl() == TocinoNetDevice::XON_XOFF )
         {
             m_tx->RemoteResume( inputVC );
         }
@@ -398,11 +623,12 @@ TocinoRx::TryForwardFlit()
     // ISSUE-REVIEW: This seems to help slightly, but is it
     // realistic to expect hardware to do this?
     //
-    // ISSUE-REVIEW: Consider rewriting this as a loop within
-    // the TryForwardFlit function, rather than ScheduleNow.
-    //
-    // Try to forward another flit?
-    Simulator::ScheduleNow( &TocinoRx::TryForwardFlit, this );
+    // Try to forward another flit?  Not worth an event if
+    // there is nothing left to forward.
+    if( m_nonEmptyVCs != 0 )
+    {
+        m_tnd->ScheduleTryForwardFlit( m_inputPort );
+    }
 }
 
 void
@@ -414,6 +640,51 @@ TocinoRx::SetReserveFlits( uint32_t numFlits )
     }
 }
 
+void
+TocinoRx::ReturnCredit( const TocinoInputVC inputVC )
+{
+    if( m_tnd->GetFlowControl() != TocinoNetDevice::CREDIT )
+    {
+        if( m_upstream != NULL )
+        {
+            m_upstream->DownstreamFreed( inputVC );
+        }
+
+        return;
+    }
+
+    // The injection port is fed by the host, not a channel
+    if( m_inputPort == m_tnd->GetHostPort() )
+    {
+        return;
+    }
+
+    m_tx->RemoteCredit( inputVC );
+}
+
+const TocinoHistogram&
+TocinoRx::GetWaitHistogram( const TocinoInputVC inputVC ) const
+{
+    NS_ASSERT( inputVC < m_tnd->GetNVCs() );
+
+    return m_waitHistograms[ inputVC.AsUInt32() ];
+}
+
+void
+TocinoRx::ResetWaitStatistics()
+{
+    for( uint32_t vc = 0; vc < m_waitHistograms.size(); ++vc )
+    {
+        m_waitHistograms[vc].Reset();
+    }
+}
+
+bool
+TocinoRx::HasQueuedFlits() const
+{
+    return m_nonEmptyVCs != 0;
+}
+
 bool
 TocinoRx::AllQuiet() const
 {
@@ -450,9 +721,7 @@ TocinoRx::DumpState() const
 
             for( uint32_t i = 0; i < queue.Size(); i++ )
             {
-                Ptr<const Packet> flit = queue.At(i).flit;
-
-                NS_LOG_LOGIC("   " << GetTocinoFlitIdString( flit ) );
+                NS_LOG_LOGIC("   " << GetTocinoFlitIdString( queue.At(i).flit ) );
             }
         }
         else
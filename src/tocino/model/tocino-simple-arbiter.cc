@@ -293,6 +293,20 @@ TocinoSimpleArbiter::GetVCOwner( const TocinoOutputVC outputVC ) const
 const TocinoArbiterAllocation TocinoSimpleArbiter::ANY_QUEUE = 
     TocinoArbiterAllocation( TOCINO_INVALID_PORT, TOCINO_INVALID_VC );
 
+TocinoArbiterStallCounts
+TocinoSimpleArbiter::GetStallCounts() const
+{
+    TocinoArbiterStallCounts counts;
+
+    counts.allocatedQueueIsEmpty = m_stallAllocatedQueueIsEmpty;
+    counts.allocatedQueueNotEmptyButXOFF = m_stallAllocatedQueueNotEmptyButXOFF;
+    counts.unallocatedButAllQueuesEmpty = m_stallUnallocatedButAllQueuesEmpty;
+    counts.unallocatedButAllNonEmptyQueuesAreXOFF =
+        m_stallUnallocatedButAllNonEmptyQueuesAreXOFF;
+
+    return counts;
+}
+
 void
 TocinoSimpleArbiter::ReportStatistics() const
 {
@@ -30,6 +30,8 @@ class TocinoSimpleArbiter : public TocinoArbiter
 
     void ReportStatistics() const;
 
+    TocinoArbiterStallCounts GetStallCounts() const;
+
     private:
 
     typedef std::vector< TocinoArbiterAllocation > AllocVector;
@@ -0,0 +1,317 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include <algorithm>
+#include <limits>
+
+#include "tocino-trace-replay-application.h"
+
+#include "ns3/node-container.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE( "TocinoTraceReplayApplication" );
+
+NS_OBJECT_ENSURE_REGISTERED( TocinoTraceReplayApplication );
+
+namespace
+{
+
+const uint32_t NOT_WAITING = std::numeric_limits< uint32_t >::max();
+
+}
+
+TypeId 
+TocinoTraceReplayApplication::GetTypeId()
+{
+    static TypeId tid = TypeId( "ns3::TocinoTraceReplayApplication" )
+        .SetParent<Application>()
+        .AddConstructor<TocinoTraceReplayApplication>()
+        .AddAttribute(
+                "PacketSize",
+                "Most bytes in one packet.",
+                UintegerValue( 1024 ),
+                MakeUintegerAccessor(
+                    &TocinoTraceReplayApplication::m_packetSize ),
+                MakeUintegerChecker< uint32_t >( 1 ) )
+        .AddTraceSource( "Finished",
+            "This rank has reached the end of its trace.",
+            MakeTraceSourceAccessor(
+                &TocinoTraceReplayApplication::m_finishedTrace ),
+            "ns3::TocinoTraceReplayApplication::FinishedCallback" )
+        ;
+    return tid;
+}
+
+TocinoTraceReplayApplication::TocinoTraceReplayApplication()
+    : m_packetSize( 1024 )
+    , m_rank( 0 )
+    , m_nodeContainer( NULL )
+    , m_netDevice( NULL )
+    , m_running( false )
+    , m_finished( false )
+    , m_waitingPeer( NOT_WAITING )
+    , m_waitingBytes( 0 )
+    , m_recordsReplayed( 0 )
+    , m_bytesSent( 0 )
+    , m_bytesReceived( 0 )
+{}
+
+void 
+TocinoTraceReplayApplication::Initialize(
+        const uint32_t rank,
+        const NodeContainer* nodeContainer,
+        Ptr<TocinoPlacement> placement,
+        const std::string& prefix )
+{
+    NS_ASSERT( nodeContainer != NULL );
+    NS_ASSERT( placement != NULL );
+
+    m_rank = rank;
+    m_nodeContainer = nodeContainer;
+    m_placement = placement;
+    m_filename = TocinoTraceFileName( prefix, rank );
+
+    const uint32_t RANKS = m_placement->GetRanks();
+
+    NS_ASSERT( m_rank < RANKS );
+
+    NS_ABORT_MSG_IF( !m_reader.Open( m_filename ),
+            "Cannot replay " << m_filename );
+
+    NS_ABORT_MSG_IF( m_reader.GetRank() != m_rank,
+            m_filename << " is the trace of another rank" );
+
+    for( uint32_t r = 0; r < RANKS; ++r )
+    {
+        Ptr<Node> node = m_nodeContainer->Get( m_placement->GetNode( r ) );
+        m_rankOfAddress[ node->GetDevice(0)->GetAddress() ] = r;
+    }
+
+    m_available.assign( RANKS, 0 );
+
+    Ptr<Node> node = m_nodeContainer->Get( m_placement->GetNode( m_rank ) );
+    NS_ASSERT( node->GetNDevices() == 1 );
+
+    // Throws if not a TocinoNetDevice, by design
+    m_netDevice = DynamicCast<TocinoNetDevice>( node->GetDevice(0) );
+
+    m_netDevice->SetReceiveCallback( 
+            MakeCallback( &TocinoTraceReplayApplication::AcceptPacket, this ) );
+
+    m_netDevice->AddReadyCallback( 
+            MakeCallback( &TocinoTraceReplayApplication::DeviceReady, this ) );
+}
+
+bool
+TocinoTraceReplayApplication::IsFinished() const
+{
+    return m_finished;
+}
+
+Time
+TocinoTraceReplayApplication::GetFinishTime() const
+{
+    NS_ASSERT( m_finished );
+    return m_finishTime;
+}
+
+uint64_t
+TocinoTraceReplayApplication::GetRecordsReplayed() const
+{
+    return m_recordsReplayed;
+}
+
+uint64_t
+TocinoTraceReplayApplication::GetBytesSent() const
+{
+    return m_bytesSent;
+}
+
+uint64_t
+TocinoTraceReplayApplication::GetBytesReceived() const
+{
+    return m_bytesReceived;
+}
+
+void
+TocinoTraceReplayApplication::StartApplication()
+{
+    NS_ASSERT( m_netDevice != NULL );
+    NS_ASSERT( m_reader.IsOpen() );
+
+    m_running = true;
+    m_startTime = Simulator::Now();
+
+    ReplayNext();
+}
+
+void
+TocinoTraceReplayApplication::ReplayNext()
+{
+    TocinoTraceRecord record;
+
+    while( m_running )
+    {
+        NS_ASSERT( m_pendingPackets.empty() );
+        NS_ASSERT( m_waitingPeer == NOT_WAITING );
+
+        if( !m_reader.Next( record ) )
+        {
+            Finish();
+            return;
+        }
+
+        m_recordsReplayed++;
+
+        const uint64_t BYTES = std::max< uint64_t >( record.value, 1 );
+
+        switch( record.type )
+        {
+            case TocinoTraceRecord::COMPUTE:
+            {
+                m_computeEvent = Simulator::Schedule(
+                        NanoSeconds( record.value ),
+                        &TocinoTraceReplayApplication::ReplayNext, this );
+                return;
+            }
+            case TocinoTraceRecord::SEND:
+            {
+                NS_ASSERT( record.peer < m_available.size() );
+
+                for( uint64_t sent = 0; sent < BYTES; sent += m_packetSize )
+                {
+                    const uint32_t LEN =
+                        std::min< uint64_t >( BYTES - sent, m_packetSize );
+
+                    m_pendingPackets.push_back( Create<Packet>( LEN ) );
+                }
+
+                m_pendingDestAddress =
+                    m_nodeContainer->Get( m_placement->GetNode( record.peer ) )
+                        ->GetDevice(0)->GetAddress();
+
+                TrySendPending();
+
+                if( !m_pendingPackets.empty() )
+                {
+                    // Resume from DeviceReady
+                    return;
+                }
+                break;
+            }
+            case TocinoTraceRecord::RECV:
+            {
+                NS_ASSERT( record.peer < m_available.size() );
+
+                if( m_available[ record.peer ] < BYTES )
+                {
+                    // Resume from AcceptPacket
+                    m_waitingPeer = record.peer;
+                    m_waitingBytes = BYTES;
+                    return;
+                }
+
+                m_available[ record.peer ] -= BYTES;
+                break;
+            }
+            default:
+                NS_ASSERT_MSG( false, "Bad trace record" );
+        }
+    }
+}
+
+void
+TocinoTraceReplayApplication::Finish()
+{
+    m_running = false;
+    m_finished = true;
+    m_finishTime = Simulator::Now();
+
+    NS_LOG_LOGIC( "rank " << m_rank << " finished after "
+            << m_recordsReplayed << " records" );
+
+    m_finishedTrace( m_finishTime - m_startTime );
+}
+
+void
+TocinoTraceReplayApplication::TrySendPending()
+{
+    while( !m_pendingPackets.empty() )
+    {
+        Ptr<Packet> p = m_pendingPackets.front();
+
+        if( !m_netDevice->Send( p, m_pendingDestAddress, 0 ) )
+        {
+            // Hold off until DeviceReady
+            return;
+        }
+
+        m_bytesSent += p->GetSize();
+        m_pendingPackets.pop_front();
+    }
+}
+
+void
+TocinoTraceReplayApplication::DeviceReady( Ptr<NetDevice> )
+{
+    if( !m_running || m_pendingPackets.empty() )
+    {
+        return;
+    }
+
+    TrySendPending();
+
+    if( m_pendingPackets.empty() )
+    {
+        ReplayNext();
+    }
+}
+
+bool
+TocinoTraceReplayApplication::AcceptPacket(
+        Ptr<NetDevice>,
+        Ptr<const Packet> p,
+        uint16_t,
+        const Address& src )
+{
+    std::map< Address, uint32_t >::const_iterator it = m_rankOfAddress.find( src );
+
+    NS_ASSERT_MSG( it != m_rankOfAddress.end(), "Packet from unplaced node" );
+
+    const uint32_t peer = it->second;
+
+    m_available[ peer ] += p->GetSize();
+    m_bytesReceived += p->GetSize();
+
+    if( ( peer == m_waitingPeer ) &&
+        ( m_available[ peer ] >= m_waitingBytes ) )
+    {
+        m_available[ peer ] -= m_waitingBytes;
+
+        m_waitingPeer = NOT_WAITING;
+        m_waitingBytes = 0;
+
+        ReplayNext();
+    }
+
+    return true;
+}
+
+void
+TocinoTraceReplayApplication::StopApplication()
+{
+    m_running = false;
+
+    Simulator::Cancel( m_computeEvent );
+
+    // Never sent, so never counted
+    m_pendingPackets.clear();
+}
+
+}
@@ -0,0 +1,486 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#include <algorithm>
+#include <list>
+#include <map>
+#include <sstream>
+#include <cstring>
+
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include "tocino-trace.h"
+
+NS_LOG_COMPONENT_DEFINE( "TocinoTrace" );
+
+namespace ns3
+{
+
+namespace
+{
+
+const char MAGIC[] = "TOCTRACE";
+const uint32_t MAGIC_BYTES = 8;
+const uint32_t VERSION = 1;
+
+const uint32_t HEADER_BYTES = 16;
+const uint32_t RECORD_BYTES = 16;
+
+uint64_t
+ReadLittleEndian( const uint8_t* p, const uint32_t width )
+{
+    uint64_t value = 0;
+
+    for( uint32_t i = 0; i < width; ++i )
+    {
+        value |= static_cast<uint64_t>( p[i] ) << ( 8 * i );
+    }
+
+    return value;
+}
+
+void
+WriteLittleEndian( uint8_t* p, uint64_t value, const uint32_t width )
+{
+    for( uint32_t i = 0; i < width; ++i )
+    {
+        p[i] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+// The files open for all TocinoTraceReaders, the one
+// used longest ago first
+class ReaderFilePool
+{
+    public:
+
+    ~ReaderFilePool()
+    {
+        while( !m_files.empty() )
+        {
+            delete m_files.front().second;
+            m_files.pop_front();
+        }
+    }
+
+    // The reader's file, opened and positioned at the given
+    // offset unless still open from last time; NULL if it
+    // cannot be opened
+    std::ifstream* Get(
+            const TocinoTraceReader* reader,
+            const std::string& filename,
+            const uint64_t offset )
+    {
+        Index::iterator it = m_index.find( reader );
+
+        if( it != m_index.end() )
+        {
+            // Now the most recently used
+            m_files.splice( m_files.end(), m_files, it->second );
+            return it->second->second;
+        }
+
+        if( m_files.size() == TOCINO_TRACE_MAX_OPEN_READERS )
+        {
+            m_index.erase( m_files.front().first );
+            delete m_files.front().second;
+            m_files.pop_front();
+        }
+
+        std::ifstream* file =
+            new std::ifstream( filename.c_str(), std::ios::in | std::ios::binary );
+
+        if( !file->seekg( offset ) )
+        {
+            delete file;
+            return NULL;
+        }
+
+        m_files.push_back( Entry( reader, file ) );
+        m_index[ reader ] = --m_files.end();
+
+        return file;
+    }
+
+    // Close the reader's file, if open
+    void Release( const TocinoTraceReader* reader )
+    {
+        Index::iterator it = m_index.find( reader );
+
+        if( it != m_index.end() )
+        {
+            delete it->second->second;
+            m_files.erase( it->second );
+            m_index.erase( it );
+        }
+    }
+
+    private:
+
+    typedef std::pair< const TocinoTraceReader*, std::ifstream* > Entry;
+    typedef std::list< Entry > Files;
+    typedef std::map< const TocinoTraceReader*, Files::iterator > Index;
+
+    Files m_files;
+    Index m_index;
+};
+
+ReaderFilePool&
+GetReaderFilePool()
+{
+    static ReaderFilePool pool;
+    return pool;
+}
+
+}
+
+std::string
+TocinoTraceFileName( const std::string& prefix, const uint32_t rank )
+{
+    std::ostringstream oss;
+    oss << prefix << "." << rank;
+    return oss.str();
+}
+
+TocinoTraceReader::TocinoTraceReader( const uint32_t bufferRecords )
+    : m_open( false )
+    , m_offset( 0 )
+    , m_rank( 0 )
+    , m_buffer( bufferRecords * RECORD_BYTES )
+    , m_records( 0 )
+    , m_next( 0 )
+{
+    NS_ASSERT( bufferRecords > 0 );
+}
+
+TocinoTraceReader::~TocinoTraceReader()
+{
+    GetReaderFilePool().Release( this );
+}
+
+TocinoTraceReader&
+TocinoTraceReader::operator=( const TocinoTraceReader& other )
+{
+    if( this != &other )
+    {
+        GetReaderFilePool().Release( this );
+
+        m_filename = other.m_filename;
+        m_open = other.m_open;
+        m_offset = other.m_offset;
+        m_rank = other.m_rank;
+        m_buffer = other.m_buffer;
+        m_records = other.m_records;
+        m_next = other.m_next;
+    }
+
+    return *this;
+}
+
+bool
+TocinoTraceReader::Open( const std::string& filename )
+{
+    NS_ASSERT( !m_open );
+
+    std::ifstream* file = GetReaderFilePool().Get( this, filename, 0 );
+
+    uint8_t header[ HEADER_BYTES ];
+
+    if( ( file == NULL ) ||
+        !file->read( reinterpret_cast<char*>( header ), HEADER_BYTES ) )
+    {
+        NS_LOG_WARN( "cannot read header of " << filename );
+        GetReaderFilePool().Release( this );
+        return false;
+    }
+
+    if( ( std::memcmp( header, MAGIC, MAGIC_BYTES ) != 0 ) ||
+        ( ReadLittleEndian( header + 8, 4 ) != VERSION ) )
+    {
+        NS_LOG_WARN( filename << " is not a version "
+                << VERSION << " Tocino trace" );
+        GetReaderFilePool().Release( this );
+        return false;
+    }
+
+    m_filename = filename;
+    m_open = true;
+    m_offset = HEADER_BYTES;
+    m_rank = ReadLittleEndian( header + 12, 4 );
+
+    return true;
+}
+
+bool
+TocinoTraceReader::IsOpen() const
+{
+    return m_open;
+}
+
+uint32_t
+TocinoTraceReader::GetRank() const
+{
+    return m_rank;
+}
+
+bool
+TocinoTraceReader::Refill()
+{
+    if( !m_open )
+    {
+        return false;
+    }
+
+    std::ifstream* file = GetReaderFilePool().Get( this, m_filename, m_offset );
+
+    NS_ABORT_MSG_IF( file == NULL, "Cannot reopen " << m_filename );
+
+    file->read( reinterpret_cast<char*>( &m_buffer[0] ), m_buffer.size() );
+
+    const uint32_t BYTES = file->gcount();
+
+    NS_ASSERT_MSG( BYTES % RECORD_BYTES == 0, "Truncated trace record" );
+
+    m_offset += BYTES;
+    m_records = BYTES / RECORD_BYTES;
+    m_next = 0;
+
+    if( BYTES < m_buffer.size() )
+    {
+        // At the end; let other readers have the file
+        GetReaderFilePool().Release( this );
+    }
+
+    return m_records > 0;
+}
+
+bool
+TocinoTraceReader::Next( TocinoTraceRecord& record )
+{
+    if( ( m_next == m_records ) && !Refill() )
+    {
+        return false;
+    }
+
+    const uint8_t* p = &m_buffer[ m_next * RECORD_BYTES ];
+    m_next++;
+
+    record.type = static_cast<TocinoTraceRecord::Type>( p[0] );
+    record.peer = ReadLittleEndian( p + 4, 4 );
+    record.value = ReadLittleEndian( p + 8, 8 );
+
+    NS_ASSERT_MSG( ( record.type == TocinoTraceRecord::SEND ) ||
+                   ( record.type == TocinoTraceRecord::RECV ) ||
+                   ( record.type == TocinoTraceRecord::COMPUTE ),
+                   "Bad trace record type" );
+
+    return true;
+}
+
+TocinoTraceWriter::TocinoTraceWriter(
+        const std::string& filename,
+        const uint32_t rank )
+    : m_file( filename.c_str(),
+            std::ios::out | std::ios::binary | std::ios::trunc )
+{
+    uint8_t header[ HEADER_BYTES ];
+
+    std::memcpy( header, MAGIC, MAGIC_BYTES );
+    WriteLittleEndian( header + 8, VERSION, 4 );
+    WriteLittleEndian( header + 12, rank, 4 );
+
+    m_file.write( reinterpret_cast<const char*>( header ), HEADER_BYTES );
+}
+
+TocinoTraceWriter::TocinoTraceWriter( const std::string& filename )
+    : m_file( filename.c_str(),
+            std::ios::out | std::ios::binary | std::ios::app )
+{}
+
+bool
+TocinoTraceWriter::IsOpen() const
+{
+    return m_file.is_open() && m_file.good();
+}
+
+void
+TocinoTraceWriter::Write( const TocinoTraceRecord& record )
+{
+    uint8_t p[ RECORD_BYTES ];
+
+    std::memset( p, 0, RECORD_BYTES );
+
+    p[0] = record.type;
+    WriteLittleEndian( p + 4, record.peer, 4 );
+    WriteLittleEndian( p + 8, record.value, 8 );
+
+    m_file.write( reinterpret_cast<const char*>( p ), RECORD_BYTES );
+}
+
+uint32_t
+TocinoConvertTextTrace(
+        std::istream& is,
+        const std::string& prefix,
+        const uint32_t maxOpenWriters )
+{
+    // N.B.
+    // Records are parsed twice: once to find the number of
+    // ranks, and again to write them.  This keeps no more
+    // than maxOpenWriters files, and nothing else, in
+    // memory.  Every file is created, with its header, at
+    // the end of the first pass; the second reopens them
+    // to append as needed, closing the one written longest
+    // ago (openOrder.front()) to make room.
+
+    NS_ASSERT( maxOpenWriters > 0 );
+
+    std::streampos start = is.tellg();
+
+    std::string line;
+    uint32_t ranks = 0;
+    uint32_t lineNumber = 0;
+
+    std::vector< TocinoTraceWriter* > writers;
+    std::list< uint32_t > openOrder;
+
+    for( uint32_t pass = 0; pass < 2; ++pass )
+    {
+        lineNumber = 0;
+
+        while( std::getline( is, line ) )
+        {
+            lineNumber++;
+
+            const std::string::size_type hash = line.find( '#' );
+
+            if( hash != std::string::npos )
+            {
+                line.erase( hash );
+            }
+
+            std::istringstream iss( line );
+
+            uint32_t rank;
+            std::string op;
+
+            if( !( iss >> rank ) )
+            {
+                // Blank
+                continue;
+            }
+
+            TocinoTraceRecord record;
+
+            if( ( iss >> op ) && ( op == "send" || op == "recv" ) )
+            {
+                record.type = ( op == "send" ) ?
+                    TocinoTraceRecord::SEND : TocinoTraceRecord::RECV;
+
+                if( !( iss >> record.peer >> record.value ) )
+                {
+                    record.type = TocinoTraceRecord::INVALID;
+                }
+            }
+            else if( op == "compute" )
+            {
+                record.type = TocinoTraceRecord::COMPUTE;
+
+                if( !( iss >> record.value ) )
+                {
+                    record.type = TocinoTraceRecord::INVALID;
+                }
+            }
+
+            if( record.type == TocinoTraceRecord::INVALID )
+            {
+                NS_LOG_WARN( "malformed trace at line " << lineNumber );
+                ranks = 0;
+                break;
+            }
+
+            if( pass == 0 )
+            {
+                ranks = std::max( ranks, rank + 1 );
+
+                if( record.type != TocinoTraceRecord::COMPUTE )
+                {
+                    ranks = std::max( ranks, record.peer + 1 );
+                }
+            }
+            else
+            {
+                if( writers[rank] == NULL )
+                {
+                    if( openOrder.size() == maxOpenWriters )
+                    {
+                        delete writers[ openOrder.front() ];
+                        writers[ openOrder.front() ] = NULL;
+                        openOrder.pop_front();
+                    }
+
+                    writers[rank] = new TocinoTraceWriter(
+                            TocinoTraceFileName( prefix, rank ) );
+
+                    if( !writers[rank]->IsOpen() )
+                    {
+                        NS_LOG_WARN( "cannot reopen "
+                                << TocinoTraceFileName( prefix, rank ) );
+                        ranks = 0;
+                        break;
+                    }
+                }
+                else
+                {
+                    openOrder.remove( rank );
+                }
+
+                openOrder.push_back( rank );
+
+                writers[rank]->Write( record );
+            }
+        }
+
+        if( ranks == 0 )
+        {
+            break;
+        }
+
+        if( pass == 0 )
+        {
+            is.clear();
+            is.seekg( start );
+
+            // Every rank has a file, even if it does nothing
+            for( uint32_t rank = 0; rank < ranks; ++rank )
+            {
+                TocinoTraceWriter writer(
+                        TocinoTraceFileName( prefix, rank ), rank );
+
+                if( !writer.IsOpen() )
+                {
+                    NS_LOG_WARN( "cannot write "
+                            << TocinoTraceFileName( prefix, rank ) );
+                    ranks = 0;
+                    break;
+                }
+            }
+
+            writers.assign( ranks, NULL );
+
+            if( ranks == 0 )
+            {
+                break;
+            }
+        }
+    }
+
+    for( uint32_t rank = 0; rank < writers.size(); ++rank )
+    {
+        delete writers[rank];
+    }
+
+    return ranks;
+}
+
+}
@@ -0,0 +1,64 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#include "tocino-traffic-class-tag.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED(TocinoTrafficClassTag);
+
+TypeId
+TocinoTrafficClassTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TocinoTrafficClassTag")
+    .SetParent<Tag>()
+    .AddConstructor<TocinoTrafficClassTag>()
+  ;
+  return tid;
+}
+
+TypeId
+TocinoTrafficClassTag::GetInstanceTypeId() const
+{
+  return GetTypeId();
+}
+
+uint32_t
+TocinoTrafficClassTag::GetSerializedSize() const
+{
+  return 4;
+}
+
+void
+TocinoTrafficClassTag::Serialize( TagBuffer buf ) const
+{
+  buf.WriteU32( m_trafficClass );
+}
+
+void
+TocinoTrafficClassTag::Deserialize( TagBuffer buf )
+{
+  m_trafficClass = buf.ReadU32();
+}
+
+void
+TocinoTrafficClassTag::Print( std::ostream &os ) const
+{
+  os << "class=" << m_trafficClass;
+}
+
+TocinoTrafficClassTag::TocinoTrafficClassTag()
+    : Tag()
+    , m_trafficClass( 0 )
+{}
+
+TocinoTrafficClassTag::TocinoTrafficClassTag( uint32_t trafficClass )
+    : Tag()
+    , m_trafficClass( trafficClass )
+{}
+
+uint32_t
+TocinoTrafficClassTag::GetTrafficClass() const
+{
+    return m_trafficClass;
+}
+
+} // namespace ns3
@@ -1,6 +1,8 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 #include "tocino-traffic-matrix-application.h"
 
+#include <algorithm>
+
 #include "ns3/node-container.h"
 #include "ns3/simulator.h"
 #include "ns3/packet.h"
@@ -8,6 +10,8 @@
 #include "ns3/boolean.h"
 #include "ns3/log.h"
 
+#include "tocino-traffic-class-tag.h"
+
 namespace ns3
 {
 
@@ -45,6 +49,11 @@ TocinoTrafficMatrixApplication::GetTypeId()
             BooleanValue( false ),
             MakeBooleanAccessor( &TocinoTrafficMatrixApplication::m_doVLB),
             MakeBooleanChecker() )
+        .AddAttribute( "TrafficClass",
+            "Traffic class, and so VCs, of every packet sent.",
+            UintegerValue( 0 ),
+            MakeUintegerAccessor( &TocinoTrafficMatrixApplication::m_trafficClass ),
+            MakeUintegerChecker< uint32_t >() )
         ;
     return tid;
 }
@@ -60,7 +69,9 @@ TocinoTrafficMatrixApplication::TocinoTrafficMatrixApplication()
     , m_netDevice( NULL )
     , m_nodeContainer( NULL )
     , m_receiveCallback( NULL )
+    , m_pendingPacket( NULL )
     , m_doVLB( false )
+    , m_trafficClass( 0 )
 {};
 
 void 
@@ -68,24 +79,65 @@ TocinoTrafficMatrixApplication::Initialize(
         const uint32_t nodeNumber,
         const NodeContainer* nodeContainer,
         const TocinoTrafficMatrix& trafficMatrix )
+{
+    InitializeDevice( nodeNumber, nodeContainer );
+
+    NS_ASSERT( trafficMatrix.size() == m_totalNodes );
+
+    // Validate that traffic matrix is square
+    for( uint32_t i = 0; i < m_totalNodes; ++i )
+    {
+        NS_ASSERT( trafficMatrix[i].size() == m_totalNodes );
+    }
+
+    const TocinoTrafficVector& trafficVector = trafficMatrix[m_nodeNumber];
+
+    for( uint32_t destNum = 0; destNum < trafficVector.size(); ++destNum )
+    {
+        AddDestination( destNum, trafficVector[destNum] );
+    }
+}
+
+void 
+TocinoTrafficMatrixApplication::Initialize(
+        const uint32_t nodeNumber,
+        const NodeContainer* nodeContainer,
+        const TocinoSparseTrafficMatrix& trafficMatrix )
+{
+    InitializeDevice( nodeNumber, nodeContainer );
+
+    NS_ASSERT( trafficMatrix.size() == m_totalNodes );
+
+    const TocinoSparseTrafficVector& trafficVector = trafficMatrix[m_nodeNumber];
+
+    for( uint32_t i = 0; i < trafficVector.size(); ++i )
+    {
+        // Ascending, so that a dense matrix with the same
+        // entries selects exactly the same destinations
+        NS_ASSERT( ( i == 0 ) ||
+                ( trafficVector[i].first > trafficVector[i-1].first ) );
+
+        AddDestination( trafficVector[i].first, trafficVector[i].second );
+    }
+}
+
+void
+TocinoTrafficMatrixApplication::InitializeDevice(
+        const uint32_t nodeNumber,
+        const NodeContainer* nodeContainer )
 {
     NS_ASSERT( nodeContainer != NULL );
    
     m_nodeNumber = nodeNumber;
     m_nodeContainer = nodeContainer;
-    m_trafficVector = &trafficMatrix[m_nodeNumber];
 
     m_totalNodes = nodeContainer->GetN();
 
-    NS_ASSERT( trafficMatrix.size() == m_totalNodes );
     NS_ASSERT( m_nodeNumber < m_totalNodes );
 
-    // Validate that traffic matrix is square
-    for( uint32_t i = 0; i < m_totalNodes; ++i )
-    {
-        NS_ASSERT( trafficMatrix[i].size() == m_totalNodes );
-    }
-    
+    m_destinations.clear();
+    m_cumulativeTraffic.clear();
+
     Ptr<Node> node = m_nodeContainer->Get( m_nodeNumber );
     NS_ASSERT( node->GetNDevices() == 1 );
 
@@ -99,6 +151,9 @@ TocinoTrafficMatrixApplication::Initialize(
     m_netDevice->SetReceiveCallback( 
             MakeCallback( &TocinoTrafficMatrixApplication::AcceptPacket, this ) );
 
+    m_netDevice->AddReadyCallback( 
+            MakeCallback( &TocinoTrafficMatrixApplication::DeviceReady, this ) );
+
     m_sendIntervalRandomVariable =
         CreateObject<ExponentialRandomVariable>();
 
@@ -106,6 +161,28 @@ TocinoTrafficMatrixApplication::Initialize(
         CreateObject<UniformRandomVariable>();
 }
 
+void
+TocinoTrafficMatrixApplication::AddDestination(
+        const uint32_t destNum,
+        const uint32_t traffic )
+{
+    NS_ASSERT( ( destNum < m_totalNodes ) || ( destNum == TOCINO_ALL_OTHERS ) );
+
+    if( traffic == 0 )
+    {
+        return;
+    }
+
+    const uint32_t lowerBound =
+        m_cumulativeTraffic.empty() ? 0 : m_cumulativeTraffic.back();
+
+    // No overflow
+    NS_ASSERT( traffic <= TOCINO_TOTAL_TRAFFIC - lowerBound );
+
+    m_destinations.push_back( destNum );
+    m_cumulativeTraffic.push_back( lowerBound + traffic );
+}
+
 void
 TocinoTrafficMatrixApplication::SetPacketSize(
         uint32_t packetSize )
@@ -139,6 +216,19 @@ TocinoTrafficMatrixApplication::ResetStatistics()
     m_packetsReceived = 0;
 }
 
+int64_t
+TocinoTrafficMatrixApplication::AssignStreams( int64_t stream )
+{
+    // Must follow Initialize(), which creates the variables
+    NS_ASSERT( m_sendIntervalRandomVariable != NULL );
+    NS_ASSERT( m_destinationRandomVariable != NULL );
+
+    m_sendIntervalRandomVariable->SetStream( stream );
+    m_destinationRandomVariable->SetStream( stream + 1 );
+
+    return 2;
+}
+
 void
 TocinoTrafficMatrixApplication::StartApplication()
 {
@@ -174,60 +264,86 @@ TocinoTrafficMatrixApplication::SelectRandomDestination()
     uint32_t rand =
         m_destinationRandomVariable->GetInteger( 0, TOCINO_TOTAL_TRAFFIC );
 
-    uint32_t lowerBound = 0;
-    uint32_t upperBound = 0;
+    std::vector< uint32_t >::const_iterator it =
+        std::upper_bound(
+                m_cumulativeTraffic.begin(),
+                m_cumulativeTraffic.end(),
+                rand );
 
-    for( uint32_t destNum = 0; destNum < m_trafficVector->size(); ++destNum )
+    if( it == m_cumulativeTraffic.end() )
     {
-        upperBound += (*m_trafficVector)[destNum];
-        
-        NS_ASSERT( upperBound <= TOCINO_TOTAL_TRAFFIC );
+        return DO_NOT_SEND;
+    }
 
-        if( ( rand >= lowerBound ) && 
-            ( rand < upperBound ) )
-        {
-            return destNum;
-        }
+    const uint32_t i = it - m_cumulativeTraffic.begin();
 
-        lowerBound = upperBound;
+    if( m_destinations[i] != TOCINO_ALL_OTHERS )
+    {
+        return m_destinations[i];
+    }
+
+    if( m_totalNodes == 1 )
+    {
+        return DO_NOT_SEND;
     }
 
-    return DO_NOT_SEND;
+    // N.B.
+    // The same draw picks among the other nodes, by where
+    // it falls in the range of this entry, rather than a
+    // second draw; the range is far wider than the nodes.
+    const uint32_t lowerBound = ( i == 0 ) ? 0 : m_cumulativeTraffic[i-1];
+    const uint64_t range = m_cumulativeTraffic[i] - lowerBound;
+
+    uint32_t destNum = static_cast<uint64_t>( rand - lowerBound )
+        * ( m_totalNodes - 1 ) / range;
+
+    if( destNum >= m_nodeNumber )
+    {
+        destNum++;
+    }
+
+    return destNum;
 }
 
 void
 TocinoTrafficMatrixApplication::ScheduleSend()
 {
     NS_ASSERT( m_sendEvent.IsExpired() );
+    NS_ASSERT( m_pendingPacket == NULL );
 
     const uint32_t destNum = SelectRandomDestination();
         
     if( destNum != DO_NOT_SEND )
     {
         Ptr<Node> destNode = m_nodeContainer->Get( destNum );
-        Address destAddress = destNode->GetDevice(0)->GetAddress();
+        m_pendingDestAddress = destNode->GetDevice(0)->GetAddress();
 
-        Ptr<Packet> packet = Create<Packet>( m_packetSize );
+        m_pendingPacket = Create<Packet>( m_packetSize );
+        m_pendingPacket->AddPacketTag( TocinoTrafficClassTag( m_trafficClass ) );
 
-        if( !m_doVLB )
-        {
-            m_netDevice->Send( packet, destAddress, 0 );
-        }
-        else
+        if( m_doVLB )
         {
             Ptr<Node> viaNode =
                 m_nodeContainer->Get( 
                     m_destinationRandomVariable->GetInteger( 
-                        0, m_trafficVector->size()-1 ) );
-
-            Address viaAddress = viaNode->GetDevice(0)->GetAddress();
+                        0, m_totalNodes-1 ) );
 
-            m_netDevice->SendVia( packet, destAddress, viaAddress, 0 );
+            m_pendingViaAddress = viaNode->GetDevice(0)->GetAddress();
         }
 
-        m_packetsSent++;
+        if( !TrySendPending() )
+        {
+            // Hold off until DeviceReady
+            return;
+        }
     }
 
+    ScheduleNextSend();
+}
+
+void
+TocinoTrafficMatrixApplication::ScheduleNextSend()
+{
     Time dt = Time(
             m_sendIntervalRandomVariable->GetValue(
                 m_meanTimeBetweenSends.GetDouble(),
@@ -239,10 +355,56 @@ TocinoTrafficMatrixApplication::ScheduleSend()
             this );
 }
 
+bool
+TocinoTrafficMatrixApplication::TrySendPending()
+{
+    NS_ASSERT( m_pendingPacket != NULL );
+
+    bool sent = false;
+
+    if( !m_doVLB )
+    {
+        sent = m_netDevice->Send( m_pendingPacket, m_pendingDestAddress, 0 );
+    }
+    else
+    {
+        sent = m_netDevice->SendVia(
+                m_pendingPacket, m_pendingDestAddress, m_pendingViaAddress, 0 );
+    }
+
+    if( sent )
+    {
+        m_pendingPacket = NULL;
+        m_packetsSent++;
+    }
+
+    return sent;
+}
+
+void
+TocinoTrafficMatrixApplication::DeviceReady( Ptr<NetDevice> )
+{
+    // N.B.
+    // StopApplication discards any pending packet, so
+    // we never resume sending once stopped.
+    if( m_pendingPacket == NULL )
+    {
+        return;
+    }
+
+    if( TrySendPending() )
+    {
+        ScheduleNextSend();
+    }
+}
+
 void
 TocinoTrafficMatrixApplication::StopApplication()
 {
     Simulator::Cancel( m_sendEvent );
+
+    // Never sent, so never counted
+    m_pendingPacket = NULL;
 }
 
 }
@@ -3,6 +3,7 @@
 #define __TOCINO_TRAFFIC_MATRIX_APPLICATION_H__
 
 #include <vector>
+#include <utility>
 #include <limits>
 
 #include "ns3/ptr.h"
@@ -19,6 +20,14 @@ class NodeContainer;
 
 typedef std::vector< uint32_t > TocinoTrafficVector;
 typedef std::vector< TocinoTrafficVector > TocinoTrafficMatrix;
+
+// Only the nonzero entries of each row, as (destination,
+// traffic) pairs, for large networks where a dense matrix
+// would not fit and most rows are nearly all zero.  The
+// last entry of a row may be TOCINO_ALL_OTHERS, below.
+typedef std::pair< uint32_t, uint32_t > TocinoSparseTrafficEntry;
+typedef std::vector< TocinoSparseTrafficEntry > TocinoSparseTrafficVector;
+typedef std::vector< TocinoSparseTrafficVector > TocinoSparseTrafficMatrix;
    
 typedef NetDevice::ReceiveCallback ReceiveCallback;
 
@@ -38,6 +47,12 @@ typedef NetDevice::ReceiveCallback ReceiveCallback;
 const uint32_t TOCINO_TOTAL_TRAFFIC =
     std::numeric_limits< uint32_t >::max() - 1;
 
+// A destination in a sparse row standing for every node
+// but the source, each equally likely, so that uniform
+// traffic costs one entry per row rather than N-1
+const uint32_t TOCINO_ALL_OTHERS =
+    std::numeric_limits< uint32_t >::max();
+
 class TocinoTrafficMatrixApplication : public Application
 {
     public:
@@ -51,6 +66,11 @@ class TocinoTrafficMatrixApplication : public Application
             const NodeContainer*,
             const TocinoTrafficMatrix& );
 
+    void Initialize(
+            const uint32_t,
+            const NodeContainer*,
+            const TocinoSparseTrafficMatrix& );
+
     void SetPacketSize( uint32_t );
 
     void SetReceiveCallback( ReceiveCallback cb );
@@ -60,13 +80,26 @@ class TocinoTrafficMatrixApplication : public Application
 
     void ResetStatistics();
 
+    int64_t AssignStreams( int64_t );
+
     private:
 
     static const uint32_t DO_NOT_SEND;
 
+    void InitializeDevice( const uint32_t, const NodeContainer* );
+
+    void AddDestination( const uint32_t, const uint32_t );
+
     uint32_t SelectRandomDestination();
 
     void ScheduleSend();
+    void ScheduleNextSend();
+
+    // Attempt to send m_pendingPacket
+    bool TrySendPending();
+
+    // NetDevice ready callback, following a refused send
+    void DeviceReady( Ptr<NetDevice> );
     
     void StartApplication();
     void StopApplication();
@@ -98,14 +131,30 @@ class TocinoTrafficMatrixApplication : public Application
 
     Ptr<TocinoNetDevice> m_netDevice;
 
-    // ISSUE-REVIEW: it would be better if these
-    // could be const references
+    // ISSUE-REVIEW: it would be better if this
+    // could be a const reference
     const NodeContainer* m_nodeContainer;
-    const TocinoTrafficVector* m_trafficVector;
+
+    // Our row of the traffic matrix, compiled for binary
+    // search: the destinations with nonzero traffic, and
+    // the running total of traffic up to and including
+    // each.  A draw r selects the first destination whose
+    // total exceeds r, or none if r is beyond the last.
+    // Should that be TOCINO_ALL_OTHERS, the position of r
+    // within its range picks the node.
+    std::vector< uint32_t > m_destinations;
+    std::vector< uint32_t > m_cumulativeTraffic;
     
     ReceiveCallback m_receiveCallback;
 
+    // A packet the NetDevice refused, held until it is ready
+    Ptr<Packet> m_pendingPacket;
+    Address m_pendingDestAddress;
+    Address m_pendingViaAddress;
+
     bool m_doVLB;
+
+    uint32_t m_trafficClass;
 };
 
 }
@@ -1,5 +1,6 @@
 /* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
 
+#include <algorithm>
 #include <cstdio>
 #include <string>
 
@@ -43,15 +44,22 @@ TocinoTx::TocinoTx(
     , m_xState( TocinoAllXON )
     , m_remoteXState( TocinoAllXON )
     , m_doUpdateXState( 0 )
+    , m_totalPendingCredits( 0 )
     , m_state( IDLE )
     , m_tnd( tnd )
     , m_channel( NULL )
+    , m_express( false )
+    , m_running( false )
+    , m_runNext( 0 )
 {
-    m_outputQueues.vec.resize( m_tnd->GetNPorts() );
-    for( TocinoInputPort inputPort = 0; inputPort < m_tnd->GetNPorts(); ++inputPort )
-    {
-        m_outputQueues.vec[ inputPort.AsUInt32() ].resize( m_tnd->GetNVCs() );
-    }
+    m_outputQueues.vec.resize( m_tnd->GetNPorts() * m_tnd->GetNVCs() );
+
+    // N.B.
+    // We assume our neighbor's input queues are as deep as
+    // our own; TocinoChannelHelper insists on it.
+    m_credits.resize( m_tnd->GetNVCs(), m_tnd->GetInputQueueFlits() );
+    m_pendingCredits.resize( m_tnd->GetNVCs(), 0 );
+    m_downstreamFlits.resize( m_tnd->GetNVCs(), 0 );
     
     ObjectFactory arbiterFactory;
     arbiterFactory.SetTypeId( m_tnd->GetArbiterTypeId() );
@@ -67,7 +75,8 @@ TocinoTx::GetOutputQueue(
     NS_ASSERT( inputPort < m_tnd->GetNPorts() );
     NS_ASSERT( outputVC < m_tnd->GetNVCs() );
 
-    return m_outputQueues.vec[ inputPort.AsUInt32() ][ outputVC.AsUInt32() ];
+    return m_outputQueues.vec[ 
+        inputPort.AsUInt32() * m_tnd->GetNVCs() + outputVC.AsUInt32() ];
 }
 
 const TocinoTx::OutputQueue&
@@ -78,7 +87,8 @@ TocinoTx::GetOutputQueue(
     NS_ASSERT( inputPort < m_tnd->GetNPorts() );
     NS_ASSERT( outputVC < m_tnd->GetNVCs() );
 
-    return m_outputQueues.vec[ inputPort.AsUInt32() ][ outputVC.AsUInt32() ];
+    return m_outputQueues.vec[ 
+        inputPort.AsUInt32() * m_tnd->GetNVCs() + outputVC.AsUInt32() ];
 }
 
 void
@@ -86,11 +96,18 @@ TocinoTx::SetXState( const TocinoFlowControlState& newXState )
 {
     NS_LOG_LOGIC( "set local XState to " << newXState.to_string() );
 
+    if( m_running && !newXState[ m_runQueue.outputVC.AsUInt32() ] )
+    {
+        StopRun();
+    }
+
     // If we are resuming any VCs, we should kick transmit
     bool shouldTransmit = ( ~m_xState & newXState ).any();
 
     m_xState = newXState;
 
+    m_arbiter->XStateChanged( m_xState );
+
     if( shouldTransmit )
     {
         Transmit();
@@ -113,6 +130,9 @@ TocinoTx::IsVCPaused( const TocinoOutputVC outputVC ) const
 void TocinoTx::SetChannel(Ptr<TocinoChannel> channel)
 {
     m_channel = channel;
+
+    m_express = m_tnd->GetExpressTransmit() &&
+        ( m_channel != NULL ) && m_channel->SupportsExpress();
 }
 
 Ptr<TocinoChannel>
@@ -121,6 +141,12 @@ TocinoTx::GetChannel() const
     return m_channel;
 }
 
+Ptr<TocinoArbiter>
+TocinoTx::GetArbiter() const
+{
+    return m_arbiter;
+}
+
 void TocinoTx::RemotePause( const TocinoInputVC inputVC )
 {
     NS_LOG_FUNCTION( inputVC );
@@ -152,6 +178,9 @@ void TocinoTx::RemotePause( const TocinoInputVC inputVC )
 
     NS_ASSERT( m_remoteXState != orig );
 
+    // The flow control flit goes ahead of the rest of any run
+    StopRun();
+
     m_doUpdateXState |= vcMask;
 
     Transmit();
@@ -188,11 +217,163 @@ void TocinoTx::RemoteResume( const TocinoInputVC inputVC )
     
     NS_ASSERT( m_remoteXState != orig );
 
+    StopRun();
+
     m_doUpdateXState |= vcMask;
 
     Transmit();
 }
 
+bool
+TocinoTx::UsesCredits() const
+{
+    // The ejection port has no channel, and no neighbor
+    return ( m_tnd->GetFlowControl() == TocinoNetDevice::CREDIT ) &&
+        ( m_outputPort != m_tnd->GetHostPort() );
+}
+
+void
+TocinoTx::AddCredits( const TocinoCredits& credits )
+{
+    NS_ASSERT( UsesCredits() );
+
+    TocinoFlowControlState newXState( m_xState );
+
+    for( TocinoOutputVC outputVC = 0; outputVC < m_tnd->GetNVCs(); ++outputVC )
+    {
+        const uint32_t vc = outputVC.AsUInt32();
+        const uint32_t n = credits.Get( vc );
+
+        if( n == 0 )
+        {
+            continue;
+        }
+
+        m_credits[vc] += n;
+
+        NS_ASSERT_MSG( m_credits[vc] <= m_tnd->GetInputQueueFlits(),
+                "More credits than buffers? outputVC=" << outputVC );
+
+        newXState.set( vc );
+    }
+
+    if( newXState != m_xState )
+    {
+        SetXState( newXState );
+    }
+}
+
+void
+TocinoTx::ConsumeCredit( const TocinoOutputVC outputVC )
+{
+    const uint32_t vc = outputVC.AsUInt32();
+
+    NS_ASSERT_MSG( m_credits[vc] > 0, "Sent without credit? outputVC=" << outputVC );
+
+    m_credits[vc]--;
+
+    if( m_credits[vc] == 0 )
+    {
+        NS_LOG_LOGIC( "out of credits on outputVC=" << outputVC );
+
+        m_xState.reset( vc );
+        m_arbiter->XStateChanged( m_xState );
+    }
+}
+
+uint32_t
+TocinoTx::GetCredits( const TocinoOutputVC outputVC ) const
+{
+    NS_ASSERT( outputVC < m_tnd->GetNVCs() );
+
+    return m_credits[ outputVC.AsUInt32() ];
+}
+
+void
+TocinoTx::DownstreamFreed( const TocinoInputVC inputVC )
+{
+    NS_ASSERT( !UsesCredits() );
+    NS_ASSERT_MSG( m_downstreamFlits[ inputVC.AsUInt32() ] > 0,
+            "Freed a flit never sent? inputVC=" << inputVC );
+
+    m_downstreamFlits[ inputVC.AsUInt32() ]--;
+}
+
+bool
+TocinoTx::IsVCIdle( const TocinoOutputVC outputVC ) const
+{
+    if( m_arbiter->GetVCOwner( outputVC ) != TocinoSimpleArbiter::ANY_QUEUE )
+    {
+        return false;
+    }
+
+    for( TocinoInputPort inputPort = 0; inputPort < m_tnd->GetNPorts(); ++inputPort )
+    {
+        if( !GetOutputQueue( inputPort, outputVC ).IsEmpty() )
+        {
+            return false;
+        }
+    }
+
+    if( m_outputPort == m_tnd->GetHostPort() )
+    {
+        // The ejection port never fills
+        return true;
+    }
+
+    if( UsesCredits() )
+    {
+        return m_credits[ outputVC.AsUInt32() ] == m_tnd->GetInputQueueFlits();
+    }
+
+    return m_downstreamFlits[ outputVC.AsUInt32() ] == 0;
+}
+
+void TocinoTx::RemoteCredit( const TocinoInputVC inputVC )
+{
+    NS_LOG_FUNCTION( inputVC );
+
+    NS_ASSERT( UsesCredits() );
+
+    m_pendingCredits[ inputVC.AsUInt32() ]++;
+    m_totalPendingCredits++;
+
+    if( AreCreditsUrgent() )
+    {
+        StopRun();
+    }
+
+    Transmit();
+}
+
+bool
+TocinoTx::AreCreditsUrgent() const
+{
+    // N.B.
+    // Credits owed pile up while we have data to send, and
+    // then all go in a single credit flit, once any one VC
+    // is owed half an input queue.  An idle wire sends them
+    // at once, see DoTransmit.  Credits held back are never
+    // needed for progress: our neighbor can only be starved
+    // of credits on a VC whose flits still fill most of our
+    // input queue, and freeing those will release them.
+    // Deep queues wait no longer than one credit flit can
+    // carry.
+    const uint32_t threshold =
+        std::max( std::min( m_tnd->GetInputQueueFlits() / 2, TocinoCredits::MAX_CREDITS ),
+                static_cast<uint32_t>( 1 ) );
+
+    for( uint32_t vc = 0; vc < m_tnd->GetNVCs(); ++vc )
+    {
+        if( m_pendingCredits[vc] >= threshold )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 Ptr<NetDevice>
 TocinoTx::GetNetDevice()
 {
@@ -208,12 +389,22 @@ TocinoTx::GetTocinoNetDevice()
 void
 TocinoTx::TransmitEnd()
 {
+  m_tnd->CatchUpExpressRuns( TOCINO_INVALID_PORT );
+
   m_state = IDLE;
   Transmit();
 }
 
 void
-TocinoTx::SendToChannel( Ptr<Packet> f )
+TocinoTx::FusedTransmitEnd()
+{
+    m_channel->TransmitEndFused();
+
+    TransmitEnd();
+}
+
+void
+TocinoTx::SendToChannel( const TocinoFlit& f )
 {
     // this acts as a mutex on Transmit
     m_state = BUSY;
@@ -227,25 +418,45 @@ TocinoTx::SendToChannel( Ptr<Packet> f )
         // need to keep m_state == BUSY to this point to prevent reentrancy
         m_tnd->EjectFlit( f ); // eject the packet
 
-        // ScheduleNow here, rather than direct call to TransmitEnd
+        // Deferring, rather than direct call to TransmitEnd
         // avoids mind-bending reentrancy due to:
         //    Transmit -> SendToChannel -> TransmitEnd -> Transmit
         // Otherwise we can end up with multiple Transmits in flight
         // at once, which is very confusing.
         
-        Simulator::ScheduleNow( &TocinoTx::TransmitEnd, this );
+        m_tnd->ScheduleTransmitEnd( m_outputPort );
     }
     else
     {
         // send packet to channel
         NS_ASSERT( m_channel != NULL );
-        m_channel->TransmitStart( f );
+
+        if( m_express )
+        {
+            // N.B.
+            // The channel would schedule its TransmitEnd just
+            // before ours, for the same time, so nothing could
+            // run between the two.  One event does for both.
+            m_channel->TransmitStartFused( f );
+        }
+        else
+        {
+            m_channel->TransmitStart( f );
+        }
+
         Time transmit_time = m_channel->GetTransmissionTime( f );
 
         NS_LOG_LOGIC( "transmitting " << GetTocinoFlitIdString( f ) 
             << " for " << transmit_time );
 
-        Simulator::Schedule(transmit_time, &TocinoTx::TransmitEnd, this);
+        if( m_express )
+        {
+            Simulator::Schedule(transmit_time, &TocinoTx::FusedTransmitEnd, this);
+        }
+        else
+        {
+            Simulator::Schedule(transmit_time, &TocinoTx::TransmitEnd, this);
+        }
     }
 }
 
@@ -257,16 +468,40 @@ TocinoTx::DoTransmitFlowControl()
 
     if( m_outputPort != m_tnd->GetHostPort() )
     {
-        Ptr<Packet> f = GetTocinoFlowControlFlit( m_remoteXState );
-        
         NS_LOG_LOGIC( "sending " << m_remoteXState.to_string() );
         
-        SendToChannel( f );
+        SendToChannel( GetPooledTocinoFlowControlFlit( m_remoteXState ) );
     }
         
     m_doUpdateXState.reset();
 }
 
+void
+TocinoTx::DoTransmitCredits()
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    NS_ASSERT( m_outputPort != m_tnd->GetHostPort() );
+
+    // N.B.
+    // A credit flit carries at most MAX_CREDITS per VC.
+    // Any more stay owed, for the next credit flit.
+    TocinoCredits credits;
+
+    for( uint32_t vc = 0; vc < m_tnd->GetNVCs(); ++vc )
+    {
+        while( ( m_pendingCredits[vc] > 0 ) &&
+                ( credits.Get( vc ) < TocinoCredits::MAX_CREDITS ) )
+        {
+            credits.Add( vc );
+            m_pendingCredits[vc]--;
+            m_totalPendingCredits--;
+        }
+    }
+
+    SendToChannel( GetPooledTocinoCreditFlit( credits ) );
+}
+
 void
 TocinoTx::DoTransmit()
 {
@@ -278,17 +513,45 @@ TocinoTx::DoTransmit()
 
     if( winner == TocinoArbiter::DO_NOTHING )
     {
+        if( m_totalPendingCredits > 0 )
+        {
+            // The wire is otherwise idle
+            DoTransmitCredits();
+            return;
+        }
+
         NS_LOG_LOGIC( "nothing to do" );
         return;
     }
   
-    Ptr<Packet> flit =
+    TocinoFlit flit =
         GetOutputQueue( winner.inputPort, winner.outputVC ).Dequeue();
 
-    NS_ASSERT_MSG( flit != NULL, "Queue underrun? inputPort="
+    NS_ASSERT_MSG( !flit.IsNull(), "Queue underrun? inputPort="
             << winner.inputPort << " outputVC=" << winner.outputVC );
 
-    SendToChannel( flit );
+    m_arbiter->FlitDequeued( winner.inputPort, winner.outputVC );
+
+    if( UsesCredits() )
+    {
+        ConsumeCredit( winner.outputVC );
+    }
+    else if( m_outputPort != m_tnd->GetHostPort() )
+    {
+        m_downstreamFlits[ winner.outputVC.AsUInt32() ]++;
+    }
+
+    if( flit.IsHead() )
+    {
+        TocinoFlitStamp& stamp = flit.GetStamp();
+
+        stamp.queueing += Simulator::Now() - stamp.arrived;
+    }
+
+    if( !m_express || !StartRun( winner, flit ) )
+    {
+        SendToChannel( flit );
+    }
 
     // Give the inputPort an opportunity to push another flit
     m_tnd->GetReceiver( winner.inputPort )->TryForwardFlit();
@@ -309,12 +572,231 @@ TocinoTx::Transmit()
     {
         DoTransmitFlowControl();
     }
+    else if( AreCreditsUrgent() )
+    {
+        DoTransmitCredits();
+    }
     else 
     {
         DoTransmit();
     }
 }
 
+bool
+TocinoTx::StartRun(
+        const TocinoArbiterAllocation& winner,
+        const TocinoFlit& flit )
+{
+    // N.B.
+    // A run sends the rest of a packet in one go, when
+    // arbitration could pick nothing else until its tail:
+    // no other output queue holds a flit, the VC is not
+    // paused, and no flow control flit is due.  Each flit
+    // still arrives downstream on its own, at its own time.
+    //
+    // Anything which might change that, such as a flit for
+    // another queue or an XOFF, stops the run (StopRun).
+    // Flits which have yet to start are withdrawn, and
+    // arbitrated one at a time as usual.
+    //
+    // In between, the flits of the run stay in the output
+    // queue, and every event on the device first catches up
+    // (CatchUp) with those which have started since.  So
+    // all state is as it would have been at any event, and
+    // every flit starts and arrives at the same time.  Only
+    // the order of simultaneous events may differ.
+
+    NS_ASSERT( m_express );
+    NS_ASSERT( !m_running );
+
+    if( flit.IsTail() )
+    {
+        return false;
+    }
+
+    const OutputQueue& queue =
+        GetOutputQueue( winner.inputPort, winner.outputVC );
+
+    if( queue.IsEmpty() )
+    {
+        return false;
+    }
+
+    if( m_doUpdateXState.any() || AreCreditsUrgent() ||
+        IsVCPaused( winner.outputVC ) )
+    {
+        return false;
+    }
+
+    // We would give the input port a chance to forward
+    // after every flit; it had better have nothing to
+    if( m_tnd->GetReceiver( winner.inputPort )->HasQueuedFlits() )
+    {
+        return false;
+    }
+
+    for( TocinoInputPort inputPort = 0; inputPort < m_tnd->GetNPorts(); ++inputPort )
+    {
+        for( TocinoOutputVC outputVC = 0; outputVC < m_tnd->GetNVCs(); ++outputVC )
+        {
+            if( ( inputPort != winner.inputPort || outputVC != winner.outputVC ) &&
+                !GetOutputQueue( inputPort, outputVC ).IsEmpty() )
+            {
+                return false;
+            }
+        }
+    }
+
+    // The rest of the packet, as far as it has arrived
+    uint32_t flits = 0;
+
+    while( flits < queue.Size() )
+    {
+        if( queue.At( flits++ ).IsTail() )
+        {
+            break;
+        }
+    }
+
+    if( UsesCredits() )
+    {
+        flits = std::min( flits, m_credits[ winner.outputVC.AsUInt32() ] );
+    }
+
+    NS_ASSERT( flits > 0 );
+
+    if( !UsesCredits() )
+    {
+        // As if sent now; StopRun takes back any withdrawn
+        m_downstreamFlits[ winner.outputVC.AsUInt32() ] += flits;
+    }
+
+    NS_LOG_LOGIC( "express run of " << ( flits + 1 ) << " flits from "
+            << GetTocinoFlitIdString( flit ) );
+
+    m_state = BUSY;
+
+    const Time now = Simulator::Now();
+
+    Time start = now + m_channel->TransmitExpress( flit, now );
+
+    for( uint32_t i = 0; i < flits; ++i )
+    {
+        m_runStarts.push_back( start );
+
+        start += m_channel->TransmitExpress( queue.At( i ), start );
+    }
+
+    m_running = true;
+    m_runQueue = winner;
+    m_runNext = 0;
+    m_runEndEvent = Simulator::Schedule( start - now, &TocinoTx::RunEnd, this );
+
+    m_tnd->SetExpressRun( m_outputPort, true );
+
+    return true;
+}
+
+void
+TocinoTx::CatchUp()
+{
+    if( !m_running )
+    {
+        return;
+    }
+
+    const Time now = Simulator::Now();
+
+    while( ( m_runNext < m_runStarts.size() ) && ( m_runStarts[ m_runNext ] <= now ) )
+    {
+        // As DoTransmit would have, when the flit started;
+        // arbiters may keep state, so they must still be asked
+        const TocinoArbiterAllocation winner = m_arbiter->Arbitrate();
+
+        NS_ASSERT_MSG( winner == m_runQueue, "Express run lost arbitration?" );
+
+        const TocinoFlit flit =
+            GetOutputQueue( winner.inputPort, winner.outputVC ).Dequeue();
+
+        NS_ASSERT( !flit.IsNull() && !flit.IsHead() );
+
+        m_arbiter->FlitDequeued( winner.inputPort, winner.outputVC );
+
+        if( UsesCredits() )
+        {
+            ConsumeCredit( winner.outputVC );
+        }
+
+        NS_ASSERT( !m_tnd->GetReceiver( winner.inputPort )->HasQueuedFlits() );
+
+        m_runNext++;
+    }
+}
+
+void
+TocinoTx::StopRunFrom( const TocinoInputPort inputPort )
+{
+    if( m_running && ( m_runQueue.inputPort == inputPort ) )
+    {
+        StopRun();
+    }
+}
+
+void
+TocinoTx::StopRun()
+{
+    if( !m_running )
+    {
+        return;
+    }
+
+    CatchUp();
+
+    const uint32_t unstarted = m_runStarts.size() - m_runNext;
+
+    if( unstarted == 0 )
+    {
+        // Every flit is on its way; RunEnd will do
+        return;
+    }
+
+    NS_LOG_LOGIC( "stopping express run, withdrawing " << unstarted << " flits" );
+
+    m_channel->WithdrawExpress( unstarted );
+
+    if( !UsesCredits() )
+    {
+        m_downstreamFlits[ m_runQueue.outputVC.AsUInt32() ] -= unstarted;
+    }
+
+    Simulator::Cancel( m_runEndEvent );
+
+    // Back to one flit at a time, from the end of this one
+    Simulator::Schedule( m_runStarts[ m_runNext ] - Simulator::Now(),
+            &TocinoTx::TransmitEnd, this );
+
+    m_running = false;
+    m_runStarts.clear();
+
+    m_tnd->SetExpressRun( m_outputPort, false );
+}
+
+void
+TocinoTx::RunEnd()
+{
+    m_tnd->CatchUpExpressRuns( TOCINO_INVALID_PORT );
+
+    NS_ASSERT( m_running );
+    NS_ASSERT( m_runNext == m_runStarts.size() );
+
+    m_running = false;
+    m_runStarts.clear();
+
+    m_tnd->SetExpressRun( m_outputPort, false );
+
+    TransmitEnd();
+}
+
 bool
 TocinoTx::CanAcceptFlit(
         const TocinoInputPort inputPort,
@@ -327,7 +809,7 @@ void
 TocinoTx::AcceptFlit(
         const TocinoInputPort inputPort,
         const TocinoOutputVC outputVC,
-        Ptr<Packet> flit )
+        const TocinoFlit& flit )
 {
     NS_LOG_LOGIC( "inputPort=" << inputPort << " outputVC="
             << outputVC << " " << GetTocinoFlitIdString( flit ) );
@@ -337,7 +819,12 @@ TocinoTx::AcceptFlit(
   
     NS_ASSERT( CanAcceptFlit( inputPort, outputVC ) );
 
+    // A competitor for the wire
+    StopRun();
+
     GetOutputQueue( inputPort, outputVC ).Enqueue( flit );
+    
+    m_arbiter->FlitEnqueued( inputPort, outputVC );
 
     // Kick off transmission
     Transmit();
@@ -355,7 +842,7 @@ TocinoTx::IsQueueEmpty(
 }
 
 
-Ptr<const Packet>
+const TocinoFlit&
 TocinoTx::PeekNextFlit( 
         const TocinoInputPort inputPort,
         const TocinoOutputVC outputVC ) const
@@ -373,7 +860,7 @@ TocinoTx::IsNextFlitHead(
         const TocinoInputPort inputPort,
         const TocinoOutputVC outputVC ) const
 {
-    return IsTocinoFlitHead( PeekNextFlit( inputPort, outputVC ) );
+    return PeekNextFlit( inputPort, outputVC ).IsHead();
 }
 
 bool
@@ -381,13 +868,53 @@ TocinoTx::IsNextFlitTail(
         const TocinoInputPort inputPort,
         const TocinoOutputVC outputVC ) const
 {
-    return IsTocinoFlitTail( PeekNextFlit( inputPort, outputVC ) );
+    return PeekNextFlit( inputPort, outputVC ).IsTail();
+}
+
+uint32_t
+TocinoTx::GetOccupancy( const TocinoOutputVC outputVC ) const
+{
+    NS_ASSERT( outputVC < m_tnd->GetNVCs() );
+
+    uint32_t occupancy = 0;
+
+    for( TocinoInputPort inputPort = 0; inputPort < m_tnd->GetNPorts(); ++inputPort )
+    {
+        occupancy += GetOutputQueue( inputPort, outputVC ).Size();
+    }
+
+    return occupancy;
 }
 
 bool
 TocinoTx::AllQuiet() const
 {
     bool quiet = true;
+
+    if( m_running )
+    {
+        NS_LOG_LOGIC( "Not quiet: express run in progress" );
+        quiet = false;
+    }
+
+    if( m_totalPendingCredits > 0 )
+    {
+        NS_LOG_LOGIC( "Not quiet: credits owed to neighbor" );
+        quiet = false;
+    }
+
+    if( UsesCredits() && ( m_channel != NULL ) )
+    {
+        for( TocinoOutputVC outputVC = 0; outputVC < m_tnd->GetNVCs(); ++outputVC )
+        {
+            if( m_credits[ outputVC.AsUInt32() ] != m_tnd->GetInputQueueFlits() )
+            {
+                NS_LOG_LOGIC( "Not quiet: outputVC=" << outputVC
+                        << " has credits outstanding" );
+                quiet = false;
+            }
+        }
+    }
    
     for( TocinoInputPort inputPort = 0; inputPort < m_tnd->GetNPorts(); ++inputPort )
     {
@@ -6,8 +6,11 @@
 
 #include "ns3/ptr.h"
 #include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
 
 #include "tocino-arbiter.h"
+#include "tocino-flit.h"
 #include "tocino-flow-control.h"
 #include "tocino-queue.h"
 
@@ -33,14 +36,46 @@ class TocinoTx
 
     void RemotePause( const TocinoInputVC );
     void RemoteResume( const TocinoInputVC );
+
+    // Credit flow control: credits received from our
+    // neighbor, and a credit owed to it
+    void AddCredits( const TocinoCredits& );
+    void RemoteCredit( const TocinoInputVC );
+
+    // Free buffers downstream, per VC
+    uint32_t GetCredits( const TocinoOutputVC ) const;
+
+    // XON/XOFF flow control: our neighbor has freed an
+    // input buffer holding a flit we sent on this VC
+    void DownstreamFreed( const TocinoInputVC );
+
+    // Could a head flit take this VC now, and keep it to
+    // its tail, without waiting on any other packet?  No
+    // queue owns or waits for the VC, and nothing sent on
+    // it is still buffered downstream.
+    bool IsVCIdle( const TocinoOutputVC ) const;
     
     void SetChannel( Ptr<TocinoChannel> channel );
     Ptr<TocinoChannel> GetChannel() const;
 
+    Ptr<TocinoArbiter> GetArbiter() const;
+
     Ptr<NetDevice> GetNetDevice();
     Ptr<TocinoNetDevice> GetTocinoNetDevice();
     
     void Transmit();
+    
+    // Called at the end of transmission on the wire,
+    // or via TocinoNetDevice::ScheduleTransmitEnd
+    void TransmitEnd();
+
+    // Express mode: perform the arbitration and dequeue of
+    // each flit of our run which has started by now
+    void CatchUp();
+
+    // Express mode: stop our run, if it is fed by the
+    // given input port
+    void StopRunFrom( const TocinoInputPort );
    
     bool CanAcceptFlit(
             const TocinoInputPort,
@@ -49,7 +84,7 @@ class TocinoTx
     void AcceptFlit( 
             const TocinoInputPort,
             const TocinoOutputVC,
-            Ptr<Packet> );
+            const TocinoFlit& );
     
     bool IsQueueEmpty( 
             const TocinoInputPort, 
@@ -63,6 +98,9 @@ class TocinoTx
             const TocinoInputPort, 
             const TocinoOutputVC ) const;
 
+    // Flits queued on an output VC, from all input ports
+    uint32_t GetOccupancy( const TocinoOutputVC ) const;
+
     bool AllQuiet() const;
     void DumpState() const;
 
@@ -70,11 +108,11 @@ class TocinoTx
 
     private:
     
-    Ptr<const Packet> PeekNextFlit(
+    const TocinoFlit& PeekNextFlit(
             const TocinoInputPort, 
             const TocinoOutputVC ) const;
     
-    typedef TocinoQueue< Ptr<Packet> > OutputQueue;
+    typedef TocinoQueue< TocinoFlit > OutputQueue;
 
     OutputQueue& GetOutputQueue( 
             const TocinoInputPort,
@@ -84,10 +122,19 @@ class TocinoTx
             const TocinoInputPort,
             const TocinoOutputVC ) const;
 
-    void SendToChannel( Ptr<Packet> f );
+    void SendToChannel( const TocinoFlit& );
+    void FusedTransmitEnd();
+
+    bool StartRun( const TocinoArbiterAllocation&, const TocinoFlit& );
+    void StopRun();
+    void RunEnd();
     void DoTransmitFlowControl();
+    void DoTransmitCredits();
     void DoTransmit();
-    void TransmitEnd();
+
+    bool UsesCredits() const;
+    bool AreCreditsUrgent() const;
+    void ConsumeCredit( const TocinoOutputVC );
 
     const TocinoOutputPort m_outputPort;
   
@@ -96,12 +143,39 @@ class TocinoTx
     
     TocinoVCBitSet m_doUpdateXState;
 
+    // Under credit flow control, m_xState is derived from
+    // m_credits: a VC is XOFF exactly when it has none
+    std::vector< uint32_t > m_credits;
+
+    // Credits owed to our neighbor, per VC.  These may
+    // exceed what one credit flit can carry.
+    std::vector< uint32_t > m_pendingCredits;
+    uint32_t m_totalPendingCredits;
+
+    // Under XON/XOFF flow control, flits sent on each VC
+    // which our neighbor has yet to free.  Only a local
+    // channel reports them freed (TocinoRx::SetUpstream),
+    // so over a remote one the count never returns to zero.
+    std::vector< uint32_t > m_downstreamFlits;
+
     enum TocinoTransmitterState {IDLE, BUSY} m_state;
  
     TocinoNetDevice* m_tnd;
     Ptr<TocinoChannel> m_channel;
     Ptr<TocinoArbiter> m_arbiter;
 
+    // Express mode, if our channel supports it
+    bool m_express;
+
+    // The run in progress: flits of one packet, sent to the
+    // channel back-to-back, which still wait in m_runQueue
+    // until CatchUp reaches the time each one starts
+    bool m_running;
+    TocinoArbiterAllocation m_runQueue;
+    std::vector< Time > m_runStarts;
+    uint32_t m_runNext;
+    EventId m_runEndEvent;
+
     // This nested class controls access to our
     // primary state variable
     class TocinoOutputQueues
@@ -111,8 +185,10 @@ class TocinoTx
         // The output queues are virtualized per input, to
         // avoid head-of-line blocking.  These queues are
         // mostly for performance.
-        typedef std::vector< OutputQueue > OutputVCVec;
-        std::vector< OutputVCVec > vec;
+        //
+        // All of them live in a single slab, indexed by
+        // ( inputPort * nVCs ) + outputVC.
+        std::vector< OutputQueue > vec;
 
         public:
         
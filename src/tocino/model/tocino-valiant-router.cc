@@ -0,0 +1,328 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include <algorithm>
+
+#include "ns3/log.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+
+#include "tocino-valiant-router.h"
+#include "tocino-misc.h"
+#include "tocino-flit.h"
+#include "tocino-tx.h"
+#include "tocino-flit-id-tag.h"
+
+NS_LOG_COMPONENT_DEFINE ("TocinoValiantRouter");
+
+#ifdef NS_LOG_APPEND_CONTEXT
+#pragma push_macro("NS_LOG_APPEND_CONTEXT")
+#undef NS_LOG_APPEND_CONTEXT
+#define NS_LOG_APPEND_CONTEXT \
+    { std::clog << "(" \
+                << (int) m_tnd->GetTocinoAddress().GetX() << "," \
+                << (int) m_tnd->GetTocinoAddress().GetY() << "," \
+                << (int) m_tnd->GetTocinoAddress().GetZ() << ") " \
+                << m_inputPort << " "; }
+#endif
+
+namespace ns3
+{
+
+NS_OBJECT_ENSURE_REGISTERED (TocinoValiantRouter);
+
+TypeId TocinoValiantRouter::GetTypeId(void)
+{
+    static TypeId tid = TypeId( "ns3::TocinoValiantRouter" )
+        .SetParent<TocinoDimensionOrderRouter>()
+        .AddAttribute( "Mode",
+            "Always take a Valiant path, or choose between it and the minimal path.",
+            EnumValue( VALIANT ),
+            MakeEnumAccessor( &TocinoValiantRouter::m_mode ),
+            MakeEnumChecker(
+                VALIANT, "Valiant",
+                UGAL, "Ugal" ) )
+        .AddAttribute( "Radices",
+            "Extent of each dimension, e.g. \"8,8,4\"; if empty, the WrapAroundRadices.",
+            StringValue( "" ),
+            MakeStringAccessor( &TocinoValiantRouter::SetRadices ),
+            MakeStringChecker() )
+        .AddConstructor<TocinoValiantRouter>();
+    return tid;
+}
+
+TocinoValiantRouter::TocinoValiantRouter()
+    : m_mode( VALIANT )
+{
+    for( uint32_t dim = 0; dim < TOCINO_MAX_DIMENSIONS; ++dim )
+    {
+        m_extent[dim] = 0;
+    }
+
+    m_random = CreateObject<UniformRandomVariable>();
+}
+
+void
+TocinoValiantRouter::SetRadices( std::string radices )
+{
+    ParseRadices( radices, m_extent );
+}
+
+uint32_t
+TocinoValiantRouter::GetRadix( const TocinoDimension dim ) const
+{
+    const uint32_t extent = m_extent[ dim.AsUInt32() ];
+
+    if( extent != 0 )
+    {
+        return extent;
+    }
+
+    return GetWrapAroundRadix( dim );
+}
+
+TocinoAddress
+TocinoValiantRouter::PickIntermediate() const
+{
+    TocinoAddress::Coordinate coord[ TOCINO_MAX_DIMENSIONS ] = { 0 };
+
+    for( TocinoDimension dim = TOCINO_DIMENSION_X;
+            dim < TocinoAddress::MAX_DIM; ++dim )
+    {
+        const uint32_t radix = GetRadix( dim );
+
+        if( radix > 1 )
+        {
+            coord[ dim.AsUInt32() ] = m_random->GetInteger( 0, radix - 1 );
+        }
+    }
+
+    return TocinoAddress( coord[0], coord[1], coord[2], coord[3] );
+}
+
+uint32_t
+TocinoValiantRouter::CountHops(
+        const TocinoAddress& a,
+        const TocinoAddress& b ) const
+{
+    uint32_t hops = 0;
+
+    for( TocinoDimension dim = TOCINO_DIMENSION_X;
+            dim < TocinoAddress::MAX_DIM; ++dim )
+    {
+        const int32_t delta = a.GetCoordinate( dim ) - b.GetCoordinate( dim );
+        const uint32_t distance = abs( delta );
+
+        if( TopologyHasWrapAround( dim ) )
+        {
+            hops += std::min( distance, GetWrapAroundRadix( dim ) - distance );
+        }
+        else
+        {
+            hops += distance;
+        }
+    }
+
+    return hops;
+}
+
+uint32_t
+TocinoValiantRouter::GetFirstHopOccupancy( const TocinoAddress& addr ) const
+{
+    const TocinoAddress localAddr = m_tnd->GetTocinoAddress();
+
+    TocinoDimension dim;
+
+    for( dim = TOCINO_DIMENSION_X; dim < TocinoAddress::MAX_DIM; ++dim )
+    {
+        if( localAddr.GetCoordinate( dim ) != addr.GetCoordinate( dim ) )
+        {
+            break;
+        }
+    }
+
+    NS_ASSERT( dim < TocinoAddress::MAX_DIM );
+
+    const TocinoDirection dir = DetermineRoutingDirection(
+            localAddr.GetCoordinate( dim ), addr.GetCoordinate( dim ), dim );
+
+    const TocinoTx* tx = m_tnd->GetTransmitter( TocinoGetPort( dim, dir ) );
+
+    uint32_t occupancy = 0;
+
+    for( TocinoOutputVC vc = 0; vc < m_tnd->GetNVCs(); ++vc )
+    {
+        occupancy += tx->GetOccupancy( vc );
+    }
+
+    return occupancy;
+}
+
+bool
+TocinoValiantRouter::PreferMinimal(
+        const TocinoAddress& destAddr,
+        const TocinoAddress& intermediate ) const
+{
+    const TocinoAddress localAddr = m_tnd->GetTocinoAddress();
+
+    if( ( intermediate == localAddr ) || ( intermediate == destAddr ) )
+    {
+        // The Valiant path is the minimal one
+        return true;
+    }
+
+    const uint32_t minimalCost =
+        CountHops( localAddr, destAddr ) * GetFirstHopOccupancy( destAddr );
+
+    const uint32_t valiantCost =
+        ( CountHops( localAddr, intermediate ) + CountHops( intermediate, destAddr ) )
+        * GetFirstHopOccupancy( intermediate );
+
+    // Ties go minimal, so an idle network routes minimally
+    return minimalCost <= valiantCost;
+}
+
+void
+TocinoValiantRouter::PrepareHead( TocinoFlit& flit )
+{
+    NS_ASSERT( flit.IsHead() );
+
+    // N.B.
+    // Packets already bounced by TocinoNetDevice::SendVia
+    // arrive MINIMAL, and are left alone.
+    if( flit.GetType() == TocinoFlitHeader::ENCAPSULATED_PACKET )
+    {
+        return;
+    }
+
+    const TocinoAddress localAddr = m_tnd->GetTocinoAddress();
+    const TocinoAddress destAddr = flit.GetDestination();
+
+    if( m_inputPort == m_tnd->GetHostPort() )
+    {
+        NS_ASSERT( flit.GetValiantPhase() == TocinoFlitHeader::MINIMAL );
+
+        if( destAddr == localAddr )
+        {
+            return;
+        }
+
+        TocinoAddress intermediate = PickIntermediate();
+
+        if( ( m_mode == UGAL ) && PreferMinimal( destAddr, intermediate ) )
+        {
+            NS_LOG_LOGIC( "UGAL chose the minimal path" );
+
+            // Turn around right here
+            intermediate = localAddr;
+        }
+
+        flit.SetValiantRoute( intermediate, TocinoFlitHeader::TO_INTERMEDIATE );
+    }
+
+    if( ( flit.GetValiantPhase() == TocinoFlitHeader::TO_INTERMEDIATE ) &&
+        ( flit.GetIntermediate() == localAddr ) )
+    {
+        NS_LOG_LOGIC( "reached intermediate, turning for destination" );
+
+        flit.SetValiantRoute( localAddr, TocinoFlitHeader::FROM_INTERMEDIATE );
+    }
+}
+
+TocinoRoute
+TocinoValiantRouter::Route( const TocinoFlit& flit ) const 
+{
+    NS_ASSERT( !flit.IsNull() );
+    
+    NS_LOG_FUNCTION( GetTocinoFlitIdString( flit ) );
+    NS_ASSERT( flit.IsHead() );
+
+    const TocinoFlitHeader::ValiantPhase phase = flit.GetValiantPhase();
+
+    if( phase == TocinoFlitHeader::MINIMAL )
+    {
+        return TocinoDimensionOrderRouter::Route( flit );
+    }
+
+    const TocinoInputVC inputVC = flit.GetVirtualChannel();
+
+    const TocinoVCAllocator& vca = m_tnd->GetVCAllocator();
+
+    NS_ASSERT_MSG( vca.GetPairs( vca.GetClass( inputVC ), TocinoVCAllocator::SECOND_LEG ) > 0,
+            "Valiant routing needs a VC pair per phase" );
+
+    const TocinoAddress localAddr = m_tnd->GetTocinoAddress();
+
+    const TocinoAddress targetAddr =
+        ( phase == TocinoFlitHeader::TO_INTERMEDIATE ) ?
+        flit.GetIntermediate() : flit.GetDestination();
+
+    if( targetAddr == localAddr )
+    {
+        // PrepareHead turns packets at the intermediate
+        NS_ASSERT( phase == TocinoFlitHeader::FROM_INTERMEDIATE );
+
+        return TocinoRoute( m_tnd->GetHostPort(), inputVC, inputVC.AsUInt32() );
+    }
+
+    TocinoDimension outputDim;
+
+    for( outputDim = TOCINO_DIMENSION_X;
+            outputDim < TocinoAddress::MAX_DIM; ++outputDim )
+    {
+        if( localAddr.GetCoordinate( outputDim ) != targetAddr.GetCoordinate( outputDim ) )
+        {
+            break;
+        }
+    }
+
+    NS_ASSERT( outputDim < TocinoAddress::MAX_DIM );
+
+    const TocinoAddress::Coordinate localCoord = localAddr.GetCoordinate( outputDim );
+
+    const bool injecting = ( m_inputPort == m_tnd->GetHostPort() );
+
+    // Turning at the intermediate starts afresh, on the
+    // second phase's VCs, even in the same dimension
+    const bool turning =
+        ( phase == TocinoFlitHeader::FROM_INTERMEDIATE ) &&
+        !vca.IsSecondLeg( inputVC );
+
+    const bool fresh = injecting || turning ||
+        ( TocinoGetDimension( m_inputPort ) != outputDim );
+
+    TocinoDirection outputDir;
+
+    if( fresh )
+    {
+        outputDir = DetermineRoutingDirection(
+                localCoord, targetAddr.GetCoordinate( outputDim ), outputDim );
+    }
+    else
+    {
+        // Continue in the same direction
+        outputDir = TocinoGetOppositeDirection( TocinoGetDirection( m_inputPort ) );
+    }
+
+    const bool crossesDateline = TopologyHasWrapAround( outputDim ) &&
+        RouteCrossesDateline( localCoord, outputDir, outputDim );
+
+    const TocinoVC pairBase = vca.MoveToLeg( inputVC,
+            ( phase == TocinoFlitHeader::TO_INTERMEDIATE ) ?
+            TocinoVCAllocator::FIRST_LEG : TocinoVCAllocator::SECOND_LEG );
+
+    // Dateline algorithm, within the pair of this phase
+    TocinoOutputVC outputVC = inputVC.AsUInt32();
+
+    if( fresh )
+    {
+        outputVC = pairBase;
+    }
+
+    if( crossesDateline )
+    {
+        outputVC = vca.CrossDateline( pairBase );
+    }
+
+    return TocinoRoute( TocinoGetPort( outputDim, outputDir ), inputVC, outputVC );
+}
+
+}
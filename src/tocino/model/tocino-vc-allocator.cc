@@ -0,0 +1,211 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#include <sstream>
+
+#include "ns3/abort.h"
+#include "ns3/assert.h"
+
+#include "tocino-vc-allocator.h"
+
+namespace ns3
+{
+
+TocinoVCAllocator::TocinoVCAllocator()
+    : m_nVCs( 0 )
+{}
+
+void
+TocinoVCAllocator::Initialize( const uint32_t nVCs, const std::string& classes )
+{
+    NS_ASSERT( nVCs > 0 );
+
+    m_nVCs = nVCs;
+    m_base.clear();
+    m_count.clear();
+
+    std::istringstream iss( classes );
+    std::string token;
+
+    uint32_t total = 0;
+
+    while( std::getline( iss, token, ',' ) )
+    {
+        std::istringstream tss( token );
+        uint32_t count = 0;
+
+        tss >> count;
+        NS_ABORT_MSG_IF( tss.fail() || count == 0,
+                "Bad VC count in \"" << classes << "\"" );
+
+        m_base.push_back( total );
+        m_count.push_back( count );
+
+        total += count;
+    }
+
+    if( m_count.empty() )
+    {
+        m_base.push_back( 0 );
+        m_count.push_back( m_nVCs );
+
+        total = m_nVCs;
+    }
+
+    NS_ABORT_MSG_IF( total != m_nVCs,
+            "VCClasses \"" << classes << "\" must cover exactly "
+            << m_nVCs << " VCs" );
+
+    // N.B.
+    // Dateline pairs must not straddle two classes.  A
+    // lone class may have an odd VC out, which can never
+    // carry a flit across a dateline.
+    if( m_count.size() > 1 )
+    {
+        for( uint32_t cls = 0; cls < m_count.size(); ++cls )
+        {
+            NS_ABORT_MSG_IF( m_count[cls] % 2 != 0,
+                    "VCClasses \"" << classes << "\" must give each class whole VC pairs" );
+        }
+    }
+
+    m_class.resize( m_nVCs );
+
+    for( uint32_t cls = 0; cls < m_count.size(); ++cls )
+    {
+        for( uint32_t i = 0; i < m_count[cls]; ++i )
+        {
+            m_class[ m_base[cls] + i ] = cls;
+        }
+    }
+}
+
+uint32_t
+TocinoVCAllocator::GetNClasses() const
+{
+    return m_count.size();
+}
+
+uint32_t
+TocinoVCAllocator::GetClass( const TocinoVC vc ) const
+{
+    NS_ASSERT( vc < m_nVCs );
+    return m_class[ vc.AsUInt32() ];
+}
+
+TocinoVC
+TocinoVCAllocator::GetClassBase( const uint32_t cls ) const
+{
+    NS_ASSERT( cls < GetNClasses() );
+    return m_base[cls];
+}
+
+uint32_t
+TocinoVCAllocator::GetClassVCs( const uint32_t cls ) const
+{
+    NS_ASSERT( cls < GetNClasses() );
+    return m_count[cls];
+}
+
+uint32_t
+TocinoVCAllocator::GetFirstLegPairs( const uint32_t cls ) const
+{
+    const uint32_t PAIRS = ( m_count[cls] + 1 ) / 2;
+
+    return PAIRS - PAIRS / 2;
+}
+
+uint32_t
+TocinoVCAllocator::GetFirstPair( const uint32_t cls, const Leg leg ) const
+{
+    return ( leg == SECOND_LEG ) ? GetFirstLegPairs( cls ) : 0;
+}
+
+uint32_t
+TocinoVCAllocator::GetPairs( const uint32_t cls, const Leg leg ) const
+{
+    NS_ASSERT( cls < GetNClasses() );
+
+    const uint32_t PAIRS = ( m_count[cls] + 1 ) / 2;
+
+    switch( leg )
+    {
+        case FIRST_LEG:
+            return GetFirstLegPairs( cls );
+        case SECOND_LEG:
+            return PAIRS - GetFirstLegPairs( cls );
+        default:
+            return PAIRS;
+    }
+}
+
+TocinoVC
+TocinoVCAllocator::GetPairBase(
+        const uint32_t cls,
+        const Leg leg,
+        const uint32_t i ) const
+{
+    NS_ASSERT( i < GetPairs( cls, leg ) );
+
+    return m_base[cls] + 2 * ( GetFirstPair( cls, leg ) + i );
+}
+
+TocinoVC
+TocinoVCAllocator::GetInjectionVC(
+        const uint32_t cls,
+        const Leg leg,
+        const uint32_t counter ) const
+{
+    const uint32_t PAIRS = GetPairs( cls, leg );
+
+    NS_ASSERT_MSG( PAIRS > 0, "Class " << cls << " has no VC pair for this leg" );
+
+    return GetPairBase( cls, leg, counter % PAIRS );
+}
+
+uint32_t
+TocinoVCAllocator::GetPairIndex( const TocinoVC vc ) const
+{
+    const uint32_t cls = GetClass( vc );
+
+    return ( vc.AsUInt32() - m_base[cls] ) / 2;
+}
+
+TocinoVC
+TocinoVCAllocator::ResetDateline( const TocinoVC vc ) const
+{
+    const uint32_t cls = GetClass( vc );
+
+    return m_base[cls] + 2 * GetPairIndex( vc );
+}
+
+TocinoVC
+TocinoVCAllocator::CrossDateline( const TocinoVC vc ) const
+{
+    NS_ASSERT_MSG( ResetDateline( vc ) == vc,
+            "Flit on VC " << vc << " has already crossed the dateline!" );
+
+    const TocinoVC high = vc.AsUInt32() + 1;
+
+    NS_ASSERT_MSG( high < m_nVCs && GetClass( high ) == GetClass( vc ),
+            "Flit on last VC of its class cannot cross dateline!" );
+
+    return high;
+}
+
+bool
+TocinoVCAllocator::IsSecondLeg( const TocinoVC vc ) const
+{
+    return GetPairIndex( vc ) >= GetFirstLegPairs( GetClass( vc ) );
+}
+
+TocinoVC
+TocinoVCAllocator::MoveToLeg( const TocinoVC vc, const Leg leg ) const
+{
+    const uint32_t cls = GetClass( vc );
+    const uint32_t PAIRS = GetPairs( cls, leg );
+
+    NS_ASSERT_MSG( PAIRS > 0, "Class " << cls << " has no VC pair for this leg" );
+
+    return GetPairBase( cls, leg, GetPairIndex( vc ) % PAIRS );
+}
+
+}
@@ -111,5 +111,11 @@ TestTocino3DTorusAllToAll::DoRun()
     TestHelper( Seconds( 0.5 ), 123 );
     TestHelper( Seconds( 0.5 ), 32 );
 
+    Config::SetDefault( 
+            "ns3::TocinoNetDevice::LightweightFlits",
+            BooleanValue( true ) );
+    
+    TestHelper( Seconds( 0.5 ), 123 );
+
     Config::Reset();
 }
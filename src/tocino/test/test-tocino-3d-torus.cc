@@ -29,28 +29,16 @@ TestTocino3DTorus::CheckAllQuiet(
 {
     bool aq = true;
 
-    for( uint32_t x = 0; x < RADIX; x++ )
+    for( uint32_t i = 0; i < netDevices.size(); i++ )
     { 
-        for( uint32_t y = 0; y < RADIX; y++ )
-        { 
-            for( uint32_t z = 0; z < RADIX; z++ )
-            {
-                aq &= netDevices[x][y][z]->AllQuiet();
-            }
-        }
+        aq &= netDevices[i]->AllQuiet();
     }
   
     if( aq ) return;
 
-    for( uint32_t x = 0; x < RADIX; x++ )
+    for( uint32_t i = 0; i < netDevices.size(); i++ )
     { 
-        for( uint32_t y = 0; y < RADIX; y++ )
-        { 
-            for( uint32_t z = 0; z < RADIX; z++ )
-            {
-                netDevices[x][y][z]->DumpState();
-            }
-        }
+        netDevices[i]->DumpState();
     }
 
     NS_TEST_ASSERT_MSG_EQ( aq, true, "not all quiet?" );
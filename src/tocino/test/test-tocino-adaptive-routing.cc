@@ -0,0 +1,245 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include <vector>
+
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/type-id.h"
+#include "ns3/simulator.h"
+
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-channel.h"
+#include "ns3/tocino-adaptive-router.h"
+#include "ns3/tocino-test-results.h"
+#include "ns3/tocino-torus-topology-helper.h"
+#include "ns3/tocino-traffic-patterns.h"
+
+#include "test-tocino-adaptive-routing.h"
+
+using namespace ns3;
+
+TestTocinoAdaptiveRouting::TestTocinoAdaptiveRouting(
+        uint32_t radix,
+        bool doWrap )
+    : TestTocino3DTorus( radix, doWrap, false, " with adaptive routing" )
+{}
+
+void
+TestTocinoAdaptiveRouting::SetAllToAll()
+{
+    m_trafficMatrix.resize( NODES );
+    
+    for( uint32_t src = 0; src < NODES; ++src )
+    {
+        m_trafficMatrix[src].assign( NODES, TOCINO_TOTAL_TRAFFIC/NODES );
+    }
+}
+
+void
+TestTocinoAdaptiveRouting::SetSingleFlow(
+        const uint32_t src,
+        const uint32_t dst )
+{
+    m_trafficMatrix.resize( NODES );
+    
+    for( uint32_t i = 0; i < NODES; ++i )
+    {
+        m_trafficMatrix[i].assign( NODES, 0 );
+    }
+
+    m_trafficMatrix[src][dst] = TOCINO_TOTAL_TRAFFIC;
+}
+
+void
+TestTocinoAdaptiveRouting::TestHelper(
+        const Time meanTimeBetweenSends,
+        const Time testDuration,
+        const unsigned BYTES,
+        const TocinoPort port,
+        uint32_t& portBytes )
+{
+    NodeContainer machines;
+    TocinoTestResults results;
+    AppVector applications;
+    
+    TocinoCustomizeLogging();
+    
+    machines.Create( NODES );
+    
+    Tocino3DTorusNetDeviceContainer netDevices =
+        m_helper.Install( machines );
+  
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        Ptr<TocinoTrafficMatrixApplication> app =
+                CreateObject<TocinoTrafficMatrixApplication>();
+    
+        applications.push_back(app);
+
+        app->Initialize( node, &machines, m_trafficMatrix );
+
+        app->SetReceiveCallback( 
+                MakeCallback( &TocinoTestResults::AcceptPacket, &results ) );
+        
+        app->SetAttribute( "MeanTimeBetweenSends", TimeValue( meanTimeBetweenSends ) );
+
+        app->SetStartTime( Seconds( 0.0 ) );
+        app->SetStopTime( testDuration );
+        app->SetPacketSize( BYTES );
+        
+        machines.Get( node )->AddApplication( app );
+    }
+
+    Simulator::Run();
+
+    CheckAllQuiet( netDevices );
+   
+    const uint32_t TOTAL_PACKETS = GetTotalPacketsSent( applications );
+
+    NS_TEST_ASSERT_MSG_GT( TOTAL_PACKETS, 0, "No packets sent" );
+
+    NS_TEST_ASSERT_MSG_EQ(
+            results.GetTotalCount(),
+            TOTAL_PACKETS,
+            "Unexpected total packet count" );
+
+    NS_TEST_ASSERT_MSG_EQ(
+            results.GetTotalBytes(),
+            BYTES * TOTAL_PACKETS,
+            "Unexpected total packet bytes" );
+
+    portBytes = netDevices[0]->GetChannel( port.AsUInt32() )->GetTotalBytesTransmitted();
+
+    Simulator::Destroy();
+}
+
+void
+TestTocinoAdaptiveRouting::TestTornado( const std::string& flowControl )
+{
+    // Each node sends halfway around X, the worst case for
+    // a ring; adaptive VCs then fill in cycles, and only
+    // the escape VCs can drain them
+    TocinoTorusTopologyHelper helper(
+            std::vector< uint32_t >( 2, 8 ),
+            std::vector< bool >( 2, true ) );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::WrapAroundRadices",
+            StringValue( helper.GetWrapAroundRadices() ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::RouterType",
+            TypeIdValue( TocinoAdaptiveRouter::GetTypeId() ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::FlowControl",
+            StringValue( flowControl ) );
+
+    // Offered load beyond saturation must back up into
+    // the senders, not into unbounded injection queues
+    Config::SetDefault( "ns3::TocinoNetDevice::InjectionQueueMaxFlits",
+            UintegerValue( 32 ) );
+
+    const TocinoSparseTrafficMatrix trafficMatrix =
+        TocinoTrafficPatterns( helper ).Tornado();
+
+    NodeContainer machines;
+    machines.Create( helper.NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+    // 1500 bytes every 187.5ns offers 64 Gbps per node
+    const uint32_t BYTES = 1500;
+    const Time MEAN = PicoSeconds( 187500 );
+
+    AppVector applications;
+
+    for( uint32_t node = 0; node < helper.NODES; ++node )
+    {
+        Ptr<TocinoTrafficMatrixApplication> app =
+            CreateObject<TocinoTrafficMatrixApplication>();
+
+        applications.push_back( app );
+
+        app->Initialize( node, &machines, trafficMatrix );
+        app->AssignStreams( node * 2 );
+
+        app->SetAttribute( "MeanTimeBetweenSends", TimeValue( MEAN ) );
+        app->SetAttribute( "MaxTimeBetweenSends", TimeValue( MEAN * 10 ) );
+
+        app->SetStartTime( Seconds( 0 ) );
+        app->SetStopTime( MicroSeconds( 120 ) );
+        app->SetPacketSize( BYTES );
+
+        machines.Get( node )->AddApplication( app );
+    }
+
+    Simulator::Run();
+
+    CheckAllQuiet( netDevices );
+
+    uint32_t sent = 0;
+    uint32_t received = 0;
+
+    for( uint32_t node = 0; node < helper.NODES; ++node )
+    {
+        sent += applications[node]->GetPacketsSent();
+        received += applications[node]->GetPacketsReceived();
+    }
+
+    NS_TEST_ASSERT_MSG_GT( sent, 0, flowControl << ": no packets sent" );
+    NS_TEST_ASSERT_MSG_EQ( received, sent, flowControl << ": packets lost" );
+
+    Simulator::Destroy();
+    Config::Reset();
+}
+
+void
+TestTocinoAdaptiveRouting::DoRun()
+{
+    if( m_doWrap )
+    {
+        Config::SetDefault( 
+                "ns3::TocinoDimensionOrderRouter::EnableWrapAround",
+                UintegerValue( RADIX ) );
+    }
+
+    // A single saturating flow from node zero to (1,1,0);
+    // dimension order only ever leaves via X+
+    const uint32_t DEST = m_helper.CoordinatesToIndex( 1, 1, 0 );
+    
+    const Time SATURATING = NanoSeconds( 5 );
+    const Time SHORT = MicroSeconds( 20 );
+
+    SetSingleFlow( 0, DEST );
+
+    uint32_t dorBytes = 0;
+    TestHelper( SATURATING, SHORT, 123, TOCINO_PORT_Y_POS, dorBytes );
+
+    NS_TEST_ASSERT_MSG_EQ( dorBytes, 0,
+            "Dimension-order routing should not use Y+ first" );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::RouterType",
+            TypeIdValue( TocinoAdaptiveRouter::GetTypeId() ) );
+
+    uint32_t adaptiveBytes = 0;
+    TestHelper( SATURATING, SHORT, 123, TOCINO_PORT_Y_POS, adaptiveBytes );
+
+    NS_TEST_ASSERT_MSG_GT( adaptiveBytes, 0,
+            "Adaptive routing should spill onto Y+ when X+ is busy" );
+
+    // Everything must still be delivered, under heavy load
+    SetAllToAll();
+
+    uint32_t unused = 0;
+    TestHelper( Seconds( 0.001 ), Seconds( 0.1 ), 123, TOCINO_PORT_X_POS, unused );
+    TestHelper( NanoSeconds( 50 ), SHORT, 20, TOCINO_PORT_X_POS, unused );
+    TestHelper( NanoSeconds( 50 ), SHORT, 123, TOCINO_PORT_X_POS, unused );
+
+    Config::Reset();
+
+    if( m_doWrap )
+    {
+        TestTornado( "XonXoff" );
+        TestTornado( "Credit" );
+    }
+}
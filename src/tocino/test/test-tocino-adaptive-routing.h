@@ -0,0 +1,42 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_ADAPTIVE_ROUTING_H__
+#define __TEST_TOCINO_ADAPTIVE_ROUTING_H__
+
+#include <stdint.h>
+#include <string>
+
+#include "test-tocino-3d-torus.h"
+
+namespace ns3
+{
+
+class TestTocinoAdaptiveRouting : public TestTocino3DTorus
+{
+    public:
+
+    TestTocinoAdaptiveRouting( uint32_t radix, bool doWrap );
+
+    private:
+
+    void SetAllToAll();
+    void SetSingleFlow( const uint32_t, const uint32_t );
+
+    // Runs m_trafficMatrix, returns bytes sent by node
+    // zero on the given port
+    void TestHelper(
+            const Time,
+            const Time,
+            const unsigned,
+            const TocinoPort,
+            uint32_t& );
+
+    // Tornado traffic at far beyond saturation, on an 8x8
+    // torus, under the given flow control
+    void TestTornado( const std::string& );
+
+    virtual void DoRun();
+};
+
+}
+
+#endif // __TEST_TOCINO_ADAPTIVE_ROUTING_H__
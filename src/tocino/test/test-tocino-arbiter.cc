@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/config.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+
+#include "ns3/tocino-bitmask-arbiter.h"
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-simple-arbiter.h"
+#include "ns3/tocino-test-results.h"
+
+#include "test-tocino-arbiter.h"
+
+using namespace ns3;
+
+TestTocinoArbiter::TestTocinoArbiter( uint32_t radix )
+    : TestTocino3DTorus( radix, true, false, " comparing arbiters" )
+{
+    m_trafficMatrix.resize( NODES );
+
+    for( uint32_t src = 0; src < NODES; ++src )
+    {
+        m_trafficMatrix[src].resize( NODES );
+
+        for( uint32_t dst = 0; dst < NODES; ++dst )
+        {
+            m_trafficMatrix[src][dst] =
+                TOCINO_TOTAL_TRAFFIC/NODES;
+        }
+    }
+}
+
+void
+TestTocinoArbiter::TestHelper(
+        const TypeId arbiterType,
+        CountVector& counts,
+        const unsigned BYTES )
+{
+    NodeContainer machines;
+    TocinoTestResults results;
+    AppVector applications;
+
+    TocinoCustomizeLogging();
+
+    Config::SetDefault( "ns3::TocinoNetDevice::ArbiterType",
+            TypeIdValue( arbiterType ) );
+
+    machines.Create( NODES );
+
+    Tocino3DTorusNetDeviceContainer netDevices =
+        m_helper.Install( machines );
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        Ptr<TocinoTrafficMatrixApplication> app =
+                CreateObject<TocinoTrafficMatrixApplication>();
+
+        applications.push_back(app);
+
+        app->Initialize( node, &machines, m_trafficMatrix );
+        app->ResetStatistics();
+
+        // Offer identical traffic regardless of arbiter
+        app->AssignStreams( node * 2 );
+
+        app->SetReceiveCallback(
+                MakeCallback( &TocinoTestResults::AcceptPacket, &results ) );
+
+        app->SetStartTime( Seconds( 0.0 ) );
+        app->SetStopTime( Seconds( 0.2 ) );
+        app->SetPacketSize( BYTES );
+
+        machines.Get( node )->AddApplication( app );
+    }
+
+    Simulator::Run();
+
+    CheckAllQuiet( netDevices );
+
+    const uint32_t TOTAL_PACKETS = GetTotalPacketsSent( applications );
+
+    NS_TEST_ASSERT_MSG_EQ(
+            results.GetTotalCount(),
+            TOTAL_PACKETS,
+            "Unexpected total packet count" );
+
+    NS_TEST_ASSERT_MSG_EQ(
+            results.GetTotalBytes(),
+            BYTES * TOTAL_PACKETS,
+            "Unexpected total packet bytes" );
+
+    counts.clear();
+
+    for( uint32_t src = 0; src < NODES; ++src )
+    {
+        for( uint32_t dst = 0; dst < NODES; ++dst )
+        {
+            counts.push_back(
+                    results.GetCount(
+                        m_helper.IndexToTocinoAddress( src ),
+                        m_helper.IndexToTocinoAddress( dst ) ) );
+        }
+    }
+
+    Simulator::Destroy();
+}
+
+void
+TestTocinoArbiter::DoRun()
+{
+    const unsigned BYTES = 123;
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::EnableWrapAround",
+            UintegerValue( RADIX ) );
+
+    CountVector simple;
+    TestHelper( TocinoSimpleArbiter::GetTypeId(), simple, BYTES );
+
+    CountVector roundRobin;
+    TestHelper( TocinoBitmaskArbiter::GetTypeId(), roundRobin, BYTES );
+
+    Config::SetDefault( "ns3::TocinoBitmaskArbiter::Priority",
+            EnumValue( TocinoBitmaskArbiter::LFSR ) );
+
+    CountVector lfsr;
+    TestHelper( TocinoBitmaskArbiter::GetTypeId(), lfsr, BYTES );
+
+    // N.B.
+    // Every arbiter must deliver all of the same offered
+    // traffic; this says nothing of the order in which they
+    // pick winners.  TestTocinoBitmaskArbiter checks that.
+    NS_TEST_ASSERT_MSG_EQ( simple.size(), NODES * NODES,
+            "Unexpected result size" );
+
+    for( uint32_t i = 0; i < simple.size(); ++i )
+    {
+        NS_TEST_ASSERT_MSG_EQ( roundRobin[i], simple[i],
+                "Round-robin bitmask arbiter delivered a different count" );
+
+        NS_TEST_ASSERT_MSG_EQ( lfsr[i], simple[i],
+                "LFSR bitmask arbiter delivered a different count" );
+    }
+
+    Config::Reset();
+}
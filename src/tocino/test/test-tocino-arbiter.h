@@ -0,0 +1,32 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_ARBITER_H__
+#define __TEST_TOCINO_ARBITER_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/type-id.h"
+
+#include "test-tocino-3d-torus.h"
+
+namespace ns3
+{
+
+class TestTocinoArbiter : public TestTocino3DTorus
+{
+    public:
+
+    TestTocinoArbiter( uint32_t radix );
+
+    private:
+
+    typedef std::vector< uint32_t > CountVector;
+
+    void TestHelper( const TypeId, CountVector&, const unsigned );
+
+    virtual void DoRun();
+};
+
+}
+
+#endif // __TEST_TOCINO_ARBITER_H__
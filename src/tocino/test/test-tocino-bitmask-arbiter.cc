@@ -0,0 +1,619 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include <vector>
+
+#include "ns3/config.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/type-id.h"
+#include "ns3/simulator.h"
+#include "ns3/ethernet-header.h"
+#include "ns3/ethernet-trailer.h"
+
+#include "ns3/tocino-channel.h"
+#include "ns3/tocino-flit.h"
+#include "ns3/tocino-flit-header.h"
+#include "ns3/tocino-flow-control.h"
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-tx.h"
+
+#include "test-tocino-bitmask-arbiter.h"
+
+using namespace ns3;
+
+namespace
+{
+
+// A lone TocinoTx for the ejection port of an unconnected
+// TocinoNetDevice, whose arbiter is the one under test.
+//
+// N.B.
+// Once it has sent a flit the transmitter stays BUSY, as
+// nothing ends the transmission until we call TransmitEnd.
+// Each Step() therefore arbitrates exactly once.  We tell
+// the winner from the output VC whose occupancy fell, and
+// the input port from who owns that VC just after a head
+// or body flit, or just before a tail.  Every packet has at
+// least two flits, so there is always an owner to see.
+class ArbiterBench
+{
+    public:
+
+    ArbiterBench( const TocinoBitmaskArbiter::Priority, const uint32_t seed );
+    ~ArbiterBench();
+
+    // Queue one packet of the given length in flits; no
+    // VC may send before Start()
+    void Enqueue(
+            const TocinoInputPort,
+            const TocinoOutputVC,
+            const uint32_t flits );
+
+    // The first arbitration, with the given VCs XON
+    TocinoArbiterAllocation Start(
+            const TocinoFlowControlState& = TocinoAllXON );
+
+    // The next arbitration, as at the end of a transmission
+    TocinoArbiterAllocation Step();
+
+    // Change the VCs which are XON; resuming one while the
+    // transmitter is idle arbitrates, as it would on a link
+    TocinoArbiterAllocation SetXState( const TocinoFlowControlState& );
+
+    TocinoArbiterAllocation GetVCOwner( const TocinoOutputVC ) const;
+
+    uint32_t GetOccupancy( const TocinoOutputVC ) const;
+
+    uint32_t GetNPorts() const;
+
+    uint32_t GetPacketsEnqueued() const;
+    uint32_t GetPacketsEjected() const;
+
+    private:
+
+    struct Snapshot
+    {
+        std::vector< uint32_t > occupancy;
+        std::vector< TocinoArbiterAllocation > owners;
+    };
+
+    Snapshot Take() const;
+    TocinoArbiterAllocation Winner( const Snapshot& before ) const;
+
+    bool Eject( Ptr<NetDevice>, Ptr<const Packet>, uint16_t, const Address& );
+
+    Ptr<TocinoNetDevice> m_tnd;
+    TocinoTx* m_tx;
+
+    uint32_t m_enqueued;
+    uint32_t m_ejected;
+};
+
+ArbiterBench::ArbiterBench(
+        const TocinoBitmaskArbiter::Priority priority,
+        const uint32_t seed )
+    : m_tx( NULL )
+    , m_enqueued( 0 )
+    , m_ejected( 0 )
+{
+    Config::SetDefault( "ns3::TocinoNetDevice::ArbiterType",
+            TypeIdValue( TocinoBitmaskArbiter::GetTypeId() ) );
+
+    Config::SetDefault( "ns3::TocinoBitmaskArbiter::Priority",
+            EnumValue( priority ) );
+
+    Config::SetDefault( "ns3::TocinoBitmaskArbiter::Seed",
+            UintegerValue( seed ) );
+
+    m_tnd = CreateObject<TocinoNetDevice>();
+    m_tnd->Initialize();
+
+    m_tnd->SetReceiveCallback( MakeCallback( &ArbiterBench::Eject, this ) );
+
+    m_tx = new TocinoTx( m_tnd->GetHostPort(), PeekPointer( m_tnd ) );
+
+    // Hold everything until Start()
+    m_tx->SetXState( ~TocinoAllXON );
+}
+
+ArbiterBench::~ArbiterBench()
+{
+    // Let the device finish its deferred work, so it is
+    // quiet when disposed
+    Simulator::Run();
+    Simulator::Destroy();
+
+    delete m_tx;
+}
+
+void
+ArbiterBench::Enqueue(
+        const TocinoInputPort inputPort,
+        const TocinoOutputVC outputVC,
+        const uint32_t flits )
+{
+    NS_ASSERT( flits >= 2 );
+
+    const TocinoAddress src( inputPort.AsUInt32() + 1 );
+    const TocinoAddress dst = m_tnd->GetTocinoAddress();
+
+    EthernetHeader eh( false );
+    EthernetTrailer et;
+
+    eh.SetSource( src.AsMac48Address() );
+    eh.SetDestination( dst.AsMac48Address() );
+
+    // One byte into the last flit
+    const uint32_t BYTES = TocinoFlitHeader::MAX_PAYLOAD_HEAD +
+        ( flits - 2 ) * TocinoFlitHeader::MAX_PAYLOAD_OTHER + 1;
+
+    Ptr<Packet> p = Create<Packet>(
+            BYTES - eh.GetSerializedSize() - et.GetSerializedSize() );
+
+    p->AddHeader( eh );
+    p->AddTrailer( et );
+
+    TocinoFlitQueue q = m_tnd->LightweightFlitter(
+            p, src, dst, outputVC.AsUInt32(), TocinoFlitHeader::ETHERNET );
+
+    NS_ASSERT( q.size() == flits );
+
+    for( uint32_t i = 0; i < q.size(); ++i )
+    {
+        NS_ASSERT( m_tx->CanAcceptFlit( inputPort, outputVC ) );
+
+        m_tx->AcceptFlit( inputPort, outputVC, q[i] );
+    }
+
+    m_enqueued++;
+}
+
+TocinoArbiterAllocation
+ArbiterBench::Start( const TocinoFlowControlState& xState )
+{
+    return SetXState( xState );
+}
+
+TocinoArbiterAllocation
+ArbiterBench::Step()
+{
+    const Snapshot before = Take();
+
+    m_tx->TransmitEnd();
+
+    return Winner( before );
+}
+
+TocinoArbiterAllocation
+ArbiterBench::SetXState( const TocinoFlowControlState& xState )
+{
+    const Snapshot before = Take();
+
+    m_tx->SetXState( xState );
+
+    return Winner( before );
+}
+
+TocinoArbiterAllocation
+ArbiterBench::GetVCOwner( const TocinoOutputVC outputVC ) const
+{
+    return m_tx->GetArbiter()->GetVCOwner( outputVC );
+}
+
+uint32_t
+ArbiterBench::GetOccupancy( const TocinoOutputVC outputVC ) const
+{
+    return m_tx->GetOccupancy( outputVC );
+}
+
+uint32_t
+ArbiterBench::GetNPorts() const
+{
+    return m_tnd->GetNPorts();
+}
+
+uint32_t
+ArbiterBench::GetPacketsEnqueued() const
+{
+    return m_enqueued;
+}
+
+uint32_t
+ArbiterBench::GetPacketsEjected() const
+{
+    return m_ejected;
+}
+
+ArbiterBench::Snapshot
+ArbiterBench::Take() const
+{
+    Snapshot s;
+
+    for( TocinoOutputVC vc = 0; vc < m_tnd->GetNVCs(); ++vc )
+    {
+        s.occupancy.push_back( GetOccupancy( vc ) );
+        s.owners.push_back( GetVCOwner( vc ) );
+    }
+
+    return s;
+}
+
+TocinoArbiterAllocation
+ArbiterBench::Winner( const Snapshot& before ) const
+{
+    const Snapshot after = Take();
+
+    TocinoArbiterAllocation winner = TocinoArbiter::DO_NOTHING;
+
+    for( uint32_t vc = 0; vc < after.occupancy.size(); ++vc )
+    {
+        if( after.occupancy[vc] == before.occupancy[vc] )
+        {
+            continue;
+        }
+
+        NS_ASSERT( after.occupancy[vc] + 1 == before.occupancy[vc] );
+        NS_ASSERT( winner == TocinoArbiter::DO_NOTHING );
+
+        // A tail frees the VC
+        const TocinoArbiterAllocation& owner =
+            ( after.owners[vc].inputPort != TOCINO_INVALID_PORT ) ?
+            after.owners[vc] : before.owners[vc];
+
+        NS_ASSERT( owner.inputPort != TOCINO_INVALID_PORT );
+
+        winner = TocinoArbiterAllocation( owner.inputPort, vc );
+    }
+
+    return winner;
+}
+
+bool
+ArbiterBench::Eject(
+        Ptr<NetDevice>,
+        Ptr<const Packet>,
+        uint16_t,
+        const Address& )
+{
+    m_ejected++;
+    return true;
+}
+
+// Arbitrate until nothing is left
+void
+Drain( ArbiterBench& bench, std::vector< TocinoArbiterAllocation >& winners )
+{
+    TocinoArbiterAllocation winner = bench.Step();
+
+    while( winner != TocinoArbiter::DO_NOTHING )
+    {
+        winners.push_back( winner );
+        winner = bench.Step();
+    }
+}
+
+// Galois LFSR, x^16 + x^14 + x^13 + x^11 + 1, as in
+// TocinoBitmaskArbiter
+class ReferenceLFSR
+{
+    public:
+
+    ReferenceLFSR( const uint32_t seed )
+        : m_state( seed & 0xFFFF )
+    {
+        if( m_state == 0 )
+        {
+            m_state = 1;
+        }
+    }
+
+    uint32_t Next()
+    {
+        const bool lsb = m_state & 1;
+
+        m_state >>= 1;
+
+        if( lsb )
+        {
+            m_state ^= 0xB400;
+        }
+
+        return m_state;
+    }
+
+    private:
+
+    uint32_t m_state;
+};
+
+}
+
+TestTocinoBitmaskArbiter::TestTocinoBitmaskArbiter()
+    : TestCase( "Tocino Bitmask Arbiter" )
+{}
+
+void
+TestTocinoBitmaskArbiter::CheckWinners(
+        const WinnerVector& winners,
+        const WinnerVector& expected,
+        const char* what )
+{
+    NS_TEST_ASSERT_MSG_EQ( winners.size(), expected.size(),
+            what << ": wrong number of winners" );
+
+    for( uint32_t i = 0; i < winners.size(); ++i )
+    {
+        NS_TEST_ASSERT_MSG_EQ( winners[i].inputPort, expected[i].inputPort,
+                what << ": wrong input port at arbitration " << i );
+
+        NS_TEST_ASSERT_MSG_EQ( winners[i].outputVC, expected[i].outputVC,
+                what << ": wrong output VC at arbitration " << i );
+    }
+}
+
+void
+TestTocinoBitmaskArbiter::TestRoundRobin()
+{
+    ArbiterBench bench( TocinoBitmaskArbiter::ROUND_ROBIN, 1 );
+
+    // Port 1 is empty, and port 0 has a second packet
+    bench.Enqueue( 0, 0, 2 );
+    bench.Enqueue( 0, 0, 2 );
+    bench.Enqueue( 2, 0, 2 );
+    bench.Enqueue( 3, 0, 2 );
+
+    WinnerVector winners( 1, bench.Start() );
+    Drain( bench, winners );
+
+    // Each port's packet in turn, wrapping back to port 0
+    const uint32_t PORTS[] = { 0, 0, 2, 2, 3, 3, 0, 0 };
+
+    WinnerVector expected;
+
+    for( uint32_t i = 0; i < 8; ++i )
+    {
+        expected.push_back( TocinoArbiterAllocation( PORTS[i], 0 ) );
+    }
+
+    CheckWinners( winners, expected, "round robin" );
+
+    NS_TEST_ASSERT_MSG_EQ( bench.GetPacketsEjected(), bench.GetPacketsEnqueued(),
+            "Packets lost" );
+}
+
+void
+TestTocinoBitmaskArbiter::TestLFSR( const uint32_t seed )
+{
+    ArbiterBench bench( TocinoBitmaskArbiter::LFSR, seed );
+
+    // One packet on every port, all for one VC
+    const uint32_t N_PORTS = bench.GetNPorts();
+
+    for( uint32_t port = 0; port < N_PORTS; ++port )
+    {
+        bench.Enqueue( port, 0, 2 );
+    }
+
+    WinnerVector winners( 1, bench.Start() );
+    Drain( bench, winners );
+
+    // N.B.
+    // Every arbitration advances the LFSR once to pick a VC,
+    // and a head flit advances it again to pick among the
+    // ready input ports, starting from the LFSR value modulo
+    // the number of ports.  The tail follows its head.
+    ReferenceLFSR lfsr( seed );
+    WinnerVector expected;
+
+    uint32_t ready = ( 1u << N_PORTS ) - 1;
+
+    while( ready != 0 )
+    {
+        // The head
+        lfsr.Next();
+
+        uint32_t port = lfsr.Next() % N_PORTS;
+
+        while( ( ready & ( 1u << port ) ) == 0 )
+        {
+            port = ( port + 1 ) % N_PORTS;
+        }
+
+        expected.push_back( TocinoArbiterAllocation( port, 0 ) );
+
+        // The tail
+        lfsr.Next();
+
+        expected.push_back( TocinoArbiterAllocation( port, 0 ) );
+
+        ready &= ~( 1u << port );
+    }
+
+    CheckWinners( winners, expected, "LFSR" );
+
+    NS_TEST_ASSERT_MSG_EQ( bench.GetPacketsEjected(), bench.GetPacketsEnqueued(),
+            "Packets lost" );
+}
+
+void
+TestTocinoBitmaskArbiter::TestXOFF()
+{
+    ArbiterBench bench( TocinoBitmaskArbiter::ROUND_ROBIN, 1 );
+
+    bench.Enqueue( 0, 0, 2 );
+    bench.Enqueue( 1, 1, 2 );
+    bench.Enqueue( 3, 2, 2 );
+    bench.Enqueue( 4, 1, 3 );
+
+    TocinoFlowControlState xState( TocinoAllXON );
+    xState.reset( 1 );
+
+    WinnerVector winners( 1, bench.Start( xState ) );
+    Drain( bench, winners );
+
+    for( uint32_t i = 0; i < winners.size(); ++i )
+    {
+        NS_TEST_ASSERT_MSG_NE( winners[i].outputVC, 1,
+                "XOFF VC picked at arbitration " << i );
+    }
+
+    NS_TEST_ASSERT_MSG_EQ( winners.size(), 4, "XON VCs not drained" );
+    NS_TEST_ASSERT_MSG_EQ( bench.GetOccupancy( 1 ), 5, "XOFF VC sent a flit?" );
+
+    // Resuming lets VC 1 go, and it alone is left
+    winners.clear();
+    winners.push_back( bench.SetXState( TocinoAllXON ) );
+    Drain( bench, winners );
+
+    NS_TEST_ASSERT_MSG_EQ( winners.size(), 5, "Resumed VC not drained" );
+
+    for( uint32_t i = 0; i < winners.size(); ++i )
+    {
+        NS_TEST_ASSERT_MSG_EQ( winners[i].outputVC, 1,
+                "Unexpected VC after resuming" );
+    }
+
+    NS_TEST_ASSERT_MSG_EQ( bench.GetPacketsEjected(), bench.GetPacketsEnqueued(),
+            "Packets lost" );
+
+    // Pausing in mid-packet holds the tail, and the VC
+    // stays with the paused packet
+    ArbiterBench paused( TocinoBitmaskArbiter::ROUND_ROBIN, 1 );
+
+    paused.Enqueue( 2, 0, 2 );
+    paused.Enqueue( 5, 0, 2 );
+
+    const TocinoArbiterAllocation head = paused.Start();
+
+    NS_TEST_ASSERT_MSG_EQ( head.inputPort, 2, "Wrong first winner" );
+
+    xState = TocinoAllXON;
+    xState.reset( 0 );
+
+    paused.SetXState( xState );
+
+    const bool stalled = ( paused.Step() == TocinoArbiter::DO_NOTHING );
+
+    NS_TEST_ASSERT_MSG_EQ( stalled, true, "Flit sent on an XOFF VC" );
+
+    NS_TEST_ASSERT_MSG_EQ( paused.GetVCOwner( 0 ).inputPort, 2,
+            "Paused packet lost its VC" );
+
+    const TocinoArbiterAllocation tail = paused.SetXState( TocinoAllXON );
+
+    NS_TEST_ASSERT_MSG_EQ( tail.inputPort, 2, "Tail did not follow its head" );
+}
+
+void
+TestTocinoBitmaskArbiter::TestAllocation()
+{
+    ArbiterBench bench( TocinoBitmaskArbiter::ROUND_ROBIN, 1 );
+
+    // Ports 1 and 4 contend for VC 0, which round robin
+    // alternates with VC 1
+    bench.Enqueue( 1, 0, 3 );
+    bench.Enqueue( 4, 0, 3 );
+    bench.Enqueue( 2, 1, 3 );
+
+    WinnerVector winners( 1, bench.Start() );
+
+    TocinoArbiterAllocation winner = bench.Step();
+
+    while( winner != TocinoArbiter::DO_NOTHING )
+    {
+        winners.push_back( winner );
+
+        if( winners.size() < 5 )
+        {
+            NS_TEST_ASSERT_MSG_EQ( bench.GetVCOwner( 0 ).inputPort, 1,
+                    "VC 0 left port 1 before its tail" );
+        }
+
+        winner = bench.Step();
+    }
+
+    const TocinoArbiterAllocation EXPECTED[] =
+    {
+        TocinoArbiterAllocation( 1, 0 ),
+        TocinoArbiterAllocation( 2, 1 ),
+        TocinoArbiterAllocation( 1, 0 ),
+        TocinoArbiterAllocation( 2, 1 ),
+        TocinoArbiterAllocation( 1, 0 ),
+        TocinoArbiterAllocation( 2, 1 ),
+        TocinoArbiterAllocation( 4, 0 ),
+        TocinoArbiterAllocation( 4, 0 ),
+        TocinoArbiterAllocation( 4, 0 )
+    };
+
+    CheckWinners( winners, WinnerVector( EXPECTED, EXPECTED + 9 ), "allocation" );
+
+    NS_TEST_ASSERT_MSG_EQ( bench.GetVCOwner( 0 ).inputPort, TOCINO_INVALID_PORT,
+            "VC 0 still owned after the last tail" );
+
+    NS_TEST_ASSERT_MSG_EQ( bench.GetPacketsEjected(), bench.GetPacketsEnqueued(),
+            "Packets lost" );
+}
+
+TestTocinoBitmaskArbiter::WinnerVector
+TestTocinoBitmaskArbiter::RunMixed(
+        const TocinoBitmaskArbiter::Priority priority,
+        const uint32_t seed )
+{
+    ArbiterBench bench( priority, seed );
+
+    bench.Enqueue( 0, 0, 3 );
+    bench.Enqueue( 0, 0, 2 );
+    bench.Enqueue( 0, 1, 2 );
+    bench.Enqueue( 1, 2, 2 );
+    bench.Enqueue( 2, 0, 2 );
+    bench.Enqueue( 3, 2, 4 );
+    bench.Enqueue( 5, 1, 3 );
+    bench.Enqueue( 6, 0, 2 );
+    bench.Enqueue( 6, 3, 2 );
+
+    WinnerVector winners( 1, bench.Start() );
+    Drain( bench, winners );
+
+    NS_TEST_EXPECT_MSG_EQ( winners.size(), 22, "Flits left behind" );
+
+    NS_TEST_EXPECT_MSG_EQ( bench.GetPacketsEjected(), bench.GetPacketsEnqueued(),
+            "Packets lost" );
+
+    return winners;
+}
+
+void
+TestTocinoBitmaskArbiter::TestRepeatable()
+{
+    const WinnerVector roundRobin =
+        RunMixed( TocinoBitmaskArbiter::ROUND_ROBIN, 1 );
+
+    CheckWinners( RunMixed( TocinoBitmaskArbiter::ROUND_ROBIN, 1 ),
+            roundRobin, "repeated round robin" );
+
+    const WinnerVector lfsr = RunMixed( TocinoBitmaskArbiter::LFSR, 0xACE1 );
+
+    CheckWinners( RunMixed( TocinoBitmaskArbiter::LFSR, 0xACE1 ),
+            lfsr, "repeated LFSR" );
+
+    // The seed matters
+    const WinnerVector other = RunMixed( TocinoBitmaskArbiter::LFSR, 1 );
+
+    NS_TEST_ASSERT_MSG_EQ( other.size(), lfsr.size(), "Wrong number of winners" );
+    const bool differs = ( other != lfsr );
+
+    NS_TEST_ASSERT_MSG_EQ( differs, true, "Seed had no effect" );
+}
+
+void
+TestTocinoBitmaskArbiter::DoRun()
+{
+    TestRoundRobin();
+    TestLFSR( 1 );
+    TestLFSR( 0xACE1 );
+    TestXOFF();
+    TestAllocation();
+    TestRepeatable();
+
+    Config::Reset();
+}
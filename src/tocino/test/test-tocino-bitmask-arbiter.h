@@ -0,0 +1,48 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_BITMASK_ARBITER_H__
+#define __TEST_TOCINO_BITMASK_ARBITER_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/test.h"
+
+#include "ns3/tocino-arbiter.h"
+#include "ns3/tocino-bitmask-arbiter.h"
+
+namespace ns3
+{
+
+// The winners TocinoBitmaskArbiter picks, one arbitration at
+// a time, for queues filled by hand
+class TestTocinoBitmaskArbiter : public TestCase
+{
+    public:
+
+    TestTocinoBitmaskArbiter();
+
+    private:
+
+    typedef std::vector< TocinoArbiterAllocation > WinnerVector;
+
+    void CheckWinners( const WinnerVector&, const WinnerVector&, const char* );
+
+    void TestRoundRobin();
+    void TestLFSR( const uint32_t seed );
+    void TestXOFF();
+    void TestAllocation();
+
+    // Packets of several lengths on several ports and VCs,
+    // arbitrated until every queue is empty
+    WinnerVector RunMixed(
+            const TocinoBitmaskArbiter::Priority,
+            const uint32_t seed );
+
+    void TestRepeatable();
+
+    virtual void DoRun();
+};
+
+}
+
+#endif // __TEST_TOCINO_BITMASK_ARBITER_H__
@@ -0,0 +1,156 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/config.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/enum.h"
+#include "ns3/simulator.h"
+
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-collective-application.h"
+#include "ns3/tocino-torus-topology-helper.h"
+
+#include "test-tocino-collectives.h"
+
+using namespace ns3;
+
+namespace
+{
+
+// Ranks, in a ring
+const uint32_t RANKS = 8;
+const uint32_t ITERATIONS = 2;
+
+// Three packets per message
+const uint32_t MESSAGE_SIZE = 3000;
+const uint32_t PACKET_SIZE = 1024;
+
+}
+
+TestTocinoCollectives::TestTocinoCollectives()
+    : TestCase( "Tocino Collective Applications" )
+    , m_completions( 0 )
+{}
+
+void
+TestTocinoCollectives::Complete( uint32_t, Time )
+{
+    m_completions++;
+}
+
+void
+TestTocinoCollectives::TestHelper(
+        const std::string& algorithm,
+        const uint32_t steps,
+        const uint32_t packetsPerRank,
+        const bool lightweight )
+{
+    std::vector< uint32_t > radix( 1, RANKS );
+    std::vector< bool > wrap( 1, true );
+
+    TocinoTorusTopologyHelper helper( radix, wrap );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::WrapAroundRadices",
+            StringValue( helper.GetWrapAroundRadices() ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::LightweightFlits",
+            BooleanValue( lightweight ) );
+
+    // Exercise refused sends
+    Config::SetDefault( "ns3::TocinoNetDevice::InjectionQueueMaxFlits",
+            UintegerValue( lightweight ? 0 : 16 ) );
+
+    NodeContainer machines;
+    machines.Create( helper.NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+    std::vector< Ptr<TocinoCollectiveApplication> > apps;
+
+    for( uint32_t rank = 0; rank < RANKS; ++rank )
+    {
+        Ptr<TocinoCollectiveApplication> app =
+            CreateObject<TocinoCollectiveApplication>();
+
+        app->SetAttribute( "Algorithm", StringValue( algorithm ) );
+        app->SetAttribute( "MessageSize", UintegerValue( MESSAGE_SIZE ) );
+        app->SetAttribute( "PacketSize", UintegerValue( PACKET_SIZE ) );
+        app->SetAttribute( "Iterations", UintegerValue( ITERATIONS ) );
+        app->Initialize( rank, &machines );
+
+        app->TraceConnectWithoutContext( "Complete",
+                MakeCallback( &TestTocinoCollectives::Complete, this ) );
+
+        app->SetStartTime( NanoSeconds( 10 ) );
+        machines.Get( rank )->AddApplication( app );
+
+        apps.push_back( app );
+    }
+
+    m_completions = 0;
+
+    Simulator::Run();
+
+    uint32_t sent = 0;
+    uint32_t received = 0;
+
+    for( uint32_t rank = 0; rank < RANKS; ++rank )
+    {
+        NS_TEST_ASSERT_MSG_EQ( apps[rank]->GetStepCount(), steps,
+                algorithm << ": wrong number of steps" );
+        
+        NS_TEST_ASSERT_MSG_EQ( apps[rank]->GetIterationsCompleted(), ITERATIONS,
+                algorithm << ": rank " << rank << " did not finish" );
+
+        if( packetsPerRank > 0 )
+        {
+            NS_TEST_ASSERT_MSG_EQ( apps[rank]->GetPacketsReceived(),
+                    packetsPerRank * ITERATIONS,
+                    algorithm << ": rank " << rank << " received wrong count" );
+        }
+
+        sent += apps[rank]->GetPacketsSent();
+        received += apps[rank]->GetPacketsReceived();
+    }
+
+    NS_TEST_ASSERT_MSG_EQ( sent, received, algorithm << ": packets lost?" );
+    NS_TEST_ASSERT_MSG_GT( sent, 0, algorithm << ": nothing sent?" );
+
+    NS_TEST_ASSERT_MSG_EQ( m_completions, RANKS * ITERATIONS,
+            algorithm << ": Complete not traced for every rank" );
+
+    for( uint32_t i = 0; i < ITERATIONS; ++i )
+    {
+        NS_TEST_ASSERT_MSG_GT(
+                TocinoCollectiveApplication::GetCompletionTime( apps, i ),
+                Time( 0 ), algorithm << ": no completion time?" );
+    }
+
+    Simulator::Destroy();
+    Config::Reset();
+}
+
+void
+TestTocinoCollectives::DoRun()
+{
+    const bool LIGHTWEIGHT[] = { false, true };
+
+    for( uint32_t i = 0; i < 2; ++i )
+    {
+        // A chunk of one packet per step, both ways around
+        TestHelper( "RingAllreduce", 2 * ( RANKS - 1 ), 2 * ( RANKS - 1 ),
+                LIGHTWEIGHT[i] );
+
+        // log2(RANKS) whole messages
+        TestHelper( "RecursiveDoublingAllreduce", 3, 3 * 3, LIGHTWEIGHT[i] );
+
+        // A message from every other rank
+        TestHelper( "PairwiseAlltoall", RANKS - 1, ( RANKS - 1 ) * 3,
+                LIGHTWEIGHT[i] );
+
+        // One message, except at the root
+        TestHelper( "BinomialBroadcast", 3, 0, LIGHTWEIGHT[i] );
+    }
+}
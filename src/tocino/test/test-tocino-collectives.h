@@ -0,0 +1,39 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_COLLECTIVES_H__
+#define __TEST_TOCINO_COLLECTIVES_H__
+
+#include <stdint.h>
+#include <string>
+
+#include "ns3/test.h"
+#include "ns3/nstime.h"
+
+namespace ns3
+{
+
+// Every rank of each collective must finish every
+// repetition, having received exactly what it expects
+class TestTocinoCollectives : public TestCase
+{
+    public:
+
+    TestTocinoCollectives();
+
+    private:
+
+    void TestHelper(
+            const std::string&,
+            const uint32_t,
+            const uint32_t,
+            const bool );
+
+    void Complete( uint32_t, Time );
+
+    uint32_t m_completions;
+
+    virtual void DoRun();
+};
+
+}
+
+#endif // __TEST_TOCINO_COLLECTIVES_H__
@@ -0,0 +1,199 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include <vector>
+
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
+
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-channel.h"
+#include "ns3/tocino-tx.h"
+#include "ns3/tocino-torus-topology-helper.h"
+#include "ns3/tocino-traffic-patterns.h"
+#include "ns3/tocino-traffic-matrix-application.h"
+
+#include "test-tocino-credit-flow-control.h"
+
+using namespace ns3;
+
+TestTocinoCreditFlowControl::TestTocinoCreditFlowControl()
+    : TestCase( "Tocino Credit Flow Control" )
+{}
+
+TestTocinoCreditFlowControl::Outcome
+TestTocinoCreditFlowControl::Run(
+        const bool useCredits,
+        const bool doWrap,
+        const Time delay,
+        const uint32_t inputQueueFlits,
+        const bool lightweightFlits,
+        const bool doVLB )
+{
+    TocinoTorusTopologyHelper helper(
+            std::vector< uint32_t >( 2, 4 ),
+            std::vector< bool >( 2, doWrap ) );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::WrapAroundRadices",
+            StringValue( helper.GetWrapAroundRadices() ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::FlowControl",
+            StringValue( useCredits ? "Credit" : "XonXoff" ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::InputQueueFlits",
+            UintegerValue( inputQueueFlits ) );
+
+    Config::SetDefault( "ns3::TocinoChannel::Delay", TimeValue( delay ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::LightweightFlits",
+            BooleanValue( lightweightFlits ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::InjectionQueueMaxFlits",
+            UintegerValue( 32 ) );
+
+    const uint32_t NODES = helper.NODES;
+
+    const TocinoSparseTrafficMatrix trafficMatrix =
+        TocinoTrafficPatterns( helper ).UniformRandom();
+
+    NodeContainer machines;
+    machines.Create( NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+    std::vector< Ptr<TocinoTrafficMatrixApplication> > applications;
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        Ptr<TocinoTrafficMatrixApplication> app =
+            CreateObject<TocinoTrafficMatrixApplication>();
+
+        applications.push_back( app );
+
+        app->Initialize( node, &machines, trafficMatrix );
+        app->AssignStreams( node * 2 );
+
+        app->SetAttribute( "MeanTimeBetweenSends", TimeValue( NanoSeconds( 50 ) ) );
+        app->SetAttribute( "MaxTimeBetweenSends", TimeValue( NanoSeconds( 500 ) ) );
+        app->SetAttribute( "EnableValiantLoadBalancing", BooleanValue( doVLB ) );
+
+        app->SetStartTime( Seconds( 0 ) );
+        app->SetStopTime( MicroSeconds( 20 ) );
+        app->SetPacketSize( 123 );
+
+        machines.Get( node )->AddApplication( app );
+    }
+
+    Simulator::Run();
+
+    Outcome outcome = { 0, 0, 0 };
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        outcome.sent += applications[node]->GetPacketsSent();
+        outcome.received += applications[node]->GetPacketsReceived();
+
+        for( uint32_t port = 0; port < netDevices[node]->GetNPorts(); ++port )
+        {
+            const TocinoTx* tx = netDevices[node]->GetTransmitter( port );
+            Ptr<TocinoChannel> channel = tx->GetChannel();
+
+            if( channel == NULL )
+            {
+                continue;
+            }
+
+            if( useCredits )
+            {
+                outcome.creditFlits += channel->GetLLCFlitsTransmitted();
+
+                // Every credit must have come home
+                for( uint32_t vc = 0; vc < netDevices[node]->GetNVCs(); ++vc )
+                {
+                    NS_TEST_EXPECT_MSG_EQ( tx->GetCredits( vc ), inputQueueFlits,
+                            "Credits outstanding on an idle network?" );
+                }
+            }
+        }
+    }
+
+    Simulator::Destroy();
+    Config::Reset();
+
+    return outcome;
+}
+
+void
+TestTocinoCreditFlowControl::CheckDelivered(
+        const Outcome& outcome,
+        const char* what )
+{
+    NS_TEST_ASSERT_MSG_GT( outcome.sent, 0, what );
+    NS_TEST_ASSERT_MSG_EQ( outcome.received, outcome.sent, what );
+}
+
+void
+TestTocinoCreditFlowControl::TestBufferRequirements()
+{
+    Ptr<TocinoChannel> shortChannel = CreateObject<TocinoChannel>();
+    Ptr<TocinoChannel> longChannel = CreateObject<TocinoChannel>();
+
+    longChannel->SetAttribute( "Delay", TimeValue( NanoSeconds( 100 ) ) );
+
+    NS_TEST_ASSERT_MSG_LT( shortChannel->FlitBuffersRequired(),
+            longChannel->FlitBuffersRequired(),
+            "XON/XOFF reserve should grow with channel delay" );
+
+    NS_TEST_ASSERT_MSG_LT( shortChannel->CreditBuffersRequired(),
+            longChannel->CreditBuffersRequired(),
+            "Credit round trip should grow with channel delay" );
+
+    // Too long for XON/XOFF with the default input queues
+    NS_TEST_ASSERT_MSG_GT( longChannel->FlitBuffersRequired(), 8,
+            "Expected XON/XOFF to need more than a full queue" );
+}
+
+void
+TestTocinoCreditFlowControl::DoRun()
+{
+    TestBufferRequirements();
+
+    const Time SHORT = Seconds( 0 );
+    const Time LONG = NanoSeconds( 100 );
+
+    const Outcome credit = Run( true, true, SHORT, 8, false, false );
+    CheckDelivered( credit, "credits" );
+    NS_TEST_ASSERT_MSG_GT( credit.creditFlits, 0, "No credits returned?" );
+
+    // XON/XOFF would need a reserve of most of the queue
+    CheckDelivered( Run( true, true, SHORT, 2, false, false ),
+            "credits, shallow queues" );
+
+    // ... and cannot work at all here
+    CheckDelivered( Run( true, true, LONG, 8, false, false ),
+            "credits, long channels" );
+
+    CheckDelivered( Run( true, false, LONG, 4, true, false ),
+            "credits, mesh, lightweight flits" );
+
+    // The discarded outer head of a bounced packet must
+    // still return its credit
+    CheckDelivered( Run( true, true, SHORT, 4, false, true ),
+            "credits, Valiant load balancing" );
+
+    // XON/XOFF, on a channel only just short enough
+    CheckDelivered( Run( false, true, NanoSeconds( 20 ), 8, false, false ),
+            "XON/XOFF, delayed channels" );
+
+    // Deep enough to owe more credits on a VC than one
+    // credit flit can carry
+    CheckDelivered( Run( true, true, NanoSeconds( 200 ), 64, false, false ),
+            "credits, deep queues" );
+
+    // ... and deep enough for XON/XOFF on long channels
+    CheckDelivered( Run( false, true, LONG, 32, false, false ),
+            "XON/XOFF, deep queues" );
+}
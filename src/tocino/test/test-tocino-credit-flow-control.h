@@ -0,0 +1,49 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_CREDIT_FLOW_CONTROL_H__
+#define __TEST_TOCINO_CREDIT_FLOW_CONTROL_H__
+
+#include <stdint.h>
+
+#include "ns3/test.h"
+#include "ns3/nstime.h"
+
+namespace ns3
+{
+
+// Credit flow control must deliver everything, including
+// over channels too long, or with input queues too short,
+// for XON/XOFF
+class TestTocinoCreditFlowControl : public TestCase
+{
+    public:
+
+    TestTocinoCreditFlowControl();
+
+    private:
+
+    struct Outcome
+    {
+        uint64_t sent;
+        uint64_t received;
+        uint64_t creditFlits;
+    };
+
+    // Heavy uniform random traffic on a 4 x 4 torus or mesh
+    Outcome Run(
+            const bool,
+            const bool,
+            const Time,
+            const uint32_t,
+            const bool,
+            const bool );
+
+    void CheckDelivered( const Outcome&, const char* );
+
+    void TestBufferRequirements();
+
+    virtual void DoRun();
+};
+
+}
+
+#endif // __TEST_TOCINO_CREDIT_FLOW_CONTROL_H__
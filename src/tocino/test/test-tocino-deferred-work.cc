@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include <algorithm>
+#include <vector>
+
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/type-id.h"
+#include "ns3/simulator.h"
+
+#include "ns3/tocino-bitmask-arbiter.h"
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-torus-topology-helper.h"
+#include "ns3/tocino-traffic-patterns.h"
+#include "ns3/tocino-traffic-matrix-application.h"
+
+#include "test-tocino-deferred-work.h"
+
+using namespace ns3;
+
+namespace
+{
+
+void
+Nothing()
+{}
+
+}
+
+bool
+TestTocinoDeferredWork::Delivery::operator<( const Delivery& other ) const
+{
+    if( time != other.time )
+    {
+        return time < other.time;
+    }
+
+    if( latency != other.latency )
+    {
+        return latency < other.latency;
+    }
+
+    return source < other.source;
+}
+
+bool
+TestTocinoDeferredWork::Delivery::operator==( const Delivery& other ) const
+{
+    return ( time == other.time ) &&
+        ( latency == other.latency ) &&
+        ( source == other.source );
+}
+
+TestTocinoDeferredWork::TestTocinoDeferredWork()
+    : TestCase( "Tocino Deferred Work" )
+{}
+
+void
+TestTocinoDeferredWork::PacketLatency(
+        const TocinoAddress& source,
+        Time latency,
+        uint32_t,
+        Time )
+{
+    Delivery d;
+
+    d.time = Simulator::Now().GetNanoSeconds();
+    d.latency = latency.GetNanoSeconds();
+    d.source = ( source.GetX() << 16 ) | ( source.GetY() << 8 ) | source.GetZ();
+
+    m_deliveries.push_back( d );
+}
+
+TestTocinoDeferredWork::Outcome
+TestTocinoDeferredWork::Run( const bool coalesce, const bool useCredits )
+{
+    TocinoTorusTopologyHelper helper(
+            std::vector< uint32_t >( 2, 4 ),
+            std::vector< bool >( 2, true ) );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::WrapAroundRadices",
+            StringValue( helper.GetWrapAroundRadices() ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::CoalesceWork",
+            BooleanValue( coalesce ) );
+
+    // TocinoSimpleArbiter draws from a fresh random stream
+    // for each decision, which no two runs in a process share
+    Config::SetDefault( "ns3::TocinoNetDevice::ArbiterType",
+            TypeIdValue( TocinoBitmaskArbiter::GetTypeId() ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::FlowControl",
+            StringValue( useCredits ? "Credit" : "XonXoff" ) );
+
+    // Small enough to refuse packets, and so exercise
+    // the injection retry too
+    Config::SetDefault( "ns3::TocinoNetDevice::InjectionQueueMaxFlits",
+            UintegerValue( 4 ) );
+
+    const uint32_t NODES = helper.NODES;
+
+    const TocinoSparseTrafficMatrix trafficMatrix =
+        TocinoTrafficPatterns( helper ).UniformRandom();
+
+    NodeContainer machines;
+    machines.Create( NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+    std::vector< Ptr<TocinoTrafficMatrixApplication> > applications;
+
+    m_deliveries.clear();
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        netDevices[node]->TraceConnectWithoutContext( "PacketLatency",
+                MakeCallback( &TestTocinoDeferredWork::PacketLatency, this ) );
+
+        Ptr<TocinoTrafficMatrixApplication> app =
+            CreateObject<TocinoTrafficMatrixApplication>();
+
+        applications.push_back( app );
+
+        app->Initialize( node, &machines, trafficMatrix );
+        app->AssignStreams( node * 2 );
+
+        app->SetAttribute( "MeanTimeBetweenSends", TimeValue( NanoSeconds( 10 ) ) );
+        app->SetAttribute( "MaxTimeBetweenSends", TimeValue( NanoSeconds( 40 ) ) );
+
+        app->SetStartTime( Seconds( 0 ) );
+        app->SetStopTime( MicroSeconds( 10 ) );
+        app->SetPacketSize( 123 );
+
+        machines.Get( node )->AddApplication( app );
+    }
+
+    Simulator::Run();
+
+    Outcome outcome;
+
+    outcome.sent = 0;
+    outcome.events = Simulator::Schedule( Seconds( 0 ), &Nothing ).GetUid();
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        outcome.sent += applications[node]->GetPacketsSent();
+    }
+
+    outcome.deliveries = m_deliveries;
+    std::sort( outcome.deliveries.begin(), outcome.deliveries.end() );
+
+    Simulator::Destroy();
+    Config::Reset();
+
+    return outcome;
+}
+
+void
+TestTocinoDeferredWork::Compare( const bool useCredits )
+{
+    const char* what = useCredits ? "credits" : "XON/XOFF";
+
+    const Outcome separate = Run( false, useCredits );
+    const Outcome coalesced = Run( true, useCredits );
+
+    NS_TEST_ASSERT_MSG_GT( separate.sent, 0, what );
+    NS_TEST_ASSERT_MSG_EQ( separate.deliveries.size(), separate.sent, what );
+    NS_TEST_ASSERT_MSG_EQ( coalesced.sent, separate.sent, what );
+    NS_TEST_ASSERT_MSG_EQ( coalesced.deliveries.size(), coalesced.sent, what );
+
+    NS_TEST_ASSERT_MSG_EQ( ( coalesced.deliveries == separate.deliveries ), true,
+            what << " delivery times differ" );
+
+    NS_TEST_ASSERT_MSG_LT_OR_EQ( coalesced.events, separate.events,
+            what << " coalesced work took more events" );
+}
+
+void
+TestTocinoDeferredWork::DoRun()
+{
+    Compare( false );
+    Compare( true );
+}
@@ -0,0 +1,60 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_DEFERRED_WORK_H__
+#define __TEST_TOCINO_DEFERRED_WORK_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/nstime.h"
+#include "ns3/test.h"
+
+#include "ns3/tocino-address.h"
+
+namespace ns3
+{
+
+// Deferred work coalesced into one event per device must
+// run in the same order as one event per piece of work, so
+// every packet is delivered at the same time
+class TestTocinoDeferredWork : public TestCase
+{
+    public:
+
+    TestTocinoDeferredWork();
+
+    private:
+
+    struct Delivery
+    {
+        int64_t time;
+        int64_t latency;
+        uint32_t source;
+
+        bool operator<( const Delivery& ) const;
+        bool operator==( const Delivery& ) const;
+    };
+
+    struct Outcome
+    {
+        uint64_t sent;
+        uint64_t events;
+
+        // Sorted
+        std::vector< Delivery > deliveries;
+    };
+
+    void PacketLatency( const TocinoAddress&, Time, uint32_t, Time );
+
+    // Heavy uniform random traffic on a 4 x 4 torus
+    Outcome Run( const bool coalesce, const bool useCredits );
+
+    void Compare( const bool useCredits );
+
+    virtual void DoRun();
+
+    std::vector< Delivery > m_deliveries;
+};
+
+}
+
+#endif // __TEST_TOCINO_DEFERRED_WORK_H__
@@ -0,0 +1,259 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/type-id.h"
+#include "ns3/simulator.h"
+
+#include "ns3/tocino-bitmask-arbiter.h"
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-channel.h"
+#include "ns3/tocino-torus-topology-helper.h"
+#include "ns3/tocino-traffic-patterns.h"
+#include "ns3/tocino-traffic-matrix-application.h"
+
+#include "test-tocino-express-transmit.h"
+
+using namespace ns3;
+
+namespace
+{
+
+void
+Nothing()
+{}
+
+double
+Mean( const std::vector< int64_t >& v )
+{
+    double sum = 0;
+
+    for( uint32_t i = 0; i < v.size(); ++i )
+    {
+        sum += v[i];
+    }
+
+    return v.empty() ? 0 : sum / v.size();
+}
+
+}
+
+TestTocinoExpressTransmit::TestTocinoExpressTransmit()
+    : TestCase( "Tocino Express Transmit" )
+{}
+
+void
+TestTocinoExpressTransmit::PacketLatency(
+        const TocinoAddress& source,
+        Time latency,
+        uint32_t,
+        Time )
+{
+    m_latencies.push_back( latency.GetNanoSeconds() );
+
+    const Time sent = Simulator::Now() - latency;
+
+    m_packets[ std::make_pair( TocinoAddressToString( source ),
+            sent.GetNanoSeconds() ) ] = latency.GetNanoSeconds();
+}
+
+TestTocinoExpressTransmit::Outcome
+TestTocinoExpressTransmit::Run(
+        const bool express,
+        const bool useCredits,
+        const std::string& pattern,
+        const Time meanTimeBetweenSends )
+{
+    TocinoTorusTopologyHelper helper(
+            std::vector< uint32_t >( 2, 4 ),
+            std::vector< bool >( 2, true ) );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::WrapAroundRadices",
+            StringValue( helper.GetWrapAroundRadices() ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::ExpressTransmit",
+            BooleanValue( express ) );
+
+    // TocinoSimpleArbiter draws from a fresh random stream
+    // for each decision, which no two runs in a process share
+    Config::SetDefault( "ns3::TocinoNetDevice::ArbiterType",
+            TypeIdValue( TocinoBitmaskArbiter::GetTypeId() ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::FlowControl",
+            StringValue( useCredits ? "Credit" : "XonXoff" ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::InjectionQueueMaxFlits",
+            UintegerValue( 64 ) );
+
+    // A flit still in flight when the next one starts
+    Config::SetDefault( "ns3::TocinoChannel::Delay",
+            TimeValue( NanoSeconds( 10 ) ) );
+
+    const uint32_t NODES = helper.NODES;
+
+    const TocinoSparseTrafficMatrix trafficMatrix =
+        TocinoTrafficPatterns( helper ).Create( pattern );
+
+    NodeContainer machines;
+    machines.Create( NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+    std::vector< Ptr<TocinoTrafficMatrixApplication> > applications;
+
+    m_latencies.clear();
+    m_packets.clear();
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        netDevices[node]->TraceConnectWithoutContext( "PacketLatency",
+                MakeCallback( &TestTocinoExpressTransmit::PacketLatency, this ) );
+
+        Ptr<TocinoTrafficMatrixApplication> app =
+            CreateObject<TocinoTrafficMatrixApplication>();
+
+        applications.push_back( app );
+
+        app->Initialize( node, &machines, trafficMatrix );
+        app->AssignStreams( node * 2 );
+
+        app->SetAttribute( "MeanTimeBetweenSends", TimeValue( meanTimeBetweenSends ) );
+        app->SetAttribute( "MaxTimeBetweenSends", TimeValue( meanTimeBetweenSends * 4 ) );
+
+        app->SetStartTime( Seconds( 0 ) );
+        app->SetStopTime( MicroSeconds( 20 ) );
+        app->SetPacketSize( 1000 );
+
+        machines.Get( node )->AddApplication( app );
+    }
+
+    Simulator::Run();
+
+    Outcome outcome;
+
+    outcome.sent = 0;
+    outcome.received = 0;
+    outcome.events = Simulator::Schedule( Seconds( 0 ), &Nothing ).GetUid();
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        outcome.sent += applications[node]->GetPacketsSent();
+        outcome.received += applications[node]->GetPacketsReceived();
+    }
+
+    outcome.latencies = m_latencies;
+    std::sort( outcome.latencies.begin(), outcome.latencies.end() );
+
+    outcome.packets = m_packets;
+
+    Simulator::Destroy();
+    Config::Reset();
+
+    return outcome;
+}
+
+uint32_t
+TestTocinoExpressTransmit::CountSame( const Outcome& a, const Outcome& b )
+{
+    uint32_t same = 0;
+
+    PacketLatencies::const_iterator it;
+
+    for( it = a.packets.begin(); it != a.packets.end(); ++it )
+    {
+        PacketLatencies::const_iterator other = b.packets.find( it->first );
+
+        if( other != b.packets.end() && other->second == it->second )
+        {
+            same++;
+        }
+    }
+
+    return same;
+}
+
+void
+TestTocinoExpressTransmit::Compare( const bool useCredits )
+{
+    const char* what = useCredits ? "credits" : "XON/XOFF";
+
+    // Lightly loaded neighbor traffic: every flow has its
+    // own links, so runs form, and nothing but the order of
+    // simultaneous events could differ.  Timing is exact.
+    const Outcome slow = Run( false, useCredits, "neighbor", MicroSeconds( 5 ) );
+    const Outcome fast = Run( true, useCredits, "neighbor", MicroSeconds( 5 ) );
+
+    NS_TEST_ASSERT_MSG_GT( slow.sent, 0, what );
+    NS_TEST_ASSERT_MSG_EQ( slow.received, slow.sent, what );
+    NS_TEST_ASSERT_MSG_EQ( fast.sent, slow.sent, what );
+    NS_TEST_ASSERT_MSG_EQ( fast.received, fast.sent, what );
+
+    NS_TEST_ASSERT_MSG_EQ( ( fast.packets == slow.packets ), true,
+            what << " latencies differ" );
+
+    NS_TEST_ASSERT_MSG_LT( fast.events, slow.events * 3 / 4,
+            what << " express transmit saved too few events" );
+
+    // Heavily loaded transpose and tornado traffic contend
+    // for links, so runs are often stopped short.  Flits from
+    // different inputs seldom arrive at the same instant, so
+    // every packet must still see exactly the same latency.
+    const char* contended[] = { "transpose", "tornado" };
+
+    for( uint32_t i = 0; i < 2; ++i )
+    {
+        const Outcome a = Run( false, useCredits, contended[i], NanoSeconds( 300 ) );
+        const Outcome b = Run( true, useCredits, contended[i], NanoSeconds( 300 ) );
+
+        NS_TEST_ASSERT_MSG_GT( a.sent, 0, what << " " << contended[i] );
+        NS_TEST_ASSERT_MSG_EQ( a.received, a.sent, what << " " << contended[i] );
+        NS_TEST_ASSERT_MSG_EQ( b.sent, a.sent, what << " " << contended[i] );
+        NS_TEST_ASSERT_MSG_EQ( b.received, b.sent, what << " " << contended[i] );
+
+        NS_TEST_ASSERT_MSG_EQ( CountSame( a, b ), a.packets.size(),
+                what << " " << contended[i] << " latencies differ" );
+
+        NS_TEST_ASSERT_MSG_LT( b.events, a.events,
+                what << " " << contended[i] << " express transmit saved no events" );
+    }
+
+    // Uniform random traffic often delivers flits to a router
+    // on two inputs at once.  Those simultaneous arrivals may
+    // run in another order, and so arbitration may differ for
+    // the odd packet, and the packets queued behind it.
+    const Outcome random = Run( false, useCredits, "uniform", MicroSeconds( 5 ) );
+    const Outcome express = Run( true, useCredits, "uniform", MicroSeconds( 5 ) );
+
+    NS_TEST_ASSERT_MSG_EQ( express.sent, random.sent, what );
+    NS_TEST_ASSERT_MSG_EQ( express.received, express.sent, what );
+
+    NS_TEST_ASSERT_MSG_GT_OR_EQ( CountSame( express, random ) * 10,
+            random.packets.size() * 9, what << " too many latencies differ" );
+
+    NS_TEST_ASSERT_MSG_EQ_TOL( Mean( express.latencies ), Mean( random.latencies ),
+            Mean( random.latencies ) * 0.02, what );
+
+    NS_TEST_ASSERT_MSG_LT( express.events, random.events,
+            what << " express transmit saved no events" );
+
+    // Heavily loaded: runs are often cut short, and must
+    // still deliver everything and drain
+    const Outcome loaded = Run( true, useCredits, "uniform", NanoSeconds( 500 ) );
+
+    NS_TEST_ASSERT_MSG_GT( loaded.sent, express.sent, what );
+    NS_TEST_ASSERT_MSG_EQ( loaded.received, loaded.sent, what );
+}
+
+void
+TestTocinoExpressTransmit::DoRun()
+{
+    Compare( false );
+    Compare( true );
+}
@@ -0,0 +1,69 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_EXPRESS_TRANSMIT_H__
+#define __TEST_TOCINO_EXPRESS_TRANSMIT_H__
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ns3/nstime.h"
+#include "ns3/test.h"
+
+#include "ns3/tocino-address.h"
+
+namespace ns3
+{
+
+// Express transmission must deliver everything, at the same
+// latencies as flit-at-a-time transmission, in fewer events.
+// Only the order of simultaneous events may differ.
+class TestTocinoExpressTransmit : public TestCase
+{
+    public:
+
+    TestTocinoExpressTransmit();
+
+    private:
+
+    // Latency in nanoseconds of each packet, by its source
+    // and the time Send accepted it
+    typedef std::map< std::pair< std::string, int64_t >, int64_t > PacketLatencies;
+
+    struct Outcome
+    {
+        uint64_t sent;
+        uint64_t received;
+        uint64_t events;
+
+        // Nanoseconds, sorted
+        std::vector< int64_t > latencies;
+
+        PacketLatencies packets;
+    };
+
+    void PacketLatency( const TocinoAddress&, Time, uint32_t, Time );
+
+    // Long packets on a 4 x 4 torus, in the named traffic
+    // pattern, at the given mean time between sends
+    Outcome Run(
+            const bool express,
+            const bool useCredits,
+            const std::string& pattern,
+            const Time );
+
+    // Packets seeing exactly the same latency in both
+    static uint32_t CountSame( const Outcome&, const Outcome& );
+
+    void Compare( const bool useCredits );
+
+    virtual void DoRun();
+
+    std::vector< int64_t > m_latencies;
+    PacketLatencies m_packets;
+};
+
+}
+
+#endif // __TEST_TOCINO_EXPRESS_TRANSMIT_H__
@@ -0,0 +1,185 @@
+/* -*- Mode:C++; c-file-style:"stroustrup"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/test.h"
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-flit.h"
+#include "ns3/tocino-flit-header.h"
+
+#include "test-tocino-flit.h"
+
+using namespace ns3;
+
+namespace 
+{
+    const TocinoAddress TEST_SRC(0);
+    const TocinoAddress TEST_DST(1);
+    const TocinoAddress TEST_VIA(2);
+    const TocinoInputVC TEST_VC(0);
+    const TocinoFlitHeader::Type TEST_TYPE( TocinoFlitHeader::ETHERNET );
+    const unsigned TEST_LEN = TocinoFlitHeader::MAX_PAYLOAD_HEAD + 1;
+}
+
+TestTocinoFlit::TestTocinoFlit()
+    : TestCase( "Tocino Flit Tests" )
+{}
+
+TestTocinoFlit::~TestTocinoFlit()
+{}
+
+void TestTocinoFlit::TestDecode()
+{
+    Ptr<TocinoNetDevice> tnd = CreateObject<TocinoNetDevice>();
+    tnd->Initialize();
+
+    Ptr<Packet> p = Create<Packet>( TEST_LEN );
+    TocinoFlittizedPacket flits;
+
+    flits = tnd->Flitter( p, TEST_SRC, TEST_DST, TEST_VC, TEST_TYPE );
+
+    NS_TEST_ASSERT_MSG_EQ( flits.size(), 2, "Incorrect number of flits" );
+
+    TocinoFlit head( flits[0] );
+    
+    NS_TEST_ASSERT_MSG_EQ( head.IsHead(), true, "Decoded head flit missing head flag?" );
+    NS_TEST_ASSERT_MSG_EQ( head.IsTail(), false, "Decoded head flit has tail flag?" );
+    NS_TEST_ASSERT_MSG_EQ( head.GetSource(), TEST_SRC, "Decoded flit has incorrect source" );
+    NS_TEST_ASSERT_MSG_EQ( head.GetDestination(), TEST_DST, "Decoded flit has incorrect destination" );
+    NS_TEST_ASSERT_MSG_EQ( head.GetType(), TEST_TYPE, "Decoded flit has incorrect type" );
+    NS_TEST_ASSERT_MSG_EQ( head.GetVirtualChannel(), TEST_VC, "Decoded flit has incorrect VC" );
+    NS_TEST_ASSERT_MSG_EQ( head.GetHeaderSize(), TocinoFlitHeader::SIZE_HEAD, "Head flit has wrong header size" );
+    
+    TocinoFlit tail( flits[1] );
+    
+    NS_TEST_ASSERT_MSG_EQ( tail.IsHead(), false, "Decoded tail flit has head flag?" );
+    NS_TEST_ASSERT_MSG_EQ( tail.IsTail(), true, "Decoded tail flit missing tail flag?" );
+    NS_TEST_ASSERT_MSG_EQ( tail.GetHeader().length, 1, "Decoded tail flit has wrong length" );
+    NS_TEST_ASSERT_MSG_EQ( tail.GetHeaderSize(), TocinoFlitHeader::SIZE_OTHER, "Tail flit has wrong header size" );
+}
+
+void TestTocinoFlit::TestSetVirtualChannel()
+{
+    Ptr<TocinoNetDevice> tnd = CreateObject<TocinoNetDevice>();
+    tnd->Initialize();
+
+    Ptr<Packet> p = Create<Packet>( TEST_LEN );
+    TocinoFlittizedPacket flits;
+
+    flits = tnd->Flitter( p, TEST_SRC, TEST_DST, TEST_VC, TEST_TYPE );
+
+    for( unsigned i = 0; i < flits.size(); ++i )
+    {
+        TocinoFlit f( flits[i] );
+        const uint32_t SIZE = f.GetSize();
+
+        f.SetVirtualChannel( 3 );
+
+        NS_TEST_ASSERT_MSG_EQ( f.GetVirtualChannel(), 3, "Decoded VC not updated" );
+        NS_TEST_ASSERT_MSG_EQ( f.GetSize(), SIZE, "Rewrite changed flit size?" );
+
+        // The serialized bytes must agree with the decoded copy
+        TocinoFlitHeader h;
+        f.GetPacket()->PeekHeader( h );
+
+        NS_TEST_ASSERT_MSG_EQ( h.GetVirtualChannel(), 3, "Serialized VC not updated" );
+        NS_TEST_ASSERT_MSG_EQ( h.IsHead(), f.IsHead(), "Rewrite changed head flag?" );
+        NS_TEST_ASSERT_MSG_EQ( h.IsTail(), f.IsTail(), "Rewrite changed tail flag?" );
+        NS_TEST_ASSERT_MSG_EQ( h.GetLength(), f.GetHeader().length, "Rewrite changed length?" );
+
+        if( f.IsHead() )
+        {
+            NS_TEST_ASSERT_MSG_EQ( h.GetDestination(), TEST_DST, "Rewrite changed destination?" );
+        }
+    }
+}
+
+void TestTocinoFlit::TestUncloak()
+{
+    Ptr<TocinoNetDevice> tnd = CreateObject<TocinoNetDevice>();
+    tnd->Initialize();
+
+    Ptr<Packet> p = Create<Packet>( TEST_LEN );
+    TocinoFlittizedPacket flits;
+
+    flits = tnd->Flitter( p, TEST_SRC, TEST_DST, TEST_VC, TEST_TYPE );
+    TocinoAddIntermediateDestination( flits, TEST_VIA );
+
+    TocinoFlit outer( flits[0] );
+    TocinoFlit inner( flits[1] );
+
+    NS_TEST_ASSERT_MSG_EQ( outer.GetType(), TocinoFlitHeader::ENCAPSULATED_PACKET, "Outer flit not encapsulated?" );
+    NS_TEST_ASSERT_MSG_EQ( outer.GetDestination(), TEST_VIA, "Outer flit has incorrect destination" );
+    NS_TEST_ASSERT_MSG_EQ( inner.IsHead(), false, "Cloaked flit decoded as head?" );
+
+    // Cloaked heads may change VC en route to the intermediate node
+    inner.SetVirtualChannel( 1 );
+    inner.Uncloak();
+
+    NS_TEST_ASSERT_MSG_EQ( inner.IsHead(), true, "Uncloaked flit is not head?" );
+    NS_TEST_ASSERT_MSG_EQ( inner.GetDestination(), TEST_DST, "Uncloaked flit has incorrect destination" );
+    NS_TEST_ASSERT_MSG_EQ( inner.GetVirtualChannel(), 1, "Uncloak lost VC rewrite?" );
+}
+
+void TestTocinoFlit::TestLightweight()
+{
+    Ptr<TocinoNetDevice> tnd = CreateObject<TocinoNetDevice>();
+    tnd->Initialize();
+
+    Ptr<Packet> p = Create<Packet>( TEST_LEN );
+    TocinoFlittizedPacket flits;
+    TocinoFlitQueue light;
+
+    flits = tnd->Flitter( p, TEST_SRC, TEST_DST, TEST_VC, TEST_TYPE );
+    light = tnd->LightweightFlitter( p, TEST_SRC, TEST_DST, TEST_VC, TEST_TYPE );
+
+    TocinoAddIntermediateDestination( flits, TEST_VIA );
+    TocinoAddIntermediateDestination( light, TEST_VIA );
+
+    NS_TEST_ASSERT_MSG_EQ( light.size(), flits.size(), "Incorrect number of lightweight flits" );
+
+    // Lightweight flits must look exactly like the real
+    // thing, down to their size on the wire
+    for( unsigned i = 0; i < flits.size(); ++i )
+    {
+        TocinoFlit f( flits[i] );
+        
+        NS_TEST_ASSERT_MSG_EQ( light[i].IsLightweight(), true, "Expected lightweight flit" );
+        NS_TEST_ASSERT_MSG_EQ( light[i].GetPacket(), p, "Lightweight flit should refer to original packet" );
+        NS_TEST_ASSERT_MSG_EQ( light[i].IsHead(), f.IsHead(), "Lightweight flit has wrong head flag" );
+        NS_TEST_ASSERT_MSG_EQ( light[i].IsTail(), f.IsTail(), "Lightweight flit has wrong tail flag" );
+        NS_TEST_ASSERT_MSG_EQ( light[i].GetType(), f.GetType(), "Lightweight flit has wrong type" );
+        NS_TEST_ASSERT_MSG_EQ( light[i].GetSize(), f.GetSize(), "Lightweight flit has wrong size" );
+
+        // Packet numbers differ, but flit numbering must not
+        const std::string lightId = light[i].GetIdString();
+        const std::string fullId = f.GetIdString();
+        NS_TEST_ASSERT_MSG_EQ( lightId.substr( lightId.find( '[' ) ),
+                fullId.substr( fullId.find( '[' ) ), "Lightweight flit has wrong id" );
+    }
+
+    NS_TEST_ASSERT_MSG_EQ( light[0].GetDestination(), TEST_VIA, "Outer head flit has incorrect destination" );
+
+    TocinoFlit inner( flits[1] );
+    inner.Uncloak();
+    light[1].Uncloak();
+   
+    NS_TEST_ASSERT_MSG_EQ( light[1].IsHead(), true, "Uncloaked lightweight flit missing head flag?" );
+    NS_TEST_ASSERT_MSG_EQ( light[1].GetDestination(), TEST_DST, "Uncloaked lightweight flit has incorrect destination" );
+    NS_TEST_ASSERT_MSG_EQ( light[1].GetSize(), inner.GetSize(), "Uncloaked lightweight flit has wrong size" );
+    NS_TEST_ASSERT_MSG_EQ( light[1].GetPayloadOffset(), 0, "Inner head flit has wrong payload offset" );
+    NS_TEST_ASSERT_MSG_EQ( light[2].GetPayloadOffset(), TocinoFlitHeader::MAX_PAYLOAD_HEAD, "Tail flit has wrong payload offset" );
+    NS_TEST_ASSERT_MSG_EQ( light[2].GetPayloadLength(), 1, "Tail flit has wrong payload length" );
+
+    light[2].SetVirtualChannel( TEST_VC.AsUInt32() + 1 );
+    NS_TEST_ASSERT_MSG_EQ( light[2].GetVirtualChannel(), TEST_VC.AsUInt32() + 1, "Lightweight VC rewrite failed" );
+}
+
+void TestTocinoFlit::DoRun( void )
+{
+    TestDecode();
+    TestSetVirtualChannel();
+    TestUncloak();
+    TestLightweight();
+}
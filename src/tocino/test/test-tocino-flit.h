@@ -0,0 +1,29 @@
+/* -*- Mode:C++; c-file-style:"stroustrup"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_FLIT_H__
+#define __TEST_TOCINO_FLIT_H__
+
+#include "ns3/test.h"
+
+namespace ns3
+{
+
+class TestTocinoFlit : public TestCase
+{
+    public:
+
+    TestTocinoFlit();
+    virtual ~TestTocinoFlit();
+
+    private:
+
+    void TestDecode();
+    void TestSetVirtualChannel();
+    void TestUncloak();
+    void TestLightweight();
+
+    virtual void DoRun( void );
+};
+
+}
+
+#endif // __TEST_TOCINO_FLIT_H__
@@ -4,6 +4,7 @@
 #include "ns3/packet.h"
 #include "ns3/tocino-flow-control.h"
 #include "ns3/tocino-flit-header.h"
+#include "ns3/tocino-flit.h"
 
 #include "test-tocino-flow-control.h"
 
@@ -30,4 +31,47 @@ void TestTocinoFlowControl::DoRun( void )
     NS_TEST_ASSERT_MSG_EQ( h.GetType(), TocinoFlitHeader::LLC, "Flow control flit should have LLC type." );
     NS_TEST_ASSERT_MSG_EQ( h.IsHead(), true, "Flow control flit is not head?" );
     NS_TEST_ASSERT_MSG_EQ( h.IsTail(), true, "Flow control flit is not tail?" );
+
+    const TocinoFlit& pf = GetPooledTocinoFlowControlFlit( fcs );
+
+    NS_TEST_ASSERT_MSG_EQ( pf.IsFlowControl(), true, "Expected flow control flit." );
+    NS_TEST_ASSERT_MSG_EQ( pf.GetFlowControlState(), fcs, "Pooled flit has unexpected FlowControlState." );
+    NS_TEST_ASSERT_MSG_EQ( GetTocinoFlowControlState( pf.GetPacket() ), fcs, "Pooled flit serialized wrong FlowControlState." );
+    NS_TEST_ASSERT_MSG_EQ( pf.GetSize(), f->GetSize(), "Pooled flit has unexpected size." );
+
+    const TocinoFlit& again = GetPooledTocinoFlowControlFlit( fcs );
+    NS_TEST_ASSERT_MSG_EQ( again.GetPacket(), pf.GetPacket(), "Expected pooled flit to be reused." );
+
+    const TocinoFlit& other = GetPooledTocinoFlowControlFlit( TocinoAllXON );
+    NS_TEST_ASSERT_MSG_EQ( other.GetFlowControlState(), TocinoAllXON, "Pooled flit has unexpected FlowControlState." );
+    NS_TEST_ASSERT_MSG_NE( other.GetPacket(), pf.GetPacket(), "Expected distinct flit per state." );
+
+    TocinoCredits credits;
+    credits.Add( 0 );
+    credits.Add( 3 );
+    credits.Add( 3 );
+
+    NS_TEST_ASSERT_MSG_EQ( credits.Get( 0 ), 1, "Unexpected credit count." );
+    NS_TEST_ASSERT_MSG_EQ( credits.Get( 1 ), 0, "Unexpected credit count." );
+    NS_TEST_ASSERT_MSG_EQ( credits.Get( 3 ), 2, "Unexpected credit count." );
+
+    Ptr<Packet> c = GetTocinoCreditFlit( credits );
+
+    NS_TEST_ASSERT_MSG_EQ( IsTocinoCreditFlit( c ), true, "Expected credit flit." );
+    NS_TEST_ASSERT_MSG_EQ( IsTocinoFlowControlFlit( c ), false, "Credit flit is not an XON/XOFF flit." );
+    NS_TEST_ASSERT_MSG_EQ( GetTocinoCredits( c ).GetPacked(), credits.GetPacked(), "Flit has unexpected credits." );
+
+    c->PeekHeader( h );
+    NS_TEST_ASSERT_MSG_EQ( h.GetType(), TocinoFlitHeader::CREDIT, "Credit flit should have CREDIT type." );
+    NS_TEST_ASSERT_MSG_EQ( h.IsHead(), false, "Credit flit should not carry a head header." );
+    NS_TEST_ASSERT_MSG_EQ( h.IsTail(), true, "Credit flit is not tail?" );
+    NS_TEST_ASSERT_MSG_LT( c->GetSize(), f->GetSize(), "Credit flit should be smaller than XON/XOFF flit." );
+
+    const TocinoFlit& pc = GetPooledTocinoCreditFlit( credits );
+
+    NS_TEST_ASSERT_MSG_EQ( pc.IsCredit(), true, "Expected credit flit." );
+    NS_TEST_ASSERT_MSG_EQ( pc.IsFlowControl(), true, "Credit flit should count as flow control." );
+    NS_TEST_ASSERT_MSG_EQ( pc.GetCredits().Get( 3 ), 2, "Pooled flit has unexpected credits." );
+    NS_TEST_ASSERT_MSG_EQ( pc.GetSize(), c->GetSize(), "Pooled flit has unexpected size." );
+    NS_TEST_ASSERT_MSG_EQ( GetPooledTocinoCreditFlit( credits ).GetPacket(), pc.GetPacket(), "Expected pooled flit to be reused." );
 }
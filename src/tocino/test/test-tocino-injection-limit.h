@@ -0,0 +1,35 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_INJECTION_LIMIT_H__
+#define __TEST_TOCINO_INJECTION_LIMIT_H__
+
+#include <stdint.h>
+
+#include "test-tocino-3d-torus.h"
+
+namespace ns3
+{
+
+class TestTocinoInjectionLimit : public TestTocino3DTorus
+{
+    public:
+
+    TestTocinoInjectionLimit( uint32_t radix );
+
+    private:
+
+    void HighWater( uint32_t, uint32_t );
+
+    void TestHelper(
+            const uint32_t,
+            uint32_t&,
+            const unsigned,
+            const uint32_t appsPerNode );
+
+    virtual void DoRun();
+
+    uint32_t m_highWater;
+};
+
+}
+
+#endif // __TEST_TOCINO_INJECTION_LIMIT_H__
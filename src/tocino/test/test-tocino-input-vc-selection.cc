@@ -0,0 +1,143 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include <vector>
+
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
+
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-channel.h"
+#include "ns3/tocino-tx.h"
+#include "ns3/tocino-torus-topology-helper.h"
+#include "ns3/tocino-traffic-patterns.h"
+#include "ns3/tocino-traffic-matrix-application.h"
+
+#include "test-tocino-input-vc-selection.h"
+
+using namespace ns3;
+
+TestTocinoInputVCSelection::TestTocinoInputVCSelection()
+    : TestCase( "Tocino Input VC Selection" )
+{}
+
+void
+TestTocinoInputVCSelection::Run(
+        const std::string& selection,
+        const std::string& classes )
+{
+    TocinoTorusTopologyHelper helper(
+            std::vector< uint32_t >( 2, 4 ),
+            std::vector< bool >( 2, true ) );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::WrapAroundRadices",
+            StringValue( helper.GetWrapAroundRadices() ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::InputVCSelection",
+            StringValue( selection ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::VCClasses",
+            StringValue( classes ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::InjectionQueueMaxFlits",
+            UintegerValue( 32 ) );
+
+    const uint32_t NODES = helper.NODES;
+
+    const TocinoSparseTrafficMatrix trafficMatrix =
+        TocinoTrafficPatterns( helper ).UniformRandom();
+
+    NodeContainer machines;
+    machines.Create( NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+    std::vector< Ptr<TocinoTrafficMatrixApplication> > applications;
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        Ptr<TocinoTrafficMatrixApplication> app =
+            CreateObject<TocinoTrafficMatrixApplication>();
+
+        applications.push_back( app );
+
+        app->Initialize( node, &machines, trafficMatrix );
+        app->AssignStreams( node * 2 );
+
+        app->SetAttribute( "MeanTimeBetweenSends", TimeValue( NanoSeconds( 50 ) ) );
+        app->SetAttribute( "MaxTimeBetweenSends", TimeValue( NanoSeconds( 500 ) ) );
+        app->SetAttribute( "TrafficClass",
+                UintegerValue( classes.empty() ? 0 : node % 2 ) );
+
+        app->SetStartTime( Seconds( 0 ) );
+        app->SetStopTime( MicroSeconds( 20 ) );
+        app->SetPacketSize( 123 );
+
+        machines.Get( node )->AddApplication( app );
+    }
+
+    Simulator::Run();
+
+    uint64_t sent = 0;
+    uint64_t received = 0;
+    uint64_t dataFlits = 0;
+    uint64_t waited = 0;
+    uint64_t datelineWaited = 0;
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        sent += applications[node]->GetPacketsSent();
+        received += applications[node]->GetPacketsReceived();
+
+        for( uint32_t port = 0; port < netDevices[node]->GetNPorts(); ++port )
+        {
+            Ptr<TocinoChannel> channel =
+                netDevices[node]->GetTransmitter( port )->GetChannel();
+
+            if( channel != NULL )
+            {
+                dataFlits += channel->GetTotalFlitsTransmitted()
+                    - channel->GetLLCFlitsTransmitted();
+            }
+        }
+
+        for( uint32_t vc = 0; vc < netDevices[node]->GetNVCs(); ++vc )
+        {
+            const uint64_t count =
+                netDevices[node]->GetInputVCWaitHistogram( vc ).GetCount();
+
+            waited += count;
+
+            if( vc % 2 )
+            {
+                datelineWaited += count;
+            }
+        }
+    }
+
+    NS_TEST_ASSERT_MSG_GT( sent, 0, selection );
+    NS_TEST_ASSERT_MSG_EQ( received, sent, selection << " lost packets" );
+
+    NS_TEST_ASSERT_MSG_EQ( waited, dataFlits,
+            selection << " missed the wait of some flits" );
+    NS_TEST_ASSERT_MSG_GT( datelineWaited, 0,
+            selection << " never used a dateline VC" );
+
+    Simulator::Destroy();
+    Config::Reset();
+}
+
+void
+TestTocinoInputVCSelection::DoRun()
+{
+    Run( "LowestFirst", "" );
+    Run( "RoundRobin", "" );
+    Run( "OldestFirst", "" );
+
+    // With one class, class priority is round-robin
+    Run( "ClassPriority", "" );
+    Run( "ClassPriority", "2,2" );
+}
@@ -0,0 +1,33 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_INPUT_VC_SELECTION_H__
+#define __TEST_TOCINO_INPUT_VC_SELECTION_H__
+
+#include <stdint.h>
+#include <string>
+
+#include "ns3/test.h"
+
+namespace ns3
+{
+
+// Every input VC selection policy must deliver everything,
+// and the per-VC wait statistics must account for every
+// flit forwarded from a network port
+class TestTocinoInputVCSelection : public TestCase
+{
+    public:
+
+    TestTocinoInputVCSelection();
+
+    private:
+
+    // Uniform random traffic on a 4 x 4 torus, under the
+    // given policy and VCClasses, with class 1 on odd nodes
+    void Run( const std::string&, const std::string& );
+
+    virtual void DoRun();
+};
+
+}
+
+#endif // __TEST_TOCINO_INPUT_VC_SELECTION_H__
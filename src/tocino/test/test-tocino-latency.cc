@@ -0,0 +1,215 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include <cmath>
+
+#include "ns3/config.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-histogram.h"
+#include "ns3/tocino-test-results.h"
+#include "ns3/tocino-torus-topology-helper.h"
+
+#include "test-tocino-latency.h"
+
+using namespace ns3;
+
+TestTocinoLatency::TestTocinoLatency()
+    : TestCase( "Tocino Latency and Hop Count Statistics" )
+    , m_traced( 0 )
+    , m_hops( 0 )
+{}
+
+void
+TestTocinoLatency::TestHistogram()
+{
+    TocinoHistogram h;
+
+    NS_TEST_ASSERT_MSG_EQ( h.GetCount(), 0, "New histogram not empty?" );
+    NS_TEST_ASSERT_MSG_EQ( h.GetPercentile( 0.5 ), 0, "Empty histogram has a median?" );
+
+    // Small values are exact
+    for( uint64_t v = 0; v < 64; ++v )
+    {
+        h.Add( v );
+    }
+
+    NS_TEST_ASSERT_MSG_EQ( h.GetCount(), 64, "Wrong count" );
+    NS_TEST_ASSERT_MSG_EQ( h.GetMin(), 0, "Wrong min" );
+    NS_TEST_ASSERT_MSG_EQ( h.GetMax(), 63, "Wrong max" );
+    NS_TEST_ASSERT_MSG_EQ( h.GetPercentile( 0.5 ), 31, "Wrong median" );
+    NS_TEST_ASSERT_MSG_EQ( h.GetPercentile( 1 ), 63, "Wrong maximum percentile" );
+    NS_TEST_ASSERT_MSG_EQ_TOL( h.GetMean(), 31.5, 1e-9, "Wrong mean" );
+
+    // Large values are within one bucket, about 3%
+    TocinoHistogram big;
+
+    for( uint64_t v = 1; v <= 100000; ++v )
+    {
+        big.Add( v );
+    }
+
+    const double QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+
+    for( uint32_t i = 0; i < 4; ++i )
+    {
+        const double exact = std::ceil( QUANTILES[i] * 100000 );
+
+        NS_TEST_ASSERT_MSG_EQ_TOL( big.GetPercentile( QUANTILES[i] ), exact,
+                exact / 32, "Percentile out of tolerance" );
+        
+        NS_TEST_ASSERT_MSG_GT_OR_EQ( big.GetPercentile( QUANTILES[i] ), exact,
+                "Percentile should be an upper bound" );
+    }
+
+    // Merging is the same as adding everything to one
+    h.Merge( big );
+
+    NS_TEST_ASSERT_MSG_EQ( h.GetCount(), 100064, "Wrong merged count" );
+    NS_TEST_ASSERT_MSG_EQ( h.GetMin(), 0, "Wrong merged min" );
+    NS_TEST_ASSERT_MSG_EQ( h.GetMax(), 100000, "Wrong merged max" );
+    NS_TEST_ASSERT_MSG_EQ( h.GetPercentile( 0.999 ), big.GetPercentile( 0.999 ),
+            "Merge changed a high percentile" );
+
+    h.Reset();
+
+    NS_TEST_ASSERT_MSG_EQ( h.GetCount(), 0, "Reset histogram not empty?" );
+    NS_TEST_ASSERT_MSG_EQ( h.GetMax(), 0, "Reset histogram has a max?" );
+}
+
+void
+TestTocinoLatency::PacketLatency(
+        const TocinoAddress&,
+        Time latency,
+        uint32_t hops,
+        Time queueing )
+{
+    m_traced++;
+    m_latency = latency;
+    m_hops = hops;
+    m_queueing = queueing;
+}
+
+void
+TestTocinoLatency::TestHelper(
+        const uint32_t RADIX,
+        const bool lightweight,
+        const unsigned BYTES,
+        const uint32_t DST,
+        const uint32_t VIA,
+        const uint32_t HOPS )
+{
+    std::vector< uint32_t > radix( 1, RADIX );
+    std::vector< bool > wrap( 1, true );
+
+    TocinoTorusTopologyHelper helper( radix, wrap );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::WrapAroundRadices",
+            StringValue( helper.GetWrapAroundRadices() ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::LightweightFlits",
+            BooleanValue( lightweight ) );
+    
+    Config::SetDefault( "ns3::TocinoNetDevice::PerSourceLatency",
+            BooleanValue( true ) );
+
+    NodeContainer machines;
+    TocinoTestResults results;
+
+    machines.Create( helper.NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+    for( uint32_t i = 0; i < helper.NODES; ++i )
+    {
+        netDevices[i]->SetReceiveCallback(
+                MakeCallback( &TocinoTestResults::AcceptPacket, &results ) );
+    }
+
+    Ptr<TocinoNetDevice> src = netDevices[0];
+    Ptr<TocinoNetDevice> dst = netDevices[DST];
+
+    dst->TraceConnectWithoutContext( "PacketLatency",
+            MakeCallback( &TestTocinoLatency::PacketLatency, this ) );
+
+    m_traced = 0;
+
+    if( VIA == 0 )
+    {
+        Simulator::ScheduleWithContext( 0, NanoSeconds( 10 ),
+                &TocinoNetDevice::Send, src, Create<Packet>( BYTES ),
+                dst->GetAddress(), 0 );
+    }
+    else
+    {
+        Simulator::ScheduleWithContext( 0, NanoSeconds( 10 ),
+                &TocinoNetDevice::SendVia, src, Create<Packet>( BYTES ),
+                dst->GetAddress(), netDevices[VIA]->GetAddress(), 0 );
+    }
+
+    Simulator::Run();
+
+    NS_TEST_ASSERT_MSG_EQ( results.GetTotalCount(), 1, "Packet not delivered?" );
+    NS_TEST_ASSERT_MSG_EQ( m_traced, 1, "PacketLatency not traced once?" );
+
+    NS_TEST_ASSERT_MSG_EQ( m_hops, HOPS, "Wrong hop count" );
+    NS_TEST_ASSERT_MSG_GT( m_latency, Time( 0 ), "No latency?" );
+
+    // Nothing else in the network to wait for
+    NS_TEST_ASSERT_MSG_EQ( m_queueing, Time( 0 ), "Queueing in an idle network?" );
+
+    const TocinoHistogram& latency = dst->GetLatencyHistogram();
+
+    NS_TEST_ASSERT_MSG_EQ( latency.GetCount(), 1, "Latency not recorded" );
+    NS_TEST_ASSERT_MSG_EQ( latency.GetMax(),
+            static_cast<uint64_t>( m_latency.GetNanoSeconds() ),
+            "Recorded latency differs from traced" );
+
+    NS_TEST_ASSERT_MSG_EQ( dst->GetHopCountHistogram().GetMax(), HOPS,
+            "Recorded hop count differs" );
+
+    const TocinoNetDevice::SourceHistograms& sources =
+        dst->GetSourceLatencyHistograms();
+
+    NS_TEST_ASSERT_MSG_EQ( sources.size(), 1, "Expected one source" );
+    NS_TEST_ASSERT_MSG_EQ( ( sources.begin()->first == src->GetTocinoAddress() ), true,
+            "Wrong source" );
+
+    // Nothing ejected elsewhere
+    NS_TEST_ASSERT_MSG_EQ( src->GetLatencyHistogram().GetCount(), 0,
+            "Latency recorded at the source?" );
+
+    dst->ResetLatencyStatistics();
+    
+    NS_TEST_ASSERT_MSG_EQ( dst->GetLatencyHistogram().GetCount(), 0,
+            "Reset did not clear latency" );
+    NS_TEST_ASSERT_MSG_EQ( dst->GetSourceLatencyHistograms().size(), 0,
+            "Reset did not clear sources" );
+
+    Simulator::Destroy();
+    Config::Reset();
+}
+
+void
+TestTocinoLatency::DoRun()
+{
+    TestHistogram();
+
+    const bool LIGHTWEIGHT[] = { false, true };
+
+    for( uint32_t i = 0; i < 2; ++i )
+    {
+        // Minimal, the short way around a 6-ring
+        TestHelper( 6, LIGHTWEIGHT[i], 20, 2, 0, 2 );
+        TestHelper( 6, LIGHTWEIGHT[i], 123, 5, 0, 1 );
+        
+        // Valiant, 0 -> 2 -> 5 continuing the same way,
+        // rather than one hop
+        TestHelper( 6, LIGHTWEIGHT[i], 123, 5, 2, 5 );
+    }
+}
@@ -0,0 +1,50 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_LATENCY_H__
+#define __TEST_TOCINO_LATENCY_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/nstime.h"
+
+#include "ns3/tocino-address.h"
+
+namespace ns3
+{
+
+// Latency, hop count and queueing delay, as recorded at
+// ejection, and the histograms which hold them
+class TestTocinoLatency : public TestCase
+{
+    public:
+
+    TestTocinoLatency();
+
+    private:
+
+    void TestHistogram();
+
+    // Send one packet from node zero of a ring, via an
+    // intermediate node if the last argument is nonzero
+    void TestHelper(
+            const uint32_t,
+            const bool,
+            const unsigned,
+            const uint32_t,
+            const uint32_t,
+            const uint32_t );
+
+    void PacketLatency( const TocinoAddress&, Time, uint32_t, Time );
+
+    uint32_t m_traced;
+    Time m_latency;
+    uint32_t m_hops;
+    Time m_queueing;
+
+    virtual void DoRun();
+};
+
+}
+
+#endif // __TEST_TOCINO_LATENCY_H__
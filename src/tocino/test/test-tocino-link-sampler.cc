@@ -0,0 +1,249 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include <sstream>
+#include <string>
+
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/boolean.h"
+#include "ns3/type-id.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+
+#include "ns3/tocino-bitmask-arbiter.h"
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-channel.h"
+#include "ns3/tocino-tx.h"
+#include "ns3/tocino-test-results.h"
+#include "ns3/tocino-torus-topology-helper.h"
+#include "ns3/tocino-link-sampler.h"
+
+#include "test-tocino-link-sampler.h"
+
+using namespace ns3;
+
+TestTocinoLinkSampler::TestTocinoLinkSampler()
+    : TestCase( "Tocino Link Utilization Sampler" )
+{}
+
+void
+TestTocinoLinkSampler::TestRing()
+{
+    std::vector< uint32_t > radix( 1, 4 );
+    std::vector< bool > wrap( 1, true );
+
+    TocinoTorusTopologyHelper helper( radix, wrap );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::WrapAroundRadices",
+            StringValue( helper.GetWrapAroundRadices() ) );
+
+    NodeContainer machines;
+    TocinoTestResults results;
+
+    machines.Create( helper.NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+    for( uint32_t i = 0; i < helper.NODES; ++i )
+    {
+        netDevices[i]->SetReceiveCallback(
+                MakeCallback( &TocinoTestResults::AcceptPacket, &results ) );
+    }
+
+    for( uint32_t src = 0; src < helper.NODES; ++src )
+    {
+        for( uint32_t dst = 0; dst < helper.NODES; ++dst )
+        {
+            if( src == dst ) continue;
+
+            Simulator::ScheduleWithContext( src, NanoSeconds( 1 ),
+                    &TocinoNetDevice::Send, netDevices[src],
+                    Create<Packet>( 200 ), netDevices[dst]->GetAddress(), 0 );
+        }
+    }
+
+    // Samples at 0, 500, ..., 10000ns; one sampler keeps
+    // them all, the other only the last eight
+    const uint32_t SAMPLES = 21;
+    const uint32_t SMALL = 8;
+
+    TocinoLinkSampler all( netDevices, 32 );
+    TocinoLinkSampler last( netDevices, SMALL );
+
+    all.Start( NanoSeconds( 500 ), NanoSeconds( 10000 ) );
+    last.Start( NanoSeconds( 500 ), NanoSeconds( 10000 ) );
+
+    Simulator::Run();
+
+    NS_TEST_ASSERT_MSG_EQ( results.GetTotalCount(),
+            helper.NODES * ( helper.NODES - 1 ), "Packets lost?" );
+
+    // Two links per node in a ring; none from the host port
+    NS_TEST_ASSERT_MSG_EQ( all.GetNLinks(), helper.NODES * 2, "Wrong link count" );
+
+    NS_TEST_ASSERT_MSG_EQ( all.GetNSamples(), SAMPLES, "Wrong sample count" );
+    NS_TEST_ASSERT_MSG_EQ( last.GetNSamples(), SMALL, "Ring did not fill" );
+    NS_TEST_ASSERT_MSG_EQ( last.GetNIntervals(), SMALL - 1, "Wrong interval count" );
+
+    const uint32_t SKIPPED = all.GetNIntervals() - last.GetNIntervals();
+
+    for( uint32_t i = 0; i < last.GetNIntervals(); ++i )
+    {
+        NS_TEST_ASSERT_MSG_EQ( last.GetIntervalEnd( i ),
+                all.GetIntervalEnd( SKIPPED + i ), "Wrong interval after wrap" );
+    }
+
+    for( uint32_t link = 0; link < all.GetNLinks(); ++link )
+    {
+        Ptr<TocinoChannel> channel =
+            netDevices[ all.GetLinkNode( link ) ]->GetTransmitter(
+                    all.GetLinkPort( link ) )->GetChannel();
+
+        uint32_t flits = 0;
+        double busy = 0;
+
+        for( uint32_t i = 0; i < all.GetNIntervals(); ++i )
+        {
+            const double utilization = all.GetUtilization( i, link );
+
+            NS_TEST_ASSERT_MSG_GT_OR_EQ( utilization, 0, "Negative utilization" );
+            NS_TEST_ASSERT_MSG_LT_OR_EQ( utilization, 1, "Utilization above one" );
+
+            busy += utilization * 500;
+
+            for( uint32_t vc = 0; vc < all.GetNVCs(); ++vc )
+            {
+                flits += all.GetVCFlits( i, link, vc );
+            }
+        }
+
+        // The run was over by the last sample
+        NS_TEST_ASSERT_MSG_EQ( flits, channel->GetTotalFlitsTransmitted(),
+                "Per-interval flits do not add up" );
+        NS_TEST_ASSERT_MSG_EQ_TOL( busy,
+                channel->GetTotalTransmitTime().GetNanoSeconds(), 1e-6,
+                "Per-interval busy time does not add up" );
+
+        for( uint32_t i = 0; i < last.GetNIntervals(); ++i )
+        {
+            NS_TEST_ASSERT_MSG_EQ( last.GetUtilization( i, link ),
+                    all.GetUtilization( SKIPPED + i, link ), "Wrapped ring differs" );
+            NS_TEST_ASSERT_MSG_EQ( last.GetVCFlits( i, link, 0 ),
+                    all.GetVCFlits( SKIPPED + i, link, 0 ), "Wrapped ring differs" );
+        }
+    }
+
+    // Header plus a line per interval
+    std::ostringstream oss;
+    all.WriteUtilizationMatrix( oss );
+
+    const std::string text = oss.str();
+    uint32_t lines = 0;
+
+    for( uint32_t i = 0; i < text.size(); ++i )
+    {
+        if( text[i] == '\n' ) lines++;
+    }
+
+    NS_TEST_ASSERT_MSG_EQ( lines, all.GetNIntervals() + 1, "Wrong matrix line count" );
+    NS_TEST_ASSERT_MSG_EQ( text.compare( 0, 12, "time_ns,0:0," ), 0,
+            "Wrong matrix header" );
+
+    Simulator::Destroy();
+    Config::Reset();
+}
+
+std::vector< double >
+TestTocinoLinkSampler::SampleNeighborTraffic( const bool express )
+{
+    std::vector< uint32_t > radix( 1, 4 );
+    std::vector< bool > wrap( 1, true );
+
+    TocinoTorusTopologyHelper helper( radix, wrap );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::WrapAroundRadices",
+            StringValue( helper.GetWrapAroundRadices() ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::ExpressTransmit",
+            BooleanValue( express ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::ArbiterType",
+            TypeIdValue( TocinoBitmaskArbiter::GetTypeId() ) );
+
+    NodeContainer machines;
+    TocinoTestResults results;
+
+    machines.Create( helper.NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+    for( uint32_t src = 0; src < helper.NODES; ++src )
+    {
+        const uint32_t dst = ( src + 1 ) % helper.NODES;
+
+        netDevices[dst]->SetReceiveCallback(
+                MakeCallback( &TocinoTestResults::AcceptPacket, &results ) );
+
+        Simulator::ScheduleWithContext( src, NanoSeconds( 1 ),
+                &TocinoNetDevice::Send, netDevices[src],
+                Create<Packet>( 1000 ), netDevices[dst]->GetAddress(), 0 );
+    }
+
+    // Several samples within each run of flits
+    TocinoLinkSampler sampler( netDevices, 128 );
+
+    sampler.Start( NanoSeconds( 10 ), NanoSeconds( 1000 ) );
+
+    Simulator::Run();
+
+    NS_TEST_EXPECT_MSG_EQ( results.GetTotalCount(), helper.NODES, "Packets lost?" );
+
+    std::vector< double > samples;
+
+    for( uint32_t i = 0; i < sampler.GetNIntervals(); ++i )
+    {
+        for( uint32_t link = 0; link < sampler.GetNLinks(); ++link )
+        {
+            for( uint32_t vc = 0; vc < sampler.GetNVCs(); ++vc )
+            {
+                samples.push_back( sampler.GetVCFlits( i, link, vc ) );
+            }
+
+            samples.push_back( sampler.GetUtilization( i, link ) * 10 );
+        }
+    }
+
+    Simulator::Destroy();
+    Config::Reset();
+
+    return samples;
+}
+
+void
+TestTocinoLinkSampler::TestExpress()
+{
+    // N.B.
+    // An express run commits to all its flits when it
+    // begins.  Each must still be counted only once it
+    // starts, in the interval it would have been counted
+    // in anyway.
+    const std::vector< double > slow = SampleNeighborTraffic( false );
+    const std::vector< double > fast = SampleNeighborTraffic( true );
+
+    NS_TEST_ASSERT_MSG_EQ( fast.size(), slow.size(), "Wrong sample count" );
+
+    for( uint32_t i = 0; i < slow.size(); ++i )
+    {
+        NS_TEST_ASSERT_MSG_EQ_TOL( fast[i], slow[i], 1e-6,
+                "Express sample " << i << " differs" );
+    }
+}
+
+void
+TestTocinoLinkSampler::DoRun()
+{
+    TestRing();
+    TestExpress();
+}
@@ -0,0 +1,35 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_LINK_SAMPLER_H__
+#define __TEST_TOCINO_LINK_SAMPLER_H__
+
+#include <vector>
+
+#include "ns3/test.h"
+
+namespace ns3
+{
+
+// Link utilization time series, including what is kept
+// once the ring buffers wrap, and with express transmission
+class TestTocinoLinkSampler : public TestCase
+{
+    public:
+
+    TestTocinoLinkSampler();
+
+    private:
+
+    // Per-interval flits of every link and VC, then busy
+    // nanoseconds of every link, with one long packet
+    // sent to each node's neighbor
+    std::vector< double > SampleNeighborTraffic( const bool express );
+
+    void TestRing();
+    void TestExpress();
+
+    virtual void DoRun();
+};
+
+}
+
+#endif // __TEST_TOCINO_LINK_SAMPLER_H__
@@ -0,0 +1,91 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include <vector>
+
+#include "ns3/data-rate.h"
+#include "ns3/simulator.h"
+
+#include "ns3/tocino-channel.h"
+#include "ns3/tocino-net-device.h"
+
+#include "test-tocino-partition.h"
+
+using namespace ns3;
+
+TestTocinoPartition::TestTocinoPartition( uint32_t radix )
+    : TestTocino3DTorus( radix, true, false, " partitioned into slabs" )
+{}
+
+void
+TestTocinoPartition::TestSlabs( const uint32_t slabs )
+{
+    std::vector< uint32_t > planes( slabs, 0 );
+
+    uint32_t prev = 0;
+
+    for( uint32_t x = 0; x < RADIX; ++x )
+    {
+        const uint32_t slab =
+            m_helper.GetSlab( TocinoAddress( x, 0, 0 ), slabs );
+
+        NS_TEST_ASSERT_MSG_LT( slab, slabs, "Slab out of range" );
+
+        NS_TEST_ASSERT_MSG_EQ( ( slab == prev ) || ( slab == prev+1 ), true,
+                "Slabs must be contiguous" );
+
+        // Slabs cut only along X
+        NS_TEST_ASSERT_MSG_EQ(
+                m_helper.GetSlab( TocinoAddress( x, RADIX-1, RADIX-1 ), slabs ),
+                slab,
+                "Slab should not depend on Y or Z" );
+
+        planes[slab]++;
+        prev = slab;
+    }
+
+    for( uint32_t s = 0; s < slabs; ++s )
+    {
+        NS_TEST_ASSERT_MSG_GT( planes[s], 0, "Empty slab" );
+
+        NS_TEST_ASSERT_MSG_LT_OR_EQ( planes[s], ( RADIX + slabs - 1 ) / slabs,
+                "Unbalanced slabs" );
+    }
+}
+
+void
+TestTocinoPartition::DoRun()
+{
+    // N.B.
+    // Any appreciable channel delay demands more flit buffers
+    // than TocinoRx provides, so we use the default of zero.
+    const Time DELAY = Seconds( 0 );
+
+    NodeContainer machines;
+    machines.Create( NODES );
+
+    Tocino3DTorusNetDeviceContainer netDevices =
+        m_helper.Install( machines );
+
+    for( uint32_t slabs = 1; slabs <= RADIX; ++slabs )
+    {
+        TestSlabs( slabs );
+    }
+
+    NS_TEST_ASSERT_MSG_EQ( m_helper.GetSlabLookahead( netDevices, 1 ), Time::Max(),
+            "A single slab should have no boundary" );
+
+    const Time LOOKAHEAD = m_helper.GetSlabLookahead( netDevices, 2 );
+   
+    // Bounded by the wire delay below, and by a full
+    // flit on the wire above
+    NS_TEST_ASSERT_MSG_GT( LOOKAHEAD, DELAY, "Lookahead too small" );
+
+    const Time FULL_FLIT = Seconds( DataRate( "10Gbps" ).CalculateTxTime(
+                TocinoFlitHeader::FLIT_LENGTH ) );
+
+    NS_TEST_ASSERT_MSG_LT( LOOKAHEAD, DELAY + FULL_FLIT, "Lookahead too large" );
+
+    CheckAllQuiet( netDevices );
+
+    Simulator::Destroy();
+}
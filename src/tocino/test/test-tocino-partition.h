@@ -0,0 +1,27 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_PARTITION_H__
+#define __TEST_TOCINO_PARTITION_H__
+
+#include <stdint.h>
+
+#include "test-tocino-3d-torus.h"
+
+namespace ns3
+{
+
+class TestTocinoPartition : public TestTocino3DTorus
+{
+    public:
+
+    TestTocinoPartition( uint32_t radix );
+
+    private:
+
+    void TestSlabs( const uint32_t );
+
+    virtual void DoRun();
+};
+
+}
+
+#endif // __TEST_TOCINO_PARTITION_H__
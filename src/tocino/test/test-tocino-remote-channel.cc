@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-flit.h"
+#include "ns3/tocino-flit-id-tag.h"
+#include "ns3/tocino-flow-control.h"
+#include "ns3/tocino-remote-channel.h"
+
+#include "test-tocino-remote-channel.h"
+
+using namespace ns3;
+
+namespace
+{
+
+std::vector< uint8_t >
+GetBytes( Ptr<const Packet> p )
+{
+    std::vector< uint8_t > bytes( p->GetSize() );
+
+    p->CopyData( &bytes[0], bytes.size() );
+
+    return bytes;
+}
+
+TocinoFlitIdTag
+GetTag( const TocinoFlit& flit )
+{
+    TocinoFlitIdTag tag;
+
+    flit.GetPacket()->PeekPacketTag( tag );
+
+    return tag;
+}
+
+}
+
+TestTocinoRemoteChannel::TestTocinoRemoteChannel()
+    : TestCase( "Tocino Remote Channel Wire Format" )
+{}
+
+void
+TestTocinoRemoteChannel::TestData()
+{
+    Ptr<TocinoNetDevice> tnd = CreateObject<TocinoNetDevice>();
+    tnd->Initialize();
+
+    std::vector< uint8_t > payload( 300 );
+
+    for( uint32_t i = 0; i < payload.size(); ++i )
+    {
+        payload[i] = i * 7;
+    }
+
+    TocinoFlittizedPacket flits = tnd->Flitter(
+            Create<Packet>( &payload[0], payload.size() ),
+            TocinoAddress( 1, 2, 3 ),
+            TocinoAddress( 3, 2, 1 ),
+            TocinoInputVC( 5 ),
+            TocinoFlitHeader::ETHERNET );
+
+    NS_TEST_ASSERT_MSG_GT( flits.size(), 2, "Want head, body and tail flits" );
+
+    for( uint32_t i = 0; i < flits.size(); ++i )
+    {
+        TocinoFlit flit( flits[i] );
+
+        TocinoFlitStamp& stamp = flit.GetStamp();
+
+        stamp.injected = NanoSeconds( 1234567 );
+        stamp.queueing = NanoSeconds( 890 );
+        stamp.hops = 11;
+
+        uint32_t port = 0;
+
+        const TocinoFlit copy = TocinoRemoteChannel::Deserialize(
+                TocinoRemoteChannel::Serialize( flit, 4 ), port );
+
+        NS_TEST_ASSERT_MSG_EQ( port, 4, "Wrong port" );
+
+        NS_TEST_ASSERT_MSG_EQ( ( GetBytes( copy.GetPacket() ) == GetBytes( flit.GetPacket() ) ),
+                true, "Flit bytes differ" );
+
+        const TocinoFlitIdTag tag = GetTag( flit );
+        const TocinoFlitIdTag copyTag = GetTag( copy );
+
+        NS_TEST_ASSERT_MSG_EQ( copyTag.GetAbsolutePacketNumber(),
+                tag.GetAbsolutePacketNumber(), "Wrong packet number" );
+        NS_TEST_ASSERT_MSG_EQ( copyTag.GetRelativeFlitNumber(),
+                tag.GetRelativeFlitNumber(), "Wrong flit number" );
+        NS_TEST_ASSERT_MSG_EQ( copyTag.GetTotalFlitsInPacket(),
+                tag.GetTotalFlitsInPacket(), "Wrong flit count" );
+
+        NS_TEST_ASSERT_MSG_EQ( copy.IsHead(), flit.IsHead(), "Wrong head flag" );
+        NS_TEST_ASSERT_MSG_EQ( copy.IsTail(), flit.IsTail(), "Wrong tail flag" );
+        NS_TEST_ASSERT_MSG_EQ( copy.GetVirtualChannel(), flit.GetVirtualChannel(),
+                "Wrong VC" );
+        NS_TEST_ASSERT_MSG_EQ( copy.GetSize(), flit.GetSize(), "Wrong size" );
+
+        NS_TEST_ASSERT_MSG_EQ( copy.GetStamp().injected, stamp.injected,
+                "Wrong injection time" );
+        NS_TEST_ASSERT_MSG_EQ( copy.GetStamp().queueing, stamp.queueing,
+                "Wrong queueing time" );
+        NS_TEST_ASSERT_MSG_EQ( copy.GetStamp().hops, stamp.hops, "Wrong hop count" );
+    }
+}
+
+void
+TestTocinoRemoteChannel::TestFlowControl()
+{
+    TocinoFlowControlState xState( TocinoAllXON );
+
+    xState.reset( 0 );
+    xState.reset( 9 );
+    xState.reset( 15 );
+
+    const TocinoFlit& flit = GetPooledTocinoFlowControlFlit( xState );
+
+    uint32_t port = 0;
+
+    const TocinoFlit copy = TocinoRemoteChannel::Deserialize(
+            TocinoRemoteChannel::Serialize( flit, 2 ), port );
+
+    NS_TEST_ASSERT_MSG_EQ( port, 2, "Wrong port" );
+    NS_TEST_ASSERT_MSG_EQ( copy.IsFlowControl(), true, "Not an LLC flit" );
+    NS_TEST_ASSERT_MSG_EQ( copy.IsCredit(), false, "Became a credit flit?" );
+    NS_TEST_ASSERT_MSG_EQ( copy.GetFlowControlState(), xState, "Wrong XON/XOFF state" );
+
+    NS_TEST_ASSERT_MSG_EQ( ( GetBytes( copy.GetPacket() ) == GetBytes( flit.GetPacket() ) ),
+            true, "Flit bytes differ" );
+}
+
+void
+TestTocinoRemoteChannel::TestCredits()
+{
+    TocinoCredits credits;
+
+    for( uint32_t vc = 0; vc < TOCINO_MAX_VCS; vc += 3 )
+    {
+        for( uint32_t i = 0; i <= vc % TocinoCredits::MAX_CREDITS; ++i )
+        {
+            credits.Add( vc );
+        }
+    }
+
+    credits.Add( 1 );
+
+    const TocinoFlit& flit = GetPooledTocinoCreditFlit( credits );
+
+    uint32_t port = 0;
+
+    const TocinoFlit copy = TocinoRemoteChannel::Deserialize(
+            TocinoRemoteChannel::Serialize( flit, 6 ), port );
+
+    NS_TEST_ASSERT_MSG_EQ( port, 6, "Wrong port" );
+    NS_TEST_ASSERT_MSG_EQ( copy.IsCredit(), true, "Not a credit flit" );
+
+    for( uint32_t vc = 0; vc < TOCINO_MAX_VCS; ++vc )
+    {
+        NS_TEST_ASSERT_MSG_EQ( copy.GetCredits().Get( vc ), credits.Get( vc ),
+                "Wrong credits on VC " << vc );
+    }
+
+    NS_TEST_ASSERT_MSG_EQ( ( GetBytes( copy.GetPacket() ) == GetBytes( flit.GetPacket() ) ),
+            true, "Flit bytes differ" );
+}
+
+void
+TestTocinoRemoteChannel::DoRun()
+{
+    TestData();
+    TestFlowControl();
+    TestCredits();
+}
@@ -0,0 +1,29 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_REMOTE_CHANNEL_H__
+#define __TEST_TOCINO_REMOTE_CHANNEL_H__
+
+#include "ns3/test.h"
+
+namespace ns3
+{
+
+// Flits must survive the trip between MPI ranks intact;
+// exercised here without MPI, through the wire format alone
+class TestTocinoRemoteChannel : public TestCase
+{
+    public:
+
+    TestTocinoRemoteChannel();
+
+    private:
+
+    void TestData();
+    void TestFlowControl();
+    void TestCredits();
+
+    virtual void DoRun();
+};
+
+}
+
+#endif // __TEST_TOCINO_REMOTE_CHANNEL_H__
@@ -0,0 +1,247 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/boolean.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-flit.h"
+#include "ns3/tocino-rx.h"
+#include "ns3/tocino-dimension-order-router.h"
+#include "ns3/tocino-test-results.h"
+#include "ns3/tocino-traffic-matrix-application.h"
+
+#include "test-tocino-routing-lookup-table.h"
+
+using namespace ns3;
+
+TestTocinoRoutingLookupTable::TestTocinoRoutingLookupTable()
+    : TestCase( "Tocino Dimension-Order Routing via Lookup Table" )
+{}
+
+void
+TestTocinoRoutingLookupTable::TestRoutes(
+        const TocinoTorusTopologyHelper& helper,
+        const TocinoTorusNetDeviceContainer& netDevices )
+{
+    for( uint32_t node = 0; node < helper.NODES; ++node )
+    {
+        Ptr<TocinoNetDevice> tnd = netDevices[node];
+        
+        for( uint32_t port = 0; port < tnd->GetNPorts(); ++port )
+        {
+            Ptr<TocinoRouter> table = tnd->GetReceiver( port )->GetRouter();
+            
+            // Same wrap-around, but no table
+            Ptr<TocinoDimensionOrderRouter> computed =
+                CreateObject<TocinoDimensionOrderRouter>();
+
+            computed->SetLookupTableRadices( "" );
+            computed->Initialize( PeekPointer( tnd ), port );
+
+            for( uint32_t dest = 0; dest < helper.NODES; ++dest )
+            {
+                TocinoFlittizedPacket flits = tnd->Flitter(
+                        Create<Packet>( 1 ),
+                        helper.IndexToTocinoAddress( dest ),
+                        helper.IndexToTocinoAddress( dest ),
+                        0,
+                        TocinoFlitHeader::ETHERNET );
+
+                const TocinoFlit head( flits[0] );
+
+                NS_TEST_ASSERT_MSG_EQ( ( table->Route( head ) == computed->Route( head ) ), true,
+                        "Compiled route differs from computed route" );
+            }
+        }
+    }
+}
+
+void
+TestTocinoRoutingLookupTable::TestTableBytes(
+        const TocinoTorusTopologyHelper& helper,
+        const TocinoTorusNetDeviceContainer& netDevices,
+        const bool shared )
+{
+    const uint32_t PORTS = 2*helper.DIMENSIONS + 1;
+
+    uint64_t ownedBytes = 0;
+    
+    for( uint32_t node = 0; node < helper.NODES; ++node )
+    {
+        for( uint32_t port = 0; port < PORTS; ++port )
+        {
+            Ptr<TocinoDimensionOrderRouter> router =
+                DynamicCast<TocinoDimensionOrderRouter>(
+                        netDevices[node]->GetReceiver( port )->GetRouter() );
+
+            ownedBytes += router->GetLookupTableBytes();
+        }
+    }
+
+    const uint64_t totalBytes =
+        TocinoDimensionOrderRouter::GetTotalLookupTableBytes();
+
+    NS_TEST_ASSERT_MSG_EQ( ownedBytes, totalBytes,
+            "Per-router table bytes do not add up" );
+   
+    // One byte per destination, per device or per input port
+    uint64_t expectedBytes = helper.NODES * helper.NODES;
+
+    if( !shared )
+    {
+        expectedBytes *= PORTS;
+    }
+
+    NS_TEST_ASSERT_MSG_EQ( totalBytes, expectedBytes,
+            "Unexpected lookup table size" );
+}
+
+void
+TestTocinoRoutingLookupTable::TestDelivery(
+        TocinoTorusTopologyHelper& helper,
+        const unsigned BYTES )
+{
+    const uint32_t NODES = helper.NODES;
+
+    TocinoTrafficMatrix trafficMatrix( NODES );
+
+    for( uint32_t src = 0; src < NODES; ++src )
+    {
+        trafficMatrix[src].assign( NODES, TOCINO_TOTAL_TRAFFIC/NODES );
+    }
+
+    NodeContainer machines;
+    TocinoTestResults results;
+    std::vector< Ptr<TocinoTrafficMatrixApplication> > applications;
+
+    machines.Create( NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        Ptr<TocinoTrafficMatrixApplication> app =
+                CreateObject<TocinoTrafficMatrixApplication>();
+    
+        applications.push_back(app);
+
+        app->Initialize( node, &machines, trafficMatrix );
+
+        app->SetReceiveCallback( 
+                MakeCallback( &TocinoTestResults::AcceptPacket, &results ) );
+        
+        app->SetStartTime( Seconds( 0.0 ) );
+        app->SetStopTime( Seconds( 0.1 ) );
+        app->SetPacketSize( BYTES );
+        
+        machines.Get( node )->AddApplication( app );
+    }
+
+    Simulator::Run();
+
+    bool aq = true;
+    uint32_t totalPackets = 0;
+    
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        aq &= netDevices[node]->AllQuiet();
+        totalPackets += applications[node]->GetPacketsSent();
+    }
+
+    NS_TEST_ASSERT_MSG_EQ( aq, true, "not all quiet?" );
+    
+    NS_TEST_ASSERT_MSG_GT( totalPackets, 0, "Nothing sent?" );
+
+    NS_TEST_ASSERT_MSG_EQ( results.GetTotalCount(), totalPackets,
+            "Unexpected total packet count" );
+
+    NS_TEST_ASSERT_MSG_EQ( results.GetTotalBytes(), BYTES * totalPackets,
+            "Unexpected total packet bytes" );
+
+    Simulator::Destroy();
+}
+
+void
+TestTocinoRoutingLookupTable::TestTopology(
+        const std::vector< uint32_t >& radix,
+        const std::vector< bool >& wrap )
+{
+    TocinoTorusTopologyHelper helper( radix, wrap );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::WrapAroundRadices",
+            StringValue( helper.GetWrapAroundRadices() ) );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::LookupTableRadices",
+            StringValue( helper.GetRadices() ) );
+
+    const bool SHARED[] = { true, false };
+
+    for( uint32_t i = 0; i < 2; ++i )
+    {
+        Config::SetDefault(
+                "ns3::TocinoDimensionOrderRouter::ShareLookupTable",
+                BooleanValue( SHARED[i] ) );
+
+        NodeContainer machines;
+        machines.Create( helper.NODES );
+
+        TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+        TestRoutes( helper, netDevices );
+        TestTableBytes( helper, netDevices, SHARED[i] );
+
+        Simulator::Destroy();
+        netDevices.clear();
+        
+        NS_TEST_ASSERT_MSG_EQ( TocinoDimensionOrderRouter::GetTotalLookupTableBytes(), 0,
+                "Lookup tables outlived their routers" );
+    }
+
+    TestDelivery( helper, 123 );
+
+    Config::Reset();
+}
+
+void
+TestTocinoRoutingLookupTable::DoRun()
+{
+    std::vector< uint32_t > radix;
+    std::vector< bool > wrap;
+    
+    // 4x3x2, a mesh in Y only
+    radix.push_back( 4 ); wrap.push_back( true );
+    radix.push_back( 3 ); wrap.push_back( false );
+    radix.push_back( 2 ); wrap.push_back( true );
+
+    TestTopology( radix, wrap );
+
+    // 3x2x2x3, using the fourth dimension
+    radix.clear(); wrap.clear();
+
+    radix.push_back( 3 ); wrap.push_back( false );
+    radix.push_back( 2 ); wrap.push_back( true );
+    radix.push_back( 2 ); wrap.push_back( false );
+    radix.push_back( 3 ); wrap.push_back( true );
+
+    TestTopology( radix, wrap );
+
+    // N.B.
+    // Bounced packets continue in their original
+    // direction, leaving the compiled route.  This
+    // requires wrap-around in every dimension.
+    radix.clear(); wrap.clear();
+
+    radix.push_back( 5 ); wrap.push_back( true );
+    radix.push_back( 4 ); wrap.push_back( true );
+    
+    Config::SetDefault( 
+            "ns3::TocinoTrafficMatrixApplication::EnableValiantLoadBalancing",
+            BooleanValue( true ) );
+
+    TestTopology( radix, wrap );
+}
@@ -0,0 +1,46 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_ROUTING_LOOKUP_TABLE_H__
+#define __TEST_TOCINO_ROUTING_LOOKUP_TABLE_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/test.h"
+
+#include "ns3/tocino-torus-topology-helper.h"
+
+namespace ns3
+{
+
+// Routes compiled into a lookup table must match those
+// computed on the fly
+class TestTocinoRoutingLookupTable : public TestCase
+{
+    public:
+
+    TestTocinoRoutingLookupTable();
+
+    private:
+
+    // Compare every device, input port and destination
+    void TestRoutes(
+            const TocinoTorusTopologyHelper&,
+            const TocinoTorusNetDeviceContainer& );
+
+    void TestTableBytes(
+            const TocinoTorusTopologyHelper&,
+            const TocinoTorusNetDeviceContainer&,
+            const bool );
+
+    void TestDelivery( TocinoTorusTopologyHelper&, const unsigned );
+
+    void TestTopology(
+            const std::vector< uint32_t >&,
+            const std::vector< bool >& );
+
+    virtual void DoRun();
+};
+
+}
+
+#endif // __TEST_TOCINO_ROUTING_LOOKUP_TABLE_H__
@@ -0,0 +1,247 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include <sstream>
+#include <string>
+
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-channel.h"
+#include "ns3/tocino-arbiter.h"
+#include "ns3/tocino-tx.h"
+#include "ns3/tocino-test-results.h"
+#include "ns3/tocino-torus-topology-helper.h"
+#include "ns3/tocino-stats-collector.h"
+
+#include "test-tocino-stats.h"
+
+using namespace ns3;
+
+namespace
+{
+
+uint32_t
+ReadU32( const std::string& data, const uint32_t offset )
+{
+    uint32_t value = 0;
+
+    for( uint32_t i = 0; i < 4 && offset + i < data.size(); ++i )
+    {
+        value |= static_cast<uint8_t>( data[ offset + i ] ) << ( 8 * i );
+    }
+
+    return value;
+}
+
+}
+
+TestTocinoStats::TestTocinoStats()
+    : TestCase( "Tocino Statistics Collector" )
+{}
+
+void
+TestTocinoStats::DoRun()
+{
+    std::vector< uint32_t > radix( 1, 4 );
+    std::vector< bool > wrap( 1, true );
+
+    TocinoTorusTopologyHelper helper( radix, wrap );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::WrapAroundRadices",
+            StringValue( helper.GetWrapAroundRadices() ) );
+
+    NodeContainer machines;
+    TocinoTestResults results;
+
+    machines.Create( helper.NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+    for( uint32_t i = 0; i < helper.NODES; ++i )
+    {
+        netDevices[i]->SetReceiveCallback(
+                MakeCallback( &TocinoTestResults::AcceptPacket, &results ) );
+    }
+
+    // Everyone sends to everyone else, at once
+    const uint32_t COUNT = 4;
+
+    for( uint32_t src = 0; src < helper.NODES; ++src )
+    {
+        for( uint32_t dst = 0; dst < helper.NODES; ++dst )
+        {
+            if( src == dst ) continue;
+
+            for( uint32_t i = 0; i < COUNT; ++i )
+            {
+                Simulator::ScheduleWithContext( src, NanoSeconds( 1 ),
+                        &TocinoNetDevice::Send, netDevices[src],
+                        Create<Packet>( 200 ), netDevices[dst]->GetAddress(), 0 );
+            }
+        }
+    }
+
+    TocinoStatsCollector stats( netDevices );
+
+    const uint32_t PORTS = netDevices[0]->GetNPorts();
+    const uint32_t VCS = netDevices[0]->GetNVCs();
+
+    NS_TEST_ASSERT_MSG_EQ( stats.GetRowsPerSample(), helper.NODES * PORTS,
+            "Expected a row per transmitter" );
+    NS_TEST_ASSERT_MSG_EQ( stats.GetNVCs(), VCS, "Wrong VC count" );
+
+    // Samples at 0, 100, ..., 1000ns, then stop on our own
+    stats.SampleEvery( NanoSeconds( 100 ), NanoSeconds( 1000 ) );
+
+    Simulator::Run();
+
+    const uint32_t PERIODIC_ROWS = 11 * stats.GetRowsPerSample();
+
+    NS_TEST_ASSERT_MSG_EQ( results.GetTotalCount(),
+            helper.NODES * ( helper.NODES - 1 ) * COUNT, "Packets lost?" );
+
+    NS_TEST_ASSERT_MSG_EQ( stats.GetNRows(), PERIODIC_ROWS,
+            "Wrong number of periodic rows" );
+
+    // The final sample, once quiet
+    stats.Sample();
+
+    NS_TEST_ASSERT_MSG_EQ( stats.GetNRows(),
+            PERIODIC_ROWS + stats.GetRowsPerSample(), "Final sample missing" );
+
+    uint32_t totalFlits = 0;
+
+    for( uint32_t row = PERIODIC_ROWS; row < stats.GetNRows(); ++row )
+    {
+        const uint32_t node = stats.Get( TocinoStatsCollector::NODE, row );
+        const uint32_t port = stats.Get( TocinoStatsCollector::PORT, row );
+
+        NS_TEST_ASSERT_MSG_EQ( stats.Get( TocinoStatsCollector::TIME_NS, row ),
+                static_cast<uint64_t>( Simulator::Now().GetNanoSeconds() ),
+                "Wrong sample time" );
+
+        const TocinoTx* tx = netDevices[node]->GetTransmitter( port );
+        Ptr<TocinoChannel> channel = tx->GetChannel();
+
+        if( channel == NULL )
+        {
+            NS_TEST_ASSERT_MSG_EQ( port, netDevices[node]->GetHostPort(),
+                    "Only the host port lacks a channel in a torus" );
+            NS_TEST_ASSERT_MSG_EQ( stats.Get( TocinoStatsCollector::FLITS, row ), 0,
+                    "Flits on the host port?" );
+        }
+        else
+        {
+            NS_TEST_ASSERT_MSG_EQ( stats.Get( TocinoStatsCollector::BYTES, row ),
+                    channel->GetTotalBytesTransmitted(), "Wrong bytes" );
+            NS_TEST_ASSERT_MSG_EQ( stats.Get( TocinoStatsCollector::FLITS, row ),
+                    channel->GetTotalFlitsTransmitted(), "Wrong flits" );
+            NS_TEST_ASSERT_MSG_EQ( stats.Get( TocinoStatsCollector::LLC_BYTES, row ),
+                    channel->GetLLCBytesTransmitted(), "Wrong LLC bytes" );
+            NS_TEST_ASSERT_MSG_EQ( stats.Get( TocinoStatsCollector::BUSY_NS, row ),
+                    static_cast<uint64_t>(
+                        channel->GetTotalTransmitTime().GetNanoSeconds() ),
+                    "Wrong busy time" );
+        }
+
+        uint32_t vcFlits = 0;
+
+        for( uint32_t vc = 0; vc < VCS; ++vc )
+        {
+            vcFlits += stats.GetVCFlits( vc, row );
+        }
+
+        NS_TEST_ASSERT_MSG_EQ( vcFlits, stats.Get( TocinoStatsCollector::FLITS, row ),
+                "Per-VC flits do not add up" );
+
+        totalFlits += vcFlits;
+
+        const TocinoArbiterStallCounts stalls = tx->GetArbiter()->GetStallCounts();
+
+        NS_TEST_ASSERT_MSG_EQ(
+                stats.Get( TocinoStatsCollector::STALL_ALLOCATED_QUEUE_EMPTY, row ),
+                stalls.allocatedQueueIsEmpty, "Wrong stall count" );
+        NS_TEST_ASSERT_MSG_EQ(
+                stats.Get( TocinoStatsCollector::STALL_UNALLOCATED_QUEUES_EMPTY, row ),
+                stalls.unallocatedButAllQueuesEmpty, "Wrong stall count" );
+    }
+
+    NS_TEST_ASSERT_MSG_GT( totalFlits, 0, "No flits sampled?" );
+
+    // A link is busy at most all of the time
+    for( uint32_t row = 0; row < stats.GetNRows(); ++row )
+    {
+        NS_TEST_ASSERT_MSG_GT_OR_EQ( stats.GetUtilization( row ), 0,
+                "Negative utilization" );
+        NS_TEST_ASSERT_MSG_LT_OR_EQ( stats.GetUtilization( row ), 1,
+                "Utilization above one" );
+    }
+
+    // Header plus a line per row
+    std::ostringstream csv;
+    stats.WriteCsv( csv );
+
+    const std::string text = csv.str();
+    uint32_t lines = 0;
+
+    for( uint32_t i = 0; i < text.size(); ++i )
+    {
+        if( text[i] == '\n' ) lines++;
+    }
+
+    NS_TEST_ASSERT_MSG_EQ( lines, stats.GetNRows() + 1, "Wrong CSV line count" );
+    NS_TEST_ASSERT_MSG_EQ( text.compare( 0, 8, "time_ns," ), 0, "Wrong CSV header" );
+
+    // Walk the binary: header, then each column's name,
+    // width and data, which must end exactly at the end
+    std::ostringstream bin;
+    stats.WriteBinary( bin );
+
+    const std::string data = bin.str();
+
+    NS_TEST_ASSERT_MSG_EQ( data.compare( 0, 8, "TOCSTAT1" ), 0, "Wrong magic" );
+    NS_TEST_ASSERT_MSG_EQ( ReadU32( data, 8 ),
+            TocinoStatsCollector::N_COLUMNS64 + TocinoStatsCollector::VC_FLITS + VCS,
+            "Wrong column count" );
+    NS_TEST_ASSERT_MSG_EQ( ReadU32( data, 12 ), stats.GetNRows(), "Wrong row count" );
+
+    uint32_t offset = 16;
+
+    for( uint32_t col = 0; col < ReadU32( data, 8 ); ++col )
+    {
+        const uint32_t nameLength = ReadU32( data, offset );
+        const std::string name = data.substr( offset + 4, nameLength );
+        offset += 4 + nameLength;
+
+        const uint32_t width = ReadU32( data, offset );
+        offset += 4;
+
+        NS_TEST_ASSERT_MSG_EQ( ( width == 4 || width == 8 ), true, "Wrong width" );
+
+        if( name == "flits" )
+        {
+            const uint32_t LAST = stats.GetNRows() - 1;
+
+            NS_TEST_ASSERT_MSG_EQ( ReadU32( data, offset + LAST * width ),
+                    stats.Get( TocinoStatsCollector::FLITS, LAST ),
+                    "Wrong binary data" );
+        }
+
+        offset += width * stats.GetNRows();
+
+        NS_TEST_ASSERT_MSG_LT_OR_EQ( offset, data.size(), "Binary truncated" );
+    }
+
+    NS_TEST_ASSERT_MSG_EQ( offset, data.size(), "Trailing binary data" );
+
+    stats.Clear();
+
+    NS_TEST_ASSERT_MSG_EQ( stats.GetNRows(), 0, "Clear left rows" );
+
+    Simulator::Destroy();
+    Config::Reset();
+}
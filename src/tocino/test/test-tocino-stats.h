@@ -0,0 +1,25 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_STATS_H__
+#define __TEST_TOCINO_STATS_H__
+
+#include "ns3/test.h"
+
+namespace ns3
+{
+
+// The statistics collector must agree with the counters
+// it samples, and export every row it holds
+class TestTocinoStats : public TestCase
+{
+    public:
+
+    TestTocinoStats();
+
+    private:
+
+    virtual void DoRun();
+};
+
+}
+
+#endif // __TEST_TOCINO_STATS_H__
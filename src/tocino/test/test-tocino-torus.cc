@@ -0,0 +1,193 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/simulator.h"
+
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-channel.h"
+#include "ns3/tocino-test-results.h"
+#include "ns3/tocino-traffic-matrix-application.h"
+
+#include "test-tocino-torus.h"
+
+using namespace ns3;
+
+TestTocinoTorus::TestTocinoTorus()
+    : TestCase( "Tocino Torus with per-dimension radix and wrap-around" )
+{}
+
+void
+TestTocinoTorus::TestIndexing( const TocinoTorusTopologyHelper& helper )
+{
+    for( uint32_t idx = 0; idx < helper.NODES; ++idx )
+    {
+        const TocinoAddress ta = helper.IndexToTocinoAddress( idx );
+
+        NS_TEST_ASSERT_MSG_EQ( helper.TocinoAddressToIndex( ta ), idx,
+                "Index does not survive round trip through address" );
+        
+        for( uint32_t dim = 0; dim < TOCINO_MAX_DIMENSIONS; ++dim )
+        {
+            NS_TEST_ASSERT_MSG_LT(
+                    ta.GetCoordinate( dim ), helper.GetRadix( dim ),
+                    "Coordinate out of range" );
+        }
+    }
+}
+
+void
+TestTocinoTorus::TestLinks(
+        const TocinoTorusTopologyHelper& helper,
+        const TocinoTorusNetDeviceContainer& netDevices )
+{
+    NS_TEST_ASSERT_MSG_EQ( netDevices.size(), helper.NODES,
+            "Unexpected device count" );
+
+    for( uint32_t idx = 0; idx < helper.NODES; ++idx )
+    {
+        Ptr<TocinoNetDevice> tnd = netDevices[idx];
+        const TocinoAddress ta = tnd->GetTocinoAddress();
+
+        NS_TEST_ASSERT_MSG_EQ( tnd->GetNPorts(), 2*helper.DIMENSIONS + 1,
+                "Unexpected port count" );
+
+        for( uint32_t dim = 0; dim < helper.DIMENSIONS; ++dim )
+        {
+            const uint32_t coord = ta.GetCoordinate( dim );
+            const uint32_t radix = helper.GetRadix( dim );
+            const bool wrap = helper.HasWrapAround( dim );
+
+            Ptr<TocinoChannel> pos =
+                tnd->GetChannel( TocinoGetPort( dim, TOCINO_DIRECTION_POS ).AsUInt32() );
+            
+            Ptr<TocinoChannel> neg =
+                tnd->GetChannel( TocinoGetPort( dim, TOCINO_DIRECTION_NEG ).AsUInt32() );
+
+            // Mesh edges are unconnected
+            NS_TEST_ASSERT_MSG_EQ( ( pos != NULL ), wrap || ( coord < radix-1 ),
+                    "Unexpected positive link" );
+            
+            NS_TEST_ASSERT_MSG_EQ( ( neg != NULL ), wrap || ( coord > 0 ),
+                    "Unexpected negative link" );
+
+            if( pos != NULL )
+            {
+                const TocinoAddress next =
+                    pos->GetTocinoDevice( TocinoChannel::RX_DEV )->GetTocinoAddress();
+
+                NS_TEST_ASSERT_MSG_EQ( next.GetCoordinate( dim ), ( coord+1 ) % radix,
+                        "Positive link goes to the wrong neighbor" );
+            }
+        }
+    }
+}
+
+void
+TestTocinoTorus::TestHelper(
+        const std::vector< uint32_t >& radix,
+        const std::vector< bool >& wrap,
+        const unsigned BYTES )
+{
+    TocinoTorusTopologyHelper helper( radix, wrap );
+
+    const uint32_t NODES = helper.NODES;
+
+    TestIndexing( helper );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::WrapAroundRadices",
+            StringValue( helper.GetWrapAroundRadices() ) );
+
+    TocinoTrafficMatrix trafficMatrix( NODES );
+
+    for( uint32_t src = 0; src < NODES; ++src )
+    {
+        trafficMatrix[src].assign( NODES, TOCINO_TOTAL_TRAFFIC/NODES );
+    }
+
+    NodeContainer machines;
+    TocinoTestResults results;
+    std::vector< Ptr<TocinoTrafficMatrixApplication> > applications;
+
+    machines.Create( NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+    TestLinks( helper, netDevices );
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        Ptr<TocinoTrafficMatrixApplication> app =
+                CreateObject<TocinoTrafficMatrixApplication>();
+    
+        applications.push_back(app);
+
+        app->Initialize( node, &machines, trafficMatrix );
+
+        app->SetReceiveCallback( 
+                MakeCallback( &TocinoTestResults::AcceptPacket, &results ) );
+        
+        app->SetStartTime( Seconds( 0.0 ) );
+        app->SetStopTime( Seconds( 0.1 ) );
+        app->SetPacketSize( BYTES );
+        
+        machines.Get( node )->AddApplication( app );
+    }
+
+    Simulator::Run();
+
+    bool aq = true;
+    uint32_t totalPackets = 0;
+    
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        aq &= netDevices[node]->AllQuiet();
+        totalPackets += applications[node]->GetPacketsSent();
+    }
+
+    NS_TEST_ASSERT_MSG_EQ( aq, true, "not all quiet?" );
+    
+    NS_TEST_ASSERT_MSG_GT( totalPackets, 0, "Nothing sent?" );
+
+    NS_TEST_ASSERT_MSG_EQ( results.GetTotalCount(), totalPackets,
+            "Unexpected total packet count" );
+
+    NS_TEST_ASSERT_MSG_EQ( results.GetTotalBytes(), BYTES * totalPackets,
+            "Unexpected total packet bytes" );
+
+    Simulator::Destroy();
+    Config::Reset();
+}
+
+void
+TestTocinoTorus::DoRun()
+{
+    std::vector< uint32_t > radix;
+    std::vector< bool > wrap;
+    
+    // 4x3x2, a mesh in Y only
+    radix.push_back( 4 ); wrap.push_back( true );
+    radix.push_back( 3 ); wrap.push_back( false );
+    radix.push_back( 2 ); wrap.push_back( true );
+
+    TestHelper( radix, wrap, 20 );
+    TestHelper( radix, wrap, 123 );
+
+    // 3x2x2x3, using the fourth dimension
+    radix.clear(); wrap.clear();
+
+    radix.push_back( 3 ); wrap.push_back( false );
+    radix.push_back( 2 ); wrap.push_back( true );
+    radix.push_back( 2 ); wrap.push_back( false );
+    radix.push_back( 3 ); wrap.push_back( true );
+
+    TestHelper( radix, wrap, 123 );
+
+    // A plain 5-node ring
+    radix.clear(); wrap.clear();
+    
+    radix.push_back( 5 ); wrap.push_back( true );
+
+    TestHelper( radix, wrap, 32 );
+}
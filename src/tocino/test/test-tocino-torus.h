@@ -0,0 +1,40 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_TORUS_H__
+#define __TEST_TOCINO_TORUS_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/test.h"
+
+#include "ns3/tocino-torus-topology-helper.h"
+
+namespace ns3
+{
+
+// Tori with a radix, and wrap-around, chosen per-dimension
+class TestTocinoTorus : public TestCase
+{
+    public:
+
+    TestTocinoTorus();
+
+    private:
+
+    void TestIndexing( const TocinoTorusTopologyHelper& );
+    
+    void TestLinks(
+            const TocinoTorusTopologyHelper&,
+            const TocinoTorusNetDeviceContainer& );
+
+    void TestHelper(
+            const std::vector< uint32_t >&,
+            const std::vector< bool >&,
+            const unsigned );
+
+    virtual void DoRun();
+};
+
+}
+
+#endif // __TEST_TOCINO_TORUS_H__
@@ -0,0 +1,236 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+#include <sys/resource.h>
+
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/simulator.h"
+
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-trace.h"
+#include "ns3/tocino-placement.h"
+#include "ns3/tocino-trace-replay-application.h"
+#include "ns3/tocino-torus-topology-helper.h"
+
+#include "test-tocino-trace-replay.h"
+
+using namespace ns3;
+
+namespace
+{
+
+// Rank 0 sends to 1 and waits for its reply; rank 2
+// waits on rank 0, which only sends after computing
+const char* TRACE =
+    "# a small job\n"
+    "0 send 1 3000\n"
+    "0 recv 1 0      # zero bytes\n"
+    "0 compute 500\n"
+    "0 send 2 100\n"
+    "\n"
+    "1 recv 0 3000\n"
+    "1 compute 100\n"
+    "1 send 0 0\n"
+    "2 recv 0 100\n";
+
+const uint32_t RANKS = 3;
+
+// Ranks in turn, so one open file at a time must be
+// closed and reopened for every line
+const char* INTERLEAVED =
+    "0 send 1 10\n"
+    "1 recv 0 10\n"
+    "0 compute 5\n"
+    "1 compute 7\n"
+    "0 recv 1 20\n"
+    "1 send 0 20\n";
+
+// More readers than we let the process have open files
+const uint32_t MANY_READERS = 1000;
+const rlim_t FEW_FILES = 256;
+
+}
+
+TestTocinoTraceReplay::TestTocinoTraceReplay()
+    : TestCase( "Tocino Trace Replay" )
+{}
+
+void
+TestTocinoTraceReplay::TestConvert( const std::string& prefix )
+{
+    std::istringstream bad( "0 send 1\n" );
+
+    NS_TEST_ASSERT_MSG_EQ( TocinoConvertTextTrace( bad, prefix ), 0,
+            "Malformed trace converted?" );
+
+    std::istringstream text( TRACE );
+
+    NS_TEST_ASSERT_MSG_EQ( TocinoConvertTextTrace( text, prefix ), RANKS,
+            "Wrong number of ranks" );
+
+    // A tiny buffer, to force refills
+    TocinoTraceReader reader( 2 );
+
+    NS_TEST_ASSERT_MSG_EQ( reader.Open( TocinoTraceFileName( prefix, 0 ) ), true,
+            "Cannot open converted trace" );
+    NS_TEST_ASSERT_MSG_EQ( reader.GetRank(), 0, "Wrong rank in trace" );
+
+    const TocinoTraceRecord EXPECTED[] =
+    {
+        TocinoTraceRecord( TocinoTraceRecord::SEND, 1, 3000 ),
+        TocinoTraceRecord( TocinoTraceRecord::RECV, 1, 0 ),
+        TocinoTraceRecord( TocinoTraceRecord::COMPUTE, 0, 500 ),
+        TocinoTraceRecord( TocinoTraceRecord::SEND, 2, 100 )
+    };
+
+    TocinoTraceRecord record;
+
+    for( uint32_t i = 0; i < 4; ++i )
+    {
+        NS_TEST_ASSERT_MSG_EQ( reader.Next( record ), true, "Trace ended early" );
+        NS_TEST_ASSERT_MSG_EQ( record.type, EXPECTED[i].type, "Wrong type" );
+        NS_TEST_ASSERT_MSG_EQ( record.peer, EXPECTED[i].peer, "Wrong peer" );
+        NS_TEST_ASSERT_MSG_EQ( record.value, EXPECTED[i].value, "Wrong value" );
+    }
+
+    NS_TEST_ASSERT_MSG_EQ( reader.Next( record ), false, "Trace too long" );
+
+    // Records of each rank in order, despite the reopening
+    std::istringstream interleaved( INTERLEAVED );
+
+    const std::string INTERLEAVED_PREFIX = prefix + ".interleaved";
+
+    NS_TEST_ASSERT_MSG_EQ( TocinoConvertTextTrace( interleaved, INTERLEAVED_PREFIX, 1 ),
+            2, "Wrong number of interleaved ranks" );
+
+    const uint64_t VALUES[2][3] = { { 10, 5, 20 }, { 10, 7, 20 } };
+
+    for( uint32_t rank = 0; rank < 2; ++rank )
+    {
+        TocinoTraceReader each;
+
+        NS_TEST_ASSERT_MSG_EQ(
+                each.Open( TocinoTraceFileName( INTERLEAVED_PREFIX, rank ) ), true,
+                "Cannot open interleaved trace" );
+
+        for( uint32_t i = 0; i < 3; ++i )
+        {
+            NS_TEST_ASSERT_MSG_EQ( each.Next( record ), true, "Trace ended early" );
+            NS_TEST_ASSERT_MSG_EQ( record.value, VALUES[rank][i], "Wrong value" );
+        }
+
+        NS_TEST_ASSERT_MSG_EQ( each.Next( record ), false, "Trace too long" );
+    }
+
+    // Readers share a pool of open files, far fewer than
+    // the readers, and reopen theirs where they left off
+    struct rlimit limit;
+    getrlimit( RLIMIT_NOFILE, &limit );
+
+    const rlim_t wasLimit = limit.rlim_cur;
+    limit.rlim_cur = std::min( limit.rlim_cur, FEW_FILES );
+    setrlimit( RLIMIT_NOFILE, &limit );
+
+    std::vector< TocinoTraceReader > readers( MANY_READERS, TocinoTraceReader( 1 ) );
+
+    for( uint32_t i = 0; i < MANY_READERS; ++i )
+    {
+        NS_TEST_EXPECT_MSG_EQ( readers[i].Open( TocinoTraceFileName( prefix, 0 ) ), true,
+                "Cannot open reader " << i );
+        NS_TEST_EXPECT_MSG_EQ( readers[i].Next( record ), true, "Trace ended early" );
+    }
+
+    for( uint32_t i = 0; i < MANY_READERS; ++i )
+    {
+        NS_TEST_EXPECT_MSG_EQ( readers[i].Next( record ), true, "Trace ended early" );
+        NS_TEST_EXPECT_MSG_EQ( record.type, TocinoTraceRecord::RECV, "Wrong type" );
+    }
+
+    limit.rlim_cur = wasLimit;
+    setrlimit( RLIMIT_NOFILE, &limit );
+
+    TocinoTraceReader notTrace;
+
+    NS_TEST_ASSERT_MSG_EQ( notTrace.Open( prefix + ".missing" ), false,
+            "Opened a missing trace?" );
+}
+
+void
+TestTocinoTraceReplay::TestReplay(
+        const std::string& prefix,
+        const std::string& placementType )
+{
+    std::vector< uint32_t > radix( 1, 4 );
+    std::vector< bool > wrap( 1, true );
+
+    TocinoTorusTopologyHelper helper( radix, wrap );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::WrapAroundRadices",
+            StringValue( helper.GetWrapAroundRadices() ) );
+
+    NodeContainer machines;
+    machines.Create( helper.NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+    ObjectFactory factory;
+    factory.SetTypeId( placementType );
+
+    Ptr<TocinoPlacement> placement = factory.Create<TocinoPlacement>();
+    placement->Place( RANKS, helper.NODES );
+
+    std::vector< Ptr<TocinoTraceReplayApplication> > apps;
+
+    for( uint32_t rank = 0; rank < RANKS; ++rank )
+    {
+        Ptr<TocinoTraceReplayApplication> app =
+            CreateObject<TocinoTraceReplayApplication>();
+
+        app->Initialize( rank, &machines, placement, prefix );
+        machines.Get( placement->GetNode( rank ) )->AddApplication( app );
+
+        apps.push_back( app );
+    }
+
+    Simulator::Run();
+
+    for( uint32_t rank = 0; rank < RANKS; ++rank )
+    {
+        NS_TEST_ASSERT_MSG_EQ( apps[rank]->IsFinished(), true,
+                placementType << ": rank " << rank << " did not finish" );
+    }
+
+    NS_TEST_ASSERT_MSG_EQ( apps[0]->GetRecordsReplayed(), 4, "Wrong record count" );
+    NS_TEST_ASSERT_MSG_EQ( apps[0]->GetBytesSent(), 3100, "Wrong bytes sent" );
+    NS_TEST_ASSERT_MSG_EQ( apps[0]->GetBytesReceived(), 1, "Zero-byte message?" );
+    NS_TEST_ASSERT_MSG_EQ( apps[1]->GetBytesReceived(), 3000, "Wrong bytes received" );
+    NS_TEST_ASSERT_MSG_EQ( apps[2]->GetBytesReceived(), 100, "Wrong bytes received" );
+
+    // Dependencies: 1 computes after receiving, 0 computes
+    // after hearing from 1, and 2 hears from 0 last
+    NS_TEST_ASSERT_MSG_GT( apps[1]->GetFinishTime(), NanoSeconds( 100 ),
+            "Rank 1 did not compute" );
+    NS_TEST_ASSERT_MSG_GT( apps[0]->GetFinishTime(),
+            apps[1]->GetFinishTime() + NanoSeconds( 500 ),
+            "Rank 0 did not wait for rank 1" );
+    NS_TEST_ASSERT_MSG_GT( apps[2]->GetFinishTime(), apps[0]->GetFinishTime(),
+            "Rank 2 did not wait for rank 0" );
+
+    Simulator::Destroy();
+    Config::Reset();
+}
+
+void
+TestTocinoTraceReplay::DoRun()
+{
+    const std::string PREFIX = CreateTempDirFilename( "tocino-trace" );
+
+    TestConvert( PREFIX );
+
+    TestReplay( PREFIX, "ns3::TocinoLinearPlacement" );
+    TestReplay( PREFIX, "ns3::TocinoRandomPlacement" );
+}
@@ -0,0 +1,30 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_TRACE_REPLAY_H__
+#define __TEST_TOCINO_TRACE_REPLAY_H__
+
+#include <string>
+
+#include "ns3/test.h"
+
+namespace ns3
+{
+
+// Conversion of text traces, streaming them back, and
+// replaying them with their dependencies
+class TestTocinoTraceReplay : public TestCase
+{
+    public:
+
+    TestTocinoTraceReplay();
+
+    private:
+
+    void TestConvert( const std::string& );
+    void TestReplay( const std::string&, const std::string& );
+
+    virtual void DoRun();
+};
+
+}
+
+#endif // __TEST_TOCINO_TRACE_REPLAY_H__
@@ -0,0 +1,193 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/simulator.h"
+
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-address.h"
+
+#include "test-tocino-traffic-matrix.h"
+
+using namespace ns3;
+
+namespace
+{
+
+const uint32_t NODES = 4;
+
+std::vector< uint32_t >
+RingRadix()
+{
+    return std::vector< uint32_t >( 1, NODES );
+}
+
+}
+
+TestTocinoTrafficMatrix::TestTocinoTrafficMatrix()
+    : TestCase( "Tocino Traffic Matrix Destination Sampling" )
+    , m_helper( RingRadix(), std::vector< bool >( 1, true ) )
+    , m_counts( NULL )
+{}
+
+bool
+TestTocinoTrafficMatrix::Receive(
+        Ptr<NetDevice> nd,
+        Ptr<const Packet>,
+        uint16_t,
+        const Address& src )
+{
+    const uint32_t SRC =
+        m_helper.TocinoAddressToIndex( TocinoAddress::ConvertFrom( src ) );
+    
+    const uint32_t DST =
+        m_helper.TocinoAddressToIndex( TocinoAddress::ConvertFrom( nd->GetAddress() ) );
+
+    (*m_counts)[SRC][DST]++;
+
+    return true;
+}
+
+void
+TestTocinoTrafficMatrix::Run(
+        const TocinoTrafficMatrix* dense,
+        const TocinoSparseTrafficMatrix* sparse,
+        CountMatrix& counts )
+{
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::WrapAroundRadices",
+            StringValue( m_helper.GetWrapAroundRadices() ) );
+
+    NodeContainer machines;
+    machines.Create( NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = m_helper.Install( machines );
+
+    counts.assign( NODES, std::vector< uint32_t >( NODES, 0 ) );
+    m_counts = &counts;
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        Ptr<TocinoTrafficMatrixApplication> app =
+            CreateObject<TocinoTrafficMatrixApplication>();
+
+        if( dense != NULL )
+        {
+            app->Initialize( node, &machines, *dense );
+        }
+        else
+        {
+            app->Initialize( node, &machines, *sparse );
+        }
+
+        app->AssignStreams( node * 2 );
+
+        app->SetAttribute( "MeanTimeBetweenSends", TimeValue( NanoSeconds( 500 ) ) );
+        app->SetAttribute( "MaxTimeBetweenSends", TimeValue( NanoSeconds( 5000 ) ) );
+        app->SetPacketSize( 20 );
+
+        app->SetReceiveCallback(
+                MakeCallback( &TestTocinoTrafficMatrix::Receive, this ) );
+
+        app->SetStartTime( Seconds( 0 ) );
+        app->SetStopTime( MicroSeconds( 200 ) );
+
+        machines.Get( node )->AddApplication( app );
+    }
+
+    Simulator::Run();
+    Simulator::Destroy();
+    Config::Reset();
+}
+
+void
+TestTocinoTrafficMatrix::DoRun()
+{
+    // A permutation, sparse: each node sends only to the next
+    TocinoSparseTrafficMatrix permutation( NODES );
+
+    for( uint32_t src = 0; src < NODES; ++src )
+    {
+        permutation[src].push_back(
+                TocinoSparseTrafficEntry( ( src + 1 ) % NODES, TOCINO_TOTAL_TRAFFIC ) );
+    }
+
+    CountMatrix counts;
+    Run( NULL, &permutation, counts );
+
+    for( uint32_t src = 0; src < NODES; ++src )
+    {
+        for( uint32_t dst = 0; dst < NODES; ++dst )
+        {
+            if( dst == ( src + 1 ) % NODES )
+            {
+                NS_TEST_ASSERT_MSG_GT( counts[src][dst], 0,
+                        "Permutation partner never chosen" );
+            }
+            else
+            {
+                NS_TEST_ASSERT_MSG_EQ( counts[src][dst], 0,
+                        "Sent outside the permutation" );
+            }
+        }
+    }
+
+    // Node zero sends three quarters to node one, a
+    // quarter to node three, and nobody else sends
+    TocinoTrafficMatrix weighted( NODES, TocinoTrafficVector( NODES, 0 ) );
+
+    weighted[0][1] = TOCINO_TOTAL_TRAFFIC / 4 * 3;
+    weighted[0][3] = TOCINO_TOTAL_TRAFFIC / 4;
+
+    CountMatrix denseCounts;
+    Run( &weighted, NULL, denseCounts );
+
+    const uint32_t TOTAL = denseCounts[0][1] + denseCounts[0][3];
+
+    NS_TEST_ASSERT_MSG_GT( TOTAL, 200, "Too few packets to judge" );
+    NS_TEST_ASSERT_MSG_EQ( denseCounts[0][2], 0, "Zero traffic chosen" );
+    NS_TEST_ASSERT_MSG_EQ_TOL( static_cast<double>( denseCounts[0][1] ) / TOTAL,
+            0.75, 0.1, "Wrong share of traffic" );
+
+    // The same matrix, sparse, draws the same destinations
+    TocinoSparseTrafficMatrix sparseWeighted( NODES );
+
+    sparseWeighted[0].push_back( TocinoSparseTrafficEntry( 1, weighted[0][1] ) );
+    sparseWeighted[0].push_back( TocinoSparseTrafficEntry( 3, weighted[0][3] ) );
+
+    CountMatrix sparseCounts;
+    Run( NULL, &sparseWeighted, sparseCounts );
+
+    for( uint32_t src = 0; src < NODES; ++src )
+    {
+        for( uint32_t dst = 0; dst < NODES; ++dst )
+        {
+            NS_TEST_ASSERT_MSG_EQ( sparseCounts[src][dst], denseCounts[src][dst],
+                    "Sparse and dense matrices differ" );
+        }
+    }
+
+    // Node zero sends half to node two, and half to all
+    // the others: a sixth each to nodes one and three,
+    // which is two thirds to node two in all
+    TocinoSparseTrafficMatrix background( NODES );
+
+    background[0].push_back( TocinoSparseTrafficEntry( 2, TOCINO_TOTAL_TRAFFIC / 2 ) );
+    background[0].push_back(
+            TocinoSparseTrafficEntry( TOCINO_ALL_OTHERS, TOCINO_TOTAL_TRAFFIC / 2 ) );
+
+    CountMatrix backgroundCounts;
+    Run( NULL, &background, backgroundCounts );
+
+    const uint32_t SENT = backgroundCounts[0][1] +
+        backgroundCounts[0][2] + backgroundCounts[0][3];
+
+    NS_TEST_ASSERT_MSG_GT( SENT, 200, "Too few packets to judge" );
+    NS_TEST_ASSERT_MSG_EQ( backgroundCounts[0][0], 0, "Sent to itself" );
+    NS_TEST_ASSERT_MSG_EQ_TOL( static_cast<double>( backgroundCounts[0][2] ) / SENT,
+            2.0 / 3, 0.1, "Wrong share of traffic" );
+    NS_TEST_ASSERT_MSG_EQ_TOL( static_cast<double>( backgroundCounts[0][1] ) / SENT,
+            1.0 / 6, 0.1, "Wrong share of background traffic" );
+    NS_TEST_ASSERT_MSG_EQ_TOL( static_cast<double>( backgroundCounts[0][3] ) / SENT,
+            1.0 / 6, 0.1, "Wrong share of background traffic" );
+}
@@ -0,0 +1,51 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_TRAFFIC_MATRIX_H__
+#define __TEST_TOCINO_TRAFFIC_MATRIX_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/net-device.h"
+#include "ns3/packet.h"
+
+#include "ns3/tocino-traffic-matrix-application.h"
+#include "ns3/tocino-torus-topology-helper.h"
+
+namespace ns3
+{
+
+// Destinations drawn by TocinoTrafficMatrixApplication
+// must follow its traffic matrix, dense or sparse
+class TestTocinoTrafficMatrix : public TestCase
+{
+    public:
+
+    TestTocinoTrafficMatrix();
+
+    private:
+
+    // Packets received, indexed [source][destination]
+    typedef std::vector< std::vector< uint32_t > > CountMatrix;
+
+    // Exactly one of the matrices is used
+    void Run(
+            const TocinoTrafficMatrix*,
+            const TocinoSparseTrafficMatrix*,
+            CountMatrix& );
+
+    bool Receive(
+            Ptr<NetDevice>,
+            Ptr<const Packet>,
+            uint16_t,
+            const Address& );
+
+    TocinoTorusTopologyHelper m_helper;
+    CountMatrix* m_counts;
+
+    virtual void DoRun();
+};
+
+}
+
+#endif // __TEST_TOCINO_TRAFFIC_MATRIX_H__
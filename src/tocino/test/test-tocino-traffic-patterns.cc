@@ -0,0 +1,191 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include <vector>
+
+#include "ns3/tocino-torus-topology-helper.h"
+#include "ns3/tocino-traffic-patterns.h"
+
+#include "test-tocino-traffic-patterns.h"
+
+using namespace ns3;
+
+TestTocinoTrafficPatterns::TestTocinoTrafficPatterns()
+    : TestCase( "Tocino Synthetic Traffic Patterns" )
+{}
+
+uint32_t
+TestTocinoTrafficPatterns::GetDest(
+        const TocinoSparseTrafficMatrix& matrix,
+        const uint32_t src )
+{
+    if( matrix[src].empty() )
+    {
+        return src;
+    }
+
+    return matrix[src][0].first;
+}
+
+void
+TestTocinoTrafficPatterns::CheckRows(
+        const TocinoSparseTrafficMatrix& matrix,
+        const char* name )
+{
+    for( uint32_t src = 0; src < matrix.size(); ++src )
+    {
+        uint64_t total = 0;
+
+        for( uint32_t i = 0; i < matrix[src].size(); ++i )
+        {
+            if( matrix[src][i].first == TOCINO_ALL_OTHERS )
+            {
+                NS_TEST_ASSERT_MSG_EQ( i + 1, matrix[src].size(), name );
+            }
+            else
+            {
+                NS_TEST_ASSERT_MSG_LT( matrix[src][i].first, matrix.size(), name );
+            }
+
+            NS_TEST_ASSERT_MSG_NE( matrix[src][i].first, src, name );
+            NS_TEST_ASSERT_MSG_GT( matrix[src][i].second, 0, name );
+
+            NS_TEST_ASSERT_MSG_EQ( ( ( i == 0 ) ||
+                        ( matrix[src][i].first > matrix[src][i-1].first ) ),
+                    true, name );
+
+            total += matrix[src][i].second;
+        }
+
+        NS_TEST_ASSERT_MSG_EQ( ( ( total == 0 ) || ( total == TOCINO_TOTAL_TRAFFIC ) ),
+                true, name );
+    }
+}
+
+void
+TestTocinoTrafficPatterns::CheckPermutation(
+        const TocinoSparseTrafficMatrix& matrix,
+        const char* name )
+{
+    CheckRows( matrix, name );
+
+    std::vector< bool > seen( matrix.size(), false );
+
+    for( uint32_t src = 0; src < matrix.size(); ++src )
+    {
+        NS_TEST_ASSERT_MSG_LT( matrix[src].size(), 2, name );
+
+        const uint32_t dst = GetDest( matrix, src );
+
+        NS_TEST_ASSERT_MSG_EQ( seen[dst], false, name );
+        seen[dst] = true;
+    }
+}
+
+void
+TestTocinoTrafficPatterns::DoRun()
+{
+    // A 4 x 4 torus; node index = x + 4y
+    TocinoTorusTopologyHelper helper(
+            std::vector< uint32_t >( 2, 4 ),
+            std::vector< bool >( 2, true ) );
+
+    TocinoTrafficPatterns patterns( helper );
+
+    const TocinoSparseTrafficMatrix transpose = patterns.Transpose();
+    CheckPermutation( transpose, "transpose" );
+    NS_TEST_ASSERT_MSG_EQ( GetDest( transpose, 1 + 4*2 ), 2 + 4*1, "transpose" );
+    NS_TEST_ASSERT_MSG_EQ( transpose[5].empty(), true, "transpose fixed point" );
+
+    const TocinoSparseTrafficMatrix complement = patterns.BitComplement();
+    CheckPermutation( complement, "bit complement" );
+    NS_TEST_ASSERT_MSG_EQ( GetDest( complement, 0 ), 15, "bit complement" );
+    NS_TEST_ASSERT_MSG_EQ( GetDest( complement, 6 ), 9, "bit complement" );
+
+    const TocinoSparseTrafficMatrix reverse = patterns.BitReverse();
+    CheckPermutation( reverse, "bit reverse" );
+    NS_TEST_ASSERT_MSG_EQ( GetDest( reverse, 1 ), 8, "bit reverse" );
+    NS_TEST_ASSERT_MSG_EQ( GetDest( reverse, 3 ), 12, "bit reverse" );
+
+    const TocinoSparseTrafficMatrix shuffle = patterns.Shuffle();
+    CheckPermutation( shuffle, "shuffle" );
+    NS_TEST_ASSERT_MSG_EQ( GetDest( shuffle, 1 ), 2, "shuffle" );
+    NS_TEST_ASSERT_MSG_EQ( GetDest( shuffle, 8 ), 1, "shuffle" );
+
+    // Radix four: one hop short of halfway
+    const TocinoSparseTrafficMatrix tornado = patterns.Tornado();
+    CheckPermutation( tornado, "tornado" );
+    NS_TEST_ASSERT_MSG_EQ( GetDest( tornado, 0 ), 1 + 4*1, "tornado" );
+    NS_TEST_ASSERT_MSG_EQ( GetDest( tornado, 3 ), 0 + 4*1, "tornado" );
+
+    const TocinoSparseTrafficMatrix neighbor = patterns.NearestNeighbor();
+    CheckPermutation( neighbor, "neighbor" );
+    NS_TEST_ASSERT_MSG_EQ( GetDest( neighbor, 15 ), 0, "neighbor" );
+
+    const TocinoSparseTrafficMatrix uniform = patterns.UniformRandom();
+    CheckRows( uniform, "uniform" );
+
+    for( uint32_t src = 0; src < uniform.size(); ++src )
+    {
+        NS_TEST_ASSERT_MSG_EQ( uniform[src].size(), 1, "uniform" );
+        NS_TEST_ASSERT_MSG_EQ( uniform[src][0].first, TOCINO_ALL_OTHERS, "uniform" );
+    }
+
+    // Half of all traffic to node 5, the rest uniform
+    const TocinoSparseTrafficMatrix hotspot =
+        patterns.Hotspot( std::vector< uint32_t >( 1, 5 ), 0.5 );
+
+    CheckRows( hotspot, "hotspot" );
+
+    NS_TEST_ASSERT_MSG_EQ( hotspot[0].size(), 2, "hotspot" );
+    NS_TEST_ASSERT_MSG_EQ( hotspot[0][0].first, 5, "hotspot" );
+    NS_TEST_ASSERT_MSG_EQ_TOL(
+            static_cast<double>( hotspot[0][0].second ) / TOCINO_TOTAL_TRAFFIC,
+            0.5, 1e-6, "hotspot share" );
+    NS_TEST_ASSERT_MSG_EQ( hotspot[5].size(), 1, "hotspot sends uniformly" );
+    NS_TEST_ASSERT_MSG_EQ( hotspot[5][0].first, TOCINO_ALL_OTHERS,
+            "hotspot sends uniformly" );
+
+    // Radices need not be powers of two for coordinate patterns
+    TocinoTorusTopologyHelper odd(
+            std::vector< uint32_t >( 3, 5 ),
+            std::vector< bool >( 3, true ) );
+
+    TocinoTrafficPatterns oddPatterns( odd );
+
+    CheckPermutation( oddPatterns.Transpose(), "odd transpose" );
+    CheckPermutation( oddPatterns.BitComplement(), "odd complement" );
+    CheckPermutation( oddPatterns.Tornado(), "odd tornado" );
+
+    // A 32K node permutation stays one entry per node
+    std::vector< uint32_t > radix( 3, 32 );
+    TocinoTorusTopologyHelper large( radix, std::vector< bool >( 3, true ) );
+
+    const TocinoSparseTrafficMatrix largeShuffle =
+        TocinoTrafficPatterns( large ).Create( "shuffle" );
+
+    NS_TEST_ASSERT_MSG_EQ( largeShuffle.size(), 32768, "large shuffle" );
+    CheckPermutation( largeShuffle, "large shuffle" );
+
+    // Dense, these would need 32K x 32K entries, some 8 GB
+    const TocinoSparseTrafficMatrix largeUniform =
+        TocinoTrafficPatterns( large ).UniformRandom();
+
+    NS_TEST_ASSERT_MSG_EQ( largeUniform.size(), 32768, "large uniform" );
+    CheckRows( largeUniform, "large uniform" );
+
+    std::vector< uint32_t > hot;
+    hot.push_back( 32767 );
+    hot.push_back( 0 );
+    hot.push_back( 1000 );
+
+    const TocinoSparseTrafficMatrix largeHotspot =
+        TocinoTrafficPatterns( large ).Hotspot( hot, 0.25 );
+
+    CheckRows( largeHotspot, "large hotspot" );
+
+    for( uint32_t src = 0; src < largeHotspot.size(); ++src )
+    {
+        NS_TEST_ASSERT_MSG_LT_OR_EQ( largeHotspot[src].size(), hot.size() + 1,
+                "large hotspot" );
+    }
+}
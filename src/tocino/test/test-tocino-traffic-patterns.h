@@ -0,0 +1,37 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_TRAFFIC_PATTERNS_H__
+#define __TEST_TOCINO_TRAFFIC_PATTERNS_H__
+
+#include <stdint.h>
+
+#include "ns3/test.h"
+
+#include "ns3/tocino-traffic-matrix-application.h"
+
+namespace ns3
+{
+
+// Each synthetic traffic pattern must send where its
+// definition says, and never more than the total traffic
+class TestTocinoTrafficPatterns : public TestCase
+{
+    public:
+
+    TestTocinoTrafficPatterns();
+
+    private:
+
+    void CheckRows( const TocinoSparseTrafficMatrix&, const char* );
+
+    void CheckPermutation( const TocinoSparseTrafficMatrix&, const char* );
+
+    // Destination of a source under a permutation, or
+    // the source itself if it sends nothing
+    static uint32_t GetDest( const TocinoSparseTrafficMatrix&, const uint32_t );
+
+    virtual void DoRun();
+};
+
+}
+
+#endif // __TEST_TOCINO_TRAFFIC_PATTERNS_H__
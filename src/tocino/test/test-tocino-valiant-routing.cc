@@ -0,0 +1,175 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include <vector>
+
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/type-id.h"
+#include "ns3/simulator.h"
+
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-channel.h"
+#include "ns3/tocino-tx.h"
+#include "ns3/tocino-torus-topology-helper.h"
+#include "ns3/tocino-traffic-patterns.h"
+#include "ns3/tocino-traffic-matrix-application.h"
+
+#include "test-tocino-valiant-routing.h"
+
+using namespace ns3;
+
+TestTocinoValiantRouting::TestTocinoValiantRouting()
+    : TestCase( "Tocino Router-Level Valiant and UGAL Routing" )
+{}
+
+TestTocinoValiantRouting::Outcome
+TestTocinoValiantRouting::Run(
+        const bool doWrap,
+        const std::string& router,
+        const std::string& mode,
+        const bool lightweightFlits,
+        const Time meanTimeBetweenSends,
+        const uint32_t packetSize )
+{
+    TocinoTorusTopologyHelper helper(
+            std::vector< uint32_t >( 2, 4 ),
+            std::vector< bool >( 2, doWrap ) );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::WrapAroundRadices",
+            StringValue( helper.GetWrapAroundRadices() ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::RouterType",
+            TypeIdValue( TypeId::LookupByName( router ) ) );
+
+    Config::SetDefault( "ns3::TocinoValiantRouter::Mode", StringValue( mode ) );
+    Config::SetDefault( "ns3::TocinoValiantRouter::Radices",
+            StringValue( helper.GetRadices() ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::LightweightFlits",
+            BooleanValue( lightweightFlits ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::InjectionQueueMaxFlits",
+            UintegerValue( 32 ) );
+
+    const uint32_t NODES = helper.NODES;
+
+    const TocinoSparseTrafficMatrix trafficMatrix =
+        TocinoTrafficPatterns( helper ).UniformRandom();
+
+    NodeContainer machines;
+    machines.Create( NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+    std::vector< Ptr<TocinoTrafficMatrixApplication> > applications;
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        Ptr<TocinoTrafficMatrixApplication> app =
+            CreateObject<TocinoTrafficMatrixApplication>();
+
+        applications.push_back( app );
+
+        app->Initialize( node, &machines, trafficMatrix );
+        app->AssignStreams( node * 2 );
+
+        app->SetAttribute( "MeanTimeBetweenSends", TimeValue( meanTimeBetweenSends ) );
+        app->SetAttribute( "MaxTimeBetweenSends", TimeValue( meanTimeBetweenSends * 10 ) );
+
+        app->SetStartTime( Seconds( 0 ) );
+        app->SetStopTime( MicroSeconds( 40 ) );
+        app->SetPacketSize( packetSize );
+
+        machines.Get( node )->AddApplication( app );
+    }
+
+    Simulator::Run();
+
+    Outcome outcome = { 0, 0, 0, 0, 0 };
+
+    TocinoHistogram hops;
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        outcome.sent += applications[node]->GetPacketsSent();
+        outcome.received += applications[node]->GetPacketsReceived();
+
+        hops.Merge( netDevices[node]->GetHopCountHistogram() );
+
+        for( uint32_t port = 0; port < netDevices[node]->GetNPorts(); ++port )
+        {
+            Ptr<TocinoChannel> channel =
+                netDevices[node]->GetTransmitter( port )->GetChannel();
+
+            if( channel != NULL )
+            {
+                outcome.dataFlits += channel->GetTotalFlitsTransmitted()
+                    - channel->GetLLCFlitsTransmitted();
+            }
+        }
+    }
+
+    outcome.meanHops = hops.GetMean();
+    outcome.totalHops = hops.GetMean() * hops.GetCount();
+
+    Simulator::Destroy();
+    Config::Reset();
+
+    return outcome;
+}
+
+void
+TestTocinoValiantRouting::CheckDelivered(
+        const Outcome& outcome,
+        const char* what )
+{
+    NS_TEST_ASSERT_MSG_GT( outcome.sent, 0, what );
+    NS_TEST_ASSERT_MSG_EQ( outcome.received, outcome.sent, what );
+}
+
+void
+TestTocinoValiantRouting::DoRun()
+{
+    const std::string DOR = "ns3::TocinoDimensionOrderRouter";
+    const std::string VALIANT = "ns3::TocinoValiantRouter";
+
+    const Time LIGHT = MicroSeconds( 1 );
+    const Time HEAVY = NanoSeconds( 50 );
+
+    // Single-flit packets, so channel flits count hops
+    const Outcome dor = Run( true, DOR, "Valiant", false, LIGHT, 20 );
+    CheckDelivered( dor, "dimension order" );
+
+    const Outcome valiant = Run( true, VALIANT, "Valiant", false, LIGHT, 20 );
+    CheckDelivered( valiant, "Valiant" );
+
+    NS_TEST_ASSERT_MSG_GT( valiant.meanHops, 1.5 * dor.meanHops,
+            "Valiant paths should be about twice as long" );
+
+    // No outer head flit, unlike SendVia
+    NS_TEST_ASSERT_MSG_EQ_TOL( static_cast<double>( valiant.dataFlits ),
+            valiant.totalHops, 0.5, "Valiant routing sent extra flits" );
+
+    // An idle network leaves UGAL no reason to detour
+    const Outcome ugal = Run( true, VALIANT, "Ugal", false, LIGHT, 20 );
+    CheckDelivered( ugal, "UGAL" );
+
+    NS_TEST_ASSERT_MSG_EQ_TOL( ugal.meanHops, dor.meanHops, 0.1 * dor.meanHops,
+            "UGAL should route minimally when idle" );
+
+    // Deadlock freedom under load, on tori and meshes,
+    // with multi-flit packets of either kind of flit
+    CheckDelivered( Run( true, VALIANT, "Valiant", false, HEAVY, 123 ),
+            "Valiant torus" );
+    CheckDelivered( Run( true, VALIANT, "Valiant", true, HEAVY, 123 ),
+            "Valiant torus, lightweight flits" );
+    CheckDelivered( Run( false, VALIANT, "Valiant", false, HEAVY, 123 ),
+            "Valiant mesh" );
+    CheckDelivered( Run( true, VALIANT, "Ugal", true, HEAVY, 123 ),
+            "UGAL torus, lightweight flits" );
+    CheckDelivered( Run( false, VALIANT, "Ugal", false, HEAVY, 123 ),
+            "UGAL mesh" );
+}
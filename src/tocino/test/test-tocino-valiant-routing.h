@@ -0,0 +1,50 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_VALIANT_ROUTING_H__
+#define __TEST_TOCINO_VALIANT_ROUTING_H__
+
+#include <stdint.h>
+#include <string>
+
+#include "ns3/test.h"
+#include "ns3/nstime.h"
+
+namespace ns3
+{
+
+// Router-level Valiant and UGAL routing must deliver
+// everything, on tori and meshes, without an extra flit
+class TestTocinoValiantRouting : public TestCase
+{
+    public:
+
+    TestTocinoValiantRouting();
+
+    private:
+
+    struct Outcome
+    {
+        uint64_t sent;
+        uint64_t received;
+        double meanHops;
+        double totalHops;
+        uint64_t dataFlits;
+    };
+
+    // Uniform random traffic on a 4 x 4 torus or mesh,
+    // under the given router
+    Outcome Run(
+            const bool,
+            const std::string&,
+            const std::string&,
+            const bool,
+            const Time,
+            const uint32_t );
+
+    void CheckDelivered( const Outcome&, const char* );
+
+    virtual void DoRun();
+};
+
+}
+
+#endif // __TEST_TOCINO_VALIANT_ROUTING_H__
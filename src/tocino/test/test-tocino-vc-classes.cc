@@ -0,0 +1,258 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+
+#include <vector>
+
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/type-id.h"
+#include "ns3/simulator.h"
+
+#include "ns3/tocino-net-device.h"
+#include "ns3/tocino-channel.h"
+#include "ns3/tocino-tx.h"
+#include "ns3/tocino-vc-allocator.h"
+#include "ns3/tocino-torus-topology-helper.h"
+#include "ns3/tocino-traffic-patterns.h"
+#include "ns3/tocino-traffic-matrix-application.h"
+
+#include "test-tocino-vc-classes.h"
+
+using namespace ns3;
+
+TestTocinoVCClasses::TestTocinoVCClasses()
+    : TestCase( "Tocino Virtual Channel Classes" )
+{}
+
+void
+TestTocinoVCClasses::TestAllocator()
+{
+    TocinoVCAllocator vca;
+
+    // The default is one class of every VC, as before
+    vca.Initialize( 4, "" );
+
+    NS_TEST_ASSERT_MSG_EQ( vca.GetNClasses(), 1, "default classes" );
+    NS_TEST_ASSERT_MSG_EQ( vca.GetInjectionVC( 0, TocinoVCAllocator::ANY_LEG, 1 ).AsUInt32(), 2,
+            "round-robin injection" );
+    NS_TEST_ASSERT_MSG_EQ( vca.GetInjectionVC( 0, TocinoVCAllocator::FIRST_LEG, 1 ).AsUInt32(), 0,
+            "first leg injection" );
+    NS_TEST_ASSERT_MSG_EQ( vca.MoveToLeg( 1, TocinoVCAllocator::SECOND_LEG ).AsUInt32(), 2,
+            "second leg" );
+    NS_TEST_ASSERT_MSG_EQ( vca.CrossDateline( 2 ).AsUInt32(), 3, "dateline" );
+    NS_TEST_ASSERT_MSG_EQ( vca.ResetDateline( 3 ).AsUInt32(), 2, "dateline reset" );
+
+    vca.Initialize( 8, "4,4" );
+
+    NS_TEST_ASSERT_MSG_EQ( vca.GetNClasses(), 2, "two classes" );
+    NS_TEST_ASSERT_MSG_EQ( vca.GetClass( 3 ), 0, "class of VC 3" );
+    NS_TEST_ASSERT_MSG_EQ( vca.GetClass( 4 ), 1, "class of VC 4" );
+    NS_TEST_ASSERT_MSG_EQ( vca.GetClassBase( 1 ).AsUInt32(), 4, "class base" );
+    NS_TEST_ASSERT_MSG_EQ( vca.GetInjectionVC( 1, TocinoVCAllocator::ANY_LEG, 3 ).AsUInt32(), 6,
+            "round-robin injection within the class" );
+    NS_TEST_ASSERT_MSG_EQ( vca.MoveToLeg( 5, TocinoVCAllocator::SECOND_LEG ).AsUInt32(), 6,
+            "second leg within the class" );
+    NS_TEST_ASSERT_MSG_EQ( vca.MoveToLeg( 7, TocinoVCAllocator::FIRST_LEG ).AsUInt32(), 4,
+            "first leg within the class" );
+    NS_TEST_ASSERT_MSG_EQ( vca.IsSecondLeg( 6 ), true, "VC 6 is second leg" );
+    NS_TEST_ASSERT_MSG_EQ( vca.IsSecondLeg( 5 ), false, "VC 5 is first leg" );
+
+    // An odd number of pairs favors the first leg
+    vca.Initialize( 6, "" );
+
+    NS_TEST_ASSERT_MSG_EQ( vca.GetPairs( 0, TocinoVCAllocator::FIRST_LEG ), 2,
+            "first leg pairs" );
+    NS_TEST_ASSERT_MSG_EQ( vca.GetPairs( 0, TocinoVCAllocator::SECOND_LEG ), 1,
+            "second leg pairs" );
+    NS_TEST_ASSERT_MSG_EQ( vca.MoveToLeg( 2, TocinoVCAllocator::SECOND_LEG ).AsUInt32(), 4,
+            "odd pairs, second leg" );
+}
+
+TestTocinoVCClasses::Outcome
+TestTocinoVCClasses::Run(
+        const uint32_t vcs,
+        const std::string& classes,
+        const std::string& router,
+        const uint32_t evenClass,
+        const uint32_t oddClass,
+        const bool doVLB )
+{
+    TocinoTorusTopologyHelper helper(
+            std::vector< uint32_t >( 2, 4 ),
+            std::vector< bool >( 2, true ) );
+
+    Config::SetDefault(
+            "ns3::TocinoDimensionOrderRouter::WrapAroundRadices",
+            StringValue( helper.GetWrapAroundRadices() ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::RouterType",
+            TypeIdValue( TypeId::LookupByName( router ) ) );
+
+    Config::SetDefault( "ns3::TocinoValiantRouter::Radices",
+            StringValue( helper.GetRadices() ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::VirtualChannels",
+            UintegerValue( vcs ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::VCClasses",
+            StringValue( classes ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::RoundRobinVCInject",
+            BooleanValue( true ) );
+
+    Config::SetDefault( "ns3::TocinoNetDevice::InjectionQueueMaxFlits",
+            UintegerValue( 32 ) );
+
+    const uint32_t NODES = helper.NODES;
+
+    const TocinoSparseTrafficMatrix trafficMatrix =
+        TocinoTrafficPatterns( helper ).UniformRandom();
+
+    NodeContainer machines;
+    machines.Create( NODES );
+
+    TocinoTorusNetDeviceContainer netDevices = helper.Install( machines );
+
+    std::vector< Ptr<TocinoTrafficMatrixApplication> > applications;
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        Ptr<TocinoTrafficMatrixApplication> app =
+            CreateObject<TocinoTrafficMatrixApplication>();
+
+        applications.push_back( app );
+
+        app->Initialize( node, &machines, trafficMatrix );
+        app->AssignStreams( node * 2 );
+
+        app->SetAttribute( "MeanTimeBetweenSends", TimeValue( NanoSeconds( 50 ) ) );
+        app->SetAttribute( "MaxTimeBetweenSends", TimeValue( NanoSeconds( 500 ) ) );
+        app->SetAttribute( "EnableValiantLoadBalancing", BooleanValue( doVLB ) );
+        app->SetAttribute( "TrafficClass",
+                UintegerValue( ( node % 2 ) ? oddClass : evenClass ) );
+
+        app->SetStartTime( Seconds( 0 ) );
+        app->SetStopTime( MicroSeconds( 20 ) );
+        app->SetPacketSize( 123 );
+
+        machines.Get( node )->AddApplication( app );
+    }
+
+    Simulator::Run();
+
+    Outcome outcome;
+
+    outcome.sent = 0;
+    outcome.received = 0;
+    outcome.vcFlits.resize( vcs, 0 );
+
+    for( uint32_t node = 0; node < NODES; ++node )
+    {
+        outcome.sent += applications[node]->GetPacketsSent();
+        outcome.received += applications[node]->GetPacketsReceived();
+
+        for( uint32_t port = 0; port < netDevices[node]->GetNPorts(); ++port )
+        {
+            Ptr<TocinoChannel> channel =
+                netDevices[node]->GetTransmitter( port )->GetChannel();
+
+            if( channel != NULL )
+            {
+                for( uint32_t vc = 0; vc < vcs; ++vc )
+                {
+                    outcome.vcFlits[vc] += channel->GetVCFlits( vc );
+                }
+
+                // Flow control flits belong to no class, and
+                // are counted against VC 0
+                outcome.vcFlits[0] -= channel->GetLLCFlitsTransmitted();
+            }
+        }
+    }
+
+    Simulator::Destroy();
+    Config::Reset();
+
+    return outcome;
+}
+
+void
+TestTocinoVCClasses::CheckDelivered(
+        const Outcome& outcome,
+        const char* what )
+{
+    NS_TEST_ASSERT_MSG_GT( outcome.sent, 0, what );
+    NS_TEST_ASSERT_MSG_EQ( outcome.received, outcome.sent, what );
+}
+
+void
+TestTocinoVCClasses::CheckConfined(
+        const Outcome& outcome,
+        const uint32_t first,
+        const uint32_t end,
+        const char* what )
+{
+    uint64_t inside = 0;
+
+    for( uint32_t vc = 0; vc < outcome.vcFlits.size(); ++vc )
+    {
+        if( vc >= first && vc < end )
+        {
+            inside += outcome.vcFlits[vc];
+        }
+        else
+        {
+            NS_TEST_ASSERT_MSG_EQ( outcome.vcFlits[vc], 0, what );
+        }
+    }
+
+    NS_TEST_ASSERT_MSG_GT( inside, 0, what );
+}
+
+void
+TestTocinoVCClasses::DoRun()
+{
+    TestAllocator();
+
+    const std::string DOR = "ns3::TocinoDimensionOrderRouter";
+    const std::string VALIANT = "ns3::TocinoValiantRouter";
+    const std::string ADAPTIVE = "ns3::TocinoAdaptiveRouter";
+
+    Outcome outcome;
+
+    outcome = Run( 4, "2,2", DOR, 1, 1, false );
+    CheckDelivered( outcome, "dimension order, class 1" );
+    CheckConfined( outcome, 2, 4, "dimension order left class 1" );
+
+    // Both classes at once, each on its own VCs
+    outcome = Run( 4, "2,2", DOR, 0, 1, false );
+    CheckDelivered( outcome, "dimension order, mixed classes" );
+    CheckConfined( outcome, 0, 4, "dimension order, mixed classes" );
+    NS_TEST_ASSERT_MSG_GT( outcome.vcFlits[0], 0, "class 0 unused" );
+    NS_TEST_ASSERT_MSG_GT( outcome.vcFlits[2], 0, "class 1 unused" );
+
+    // Two legs, and so two pairs, within each class
+    outcome = Run( 8, "4,4", DOR, 1, 1, true );
+    CheckDelivered( outcome, "SendVia, class 1" );
+    CheckConfined( outcome, 4, 8, "SendVia left class 1" );
+
+    outcome = Run( 8, "4,4", VALIANT, 1, 1, false );
+    CheckDelivered( outcome, "Valiant, class 1" );
+    CheckConfined( outcome, 4, 8, "Valiant left class 1" );
+
+    outcome = Run( 8, "4,4", ADAPTIVE, 0, 1, false );
+    CheckDelivered( outcome, "adaptive, mixed classes" );
+
+    outcome = Run( 8, "4,4", ADAPTIVE, 1, 1, false );
+    CheckDelivered( outcome, "adaptive, class 1" );
+    CheckConfined( outcome, 4, 8, "adaptive left class 1" );
+
+    // More VCs need no change to the routers: with one
+    // class, SendVia rotates over the pairs of each leg
+    outcome = Run( 8, "", DOR, 0, 0, true );
+    CheckDelivered( outcome, "SendVia, eight VCs" );
+    CheckConfined( outcome, 0, 8, "SendVia, eight VCs" );
+    NS_TEST_ASSERT_MSG_GT( outcome.vcFlits[2], 0, "first leg pair 1 unused" );
+    NS_TEST_ASSERT_MSG_GT( outcome.vcFlits[6], 0, "second leg pair 3 unused" );
+}
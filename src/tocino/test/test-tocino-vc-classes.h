@@ -0,0 +1,61 @@
+/* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
+#ifndef __TEST_TOCINO_VC_CLASSES_H__
+#define __TEST_TOCINO_VC_CLASSES_H__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "ns3/test.h"
+
+namespace ns3
+{
+
+// Each traffic class must stay within its own VCs, under
+// every router and with SendVia, and still deliver
+// everything
+class TestTocinoVCClasses : public TestCase
+{
+    public:
+
+    TestTocinoVCClasses();
+
+    private:
+
+    struct Outcome
+    {
+        uint64_t sent;
+        uint64_t received;
+
+        // flits sent on each VC, all channels together
+        std::vector< uint64_t > vcFlits;
+    };
+
+    void TestAllocator();
+
+    // Uniform random traffic on a 4 x 4 torus, given the
+    // VCs, VCClasses, router, classes of even and odd
+    // nodes, and whether to bounce through intermediates
+    Outcome Run(
+            const uint32_t,
+            const std::string&,
+            const std::string&,
+            const uint32_t,
+            const uint32_t,
+            const bool );
+
+    void CheckDelivered( const Outcome&, const char* );
+
+    // No flits outside the given range of VCs
+    void CheckConfined(
+            const Outcome&,
+            const uint32_t,
+            const uint32_t,
+            const char* );
+
+    virtual void DoRun();
+};
+
+}
+
+#endif // __TEST_TOCINO_VC_CLASSES_H__
@@ -1,13 +1,35 @@
 /* -*- Mode:C++; c-file-style:"microsoft"; indent-tabs-mode:nil; -*- */
 
+#include "test-tocino-adaptive-routing.h"
+#include "test-tocino-arbiter.h"
+#include "test-tocino-bitmask-arbiter.h"
 #include "test-tocino-callbackqueue.h"
+#include "test-tocino-collectives.h"
+#include "test-tocino-credit-flow-control.h"
+#include "test-tocino-deferred-work.h"
+#include "test-tocino-flit.h"
 #include "test-tocino-flit-header.h"
 #include "test-tocino-flitter.h"
 #include "test-tocino-flow-control.h"
+#include "test-tocino-injection-limit.h"
+#include "test-tocino-input-vc-selection.h"
+#include "test-tocino-express-transmit.h"
+#include "test-tocino-latency.h"
+#include "test-tocino-link-sampler.h"
 #include "test-tocino-loopback.h"
 #include "test-tocino-point-to-point.h"
 #include "test-tocino-multihop.h"
+#include "test-tocino-partition.h"
+#include "test-tocino-remote-channel.h"
 #include "test-tocino-ring.h"
+#include "test-tocino-routing-lookup-table.h"
+#include "test-tocino-stats.h"
+#include "test-tocino-torus.h"
+#include "test-tocino-trace-replay.h"
+#include "test-tocino-traffic-matrix.h"
+#include "test-tocino-traffic-patterns.h"
+#include "test-tocino-valiant-routing.h"
+#include "test-tocino-vc-classes.h"
 #include "test-tocino-deadlock.h"
 #include "test-tocino-3d-torus-corner-to-corner.h"
 #include "test-tocino-3d-torus-incast.h"
@@ -41,8 +63,10 @@ TocinoTestSuite::TocinoTestSuite ()
 {
     AddTestCase( new TestTocinoCallbackQueue, QUICK );
     AddTestCase( new TestTocinoFlitHeader, QUICK );
+    AddTestCase( new TestTocinoFlit, QUICK );
     AddTestCase( new TestTocinoFlitter, QUICK );
     AddTestCase( new TestTocinoFlowControl, QUICK );
+    AddTestCase( new TestTocinoCreditFlowControl, QUICK );
     AddTestCase( new TestTocinoLoopback, QUICK );
     AddTestCase( new TestTocinoPointToPoint, QUICK );
     AddTestCase( new TestTocinoMultihop, QUICK );
@@ -52,6 +76,27 @@ TocinoTestSuite::TocinoTestSuite ()
     Add3DTorusTestCases( true, false );
     Add3DTorusTestCases( false, true );
     Add3DTorusTestCases( true, true );
+    AddTestCase( new TestTocinoArbiter( 3 ), QUICK );
+    AddTestCase( new TestTocinoBitmaskArbiter, QUICK );
+    AddTestCase( new TestTocinoInjectionLimit( 3 ), QUICK );
+    AddTestCase( new TestTocinoPartition( 4 ), QUICK );
+    AddTestCase( new TestTocinoTorus, QUICK );
+    AddTestCase( new TestTocinoRoutingLookupTable, QUICK );
+    AddTestCase( new TestTocinoLatency, QUICK );
+    AddTestCase( new TestTocinoStats, QUICK );
+    AddTestCase( new TestTocinoLinkSampler, QUICK );
+    AddTestCase( new TestTocinoCollectives, QUICK );
+    AddTestCase( new TestTocinoTraceReplay, QUICK );
+    AddTestCase( new TestTocinoTrafficMatrix, QUICK );
+    AddTestCase( new TestTocinoTrafficPatterns, QUICK );
+    AddTestCase( new TestTocinoValiantRouting, QUICK );
+    AddTestCase( new TestTocinoVCClasses, QUICK );
+    AddTestCase( new TestTocinoInputVCSelection, QUICK );
+    AddTestCase( new TestTocinoExpressTransmit, QUICK );
+    AddTestCase( new TestTocinoDeferredWork, QUICK );
+    AddTestCase( new TestTocinoRemoteChannel, QUICK );
+    AddTestCase( new TestTocinoAdaptiveRouting( 3, false ), QUICK );
+    AddTestCase( new TestTocinoAdaptiveRouting( 4, true ), QUICK );
 }
 
 static TocinoTestSuite tocinoTestSuite;